@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstdint>
+#include "Config.h"
+
+// Spectral analysis of the feed arm angle.
+// A tangled or eccentric spool catches once per revolution, so it shows up
+// as a periodic wobble in the arm long before the snag that stops it. The
+// jam detectors only look at the arm tick by tick; this stage looks at its
+// recent history as a spectrum:
+//   - monitoring ticks are averaged down to one frame per
+//     spectrumDecimation ticks (the mean is the anti-alias filter),
+//   - every kHop frames the newest kFrames are detrended, Hann-windowed
+//     and run through a real FFT (a kFrames/2-point complex FFT and a split),
+//   - the power spectrum gives the dominant frequency, how much of the
+//     arm's motion is that one tone, and the energy in kBands octave-wide
+//     bands,
+//   - each band is compared with a baseline learned from earlier windows.
+//     The anomaly score is the largest excess over it in units of
+//     spectrumAnomalyDb, so 1.0 is the trigger point and a spool that has
+//     always wobbled scores nothing.
+// The baseline survives restart(), like the trajectory detector's
+// breakaway level: an unstick doesn't change the spool.
+//
+// The complex FFT runs on esp-dsp's PIE (SIMD) kernels on the ESP32-S3
+// when the library is there, otherwise on the portable radix-2 code below.
+// Both take the same interleaved buffer, so they can be timed side by side.
+
+enum class FftImpl : uint8_t {
+    SCALAR,     // portable radix-2, both targets
+    ESP_DSP     // esp-dsp dsps_fft2r_fc32 (PIE on the S3)
+};
+
+const char* fftImplName(FftImpl impl);
+bool fftAvailable(FftImpl impl);
+
+// In-place complex FFT of n (power of two, at most ArmSpectrum::kFrames / 2)
+// points, interleaved re/im, result in natural order. Falls back to SCALAR
+// if impl isn't built in.
+void fftComplex(float* data, uint16_t n, FftImpl impl);
+
+struct ArmSpectrumFeatures {
+    uint32_t windows;           // analysed since begin
+    float frameHz;              // frame rate the bins are spaced by
+    float peakHz;               // dominant frequency, 0 with no window yet
+    float peakShare;            // of the AC power, in the peak (0-1)
+    float rmsDeg;               // detrended arm motion in the window
+    float bandDb[4];            // energy per band, dB re 1 deg^2
+    float anomaly;              // 1.0 = spectrumAnomalyDb over the baseline
+};
+
+class ArmSpectrum {
+public:
+    static constexpr uint16_t kFrames = 256;    // window, power of two
+    static constexpr uint16_t kHop = kFrames / 8;
+    static constexpr uint8_t kBands = 4;
+
+    // First FFT bin of each band; band i runs to the next one's start, the
+    // last to kFrames / 2. Bin 0 (the mean) is left out.
+    static constexpr uint16_t kBandStart[kBands + 1] = { 1, 4, 16, 64, kFrames / 2 + 1 };
+
+    void configure(const Config& cfg);
+
+    // Drop the window (the arm has been driven), keep the baseline.
+    void restart();
+    // Forget the baseline too.
+    void relearn();
+
+    // One monitoring tick's arm angle. Returns true when a window has just
+    // been analysed; the features change only then.
+    bool push(float angleDeg);
+
+    const ArmSpectrumFeatures& features() const { return _features; }
+    // Latest window's power in bin k (0..kFrames/2), deg^2.
+    float power(uint16_t k) const { return _power[k]; }
+    float anomaly() const { return _features.anomaly; }
+    bool learned() const { return _baselineWindows >= kWarmupWindows; }
+
+    // Band edges in Hz at the configured frame rate.
+    float bandLowHz(uint8_t band) const;
+    float bandHighHz(uint8_t band) const;
+
+    // FFT kernel the analysis uses: ESP_DSP when built in.
+    FftImpl impl() const { return _impl; }
+    void setImpl(FftImpl impl) { _impl = fftAvailable(impl) ? impl : FftImpl::SCALAR; }
+
+    // Run the analysis on the current window now (for benchmarks).
+    void analyse();
+
+private:
+    // Windows averaged into the baseline before anything is scored.
+    static constexpr uint8_t kWarmupWindows = 3;
+
+    Config _cfg;
+    FftImpl _impl = fftAvailable(FftImpl::ESP_DSP) ? FftImpl::ESP_DSP : FftImpl::SCALAR;
+    float _frameHz = 0;
+
+    float _acc = 0;                 // decimation
+    uint8_t _accTicks = 0;
+    float _frames[kFrames] = {};    // ring of decimated angles
+    uint16_t _head = 0;
+    uint16_t _filled = 0;
+    uint16_t _sinceAnalysis = 0;
+
+    // kFrames/2 complex points, 16-byte aligned for the PIE kernels.
+    alignas(16) float _work[kFrames] = {};
+    // One-sided power per bin (deg^2); a member to keep it off the
+    // control task's stack.
+    float _power[kFrames / 2 + 1] = {};
+
+    float _baselineDb[kBands] = {};
+    uint16_t _baselineWindows = 0;
+    ArmSpectrumFeatures _features = {};
+};
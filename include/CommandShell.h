@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Non-blocking serial command engine.
+// Bytes are fed in as they arrive; a complete line is looked up in a static
+// dispatch table by its first character. Nothing here allocates or waits, so
+// the caller's loop latency is bounded by poll()'s byte budget plus whatever
+// one handler or one job step does.
+
+// Incremental line assembler. Accepts CR, LF or CRLF endings and backspace.
+// Overlong lines are discarded up to the next terminator rather than being
+// split into two commands.
+class LineAssembler {
+public:
+    static constexpr size_t kMaxLine = 64;
+
+    // Feed one byte. Returns true when a non-empty line is ready in line().
+    bool feed(char c);
+
+    const char* line() const { return _buf; }
+
+    // Lines thrown away for being longer than kMaxLine - 1.
+    uint32_t overflows() const { return _overflows; }
+
+private:
+    char _buf[kMaxLine] = {};
+    size_t _len = 0;
+    bool _discarding = false;
+    uint32_t _overflows = 0;
+};
+
+// A long-running command, stepped from the loop instead of blocking it.
+class ShellJob {
+public:
+    virtual ~ShellJob() = default;
+
+    // Do one bounded slice of work. Return false when finished.
+    virtual bool poll(uint32_t nowMs) = 0;
+
+    // Stop early (operator typed another command).
+    virtual void cancel() {}
+};
+
+class CommandShell;
+
+// args points past the command character with leading blanks skipped.
+typedef void (*CommandHandler)(CommandShell& shell, const char* args);
+
+struct CommandSpec {
+    char key;               // matched case-insensitively
+    const char* usage;      // e.g. "t <angle>"
+    const char* help;
+    CommandHandler handler;
+};
+
+class CommandShell {
+public:
+    // Max bytes consumed per poll() — bounds the time spent per loop pass.
+    static constexpr uint16_t kBytesPerPoll = 32;
+
+    // readByte returns the next byte or -1 if none is waiting.
+    typedef int (*ReadByte)(void* ctx);
+
+    void begin(const CommandSpec* table, size_t count, ReadByte readByte, void* ctx);
+
+    // Consume waiting input, dispatch at most one line and step the active job.
+    void poll(uint32_t nowMs);
+
+    // Run a job from a handler. Any job already running is cancelled.
+    void startJob(ShellJob* job, uint32_t nowMs);
+    bool jobRunning() const { return _job != nullptr; }
+
+    // Print the table's usage/help columns.
+    void printHelp() const;
+
+    uint32_t overflows() const { return _line.overflows(); }
+
+private:
+    void dispatch(const char* line);
+
+    const CommandSpec* _table = nullptr;
+    size_t _count = 0;
+    ReadByte _readByte = nullptr;
+    void* _ctx = nullptr;
+    LineAssembler _line;
+    ShellJob* _job = nullptr;
+};
+
+// Parse a float argument. Returns false if args holds no number.
+bool parseFloatArg(const char* args, float& out);
@@ -5,6 +5,45 @@
 // All angles in degrees (0-160 range for 160-degree servos).
 // All times in milliseconds unless noted.
 
+// Filter chains selectable for the pot and reed paths (Filters.h).
+enum class SignalFilterType : uint8_t {
+    NONE,           // pass through
+    MEDIAN,         // median of 5
+    IIR,            // one-pole IIR, alpha 1/4
+    MEDIAN_AVERAGE, // median of 3 -> mean of 4
+    HAMPEL_IIR      // Hampel (7, 3 sigma) -> one-pole IIR, alpha 1/2
+};
+
+// Which jam detector FeedArmController runs (JamDetector.h).
+enum class JamDetectorType : uint8_t {
+    THRESHOLD,      // fixed angle threshold + reed stall
+    TRAJECTORY      // alpha-beta angle/velocity estimate + reed weighting
+};
+
+// One rung of the unstick escalation ladder (UnstickLadder.h).
+struct UnstickStage {
+    float angle;        // feed servo target (deg)
+    uint32_t holdMs;    // longest pull, out-stroke and shakes included (ms)
+    float relax;        // tension relaxation: 0 = keep, 1 = tensionAngleMin
+    uint8_t shakes;     // down-and-up oscillations at the top
+};
+
+static constexpr uint8_t kMaxUnstickStages = 4;
+
+// Pot linearisation measured by the servo sweep (PotTable.h): the settled
+// ADC reading at evenly spaced angles from fromDeg to toDeg.
+static constexpr uint8_t kPotCalPoints = 9;
+
+struct PotCalibration {
+    uint8_t points;                 // 0 = none, use the two-point range
+    float fromDeg;                  // angle at adc[0]
+    float toDeg;                    // angle at adc[points - 1]
+    uint16_t adc[kPotCalPoints];
+};
+
+// Feed arms one board can drive (one row each in pins.h's kChannelPins).
+static constexpr uint8_t kMaxFeedChannels = 4;
+
 struct Config {
     // --- Feed Arm ---
     // Resting angle: where the spring holds the arm under normal filament tension.
@@ -16,15 +55,109 @@ struct Config {
     // Lower angle = more tension pulling the arm toward the spool.
     float feedArmJamAngle = 45.0f;
 
-    // Unstick angle: the servo drives to this angle to yank filament away from spool.
-    float feedArmUnstickAngle = 140.0f;
+    // --- Unstick Escalation ---
+    // Attempts for one jam. Each stage drives the feed servo to `angle` and
+    // holds for up to `holdMs`; the hold ends early once the unstick is
+    // confirmed (below). An unconfirmed attempt escalates to the next stage
+    // straight away. Relaxing the tension spring stops the servo fighting
+    // it, but the spring also adds to the yank. A stage below rest is a dip:
+    // the servo lowers the arm, and on detach the re-tensioned spring snaps
+    // it back up, jerking the filament harder than the servo can pull it.
+    UnstickStage unstickLadder[kMaxUnstickStages] = {
+        { 140.0f,  500, 1.0f, 0 },   // the original single yank
+        { 160.0f,  800, 0.0f, 0 },   // full yank with the spring helping
+        {  20.0f,  200, 0.0f, 0 },   // dip and release
+        { 160.0f, 1500, 0.0f, 2 },   // yank and shake
+    };
+    uint8_t unstickStages = 4;
 
-    // How long to hold the unstick position before returning to rest (ms).
-    uint32_t unstickHoldTimeMs = 500;
+    // Depth of each shake below the stage angle (deg).
+    float unstickShakeDeg = 30.0f;
 
-    // Cooldown between unstick attempts to avoid hammering (ms).
+    // Start each jam at the stage with the best success rate so far
+    // rather than the first.
+    bool unstickAdaptive = true;
+
+    // Cooldown once the ladder is exhausted, to avoid hammering (ms).
     uint32_t unstickCooldownMs = 2000;
 
+    // --- Unstick Motion ---
+    // Feed servo speed and acceleration limits for unstick moves.
+    float unstickMaxDegPerSec = 300.0f;
+    float unstickAccelDegPerSec2 = 2000.0f;
+
+    // Pot reading within this of a move's target counts as arrived (deg).
+    float unstickArriveTolDeg = 6.0f;
+
+    // The arm has to sit at the unstick angle this long to confirm the
+    // filament is free (ms). The spool turning (reed) confirms at once.
+    uint32_t unstickSettleMs = 100;
+
+    // Reed pulses since the unstick began that show the spool turning.
+    uint8_t unstickReedPulses = 1;
+
+    // Extra wait for the pot to confirm the return to rest after the
+    // profile finishes (ms).
+    uint32_t unstickReturnTimeoutMs = 500;
+
+    // Cooldown after each attempt before it is judged (ms). Long enough for
+    // the tension servo to re-tension the spring.
+    uint32_t unstickCooldownMinMs = 300;
+
+    // A confirmed unstick's cooldown also waits for the arm to come back
+    // within this of the rest angle (deg), up to unstickCooldownMs.
+    float unstickRecoveredDeg = 15.0f;
+
+    // --- Jam Detector ---
+    JamDetectorType jamDetector = JamDetectorType::TRAJECTORY;
+
+    // Alpha-beta filter gains for angle and angular velocity (per tick).
+    float jamAlpha = 0.5f;
+    float jamBeta = 0.1f;
+
+    // Upward arm speed (deg/s) that marks the spool breaking free of its
+    // static drag. The angle just before it is the learned breakaway level.
+    float jamSlipDegPerSec = 4.0f;
+
+    // Degrees below the breakaway level that count as a jam.
+    float jamMarginDeg = 3.0f;
+
+    // How fast the breakaway level creeps up after a shallower release (0-1).
+    float jamFloorAdapt = 0.2f;
+
+    // After monitoring resumes, only the threshold rule applies for this
+    // long while the tension servo re-tensions the spring (ms).
+    uint32_t jamSettleMs = 1500;
+
+    // Look-ahead at the current descent rate (s). Forecast depth is scored
+    // against twice the margin.
+    float jamHorizonSec = 1.0f;
+
+    // Evidence scale applied while the reed shows filament still moving.
+    float jamReedMovingWeight = 0.5f;
+
+    // Trigger when the detector's confidence reaches this (1.0 = nominal).
+    float jamConfidence = 1.0f;
+
+    // Evidence scale-up (1 + this) while the arm spectrum flags a wobble,
+    // anomaly score 1 and above (ArmSpectrum.h). 0 ignores the spectrum.
+    float jamWobbleGain = 0.5f;
+
+    // --- Arm Spectrum (ArmSpectrum.h) ---
+    // Analyse the arm angle's spectrum while monitoring.
+    bool spectrum = true;
+
+    // Control ticks averaged into each spectrum frame. At 50 ms ticks, 20
+    // gives 1 Hz frames: a 256 s window (a couple of spool revolutions), a
+    // new one every 32 s, 4 mHz bins up to 0.5 Hz.
+    uint8_t spectrumDecimation = 20;
+
+    // A band this far above its learned level scores 1.0 (dB).
+    float spectrumAnomalyDb = 12.0f;
+
+    // How fast the learned band levels follow normal windows (0-1).
+    float spectrumAdapt = 0.1f;
+
     // --- Tension Arm (Spring Adjustment) ---
     // Servo angle that sets the spring's effective length.
     // Higher angle = more spring compression = more tension on feed arm.
@@ -36,29 +169,203 @@ struct Config {
     float tensionAngleMin = 30.0f;
     float tensionAngleMax = 130.0f;
 
+    // --- Tension Tracking (TensionTracker.h) ---
+    // Re-tension the spring as the spool's drag changes, so the arm keeps
+    // resting at feedArmRestAngle while printing.
+    bool tensionTrack = true;
+
+    // Time constant of the resting-angle average (s), and how much of it
+    // is averaged after startup or an unstick before the first nudge (ms).
+    float tensionTrackTauSec = 300.0f;
+    uint32_t tensionTrackWarmupMs = 600000;
+
+    // Start correcting when the average is this far from rest, stop once
+    // it is back within the inner band (deg).
+    float tensionTrackStartDeg = 3.0f;
+    float tensionTrackStopDeg = 1.0f;
+
+    // Tension servo degrees per degree of arm error, per nudge.
+    float tensionTrackGain = 0.5f;
+
+    // Time between nudges (ms) and the rate limit they add up to (deg/min).
+    uint32_t tensionTrackIntervalMs = 60000;
+    float tensionTrackMaxDegPerMin = 1.0f;
+
+    // Ticks where the jam detector's confidence is above this are left out
+    // of the average, so a developing snag isn't tensioned away.
+    float tensionTrackMaxConfidence = 0.5f;
+
+    // No reed pulse for this long means the printer is idle (or the spool
+    // is empty) and the arm's position says nothing about drag (ms).
+    uint32_t tensionTrackIdleMs = 120000;
+
+    // --- Tension Model (TensionModel.h) ---
+    // Arm geometry (mm, cad/*.scad) and spring, for turning the two pot
+    // angles into filament tension.
+    float feedArmLengthMm = 120.0f;      // feed_arm.scad arm_length
+    float springAnchorMm = 35.0f;        // feed_arm.scad spring_anchor_dist
+    float tensionArmLengthMm = 50.0f;    // tension_arm.scad arm_length
+    float pivotSpacingMm = 25.0f;        // assembly.scad servo_gap + servo_body_w
+    // Filament path gained per radian of feed arm lift, as a multiple of
+    // arm length (~1.5 for the wrap the base geometry gives).
+    float pathGain = 1.5f;
+    // Spring rate (N/mm; `k` calibrates it against a known load) and
+    // unstretched length, hook to hook (mm).
+    float springRate = 0.7f;
+    float springFreeMm = 15.8f;
+
+    // Jam when the estimated filament tension reaches this (N), whatever
+    // the tension servo is doing. 0 uses feedArmJamAngle instead.
+    float jamTensionN = 0.0f;
+
     // --- Potentiometer Angle Reading ---
     // ADC range mapping: what ADC values correspond to 0° and 160°.
     // Calibrate by manually moving arm to known angles and reading ADC.
+    // Only used until a servo sweep table (below) has been taken.
     uint16_t potFeedMin = 200;       // ADC value at 0° (full one direction)
     uint16_t potFeedMax = 3800;      // ADC value at 160° (full other direction)
     uint16_t potTensionMin = 200;
     uint16_t potTensionMax = 3800;
 
+    // Tables from the servo sweep ('c'). The ADC bows away from a straight
+    // line near the rails at 11 dB, which two endpoints can't capture.
+    PotCalibration potFeedCal = {};
+    PotCalibration potTensionCal = {};
+
+    // Sweep range for the feed arm (the tension arm covers tensionAngleMin
+    // to tensionAngleMax). Keep it clear of the arm's hard stops.
+    float potCalFeedMinDeg = 20.0f;
+    float potCalFeedMaxDeg = 160.0f;
+
+    // Wait after each sweep move before sampling (ms), then average this
+    // many control ticks of pot readings.
+    uint32_t potCalSettleMs = 300;
+    uint8_t potCalSamples = 8;
+
     // Potentiometer smoothing: number of samples to average.
-    uint8_t potSamples = 8;
+    // Samples come from the continuous ADC ring, so this is a sliding window
+    // over the newest conversions (max 64).
+    uint8_t potSamples = 32;
+
+    // Continuous ADC sample rate per pot (Hz). Both pots share ADC1.
+    uint32_t potSampleRateHz = 2000;
+
+    // Extra filter chain on each pot reading, per control tick, after the
+    // sampler's window mean.
+    SignalFilterType potFilter = SignalFilterType::NONE;
+
+    // --- Guide Wheel Encoder (WheelEncoder.h) ---
+    // Pulses per wheel revolution: magnets on the wheel, or 4 x lines for
+    // a quadrature sensor. Stall detection and debounce scale with it.
+    uint16_t wheelPulsesPerRev = 1;
+    // Diameter the filament runs on (mm), guide_wheel.scad wheel_od.
+    float wheelDiameterMm = 25.0f;
+    // Two-channel quadrature sensor on the reed pin and ChannelPins::wheelB.
+    bool wheelQuadrature = false;
+    // A stop this long ends a print for the per-print odometer (ms).
+    uint32_t odometerPrintGapMs = 300000;
 
     // --- Reed Switch (Filament Movement Detection) ---
     // If no reed switch pulses within this window, filament has stalled.
+    // Upper bound for the adaptive stall window below, and the window used
+    // until enough revolutions have been timed.
     uint32_t reedStallTimeoutMs = 3000;
 
+    // Adaptive stall: stalled after this many expected revolution periods
+    // (rolling mean of recent revolutions) without a pulse.
+    float reedStallPeriods = 2.5f;
+
+    // Lower bound for the adaptive stall window (ms).
+    uint32_t reedStallMinMs = 300;
+
+    // Debounce: edges closer than this fraction of the last pulse period
+    // are contact bounce. Clamped to the min/max below (µs); the max is
+    // for one pulse per revolution and shrinks with wheelPulsesPerRev.
+    float reedDebounceFraction = 0.3f;
+    uint32_t reedDebounceMinUs = 2000;
+    uint32_t reedDebounceMaxUs = 50000;
+
+    // Filter chain on the reed pulse rate given to the jam detector.
+    SignalFilterType reedFilter = SignalFilterType::NONE;
+
     // Minimum pulses per second during active printing.
     // Below this = suspicious (slow feed or stall).
     float reedMinPulsesPerSec = 0.5f;
 
+    // --- Printer Link (PrinterLink.h) ---
+    // Line protocol to the printer's host on the UART pins in pins.h.
+    // Board-wide settings come from channel 0.
+    bool printerLink = false;
+    uint32_t printerBaud = 115200;
+
+    // No report for this long: the link is down and stall detection goes
+    // back to the reed alone (ms).
+    uint32_t printerLinkTimeoutMs = 1000;
+
+    // Resend an unacknowledged hold/release request this often (ms).
+    uint32_t printerRetryMs = 100;
+
+    // Ask the printer to stop extruding while an arm is out of MONITORING.
+    bool printerHold = true;
+
+    // With the link up, the filament is stalled once the printer has
+    // commanded this much more than one wheel pulse's worth since the last
+    // pulse (mm). Covers what the arm can give up on its own. A travel move
+    // commands nothing, so it is never a stall.
+    float printerSlipMarginMm = 30.0f;
+
+    // --- Flight Recorder (PSRAM) ---
+    // History kept before and after each unstick trigger (ms). Raw pot
+    // samples cost 8 bytes each at potSampleRateHz per pot.
+    uint32_t recorderPreMs = 10000;
+    uint32_t recorderPostMs = 5000;
+
+    // Frozen captures kept for dumping; the oldest is reused first (max 8).
+    uint8_t recorderCaptures = 4;
+
+    // Servo/reed/state records per capture.
+    uint32_t recorderControlEntries = 4096;
+
+    // --- Power (IdleMonitor.h) ---
+    // Slow down between prints: once the board has been idle for a while,
+    // drop the CPU clock and tick every idleTickMs, light-sleeping between
+    // ticks when nothing is listening. USB serial drops while the chip
+    // sleeps, so it only sleeps with no terminal attached and the printer
+    // link quiet; otherwise it just runs slower.
+    bool lowPower = false;
+
+    // Quiet time before idling: every arm monitoring, no wheel pulses, no
+    // arm movement, printer not printing (ms).
+    uint32_t idleAfterMs = 600000;
+
+    // Control tick period while idle (ms). A reed edge wakes the board at
+    // once; an arm pulled by a jammed spool is seen within one idle tick.
+    uint32_t idleTickMs = 500;
+
+    // An arm moving this far from where it settled ends idle (degrees).
+    float idleWakeDeg = 3.0f;
+
+    // CPU clock while idle (MHz: 80, 160 or 240).
+    uint16_t idleCpuMhz = 80;
+
+    // Wake to first fresh pot sample; slower wakes are counted (us). The
+    // ADC DMA needs a whole frame after restarting, ~8 ms at the default
+    // pot rate.
+    uint32_t wakeBudgetUs = 15000;
+
     // --- General ---
     // How often the main monitor loop runs (ms).
     uint32_t monitorIntervalMs = 50;
 
+    // Control-tick budget per channel: timer release to that channel's
+    // update finishing (us). Channels run in order, so the last one also
+    // waits for the others. Ticks over budget are counted per channel.
+    uint32_t controlBudgetUs = 2000;
+
     // Serial baud rate.
     uint32_t baudRate = 115200;
+
+    // Start with the binary telemetry stream on instead of text status
+    // lines (toggle at runtime with 'b').
+    bool telemetryBinary = false;
 };
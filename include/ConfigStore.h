@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "Config.h"
+
+// Persistent Config, one blob per feed channel.
+//
+// Blob layout (little-endian):
+//   u32 magic 'FFXC', u16 version, u16 payload bytes, u32 CRC-32 of payload
+//   payload: records of [u8 field id][u8 size][size bytes]
+// Loading starts from the compile-time defaults and overlays every record
+// whose id is known and whose size still matches. Fields added since the
+// blob was written keep their defaults, and fields since removed are
+// skipped. Changes in meaning bump kConfigVersion and get a step in
+// migrateConfig(). Field ids are never reused.
+
+static constexpr uint16_t kConfigVersion = 1;
+static constexpr size_t kConfigBlobMax = 1024;
+
+// Where blobs live: NVS on the ESP32.
+class ConfigStorage {
+public:
+    virtual ~ConfigStorage() = default;
+
+    // Copy the blob stored under key into buf. Returns its size, or 0 if
+    // there is none or it doesn't fit.
+    virtual size_t read(const char* key, void* buf, size_t len) = 0;
+    virtual bool write(const char* key, const void* buf, size_t len) = 0;
+    virtual bool erase(const char* key) = 0;
+};
+
+enum class ConfigLoadResult : uint8_t {
+    LOADED,     // stored blob, current version
+    MIGRATED,   // stored blob, older version, upgraded in place
+    DEFAULTS,   // nothing stored
+    CORRUPT     // bad magic, CRC or a newer version; defaults used
+};
+
+const char* configLoadResultName(ConfigLoadResult result);
+
+// Serialise cfg into out. Returns the blob size, or 0 if out is too small.
+size_t encodeConfig(const Config& cfg, uint8_t* out, size_t len);
+
+// Overlay a blob onto cfg (which should hold the defaults). cfg is only
+// modified if the blob is valid.
+ConfigLoadResult decodeConfig(const uint8_t* blob, size_t len, Config& cfg);
+
+// Upgrade a config decoded from an older blob version.
+void migrateConfig(Config& cfg, uint16_t fromVersion);
+
+uint32_t crc32(const uint8_t* data, size_t len);
+
+class ConfigStore {
+public:
+    void begin(ConfigStorage* storage) { _storage = storage; }
+
+    // One storage read. On anything but LOADED/MIGRATED cfg is untouched.
+    ConfigLoadResult load(uint8_t channel, Config& cfg);
+    bool save(uint8_t channel, const Config& cfg);
+    bool erase(uint8_t channel);
+
+    // Size of the last blob loaded or saved.
+    size_t lastBlobBytes() const { return _lastBytes; }
+
+private:
+    static void key(uint8_t channel, char* out);
+
+    ConfigStorage* _storage = nullptr;
+    size_t _lastBytes = 0;
+};
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <Arduino.h>
+#include "FeedArmController.h"
+#include "IdleMonitor.h"
+#include "PowerControl.h"
+#include "SpscRing.h"
+#include "WheelEncoder.h"
+
+// Real-time control task.
+// Every channel's FeedArmController::update() runs in one high-priority
+// FreeRTOS task pinned to core 0, released by a hardware timer at a fixed
+// period. The Arduino loop on core 1 does serial, logging and LED work. The
+// two sides only talk through lock-free SPSC rings, so the control tick never
+// waits on USB CDC. Channels are updated in order each tick; the time from
+// the timer release to each channel's update finishing is checked against
+// Config::controlBudgetUs. Each finished tick wakes the comms side.
+// With Config::lowPower (channel 0's) and a PowerControl attached, the task
+// stops the timer once IdleMonitor calls the board idle and paces itself
+// with PowerControl::waitIdleTick() instead, until something wakes it.
+
+// Core 1 runs the Arduino loop (comms); control gets the other core.
+static constexpr BaseType_t kControlCore = 0;
+static constexpr UBaseType_t kControlPriority = 10;   // above the ADC drain task
+static constexpr uint8_t kControlTimer = 0;
+
+// Comms -> control requests.
+enum class ControlCommandType : uint8_t {
+    UNSTICK,
+    SET_TENSION,    // value = angle
+    CLEAR_UNSTICK_STATS,
+    CALIBRATE_POTS, // servo sweep; the result comes back via takePotSweep()
+    START_PRINT     // restart the per-print odometer
+};
+
+struct ControlCommand {
+    uint8_t channel;
+    ControlCommandType type;
+    float value;
+};
+
+// Control -> comms snapshot, published once per tick per channel.
+struct FeedArmStatus {
+    uint8_t channel;
+    uint32_t tick;
+    uint32_t timeMs;
+    FeedArmState state;
+    float feedArmAngle;
+    float tensionArmAngle;
+    float tensionAngle;
+    float filamentTension;      // N, estimated
+    uint16_t rawFeedPot;
+    uint16_t rawTensionPot;
+    uint32_t unstickCount;
+    bool filamentStalled;
+    float pulsesPerSec;
+    uint32_t pulseCount;
+    float filamentSpeed;        // mm/s
+    float expectedFeed;         // mm/s commanded by the printer, -1 with no link
+    float filamentUsedMm;       // since boot
+    float printUsedMm;          // this print
+    uint32_t printCount;
+    uint32_t msSinceLastPulse;
+    uint64_t lastPulseUs;       // newest pulse timestamp
+    uint32_t reedPeriodUs;      // latest revolution
+    uint32_t reedJitterUs;      // std-dev of recent revolutions
+    ArmSpectrumFeatures spectrum;   // latest window
+    uint32_t latencyUs;         // timer release -> this channel's update done
+};
+
+// Per-channel tick timing, kept by the control task.
+struct ChannelTiming {
+    uint32_t worstLatencyUs;    // since the last clearTiming()
+    uint32_t overBudget;        // ticks past Config::controlBudgetUs
+};
+
+class ControlTask {
+public:
+    // Starts the timer and the task for count channels: arms[i] with
+    // reeds[i] (reeds may be null). The controllers and reed switches must
+    // already be initialised; from here on only the control task touches
+    // them. The tick budget comes from channel 0's config.
+    bool begin(FeedArmController* arms, ReedSwitch* reeds, uint8_t count,
+               uint32_t periodMs);
+
+    uint8_t channels() const { return _count; }
+
+    // --- Comms side (single consumer / single producer) ---
+    bool send(uint8_t channel, ControlCommandType type, float value = 0);
+
+    // Replace a channel's whole config before its next update. Comms and
+    // the controller each keep their own copy; this hands it over whole
+    // between ticks, so the controller never sees a half-written struct.
+    // False if the previous one hasn't been applied yet; try again next pass.
+    bool setConfig(uint8_t channel, const Config& cfg);
+
+    // The printer link's latest report for a channel. Same hand-off as
+    // setConfig(); the comms side just offers the newest every pass.
+    bool setPrinterFeed(uint8_t channel, const PrinterFeed& feed);
+
+    // A channel's finished pot sweep, once.
+    bool takePotSweep(uint8_t channel, PotSweepResult& out);
+    bool pollEvent(FeedArmEvent& ev) { return _events.pop(ev); }
+
+    // The newest snapshot per channel in out[channel], however far behind
+    // comms fell. Returns false if none has been published since the last
+    // call. Drops the unread stream (pollStatus()).
+    bool latestStatus(FeedArmStatus* out);
+
+    // Oldest unread snapshot, for consumers that want every tick. A full
+    // stream drops the newest; latestStatus() still has them.
+    bool pollStatus(FeedArmStatus& out) { return _status.pop(out); }
+    uint32_t droppedStatus() const { return _status.dropped(); }
+
+    // Notify this task (xTaskNotifyGive) after every tick, so the comms
+    // side can block until there is something to drain.
+    void setListener(TaskHandle_t task) { _listener = task; }
+
+    // Low-power idle (IdleMonitor.h). Call before begin().
+    void setPower(PowerControl* power) { _power = power; }
+    bool idle() const { return _idleMode; }
+    WakeReason lastWake() const { return _idle.lastWake(); }
+    // Written by the control task; reads may be a tick stale.
+    const WakeStats& wakeStats() const { return _idle.stats(); }
+    void clearWakeStats() { _clearWake = true; }
+
+    // Ticks the task could not service before the next timer fired.
+    uint32_t missedTicks() const { return _missedTicks; }
+    uint32_t droppedEvents() const { return _events.dropped(); }
+
+    // Tick latency per channel. Written by the control task; reads may be
+    // a tick stale.
+    ChannelTiming timing(uint8_t channel) const;
+    void clearTiming();
+
+    // Task body and timer hook — public for the static trampolines.
+    void run();
+    void IRAM_ATTR onTimer();
+
+private:
+    void applyCommand(const ControlCommand& cmd);
+    void publishStatus(uint8_t ch, uint32_t latencyUs);
+    uint64_t idleWait();
+    void updateIdle();
+    void syncPowerMode();
+
+    FeedArmController* _arms = nullptr;
+    ReedSwitch* _reeds = nullptr;
+    uint8_t _count = 0;
+    SpscMailbox<Config> _configs[kMaxFeedChannels];        // comms -> control
+    SpscMailbox<PotSweepResult> _sweeps[kMaxFeedChannels];  // control -> comms
+    SpscMailbox<PrinterFeed> _printerFeeds[kMaxFeedChannels];  // comms -> control
+    uint32_t _budgetUs = 0;
+    uint32_t _periodUs = 0;
+    uint64_t _lastStartUs = 0;     // profiling only
+    TaskHandle_t _task = nullptr;
+    TaskHandle_t _listener = nullptr;
+    PowerControl* _power = nullptr;
+    IdleMonitor _idle;
+    bool _idleMode = false;         // timer stopped, pacing on idle ticks
+    volatile bool _clearWake = false;
+    PrinterActivity _printerActivity[kMaxFeedChannels] = {};
+    hw_timer_t* _timer = nullptr;
+
+    SpscRing<ControlCommand, 16> _commands;
+    FeedArmEventRing _events;
+    // Deep enough to ride out a slow USB write at full telemetry rate.
+    SpscRing<FeedArmStatus, 16 * kMaxFeedChannels> _status;
+    SpscLatest<FeedArmStatus> _latest[kMaxFeedChannels];
+
+    uint32_t _tick = 0;
+    volatile uint32_t _missedTicks = 0;
+    volatile uint64_t _releaseUs = 0;   // last timer release, set by the ISR
+    volatile uint32_t _worstLatencyUs[kMaxFeedChannels] = {};
+    volatile uint32_t _overBudget[kMaxFeedChannels] = {};
+    volatile bool _clearTiming = false;
+};
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include "ConfigStore.h"
+#include "Hal.h"
+#include "JamJournal.h"
+
+// ESP32 implementations of the hardware interfaces in Hal.h.
+// The pot input is PotSampler (continuous ADC).
+
+class Esp32Clock : public Clock {
+public:
+    uint32_t millis() override;
+    uint64_t micros() override;
+    void delayMs(uint32_t ms) override;
+};
+
+// Servo on a dedicated LEDC channel, 50 Hz frame. Each servo is given its
+// channel in begin() and keeps it through detach/attach, so a multi-arm
+// board never runs out mid-print or has arms trade channels. LEDC channels
+// pair up on timers (0/1, 2/3, ...); every servo runs at 50 Hz, so pairs
+// always agree on the frequency. Angles are written as pulse widths
+// (0-180° across minUs-maxUs) at 14-bit duty resolution, about 1.2 us.
+class Esp32ServoOutput : public ServoOutput {
+public:
+    static constexpr uint8_t kLedcChannels = 8;     // ESP32-S3
+
+    // keepInSleep lets useSleepClock() move the LEDC timer onto the RC
+    // oscillator while idle, so pulses continue through light sleep
+    // (Config::lowPower).
+    bool begin(uint8_t ledcChannel, bool keepInSleep = false);
+
+    // Clock every keepInSleep servo's timer from the RC oscillator (idle)
+    // or from APB (active). The RC oscillator drifts by a few percent,
+    // degrees of servo error, so it is only for holding through sleep.
+    static bool useSleepClock(bool sleep);
+
+    bool attach(uint8_t pin, uint16_t minUs, uint16_t maxUs) override;
+    void detach() override;
+    bool attached() const override { return _attached; }
+    void write(float angle) override;
+
+private:
+    uint8_t _ledc = 0xff;
+    uint8_t _pin = 0xff;
+    bool _attached = false;
+    uint16_t _minUs = 500;
+    uint16_t _maxUs = 2500;
+
+    static uint8_t _sleepTimers;    // LEDC timers begun with keepInSleep, one bit each
+};
+
+// GPIO edge interrupts. Each pin gets a slot holding its callback; the shared
+// ISR trampoline timestamps the edge with esp_timer before calling it.
+class Esp32EdgeInput : public EdgeInput {
+public:
+    static constexpr uint8_t kMaxPins = 8;      // two wheel channels per feed channel
+
+    bool attachFalling(uint8_t pin, bool pullup, EdgeCallback cb, void* arg) override;
+    bool attachChange(uint8_t pin, bool pullup, EdgeCallback cb, void* arg) override;
+    bool level(uint8_t pin) override;
+
+    // Light sleep (PowerControl.h): swap every pin's edge interrupt for a
+    // GPIO wake on the level it isn't at now, and back afterwards. An edge
+    // that happened while asleep is handed to its callback at nowUs, so a
+    // reed pulse that woke the chip still counts.
+    void armWake();
+    bool disarmWake(uint64_t nowUs);    // true if any pin changed
+
+private:
+    bool attach(uint8_t pin, bool pullup, EdgeCallback cb, void* arg, int mode);
+};
+
+// Config blobs in the "ffx" NVS namespace. A flash write stalls the cache
+// on both cores, control tick included, so saves only happen when the
+// operator asks for one.
+class Esp32ConfigStorage : public ConfigStorage {
+public:
+    bool begin();
+
+    size_t read(const char* key, void* buf, size_t len) override;
+    bool write(const char* key, const void* buf, size_t len) override;
+    bool erase(const char* key) override;
+
+private:
+    Preferences _prefs;
+    bool _open = false;
+};
+
+// Jam journal segments as files on LittleFS (the "spiffs" partition),
+// which spreads the writes over the flash. Each append is one open, write
+// and close; LittleFS commits it whole or not at all.
+class Esp32JournalStorage : public JournalStorage {
+public:
+    bool begin();
+
+    size_t size(uint8_t segment) override;
+    size_t read(uint8_t segment, size_t offset, void* buf, size_t len) override;
+    bool append(uint8_t segment, const void* buf, size_t len) override;
+    bool erase(uint8_t segment) override;
+
+private:
+    static void path(uint8_t segment, char* out);
+
+    bool _mounted = false;
+};
@@ -1,25 +1,111 @@
 #pragma once
 
-#include <Arduino.h>
-#include <ESP32Servo.h>
+#include <cstddef>
+#include "ArmSpectrum.h"
 #include "Config.h"
+#include "Filters.h"
+#include "FlightRecorder.h"
+#include "JamDetector.h"
+#include "Hal.h"
+#include "Platform.h"
+#include "PotTable.h"
+#include "ServoMotion.h"
+#include "SpscRing.h"
+#include "TensionModel.h"
+#include "TensionTracker.h"
+#include "UnstickLadder.h"
 #include "WheelEncoder.h"
 
 // States for the feed arm state machine.
 enum class FeedArmState : uint8_t {
     MONITORING,     // Servo DETACHED — arm floats with spring, reading pot for angle
-    UNSTICKING,     // Servo ATTACHED — driving to unstick angle to yank filament free
-    HOLD_UNSTICK,   // Holding unstick position for configured duration
-    RETURNING,      // Returning servo to rest angle after unstick
-    COOLDOWN        // Servo DETACHED — waiting between unstick attempts
+    UNSTICKING,     // Servo ATTACHED — profiled move (and shakes) to the stage's angle
+    HOLD_UNSTICK,   // Holding unstick position until pot/reed confirm the filament is free
+    RETURNING,      // Profiled move back to rest angle, until the pot confirms arrival
+    COOLDOWN,       // Servo DETACHED — judging the attempt, then escalate or wait
+    CALIBRATING     // Both servos sweeping the arms to build the pot tables
 };
 
 const char* feedArmStateName(FeedArmState state);
 
+// Things the controller reports. The control task never formats text —
+// events are queued and printed by whoever drains the ring.
+enum class FeedArmEventType : uint8_t {
+    STATE_CHANGE,       // from -> to
+    JAM_DETECTED,       // a = arm angle, b = detector confidence, flag = reed stalled,
+                        // n = JamPath
+    TENSION_RELAXED,    // a = saved tension angle, b = relaxed angle
+    SERVO_ATTACHED,
+    UNSTICK_COMPLETE,   // n = unstick count, a = rest angle
+    SERVO_DETACHED,
+    TENSION_RESTORED,   // a = tension angle
+    TENSION_SET,        // a = tension angle
+    MANUAL_UNSTICK,
+    UNSTICK_CONFIRMED,  // a = arm angle, n = ms since unstick start, flag = by reed
+    UNSTICK_STAGE,      // n = stage (1-based), a = angle, b = tension, flag = escalated
+    UNSTICK_RESULT,     // n = stage (1-based), a = stage success rate, flag = success
+    UNSTICK_GAVE_UP,    // n = stages tried
+    POT_SWEEP_DONE,     // a/b = feed/tension ADC span, flag = both pots usable
+    TENSION_TRACKED,    // a = new tension angle, b = averaged resting arm angle
+    SPOOL_WOBBLE,       // a = dominant Hz, b = spectrum anomaly score, n = peak share %
+    IDLE_ENTERED,       // whole board (IdleMonitor.h): a = quiet s before it, n = idle tick ms
+    IDLE_WOKE           // whole board: a = s idle, n = WakeReason
+};
+
+struct FeedArmEvent {
+    uint32_t timeMs;
+    FeedArmEventType type;
+    FeedArmState from;
+    FeedArmState to;
+    bool flag;
+    float a;
+    float b;
+    uint32_t n;
+    uint8_t channel;    // feed channel that raised it
+};
+
+using FeedArmEventRing = SpscRing<FeedArmEvent, 32>;
+
+// One-line human-readable description of an event (no trailing newline).
+int formatFeedArmEvent(const FeedArmEvent& ev, char* buf, size_t len);
+
+// Result of a servo sweep. A pot whose readings didn't move strictly one
+// way comes back with points = 0.
+struct PotSweepResult {
+    PotCalibration feed;
+    PotCalibration tension;
+};
+
+// What the printer's host last reported (PrinterLink.h).
+enum class PrinterActivity : uint8_t {
+    UNKNOWN,        // no link, or the last report is stale
+    IDLE,
+    TRAVEL,         // printing, but the extruder isn't feeding
+    EXTRUDING,
+    PAUSED
+};
+
+const char* printerActivityName(PrinterActivity activity);
+
+struct PrinterFeed {
+    PrinterActivity activity;
+    float mmPerSec;         // commanded filament rate; 0 unless EXTRUDING
+};
+
+// Hardware the controller drives. All of it is injected so the same
+// controller runs on the ESP32 and against the simulator.
+struct FeedArmIo {
+    Clock* clock;
+    PotInput* pots;
+    ServoOutput* feedServo;
+    ServoOutput* tensionServo;
+};
+
 class FeedArmController {
 public:
-    void begin(const Config& cfg, uint8_t feedServoPin, uint8_t tensionServoPin,
-               uint8_t feedPotPin, uint8_t tensionPotPin, ReedSwitch* reed);
+    void begin(const Config& cfg, const FeedArmIo& io, uint8_t feedServoPin,
+               uint8_t tensionServoPin, uint8_t feedPotPin, uint8_t tensionPotPin,
+               ReedSwitch* reed);
 
     // Main update loop — call every monitorIntervalMs.
     void update();
@@ -32,6 +118,8 @@ public:
 
     // Read the actual tension arm angle from potentiometer (degrees).
     float tensionArmAngle() const { return _tensionArmAngle; }
+    // Estimated from both pot angles (TensionModel.h), N.
+    float filamentTension() const { return _filamentTension; }
 
     // Manually trigger an unstick action (e.g., from serial command).
     void triggerUnstick();
@@ -40,47 +128,172 @@ public:
     // Tension servo STAYS ATTACHED and holds this position.
     void setTensionAngle(float angle);
     float tensionAngle() const { return _tensionAngle; }
+    const TensionTracker& tensionTracker() const { return _tracker; }
+
+    // Spectrum of the arm while printing (Config::spectrum).
+    const ArmSpectrum& spectrum() const { return _spectrum; }
+
+    // Sweep both servos through kPotCalPoints angles and back, averaging
+    // the settled pot readings at each, then return the arm to rest and
+    // resume monitoring. Only starts from MONITORING; the tables are not
+    // applied until they come back through updateConfig().
+    bool startCalibration();
+
+    // The finished sweep, once.
+    bool takeCalibration(PotSweepResult& out);
 
     // Update config at runtime (e.g., from serial commands).
-    void updateConfig(const Config& cfg) { _cfg = cfg; }
+    void updateConfig(const Config& cfg);
+    const Config& config() const { return _cfg; }
+
+    // Where events go. Controllers sharing a ring must all be updated from
+    // the same task, which is then its only producer.
+    void setEventSink(FeedArmEventRing* sink) { _events = sink; }
+
+    // Feed channel number, stamped on events and recorder entries.
+    void setChannel(uint8_t channel) { _channel = channel; }
+    uint8_t channel() const { return _channel; }
+
+    // Replace the detector chosen by Config::jamDetector (nullptr restores
+    // it). The controller doesn't own it.
+    void setJamDetector(JamDetector* detector);
+    const JamDetector& jamDetector() const { return *_detector; }
+
+    // Optional flight recorder: gets reed pulses and state changes, and is
+    // triggered on every UNSTICKING transition.
+    void setRecorder(FlightRecorder* rec) { _recorder = rec; }
 
     // Stats.
     uint32_t unstickCount() const { return _unstickCount; }
+    const UnstickLadder& unstickLadder() const { return _ladder; }
+    void clearUnstickStats() { _ladder.clear(); }
     bool filamentStalled() const { return _filamentStalled; }
     float filamentPulsesPerSec() const;
 
+    // Odometry from the guide wheel: feed rate (mm/s), filament used since
+    // boot and in the current print (mm), prints seen.
+    float filamentSpeed() const;
+    float filamentUsedMm() const;
+    float printUsedMm() const;
+    uint32_t printCount() const { return _odometer.prints(); }
+    void startPrint() { _odometer.startPrint(); }
+
+    // The printer's latest report. While one is fresh (printerLinkTimeoutMs)
+    // the filament is judged stalled by the feed the printer commanded
+    // since the last wheel pulse instead of by pulse timing.
+    void setPrinterFeed(const PrinterFeed& feed);
+    // Commanded feed (mm/s), or -1 with no fresh report.
+    float expectedFeed() const;
+    // Commanded since the last wheel pulse (mm).
+    float feedSincePulseMm() const { return _feedSincePulseMm; }
+
     // Pot calibration helpers.
     uint16_t rawFeedPot() const { return _rawFeedPot; }
     uint16_t rawTensionPot() const { return _rawTensionPot; }
 
 private:
     void transitionTo(FeedArmState newState);
+    void enterState();
+    void confirmUnstick(bool byReed);
+    bool reedResumed() const;
+    void emit(FeedArmEventType type, float a = 0, float b = 0, uint32_t n = 0,
+              bool flag = false);
+    void recordReed();
+    void selectDetector();
+    void selectFilters();
     bool isJamDetected();
-    float readPotAngle(uint8_t pin, uint16_t adcMin, uint16_t adcMax);
+    void trackTension(uint32_t now);
+    void updateSpectrum();
+    void updateStall(uint32_t now);
+    bool printerKnown(uint32_t now) const;
+    void configureReed();
+    void updateCalibration(uint32_t now);
+    void startCalibrationStep();
+    void finishCalibration();
+
+    float readPotAngle(uint8_t pin, const PotTable& table, SignalFilter* filter);
     uint16_t readPotSmoothed(uint8_t pin);
 
     Config _cfg;
     ReedSwitch* _reed = nullptr;
+    FeedArmEventRing* _events = nullptr;
+    FlightRecorder* _recorder = nullptr;
+    uint8_t _channel = 0;
 
-    Servo _feedServo;
-    Servo _tensionServo;
+    ThresholdJamDetector _thresholdDetector;
+    TrajectoryJamDetector _trajectoryDetector;
+    JamDetector* _customDetector = nullptr;
+    JamDetector* _detector = &_trajectoryDetector;
+
+    FilterBank _feedFilters;
+    FilterBank _tensionFilters;
+    FilterBank _reedFilters;
+    SignalFilter* _feedFilter = nullptr;
+    SignalFilter* _tensionFilter = nullptr;
+    SignalFilter* _reedFilter = nullptr;
+    bool _filtersSelected = false;
+    SignalFilterType _potFilterType = SignalFilterType::NONE;
+    SignalFilterType _reedFilterType = SignalFilterType::NONE;
+    PotTable _feedTable;
+    PotTable _tensionTable;
+    TensionModel _tensionModel;
+    uint64_t _recordedPulseUs = 0;
+    uint32_t _recordedPulses = 0;
+
+    Clock* _clock = nullptr;
+    PotInput* _pots = nullptr;
+    ServoOutput* _feedServo = nullptr;
+    ServoOutput* _tensionServo = nullptr;
     uint8_t _feedServoPin = 0;
     uint8_t _tensionServoPin = 0;
     uint8_t _feedPotPin = 0;
     uint8_t _tensionPotPin = 0;
     bool _feedServoAttached = false;
+    ServoMotion _feedMotion;
+    UnstickLadder _ladder;
+    FilamentOdometer _odometer;
+    TensionTracker _tracker;
+    ArmSpectrum _spectrum;
+    bool _wobbling = false;           // spectrum anomaly at or over 1
+
+    PrinterFeed _printer = { PrinterActivity::UNKNOWN, 0 };
+    uint32_t _printerAt = 0;
+    uint32_t _stallCheckedAt = 0;
+    uint32_t _feedPulseBase = 0;      // reed count the feed below is counted from
+    float _feedSincePulseMm = 0;
 
     FeedArmState _state = FeedArmState::MONITORING;
     float _feedArmAngle = 90.0f;      // actual angle from pot
     float _tensionArmAngle = 80.0f;   // actual angle from pot
+    float _filamentTension = 0;       // N, from both pots
     float _tensionAngle = 80.0f;      // commanded tension angle
+    float _baseTensionAngle = 80.0f;  // operator's setting; tracking only adds to it
     float _savedTensionAngle = 80.0f; // tension angle saved before relaxing for unstick
     uint16_t _rawFeedPot = 0;
     uint16_t _rawTensionPot = 0;
 
     uint32_t _stateEnteredAt = 0;
+    uint32_t _unstickStartedAt = 0;
+    uint8_t _stage = 0;               // ladder stage of the current attempt
+    uint8_t _firstStage = 0;          // where this jam's run started
+    uint8_t _shakeLegs = 0;           // shake moves still to make
+    bool _escalating = false;         // next UNSTICKING continues the run
+    bool _attemptJudged = false;
+    uint32_t _unstickPulseBase = 0;   // reed count when the unstick began
+    uint32_t _atTargetSince = 0;
+    bool _atTarget = false;
+    bool _unstickConfirmed = false;
     uint32_t _unstickCount = 0;
     bool _filamentStalled = false;
 
-    uint32_t _lastReedSampleTime = 0;
+    // Servo sweep. Steps 0..2n-1 visit the points up and back down; the
+    // last step returns the arm to rest.
+    uint8_t _calStep = 0;
+    bool _calSampling = false;
+    uint32_t _calSince = 0;           // move finished / sampling started
+    uint8_t _calTicks = 0;
+    uint32_t _calFeedSum[kPotCalPoints] = {};
+    uint32_t _calTensionSum[kPotCalPoints] = {};
+    PotSweepResult _calResult = {};
+    bool _calReady = false;
 };
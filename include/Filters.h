@@ -0,0 +1,249 @@
+#pragma once
+
+#include <cstdint>
+#include "Config.h"
+
+// Header-only fixed-point signal filters.
+// Every stage takes and returns int32_t samples (ADC counts, or any scaled
+// integer), keeps its state inline and never allocates. Stages are composed
+// at compile time with FilterChain:
+//
+//   FilterChain<HampelFilter<7>, OnePoleIir<2>> f;
+//   int32_t y = f.push(raw);
+//
+// SignalFilter wraps a chain behind a virtual push() so the controller can
+// pick one from Config at runtime (FilterBank below).
+
+// Sliding mean of the last N samples, running sum.
+template <uint8_t N>
+class MovingAverage {
+    static_assert(N >= 1, "MovingAverage needs N >= 1");
+
+public:
+    int32_t push(int32_t x) {
+        if (_count == N) {
+            _sum -= _ring[_pos];
+        } else {
+            _count++;
+        }
+        _ring[_pos] = x;
+        _sum += x;
+        _pos = (_pos + 1) % N;
+        // Round to nearest rather than truncate toward zero.
+        return (int32_t)((_sum + (_sum >= 0 ? _count / 2 : -(int32_t)(_count / 2))) / (int32_t)_count);
+    }
+
+    void reset() { _sum = 0; _pos = 0; _count = 0; }
+
+private:
+    int32_t _ring[N] = {};
+    int32_t _sum = 0;
+    uint8_t _pos = 0;
+    uint8_t _count = 0;
+};
+
+// Median of the last N samples (N odd). Insertion sort on a copy; meant for
+// small windows.
+template <uint8_t N>
+class MedianFilter {
+    static_assert(N % 2 == 1 && N <= 15, "MedianFilter needs odd N <= 15");
+
+public:
+    int32_t push(int32_t x) {
+        _ring[_pos] = x;
+        _pos = (_pos + 1) % N;
+        if (_count < N) _count++;
+        int32_t s[N];
+        sort(_ring, _count, s);
+        return s[_count / 2];
+    }
+
+    void reset() { _pos = 0; _count = 0; }
+
+    // Sorted copy of the first n values of v.
+    static void sort(const int32_t* v, uint8_t n, int32_t* s) {
+        for (uint8_t i = 0; i < n; i++) {
+            int32_t x = v[i];
+            uint8_t j = i;
+            while (j > 0 && s[j - 1] > x) {
+                s[j] = s[j - 1];
+                j--;
+            }
+            s[j] = x;
+        }
+    }
+
+private:
+    int32_t _ring[N] = {};
+    uint8_t _pos = 0;
+    uint8_t _count = 0;
+};
+
+// y += (x - y) / 2^Shift, with 8 fractional bits of state so small steps
+// aren't lost to truncation. Shift 1 ~ alpha 0.5, 2 ~ 0.25, 3 ~ 0.125.
+template <uint8_t Shift>
+class OnePoleIir {
+    static_assert(Shift >= 1 && Shift <= 8, "OnePoleIir Shift must be 1..8");
+
+public:
+    int32_t push(int32_t x) {
+        int32_t xq = x * 256;
+        if (!_primed) {
+            _acc = xq;
+            _primed = true;
+        } else {
+            _acc += (xq - _acc) >> Shift;
+        }
+        return (_acc + 128) >> 8;
+    }
+
+    void reset() { _primed = false; }
+
+private:
+    int32_t _acc = 0;
+    bool _primed = false;
+};
+
+// Hampel outlier rejector over the last N samples (N odd): a sample further
+// than K * MAD from the window median is replaced by the median. KQ8 is
+// K * 1.4826 (MAD -> sigma) in Q8, default 3 sigma. MinDev keeps a
+// quantised, perfectly steady signal (MAD 0) from flagging every 1-count step.
+template <uint8_t N, uint16_t KQ8 = 1139, uint8_t MinDev = 3>
+class HampelFilter {
+    static_assert(N % 2 == 1 && N >= 3 && N <= 15, "HampelFilter needs odd N in 3..15");
+
+public:
+    int32_t push(int32_t x) {
+        _ring[_pos] = x;
+        _pos = (_pos + 1) % N;
+        if (_count < N) _count++;
+        if (_count < 3) return x;
+
+        int32_t s[N];
+        MedianFilter<N>::sort(_ring, _count, s);
+        uint8_t mid = _count / 2;
+        int32_t med = s[mid];
+
+        // MAD without a second sort: deviations grow outward from the median
+        // on both sides of the sorted window, so merge the two runs until
+        // the middle one is reached.
+        int8_t lo = mid - 1;
+        uint8_t hi = mid + 1;
+        int32_t mad = 0;
+        for (uint8_t k = 0; k < mid; k++) {
+            int32_t dl = lo >= 0 ? med - s[lo] : INT32_MAX;
+            int32_t dh = hi < _count ? s[hi] - med : INT32_MAX;
+            if (dl <= dh) {
+                mad = dl;
+                lo--;
+            } else {
+                mad = dh;
+                hi++;
+            }
+        }
+
+        int32_t d = x - med;
+        if (d < 0) d = -d;
+        int32_t limit = (int32_t)(((int64_t)mad * KQ8) >> 8);
+        if (limit < MinDev) limit = MinDev;
+        if (d > limit) {
+            _rejected++;
+            return med;
+        }
+        return x;
+    }
+
+    void reset() { _pos = 0; _count = 0; }
+
+    uint32_t rejected() const { return _rejected; }
+
+private:
+    int32_t _ring[N] = {};
+    uint8_t _pos = 0;
+    uint8_t _count = 0;
+    uint32_t _rejected = 0;
+};
+
+// Compile-time pipeline: each stage's output feeds the next.
+template <typename... Stages>
+class FilterChain;
+
+template <>
+class FilterChain<> {
+public:
+    int32_t push(int32_t x) { return x; }
+    void reset() {}
+};
+
+template <typename First, typename... Rest>
+class FilterChain<First, Rest...> {
+public:
+    int32_t push(int32_t x) { return _rest.push(_first.push(x)); }
+
+    void reset() {
+        _first.reset();
+        _rest.reset();
+    }
+
+private:
+    First _first;
+    FilterChain<Rest...> _rest;
+};
+
+// Runtime handle on a chain.
+class SignalFilter {
+public:
+    virtual ~SignalFilter() = default;
+    virtual int32_t push(int32_t x) = 0;
+    virtual void reset() = 0;
+};
+
+template <typename Chain>
+class ChainFilter : public SignalFilter {
+public:
+    int32_t push(int32_t x) override { return _chain.push(x); }
+    void reset() override { _chain.reset(); }
+
+private:
+    Chain _chain;
+};
+
+// The chains Config can select. One of each is held inline, so switching
+// filters needs no allocation; select() hands out the chosen one, reset.
+using MedianChain = FilterChain<MedianFilter<5>>;
+using IirChain = FilterChain<OnePoleIir<2>>;
+using MedianAverageChain = FilterChain<MedianFilter<3>, MovingAverage<4>>;
+using HampelIirChain = FilterChain<HampelFilter<7>, OnePoleIir<1>>;
+
+class FilterBank {
+public:
+    SignalFilter* select(SignalFilterType type) {
+        SignalFilter* f = nullptr;
+        switch (type) {
+        case SignalFilterType::NONE:           return nullptr;
+        case SignalFilterType::MEDIAN:         f = &_median; break;
+        case SignalFilterType::IIR:            f = &_iir; break;
+        case SignalFilterType::MEDIAN_AVERAGE: f = &_medianAverage; break;
+        case SignalFilterType::HAMPEL_IIR:     f = &_hampelIir; break;
+        }
+        if (f) f->reset();
+        return f;
+    }
+
+private:
+    ChainFilter<MedianChain> _median;
+    ChainFilter<IirChain> _iir;
+    ChainFilter<MedianAverageChain> _medianAverage;
+    ChainFilter<HampelIirChain> _hampelIir;
+};
+
+inline const char* signalFilterName(SignalFilterType type) {
+    switch (type) {
+    case SignalFilterType::NONE:           return "none";
+    case SignalFilterType::MEDIAN:         return "median";
+    case SignalFilterType::IIR:            return "iir";
+    case SignalFilterType::MEDIAN_AVERAGE: return "median-average";
+    case SignalFilterType::HAMPEL_IIR:     return "hampel-iir";
+    }
+    return "?";
+}
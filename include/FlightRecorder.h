@@ -0,0 +1,185 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "Config.h"
+#include "Hal.h"
+
+// Pre/post-trigger flight recorder.
+// Two live rings (PSRAM on the ESP32) hold the last few seconds of history:
+//   - pot stream:     every raw ADC conversion, written by the ADC drain task
+//   - control stream: servo commands, reed pulses and state changes, written
+//                     by the control task
+// Each ring has exactly one producer and overwrites its oldest entries.
+// trigger() marks a moment (every UNSTICKING transition); once the post-trigger
+// time has passed, service() copies the window around it into a frozen
+// capture slot that can be dumped later. Copying happens on the comms core,
+// so the producers never do more than a store and an index bump.
+
+enum class RecordKind : uint8_t {
+    POT,            // ch = pot channel, value = raw ADC
+                    // other kinds: ch = feed channel
+    REED,           // value = pulses since the previous record (saturating)
+    FEED_SERVO,     // value = deci-degrees, kServoDetached = detached
+    TENSION_SERVO,  // same
+    STATE,          // value = FeedArmState
+    TRIGGER         // value = capture sequence number (low 16 bits)
+};
+
+const char* recordKindName(RecordKind kind);
+
+static constexpr uint16_t kServoDetached = 0xffff;
+
+struct RecordSample {
+    uint32_t us;    // low 32 bits of Clock::micros()
+    RecordKind kind;
+    uint8_t ch;
+    uint16_t value;
+};
+
+// One producer, overwrite-oldest. Readers copy out ranges and check
+// afterwards that the producer didn't lap them.
+class SampleLog {
+public:
+    bool begin(void* storage, uint32_t capacity);   // capacity: power of two
+
+    void push(const RecordSample& s) {
+        uint32_t head = _head.load(std::memory_order_relaxed);
+        _buf[head & _mask] = s;
+        _head.store(head + 1, std::memory_order_release);
+    }
+
+    uint32_t head() const { return _head.load(std::memory_order_acquire); }
+    uint32_t capacity() const { return _mask + 1; }
+
+    // Oldest index still in the ring whose sample is at or after fromUs
+    // (samples are in time order per stream). Searches [head - capacity, head).
+    uint32_t findFrom(uint32_t head, uint32_t fromUs) const;
+
+    // Copy [from, to) into out. False if the producer overwrote part of the
+    // range while copying.
+    bool copy(uint32_t from, uint32_t to, RecordSample* out) const;
+
+private:
+    RecordSample* _buf = nullptr;
+    uint32_t _mask = 0;
+    std::atomic<uint32_t> _head{0};
+};
+
+struct RecorderCapture {
+    uint32_t seq;           // 0 = empty slot
+    uint32_t triggerUs;
+    uint32_t potCount;
+    uint32_t ctlCount;
+    bool torn;              // producer lapped the copy; oldest samples suspect
+    RecordSample* pot;
+    RecordSample* ctl;
+};
+
+class FlightRecorder {
+public:
+    typedef void* (*Allocator)(size_t bytes);
+
+    static constexpr uint8_t kMaxCaptures = 8;
+
+    // Sizes the rings from the config's window and pot rate and allocates
+    // everything up front. Returns false (recorder stays disabled) if the
+    // memory isn't there.
+    bool begin(const Config& cfg, uint8_t potChannels, Allocator alloc);
+    bool enabled() const { return _enabled; }
+
+    // --- Producers ---
+    void recordPot(uint8_t ch, uint16_t raw, uint64_t nowUs) {
+        if (_enabled) _pot.push({ (uint32_t)nowUs, RecordKind::POT, ch, raw });
+    }
+    void recordControl(RecordKind kind, uint16_t value, uint64_t nowUs, uint8_t ch = 0) {
+        if (_enabled) _ctl.push({ (uint32_t)nowUs, kind, ch, value });
+    }
+
+    // Control-task side: start a capture around nowUs. Ignored while one is
+    // already waiting for its post-trigger time (that window covers this one).
+    void trigger(uint64_t nowUs);
+
+    // --- Comms side ---
+    // Finalise a pending capture once its post-trigger time has passed.
+    void service(uint64_t nowUs);
+
+    uint8_t captureSlots() const { return _slots; }
+    // Slot i, or nullptr if empty. Slots are reused oldest first.
+    const RecorderCapture* capture(uint8_t i) const;
+
+    // A locked slot is never reused, so it can be dumped in pieces.
+    void lock(int8_t slot) { _locked = slot; }
+
+    uint32_t triggers() const { return _triggers; }
+    uint32_t merged() const { return _merged; }
+    uint32_t preMs() const { return _preMs; }
+    uint32_t postMs() const { return _postMs; }
+
+private:
+    bool _enabled = false;
+    SampleLog _pot;
+    SampleLog _ctl;
+    uint32_t _preMs = 0;
+    uint32_t _postMs = 0;
+
+    RecorderCapture _captures[kMaxCaptures] = {};
+    uint8_t _slots = 0;
+    uint32_t _potCap = 0;       // per capture
+    uint32_t _ctlCap = 0;
+    uint32_t _seq = 0;
+    int8_t _locked = -1;
+
+    // Trigger handoff, control task -> comms.
+    std::atomic<bool> _pending{false};
+    uint32_t _pendingUs = 0;
+    uint32_t _triggers = 0;
+    uint32_t _merged = 0;
+};
+
+// Walks a capture's two streams merged into time order.
+class CaptureReader {
+public:
+    void begin(const RecorderCapture* cap) { _cap = cap; _pi = _ci = 0; }
+    bool next(RecordSample& out);
+
+private:
+    const RecorderCapture* _cap = nullptr;
+    uint32_t _pi = 0;
+    uint32_t _ci = 0;
+};
+
+// Servo decorator that logs every command to the control stream, tagged
+// with the feed channel it belongs to.
+class RecordingServo : public ServoOutput {
+public:
+    void begin(ServoOutput* inner, FlightRecorder* rec, Clock* clock, RecordKind kind,
+               uint8_t ch = 0) {
+        _inner = inner;
+        _rec = rec;
+        _clock = clock;
+        _kind = kind;
+        _ch = ch;
+    }
+
+    bool attach(uint8_t pin, uint16_t minUs, uint16_t maxUs) override {
+        return _inner->attach(pin, minUs, maxUs);
+    }
+    void detach() override {
+        _inner->detach();
+        _rec->recordControl(_kind, kServoDetached, _clock->micros(), _ch);
+    }
+    bool attached() const override { return _inner->attached(); }
+    void write(float angle) override {
+        _inner->write(angle);
+        _rec->recordControl(_kind, (uint16_t)(angle * 10.0f + 0.5f), _clock->micros(), _ch);
+    }
+
+private:
+    ServoOutput* _inner = nullptr;
+    FlightRecorder* _rec = nullptr;
+    Clock* _clock = nullptr;
+    RecordKind _kind = RecordKind::FEED_SERVO;
+    uint8_t _ch = 0;
+};
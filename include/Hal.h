@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+
+// Hardware abstraction for the control code.
+// FeedArmController and ReedSwitch only see these interfaces. The ESP32 build
+// backs them with esp_timer, the continuous ADC, LEDC servo PWM and GPIO
+// interrupts (Esp32Hal.h); the native build backs them with the simulator
+// (src/sim/), which drives a virtual clock.
+
+// Monotonic time source.
+class Clock {
+public:
+    virtual ~Clock() = default;
+
+    virtual uint32_t millis() = 0;
+    virtual uint64_t micros() = 0;
+
+    // Blocking wait. Only used during begin(), never from the control tick.
+    virtual void delayMs(uint32_t ms) = 0;
+};
+
+// Smoothed potentiometer readings, one channel per pin.
+class PotInput {
+public:
+    virtual ~PotInput() = default;
+
+    // Start sampling the given pins. sampleRateHz is per channel;
+    // window is the number of samples averaged.
+    virtual bool begin(const uint8_t* pins, uint8_t count, uint32_t sampleRateHz,
+                       uint8_t window) = 0;
+
+    // Index of a pin passed to begin(), or -1.
+    virtual int channelIndex(uint8_t pin) const = 0;
+
+    // Newest filtered reading (12-bit ADC counts).
+    virtual uint16_t read(uint8_t ch) = 0;
+
+    virtual void setWindow(uint8_t window) = 0;
+};
+
+// One controller's view of a PotInput that samples several channels' pots.
+// The owner starts the shared input once with every pin; begin() here only
+// checks that this controller's pins are among them. The averaging window
+// is the shared input's, so setWindow() applies to every channel.
+class SharedPotInput : public PotInput {
+public:
+    void setSource(PotInput* source) { _source = source; }
+
+    bool begin(const uint8_t* pins, uint8_t count, uint32_t sampleRateHz,
+               uint8_t window) override {
+        (void)sampleRateHz;
+        (void)window;
+        if (!_source) return false;
+        for (uint8_t i = 0; i < count; i++) {
+            if (_source->channelIndex(pins[i]) < 0) return false;
+        }
+        return true;
+    }
+    int channelIndex(uint8_t pin) const override { return _source->channelIndex(pin); }
+    uint16_t read(uint8_t ch) override { return _source->read(ch); }
+    void setWindow(uint8_t window) override { _source->setWindow(window); }
+
+private:
+    PotInput* _source = nullptr;
+};
+
+// Hobby servo on a PWM pin.
+class ServoOutput {
+public:
+    virtual ~ServoOutput() = default;
+
+    virtual bool attach(uint8_t pin, uint16_t minUs, uint16_t maxUs) = 0;
+    virtual void detach() = 0;
+    virtual bool attached() const = 0;
+
+    // Commanded angle in degrees.
+    virtual void write(float angle) = 0;
+};
+
+// Edge interrupt callback. The timestamp is taken by the platform as close
+// to the edge as possible, in the same time base as Clock::micros().
+typedef void (*EdgeCallback)(void* arg, uint64_t nowUs);
+
+// Digital inputs with edge interrupts.
+class EdgeInput {
+public:
+    virtual ~EdgeInput() = default;
+
+    virtual bool attachFalling(uint8_t pin, bool pullup, EdgeCallback cb, void* arg) = 0;
+    // Both edges, for quadrature sensors.
+    virtual bool attachChange(uint8_t pin, bool pullup, EdgeCallback cb, void* arg) = 0;
+
+    // Current pin level. Not for edge callbacks: on the ESP32 they run from
+    // IRAM and this is a virtual call into flash.
+    virtual bool level(uint8_t pin) = 0;
+};
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstdint>
+#include "Config.h"
+#include "FeedArmController.h"
+
+// Decides when the board may slow down between prints (Config::lowPower).
+// Fed once per control tick with every channel's state, the board idles
+// after idleAfterMs in which every arm sat in MONITORING, no wheel moved,
+// no arm moved more than idleWakeDeg from where it settled, and the
+// printer (if linked) wasn't printing. While idle the control tick runs
+// every idleTickMs instead of monitorIntervalMs; any one of those
+// conditions breaking ends it at once. A reed edge also ends it between
+// ticks (wake()), which is what lets the board sleep through the gaps.
+//
+// Portable: the ESP32 control task and the simulator use the same policy.
+// Wake latency (wake to first fresh pot sample) is measured by the platform
+// and kept here against wakeBudgetUs.
+
+enum class WakeReason : uint8_t {
+    NONE,
+    REED,           // a wheel pulse
+    ARM_MOVED,      // an arm left its settled angle (the pot path)
+    STATE,          // a controller left MONITORING
+    PRINTER,        // the printer's host reported printing, or spoke up
+    COMMAND,        // operator
+    COUNT
+};
+
+const char* wakeReasonName(WakeReason reason);
+
+// One channel's view for one tick.
+struct IdleInput {
+    FeedArmState state;
+    uint32_t pulses;            // wheel pulse count
+    float armDeg;               // feed arm angle
+    PrinterActivity printer;    // UNKNOWN with no link
+};
+
+struct WakeStats {
+    uint32_t wakes[(uint8_t)WakeReason::COUNT];
+    uint32_t latencySamples;
+    uint32_t lastLatencyUs;
+    uint32_t worstLatencyUs;
+    uint64_t totalLatencyUs;
+    uint32_t overBudget;        // wakes slower than wakeBudgetUs
+    uint64_t idleMs;            // total time idle
+    uint32_t idleEntries;
+};
+
+class IdleMonitor {
+public:
+    void configure(const Config& cfg);
+
+    // One tick's inputs for count channels. Returns idle().
+    bool update(uint32_t nowMs, const IdleInput* in, uint8_t count);
+
+    // End an idle stretch between ticks (reed edge, UART, command).
+    void wake(WakeReason reason, uint32_t nowMs);
+
+    bool idle() const { return _idle; }
+    WakeReason lastWake() const { return _lastWake; }
+
+    // Control tick period for the current mode.
+    uint32_t tickMs() const { return _idle ? _cfg.idleTickMs : _cfg.monitorIntervalMs; }
+
+    // Platform-measured wake-to-first-sample latency.
+    void recordWakeLatency(uint32_t us);
+
+    const WakeStats& stats() const { return _stats; }
+    void clearStats();
+
+    // The last idle entry or wake (IDLE_ENTERED / IDLE_WOKE) not yet taken,
+    // for the caller's event ring. On the board this runs on the control
+    // task, which never formats text.
+    bool takeEvent(FeedArmEvent& out);
+
+private:
+    void enter(uint32_t nowMs);
+    void leave(WakeReason reason, uint32_t nowMs);
+    void settle(uint32_t nowMs, const IdleInput* in, uint8_t count);
+
+    Config _cfg;
+    bool _idle = false;
+    bool _settled = false;
+    uint32_t _quietSinceMs = 0;
+    uint32_t _idleSinceMs = 0;
+    WakeReason _lastWake = WakeReason::NONE;
+
+    uint32_t _pulses[kMaxFeedChannels] = {};
+    float _restDeg[kMaxFeedChannels] = {};
+
+    WakeStats _stats = {};
+    FeedArmEvent _event = {};
+    bool _eventPending = false;
+};
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstdint>
+#include "Config.h"
+
+// Jam detection stage.
+// FeedArmController feeds a detector one sample per control tick while it is
+// MONITORING (servo detached, arm floating) and unsticks when it says so.
+// Detectors are reset whenever monitoring resumes, since the arm has just
+// been driven by the servo.
+
+// Which rule fired, for the jam journal (JamJournal.h).
+enum class JamPath : uint8_t {
+    NONE,
+    ANGLE,          // arm at or below feedArmJamAngle
+    TENSION,        // estimated tension at or above jamTensionN
+    STALL,          // reed stalled with the arm well below rest
+    TRAJECTORY,     // below the learned breakaway level
+    MANUAL          // 'u', not a detector
+};
+
+const char* jamPathName(JamPath path);
+
+// True if b changes a setting the detectors read (or which one runs).
+// Other config edits leave them, and their settle window, alone.
+bool jamDetectorConfigChanged(const Config& a, const Config& b);
+
+struct JamInputs {
+    uint32_t nowMs;
+    float angle;            // feed arm, degrees (pot)
+    float tension;          // filament, N (TensionModel, both pots)
+    bool stalled;           // reed: no pulse within the adaptive stall window, or
+                            // with the printer link up, more feed commanded
+                            // since the last pulse than the wheel accounts for
+    uint32_t msSinceReed;   // reed: time since the newest pulse
+    float pulsesPerSec;     // reed: rolling rate
+    float wobble;           // arm spectrum anomaly (ArmSpectrum.h), 1.0 = flagged
+};
+
+class JamDetector {
+public:
+    virtual ~JamDetector() = default;
+
+    virtual void reset(const Config& cfg) = 0;
+
+    // One tick. Returns true when a jam should be acted on.
+    virtual bool update(const JamInputs& in) = 0;
+
+    // How sure the detector is, where 1.0 is its trigger point.
+    virtual float confidence() const = 0;
+
+    virtual const char* name() const = 0;
+
+    // The rule behind the last true from update().
+    virtual JamPath path() const { return JamPath::NONE; }
+};
+
+// The original rule: angle at or below the jam threshold (or tension at or
+// above jamTensionN, if set), or reed stalled with the arm well below rest.
+class ThresholdJamDetector : public JamDetector {
+public:
+    void reset(const Config& cfg) override;
+    bool update(const JamInputs& in) override;
+    float confidence() const override { return _confidence; }
+    const char* name() const override { return "threshold"; }
+    JamPath path() const override { return _path; }
+
+private:
+    Config _cfg;
+    float _confidence = 0;
+    JamPath _path = JamPath::NONE;
+};
+
+// Tracks the arm's trajectory instead of a fixed angle.
+// In normal printing the spool stick-slips: while it sticks, the extruder
+// draws the arm down; once filament tension reaches the spool's breakaway
+// drag the spool jerks free and the arm snaps back up. A snag is the same
+// descent that never snaps back. So the detector:
+//   - runs an alpha-beta filter for angle and angular velocity,
+//   - marks each breakaway (fast upward swing) and learns the angle the arm
+//     had fallen to just before it, the breakaway level,
+//   - scores how far the arm is below that level (and where it will be a
+//     short horizon ahead) in units of a margin.
+// The reed weighs the evidence: filament still turning the wheel discounts
+// it, a wobble in the arm's spectrum (a tangle catching once a revolution)
+// adds to it. The threshold rule always runs alongside as a backstop, and is all
+// there is until a breakaway has been seen and for a settle time after each
+// reset, while the tension servo re-tensions the spring.
+class TrajectoryJamDetector : public JamDetector {
+public:
+    void reset(const Config& cfg) override;
+    bool update(const JamInputs& in) override;
+    float confidence() const override { return _confidence; }
+    const char* name() const override { return "trajectory"; }
+    JamPath path() const override { return _path; }
+
+    // Forget the learned breakaway level too (new spool, new tension).
+    void relearn();
+
+    float angle() const { return _angle; }
+    float velocity() const { return _velocity; }    // deg/s, negative = dropping
+    bool learned() const { return _floorValid; }
+    float breakawayAngle() const { return _floor; }
+
+private:
+    Config _cfg;
+    ThresholdJamDetector _fallback;
+    bool _primed = false;
+    uint32_t _lastMs = 0;
+    uint32_t _settleUntilMs = 0;
+    float _angle = 0;
+    float _velocity = 0;
+    float _confidence = 0;
+    JamPath _path = JamPath::NONE;
+
+    // Breakaway learning. Survives reset(): an unstick doesn't change the
+    // spool's drag.
+    bool _slipping = false;
+    float _troughMin = 0;
+    bool _floorValid = false;
+    float _floor = 0;
+};
@@ -0,0 +1,246 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "Config.h"
+#include "FeedArmController.h"
+#include "Hal.h"
+
+// Persistent jam journal.
+// Every jam (and every manual unstick) becomes one compact record, kept on
+// flash across reboots so the host can ask which spool jams most, or
+// whether jams cluster as a spool runs out. The comms side builds records
+// from the controller's events (JamTracker), queues them in RAM and flushes
+// them once the board is idle (JamJournal::flush()): a flash write stalls
+// the control task too, so nothing is written while filament is moving.
+//
+// Storage is a ring of kJournalSegments append-only segments. The oldest is
+// erased when the newest fills. Each segment is self-contained:
+//   u32 magic 'FFXJ', u8 version, u32 sequence (the newest has the highest)
+//   records back to back, each [u8 kind | channel << 4][fields]:
+//     SESSION  varint boot                      first in every segment and
+//                                               after each boot; resets deltas
+//     SPOOL    varint tag, varint metres used    tag set, or every
+//                                               kJournalSpoolCheckpointM
+//     JAM      varint seconds since the previous JAM's (this session),
+//              u8 path << 4 | outcome, varint attempts,
+//              zigzag varint print number - the channel's previous JAM's,
+//              varint cm into the print, varint spool tag, varint spool m,
+//              varint arm deci-degrees, varint tension deci-degrees,
+//              varint centiseconds to clear
+// Varints are LEB128: 7 bits a byte, low bits first. A typical JAM record
+// is 15-18 bytes. A record cut short at the end of a segment (power lost
+// mid-append) is dropped by the decoder, and the journal never appends
+// after one: the next boot, or the next write after a failed append,
+// starts a new segment.
+
+static constexpr uint8_t kJournalVersion = 1;
+static constexpr uint8_t kJournalSegments = 8;
+static constexpr size_t kJournalSegmentBytes = 8192;
+static constexpr size_t kJournalHeaderBytes = 9;
+static constexpr uint32_t kJournalSpoolCheckpointM = 10;
+
+enum class JamOutcome : uint8_t {
+    FREED,          // confirmed by the pot
+    FREED_BY_REED,  // confirmed by the wheel turning again
+    GAVE_UP,        // every stage failed
+    INTERRUPTED     // back to monitoring without a verdict
+};
+
+const char* jamOutcomeName(JamOutcome outcome);
+
+struct JamRecord {
+    uint8_t channel;
+    uint32_t boot;          // journal session the jam happened in
+    uint32_t uptimeS;       // seconds since that boot
+    JamPath path;
+    JamOutcome outcome;
+    uint8_t attempts;       // unstick stages tried
+    uint32_t print;         // print number since boot (odometer)
+    uint32_t printMm;       // filament into that print (10 mm steps)
+    uint16_t spoolTag;      // operator's label for the loaded spool
+    uint32_t spoolM;        // filament used from it (m)
+    float armDeg;           // feed arm when the jam fired: its lowest point
+    float tensionDeg;       // tension servo setting
+    uint32_t clearMs;       // jam to monitoring again (10 ms steps)
+};
+
+enum class JournalKind : uint8_t {
+    SESSION = 1,
+    SPOOL = 2,
+    JAM = 3
+};
+
+struct JournalEntry {
+    JournalKind kind;
+    uint8_t channel;
+    uint32_t boot;          // SESSION
+    uint16_t spoolTag;      // SPOOL
+    uint32_t spoolM;        // SPOOL
+    JamRecord jam;          // JAM
+};
+
+// Delta bases, reset by every SESSION entry.
+struct JournalDeltas {
+    uint32_t uptimeS;
+    uint32_t print[kMaxFeedChannels];
+};
+
+// Append one entry's bytes to out (room for kJournalMaxEntry). Returns the
+// count written.
+static constexpr size_t kJournalMaxEntry = 48;
+size_t encodeJournalEntry(const JournalEntry& e, JournalDeltas& deltas, uint8_t* out);
+
+// One line of a dump, "J <segment> <hex>\n": segments in order oldest
+// first, each cut into lines of kJournalDumpBytes. The host summariser
+// (program journal) joins the lines back into segments.
+static constexpr size_t kJournalDumpBytes = 48;
+static constexpr size_t kJournalDumpLine = 8 + kJournalDumpBytes * 2;
+int formatJournalDumpLine(uint8_t segment, const uint8_t* data, size_t len, char* out);
+
+void encodeJournalHeader(uint32_t sequence, uint8_t* out);
+// False unless the bytes start with a current-version header.
+bool decodeJournalHeader(const uint8_t* data, size_t len, uint32_t& sequence);
+
+// Walks the entries of one segment's bytes (header included).
+class JournalDecoder {
+public:
+    bool begin(const uint8_t* data, size_t len);
+    bool next(JournalEntry& out);
+
+    uint32_t sequence() const { return _sequence; }
+    bool truncated() const { return _truncated; }  // stopped on a partial entry
+    size_t framed() const { return _framed; }      // header and whole entries
+
+private:
+    bool varint(uint32_t& out);
+
+    const uint8_t* _data = nullptr;
+    size_t _len = 0;
+    size_t _pos = 0;
+    size_t _framed = 0;
+    uint32_t _sequence = 0;
+    bool _truncated = false;
+    JournalDeltas _deltas = {};
+};
+
+// Builds one record per jam from a channel's events.
+// What the events don't carry comes from the caller's latest status.
+struct JamContext {
+    uint32_t uptimeS;
+    float armDeg;           // for manual unsticks (no jam angle)
+    float tensionDeg;
+    uint32_t print;
+    float printMm;
+};
+
+class JamTracker {
+public:
+    // True when ev closed a jam; the record (without boot or spool) is in out.
+    bool onEvent(const FeedArmEvent& ev, const JamContext& ctx, JamRecord& out);
+
+    bool open(uint8_t channel) const { return channel < kMaxFeedChannels && _open[channel].active; }
+
+private:
+    struct Open {
+        bool active;
+        bool freed;
+        bool byReed;
+        bool gaveUp;
+        uint32_t startMs;
+        JamRecord rec;
+    };
+    Open _open[kMaxFeedChannels] = {};
+};
+
+// Where segments live: LittleFS on the ESP32.
+class JournalStorage {
+public:
+    virtual ~JournalStorage() = default;
+
+    virtual size_t size(uint8_t segment) = 0;      // 0 if absent
+    virtual size_t read(uint8_t segment, size_t offset, void* buf, size_t len) = 0;
+    virtual bool append(uint8_t segment, const void* buf, size_t len) = 0;
+    virtual bool erase(uint8_t segment) = 0;
+};
+
+class JamJournal {
+public:
+    // Holds a print's worth: jams, plus one pending checkpoint per spool.
+    static constexpr uint8_t kQueueDepth = 64;
+
+    // Scans the stored segments for the newest, the last boot number and
+    // each channel's spool. This boot's SESSION goes out with the first
+    // flush.
+    void begin(JournalStorage* storage, Clock* clock);
+
+    // --- Comms side ---
+    // Queue a finished jam; boot and spool are filled in here. False (and
+    // counted) if the queue is full.
+    bool record(const JamRecord& jam);
+
+    // A new spool on a channel: its odometer starts over under this tag.
+    void setSpool(uint8_t channel, uint16_t tag);
+    // Filament fed on a channel since the last call (mm).
+    void addFilament(uint8_t channel, float mm);
+    uint16_t spoolTag(uint8_t channel) const { return _spool[channel].tag; }
+    uint32_t spoolM(uint8_t channel) const { return (uint32_t)(_spool[channel].mm / 1000.0f); }
+
+    // Write everything queued. Flash writes stall code running from flash
+    // on both cores, so call this only while idle. Returns the entries written.
+    uint8_t flush();
+    uint8_t pending() const { return _count; }
+
+    // Drop every segment and start over.
+    void erase();
+
+    // Stored segments oldest first, for dumping.
+    uint8_t segmentsUsed() const { return _used; }
+    size_t segmentSize(uint8_t index);
+    size_t readSegment(uint8_t index, size_t offset, void* buf, size_t len);
+
+    uint32_t boot() const { return _boot; }
+    uint32_t storedJams() const { return _storedJams; }
+    uint32_t storedBytes() const { return _storedBytes; }
+    uint32_t dropped() const { return _dropped; }
+    uint32_t writeErrors() const { return _writeErrors; }
+    uint32_t lastFlushUs() const { return _lastFlushUs; }
+    uint32_t worstFlushUs() const { return _worstFlushUs; }
+
+private:
+    struct Spool {
+        uint16_t tag;
+        float mm;
+        uint32_t checkpointM;   // last SPOOL entry written
+    };
+
+    bool push(const JournalEntry& e);
+    void replay(const JournalEntry& e);
+    bool write(const JournalEntry& e);
+    bool append(const uint8_t* data, size_t len);
+    bool startSegment();
+    uint8_t physical(uint8_t index) const;
+
+    JournalStorage* _storage = nullptr;
+    Clock* _clock = nullptr;
+    uint8_t _current = 0;           // segment being appended to
+    uint8_t _used = 0;              // segments holding data, newest = _current
+    uint32_t _sequence = 0;
+    size_t _currentBytes = 0;
+    bool _sessionWritten = false;   // this boot's SESSION is in _current
+    bool _torn = false;             // _current ends in a partial entry
+    JournalDeltas _deltas = {};
+    uint32_t _boot = 0;
+    Spool _spool[kMaxFeedChannels] = {};
+
+    JournalEntry _queue[kQueueDepth];
+    uint8_t _count = 0;
+
+    uint32_t _storedJams = 0;
+    uint16_t _segmentJams[kJournalSegments] = {};
+    uint32_t _storedBytes = 0;
+    uint32_t _dropped = 0;
+    uint32_t _writeErrors = 0;
+    uint32_t _lastFlushUs = 0;
+    uint32_t _worstFlushUs = 0;
+};
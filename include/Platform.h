@@ -0,0 +1,20 @@
+#pragma once
+
+// The few Arduino-isms the portable control code relies on, so it builds
+// unchanged for the native target.
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#else
+#include <cstdint>
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+
+#ifndef constrain
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#endif
+#endif
+
+// printf-style log line. Serial on the ESP32, stdout (or nothing) on the host.
+void logPrintf(const char* fmt, ...) __attribute__((format(printf, 1, 2)));
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <Arduino.h>
+#include "FlightRecorder.h"
+#include "Hal.h"
+
+// Continuous-mode ADC sampler for the arm potentiometers.
+// The ADC1 digital controller scans every registered pin at a fixed rate and
+// DMAs the conversions into a driver-owned pool. A background task drains that
+// pool into a per-channel ring buffer and keeps a running windowed sum, so the
+// newest filtered reading is available in O(1) without touching the ADC.
+// If the DMA engine can't start, read() falls back to a burst of analogRead().
+// One sampler serves every feed channel: the scan pattern interleaves all
+// the pots, and each controller reads its own through a SharedPotInput.
+
+class PotSampler : public PotInput {
+public:
+    static constexpr uint8_t kMaxChannels = 8;  // two pots per feed channel
+    static constexpr uint16_t kRingSize = 64;   // samples per channel, power of two
+
+    // Start continuous conversion on ADC1-capable pins.
+    // sampleRateHz is per channel; window is the number of samples averaged.
+    bool begin(const uint8_t* pins, uint8_t count, uint32_t sampleRateHz,
+               uint8_t window) override;
+    void end();
+
+    bool running() const { return _running; }
+
+    // Stop and restart the scan around a light sleep, which the DMA doesn't
+    // survive. Readings hold their last values while paused.
+    void pause();
+    void resume();
+    // esp_timer time the first frame after resume() arrived; 0 until then.
+    uint64_t resumedUs() const { return _resumedUs; }
+
+    // Index of a pin in the scan pattern, or -1 if it isn't sampled.
+    int channelIndex(uint8_t pin) const override;
+
+    // Newest windowed mean for a channel (12-bit ADC counts).
+    uint16_t read(uint8_t ch) override;
+
+    // Most recent unfiltered conversion for a channel.
+    uint16_t latestRaw(uint8_t ch) const;
+
+    // Total conversions received on a channel since begin().
+    uint32_t sampleCount(uint8_t ch) const { return _head[ch]; }
+
+    // Change the averaging window (clamped to kRingSize). Applied by the task.
+    void setWindow(uint8_t window) override;
+
+    // DMA pool overflows — the task fell behind and conversions were lost.
+    uint32_t overruns() const { return _overruns; }
+
+    // Also log every raw conversion to the flight recorder's pot stream.
+    // Set before begin(); the drain task is the stream's only producer.
+    void setRecorder(FlightRecorder* rec) { _recorder = rec; }
+
+    // Task body — public for the static trampoline.
+    void drain();
+
+private:
+    bool startDma(uint32_t sampleRateHz);
+    void push(uint8_t ch, uint16_t value);
+    void applyWindow();
+
+    uint8_t _count = 0;
+    uint8_t _pins[kMaxChannels] = {};
+    uint8_t _adcChannel[kMaxChannels] = {};
+    bool _running = false;
+    void* _task = nullptr;
+
+    uint16_t _ring[kMaxChannels][kRingSize] = {};
+    volatile uint32_t _head[kMaxChannels] = {};
+    uint32_t _sum[kMaxChannels] = {};
+    volatile uint16_t _filtered[kMaxChannels] = {};
+
+    uint8_t _window = 8;
+    volatile uint8_t _pendingWindow = 8;
+    volatile uint32_t _overruns = 0;
+
+    FlightRecorder* _recorder = nullptr;
+    uint32_t _conversionUs = 0;     // time between conversions in the scan
+
+    volatile bool _paused = false;
+    volatile bool _resuming = false;
+    volatile uint64_t _resumedUs = 0;
+};
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include "Config.h"
+
+// ADC counts -> feed/tension arm angle in centidegrees (0-16000).
+// The map is kept as its value at every 64th count, so a lookup is one
+// table read and a linear interpolation inside the bin, whether it was
+// built from the two-point range or from a servo sweep's points.
+class PotTable {
+public:
+    static constexpr uint8_t kBinBits = 6;
+    static constexpr int32_t kBinSize = 1 << kBinBits;
+    static constexpr uint16_t kBins = 4096 >> kBinBits;
+
+    // Straight line: adcMin at 0°, adcMax at 160°.
+    void linear(uint16_t adcMin, uint16_t adcMax);
+
+    // Piecewise-linear through the sweep's points, continued past the ends
+    // along the end segments. False (table unchanged) if cal has fewer than
+    // two points or its readings aren't strictly monotonic.
+    bool build(const PotCalibration& cal);
+
+    int32_t centiDegrees(int32_t counts) const {
+        if (counts < 0) counts = 0;
+        if (counts > 4095) counts = 4095;
+        uint32_t bin = (uint32_t)counts >> kBinBits;
+        int32_t lo = _cdeg[bin];
+        int32_t cdeg = lo + (((_cdeg[bin + 1] - lo) * (counts & (kBinSize - 1))) >> kBinBits);
+        return cdeg < 0 ? 0 : cdeg > 16000 ? 16000 : cdeg;
+    }
+
+private:
+    // Unclamped, so bins straddling 0° or 160° interpolate correctly.
+    int32_t _cdeg[kBins + 1] = {};
+};
+
+// A sweep is usable if it has at least two points whose readings move
+// strictly one way.
+bool potCalibrationValid(const PotCalibration& cal);
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <Arduino.h>
+#include "Config.h"
+#include "Esp32Hal.h"
+#include "IdleMonitor.h"
+#include "PotSampler.h"
+
+// ESP32 side of low-power idle (Config::lowPower, IdleMonitor.h).
+// The control task calls it when the board goes idle and when it wakes:
+//   - idle drops the CPU to idleCpuMhz; waking restores the boot clock,
+//   - each idle tick is a light sleep when the comms side allows one (no
+//     USB host, printer link quiet), otherwise a plain block,
+//   - a light sleep ends early on any wheel pin changing level, or on a
+//     byte arriving from the printer. The pot scan is paused across it and
+//     restarted after, and the wait for its first fresh frame is the wake
+//     latency kept against wakeBudgetUs,
+//   - the servo outputs (LEDC moved onto the RC clock while idle,
+//     Esp32ServoOutput) and the status LED keep driving their pins through
+//     the sleep, so the tension servo holds the spring.
+// The ESP32-S3 has no analog comparator to wake on a pot, so arm movement
+// is caught by the idle tick's pot read instead (WakeReason::ARM_MOVED).
+
+class PowerControl {
+public:
+    // holdPins keep their output function through light sleep; uartNum is
+    // the printer link's UART (-1 for none).
+    void begin(const Config& cfg, PotSampler* pots, Esp32EdgeInput* edges,
+               const uint8_t* holdPins, uint8_t holdCount, int uartNum);
+    void configure(const Config& cfg) { _cfg = cfg; }
+
+    // Comms side, every pass: may the chip sleep at all?
+    void allowSleep(bool allow) { _sleepAllowed = allow; }
+    bool sleepAllowed() const { return _sleepAllowed; }
+
+    void enterIdle();
+    void exitIdle();
+
+    // One idle tick. Returns why it ended early (NONE: the tick just came
+    // round); wakeUs is when the CPU was running again.
+    WakeReason waitIdleTick(uint32_t tickUs, uint64_t& wakeUs);
+
+    // After a light sleep: block until the pot scan has delivered fresh
+    // samples. False if nothing was paused (no sleep) or it timed out.
+    bool waitFreshSamples(uint64_t wakeUs, uint32_t& latencyUs);
+
+    uint32_t cpuMhz() const { return getCpuFrequencyMhz(); }
+    uint32_t sleeps() const { return _sleeps; }
+    uint64_t sleptUs() const { return _sleptUs; }
+    // Light sleep exit overhead on timer wakes: CPU back minus the alarm.
+    uint32_t worstExitUs() const { return _worstExitUs; }
+    void clearStats();
+
+private:
+    Config _cfg;
+    PotSampler* _pots = nullptr;
+    Esp32EdgeInput* _edges = nullptr;
+    int _uart = -1;
+    uint32_t _activeMhz = 240;
+    volatile bool _sleepAllowed = false;
+    bool _paused = false;
+
+    uint32_t _sleeps = 0;
+    uint64_t _sleptUs = 0;
+    uint32_t _worstExitUs = 0;
+};
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "CommandShell.h"
+#include "FeedArmController.h"
+
+// Printer link.
+// A line protocol on a spare UART between the controller and the printer's
+// host: a Klipper or Marlin macro, or `program printer` (src/sim/) standing
+// in for one on a PC. The printer reports what the extruder is commanded to
+// do; the controller asks it to hold extrusion while an arm is recovering.
+//
+// Every line is  <type> <seq> [fields]*<xx>  ended by LF (or CR), where xx is
+// the XOR of the bytes before '*' as two hex digits, as in NMEA. Lines that
+// fail the checksum are dropped and counted. Sequence numbers are per sender.
+//
+// Printer -> controller
+//   F <seq> <mm/s> <state> [tool]   commanded E-axis rate (mm/s of filament)
+//                                   and state: I idle, T travel (printing,
+//                                   not extruding), E extruding, P paused.
+//                                   tool is the feed channel drawn from
+//                                   (default 0). Sent at least every
+//                                   printerLinkTimeoutMs / 2.
+//   A <seq>                         acknowledges our H or R <seq>
+// Controller -> printer
+//   K <seq>                         echoes each F in the same poll, so the
+//                                   host can time the round trip
+//   H <seq> <channel>               hold: stop extruding, an arm is recovering
+//   R <seq> <channel>               release: carry on
+// An H or R is resent every printerRetryMs until it is acknowledged, and a
+// newer request replaces an unacknowledged one, so a round trip is bounded
+// by the UART latency plus one retry period.
+
+// One decoded line. fields points into the line that was parsed.
+struct PrinterLinkLine {
+    char type;
+    uint32_t seq;
+    const char* fields;     // past the sequence number, blanks skipped
+};
+
+// Build a line with its checksum and LF into buf. Returns the length, or 0
+// if it doesn't fit.
+size_t formatPrinterLinkLine(char* buf, size_t len, char type, uint32_t seq,
+                             const char* fields);
+
+// Check and split a line (no terminator). False if malformed or the
+// checksum doesn't match. The line's '*' is overwritten.
+bool parsePrinterLinkLine(char* line, PrinterLinkLine& out);
+
+// Controller end of the link. Polled from the comms loop, never the
+// control task.
+class PrinterLink {
+public:
+    // Max bytes consumed per poll(), as for CommandShell.
+    static constexpr uint16_t kBytesPerPoll = 64;
+
+    // writeBytes returns the bytes accepted; a short write drops the line.
+    typedef size_t (*WriteBytes)(void* ctx, const char* data, size_t len);
+
+    void begin(const Config& cfg, CommandShell::ReadByte readByte,
+               WriteBytes writeBytes, void* ctx);
+    void setConfig(const Config& cfg) { _cfg = cfg; }
+
+    // Consume waiting input, answer it and resend an unacknowledged request.
+    void poll(uint32_t nowUs);
+
+    // Follow the controllers' state changes: a channel leaving MONITORING
+    // holds the printer, and it is released once every channel is back.
+    void onEvent(const FeedArmEvent& ev, uint32_t nowUs);
+
+    // Ask for (or drop) a hold on behalf of a channel.
+    void hold(uint8_t channel, bool on, uint32_t nowUs);
+
+    // A report arrived within printerLinkTimeoutMs.
+    bool up(uint32_t nowUs) const;
+
+    // What to hand channel `channel`'s controller: UNKNOWN while the link
+    // is down, IDLE for channels other than the reported tool.
+    PrinterFeed feedFor(uint8_t channel, uint32_t nowUs) const;
+
+    // Reports received so far; a consumer can tell a new one by this.
+    uint32_t reports() const { return _reports; }
+
+    // Hold wanted, and whether the printer has acknowledged the latest ask.
+    bool holding() const { return _holdMask != 0; }
+    bool acknowledged() const { return !_pending; }
+
+    // Request -> acknowledgement time, latest and worst (us).
+    uint32_t lastRttUs() const { return _lastRttUs; }
+    uint32_t worstRttUs() const { return _worstRttUs; }
+    void clearStats();
+
+    uint32_t badLines() const { return _badLines; }
+    uint32_t retries() const { return _retries; }
+    uint32_t droppedLines() const { return _droppedLines; }
+
+private:
+    void handle(char* line, uint32_t nowUs);
+    void sendRequest(uint32_t nowUs);
+    void send(char type, uint32_t seq, const char* fields);
+
+    Config _cfg;
+    CommandShell::ReadByte _readByte = nullptr;
+    WriteBytes _writeBytes = nullptr;
+    void* _ctx = nullptr;
+    LineAssembler _line;
+
+    // Printer side.
+    PrinterActivity _activity = PrinterActivity::UNKNOWN;
+    float _mmPerSec = 0;
+    uint8_t _tool = 0;
+    uint32_t _reportUs = 0;
+    uint32_t _reports = 0;
+
+    // Our hold / release request.
+    uint8_t _holdMask = 0;          // one bit per channel wanting a hold
+    bool _pending = false;          // sent, not yet acknowledged
+    uint32_t _seq = 0;              // of the latest request
+    uint32_t _firstSentUs = 0;
+    uint32_t _lastSentUs = 0;
+    uint8_t _requestChannel = 0;    // named in the request, for the log
+
+    uint32_t _lastRttUs = 0;
+    uint32_t _worstRttUs = 0;
+    uint32_t _badLines = 0;
+    uint32_t _retries = 0;
+    uint32_t _droppedLines = 0;
+};
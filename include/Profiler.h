@@ -0,0 +1,127 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "Platform.h"
+
+// Hot-path profiler.
+// PROFILE_SCOPE(NAME) times the rest of the enclosing block in CPU cycles
+// (ESP.getCycleCount() on the ESP32, steady_clock nanoseconds on the host)
+// and adds it to that scope's histogram. PROFILE_RECORD(NAME, us) adds a
+// measurement taken some other way, such as the control tick's wake-up
+// latency. Build with -D FFX_PROFILE to enable; without it both macros
+// expand to nothing and no histogram exists.
+//
+// Each scope has one writer (the control task or the loop). Readers on the
+// other core may see a histogram mid-update, which only skews one sample.
+
+enum class ProfileScope : uint8_t {
+    CONTROL_TICK,   // every channel's update in one tick
+    ARM_UPDATE,     // FeedArmController::update()
+    POT_READ,       // one readPotSmoothed()
+    TICK_WAKE,      // timer release -> control task running (us)
+    TICK_JITTER,    // |tick start-to-start - period| (us)
+    LOOP_PASS,      // one Arduino loop() pass
+    SHELL_POLL,     // CommandShell::poll()
+    STATUS_PRINT,   // periodic status lines
+    TELEMETRY,      // one tick's telemetry frames
+    PRINTER_LINK,   // PrinterLink::poll() and the feed hand-off
+    SPECTRUM,       // one ArmSpectrum window: detrend, FFT, features
+    COUNT
+};
+
+const char* profileScopeName(ProfileScope scope);
+
+// Summary of one scope, converted to nanoseconds.
+struct ProfileStats {
+    uint32_t count;
+    uint32_t minNs;
+    uint32_t p50Ns;
+    uint32_t p90Ns;
+    uint32_t p99Ns;
+    uint32_t maxNs;
+};
+
+// Log-linear histogram: values below 8 get a bucket each, then every power
+// of two is split into 8 buckets, so a percentile is within 1/16 of the
+// true value over the whole 32-bit range.
+class ProfileHistogram {
+public:
+    static constexpr uint8_t kSubBits = 3;
+    static constexpr uint8_t kSub = 1 << kSubBits;
+    static constexpr uint16_t kBuckets = (32 - kSubBits + 1) * kSub;
+
+    void record(uint32_t value);
+
+    // Ask the writer to start over; it clears before its next record().
+    void requestClear() { _clearPending.store(true, std::memory_order_release); }
+
+    uint32_t count() const { return _count; }
+    uint32_t min() const { return _count ? _min : 0; }
+    uint32_t max() const { return _max; }
+
+    // Midpoint of the bucket holding the p-th fraction (0-1) of samples.
+    uint32_t percentile(float p) const;
+
+private:
+    static uint16_t bucketOf(uint32_t value);
+    static uint32_t bucketLow(uint16_t bucket);
+    void clear();
+
+    uint32_t _counts[kBuckets] = {};
+    uint32_t _count = 0;
+    uint32_t _min = UINT32_MAX;
+    uint32_t _max = 0;
+    std::atomic<bool> _clearPending{false};
+};
+
+class Profiler {
+public:
+    // value in the scope's unit: cycles, or us for TICK_WAKE / TICK_JITTER.
+    void record(ProfileScope scope, uint32_t value) {
+        _hist[(uint8_t)scope].record(value);
+    }
+
+    ProfileStats stats(ProfileScope scope) const;
+    void clear();
+
+private:
+    ProfileHistogram _hist[(uint8_t)ProfileScope::COUNT];
+};
+
+// Free-running cycle counter and its rate.
+uint32_t profileCycles();
+uint32_t profileCyclesPerUs();
+
+// One table row: "name  count  min  p50  p90  p99  max" in microseconds.
+int formatProfileLine(ProfileScope scope, const ProfileStats& st, char* buf, size_t len);
+extern const char* const kProfileHeader;
+
+#ifdef FFX_PROFILE
+
+extern Profiler profiler;
+
+// Records the cycles between construction and destruction.
+class ProfileTimer {
+public:
+    explicit ProfileTimer(ProfileScope scope) : _scope(scope), _start(profileCycles()) {}
+    ~ProfileTimer() { profiler.record(_scope, profileCycles() - _start); }
+
+private:
+    ProfileScope _scope;
+    uint32_t _start;
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(name) \
+    ProfileTimer PROFILE_CONCAT(_profileTimer, __LINE__)(ProfileScope::name)
+#define PROFILE_RECORD(name, value) profiler.record(ProfileScope::name, (value))
+
+#else
+
+#define PROFILE_SCOPE(name) do {} while (0)
+#define PROFILE_RECORD(name, value) do {} while (0)
+
+#endif
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include "Hal.h"
+
+// Cooperative scheduler for the comms side's periodic and one-shot jobs.
+// Jobs run to completion from run(), earliest deadline first, so they must
+// be short. A periodic job's next deadline is its last deadline plus the
+// period, not its start time plus the period, so a late start doesn't
+// shift the ones after it. A job more than a whole period behind skips the
+// missed runs (counted) and keeps its phase.
+//
+// Nothing here waits: nextDueUs() tells the caller how long it may sleep.
+// The ESP32 loop blocks on an esp_timer armed for that deadline, or on a
+// notification from the control task, whichever comes first.
+
+struct SchedulerJobStats {
+    uint32_t runs;
+    uint32_t skipped;       // periods missed entirely
+    uint32_t worstLateUs;   // start after the deadline
+    uint32_t worstRunUs;
+};
+
+class Scheduler {
+public:
+    static constexpr uint8_t kMaxJobs = 8;
+
+    // ctx is the pointer given at registration; nowUs is the deadline the
+    // job is running for, so periodic work can count in exact periods.
+    typedef void (*JobFn)(void* ctx, uint64_t nowUs);
+
+    void begin(Clock& clock);
+
+    // Run fn every periodUs, first at now + periodUs. Returns the job id,
+    // or -1 if every slot is taken.
+    int8_t every(const char* name, uint32_t periodUs, JobFn fn, void* ctx = nullptr);
+
+    // Run fn once, delayUs from now. The slot is freed after it runs.
+    int8_t after(const char* name, uint32_t delayUs, JobFn fn, void* ctx = nullptr);
+
+    // Change a periodic job's period; its next run moves to now + periodUs.
+    void setPeriod(int8_t id, uint32_t periodUs);
+    void cancel(int8_t id);
+
+    // Run every job that is due, earliest deadline first. Returns how many ran.
+    uint8_t run();
+
+    // Earliest deadline of any job (Clock::micros() time), UINT64_MAX if none.
+    uint64_t nextDueUs() const;
+
+    // Registered jobs are ids 0 .. slots() - 1; freed slots have no name.
+    uint8_t slots() const { return _slots; }
+    const char* name(int8_t id) const;
+    uint32_t periodUs(int8_t id) const;
+    SchedulerJobStats stats(int8_t id) const;
+    void clearStats();
+
+private:
+    struct Job {
+        const char* name;
+        JobFn fn;
+        void* ctx;
+        uint32_t periodUs;      // 0 = one-shot
+        uint64_t dueUs;
+        SchedulerJobStats stats;
+    };
+
+    int8_t add(const char* name, uint32_t periodUs, uint32_t delayUs, JobFn fn, void* ctx);
+    bool valid(int8_t id) const { return id >= 0 && id < _slots && _jobs[id].fn; }
+
+    Clock* _clock = nullptr;
+    Job _jobs[kMaxJobs] = {};
+    uint8_t _slots = 0;
+};
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include "Hal.h"
+
+// Velocity/acceleration-limited servo moves.
+//
+// A move is a trapezoidal velocity profile: accelerate, cruise at the speed
+// limit, decelerate. Short moves that never reach the limit are triangular.
+// The setpoint is evaluated from elapsed time, so it doesn't drift when
+// control ticks arrive late.
+
+class TrapezoidProfile {
+public:
+    // Plan a move. maxVel in deg/s, accel in deg/s^2 (both > 0).
+    void plan(float from, float to, float maxVel, float accel);
+
+    // Position t seconds after the start (clamped to the end points).
+    float position(float t) const;
+
+    float from() const { return _from; }
+    float to() const { return _to; }
+    float duration() const { return _total; }
+
+private:
+    float _from = 0;
+    float _to = 0;
+    float _dir = 1;
+    float _accel = 1;
+    float _peakVel = 0;     // cruise speed, or the triangle's apex
+    float _tAccel = 0;      // end of the acceleration ramp
+    float _tCruise = 0;     // end of the cruise segment
+    float _total = 0;
+};
+
+// Streams a TrapezoidProfile to a servo, one setpoint per update().
+class ServoMotion {
+public:
+    void begin(ServoOutput* servo) { _servo = servo; }
+
+    // Start a move from `from` (normally the pot reading, so the servo picks
+    // up where the arm is) to `to`, and write the first setpoint.
+    void moveTo(float from, float to, float maxVel, float accel, uint64_t nowUs);
+
+    // Write the setpoint for nowUs. True once the profile has reached its end.
+    bool update(uint64_t nowUs);
+
+    bool done() const { return _done; }
+    float setpoint() const { return _setpoint; }
+    float target() const { return _profile.to(); }
+
+    // Whether a measured angle confirms the move: within tol of the target,
+    // or past it in the direction of travel.
+    bool reached(float measured, float tol) const;
+
+    // Planned move time, for phase timeouts.
+    uint32_t durationMs() const { return (uint32_t)(_profile.duration() * 1000.0f + 0.5f); }
+
+private:
+    ServoOutput* _servo = nullptr;
+    TrapezoidProfile _profile;
+    uint64_t _startUs = 0;
+    float _setpoint = 0;
+    bool _done = true;
+};
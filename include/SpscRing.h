@@ -0,0 +1,116 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Lock-free single-producer / single-consumer ring buffer.
+// One task (or ISR) pushes, one other task pops; neither ever blocks.
+// Head and tail are free-running counters, so full vs. empty needs no spare slot.
+// A push onto a full ring is dropped and counted rather than overwriting
+// data the consumer may be reading.
+
+template <typename T, uint32_t N>
+class SpscRing {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscRing size must be a power of two");
+
+public:
+    // Producer side.
+    bool push(const T& item) {
+        uint32_t head = _head.load(std::memory_order_relaxed);
+        if (head - _tail.load(std::memory_order_acquire) >= N) {
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        _items[head & (N - 1)] = item;
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side.
+    bool pop(T& out) {
+        uint32_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail == _head.load(std::memory_order_acquire)) return false;
+        out = _items[tail & (N - 1)];
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    uint32_t size() const {
+        return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+    }
+    bool empty() const { return size() == 0; }
+    static constexpr uint32_t capacity() { return N; }
+
+    // Pushes rejected because the ring was full.
+    uint32_t dropped() const { return _dropped.load(std::memory_order_relaxed); }
+
+private:
+    T _items[N];
+    std::atomic<uint32_t> _head{0};
+    std::atomic<uint32_t> _tail{0};
+    std::atomic<uint32_t> _dropped{0};
+};
+
+// Single-slot hand-off of a whole struct between two tasks. The producer
+// fills the slot and marks it ready; the consumer reads it in place and
+// hands it back. publish() refuses while the slot is still waiting, so
+// neither side ever sees it half-written.
+template <typename T>
+class SpscMailbox {
+public:
+    // Producer side. False if the last item hasn't been taken yet.
+    bool publish(const T& item) {
+        if (_ready.load(std::memory_order_acquire)) return false;
+        _item = item;
+        _ready.store(true, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side: the waiting item, or null. Valid until release().
+    const T* pending() const {
+        return _ready.load(std::memory_order_acquire) ? &_item : nullptr;
+    }
+    void release() { _ready.store(false, std::memory_order_release); }
+
+    bool take(T& out) {
+        const T* item = pending();
+        if (!item) return false;
+        out = *item;
+        release();
+        return true;
+    }
+
+private:
+    T _item;
+    std::atomic<bool> _ready{false};
+};
+
+// Latest-value hand-off: the producer overwrites whatever is waiting, the
+// consumer gets the newest whole item. Triple buffered, so the producer
+// never waits and neither side sees an item half-written.
+template <typename T>
+class SpscLatest {
+public:
+    // Producer side.
+    void publish(const T& item) {
+        _slots[_back] = item;
+        _back = _shared.exchange(_back | kFresh, std::memory_order_acq_rel) & kIndex;
+    }
+
+    // Consumer side. False if nothing new since the last take.
+    bool take(T& out) {
+        if (!(_shared.load(std::memory_order_relaxed) & kFresh)) return false;
+        _front = _shared.exchange(_front, std::memory_order_acq_rel) & kIndex;
+        out = _slots[_front];
+        return true;
+    }
+
+private:
+    static constexpr uint8_t kIndex = 0x03;
+    static constexpr uint8_t kFresh = 0x04;
+
+    T _slots[3];
+    uint8_t _back = 0;                  // producer's slot
+    uint8_t _front = 1;                 // consumer's slot
+    std::atomic<uint8_t> _shared{2};    // the one in between, | kFresh once written
+};
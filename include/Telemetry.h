@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "FeedArmController.h"
+#include "Profiler.h"
+
+// Binary telemetry stream.
+// Each record is [type][seq][payload][crc16], COBS-encoded and terminated by a
+// 0x00 byte, so a reader can resync on any zero after garbage or a dropped
+// byte. Multi-byte fields are little-endian; angles are centidegrees.
+// Text (command replies) may be interleaved: it contains no zero bytes and
+// fails the CRC, so decoders just count it as a bad frame.
+//
+// Record payloads (version 3):
+//   HELLO  u8 version, u16 tick period ms
+//   TICK   u8 channel, u32 tick, u32 timeMs, u8 state, u8 flags, i16 feed cdeg,
+//          i16 tension arm cdeg, i16 tension cmd cdeg, u16 raw feed,
+//          u16 raw tension, u32 pulse count, u32 unstick count
+//   REED   u8 channel, u32 pulse count, u64 stamp µs, u32 period µs
+//   EVENT  u8 channel, u32 timeMs, u8 type, u8 from, u8 to, u8 flag,
+//          i32 a*100, i32 b*100, u32 n
+//   PROFILE u8 scope, u32 count, u32 min ns, u32 p50 ns, u32 p90 ns,
+//          u32 p99 ns, u32 max ns (FFX_PROFILE builds only, about once a second)
+// Version 1 had no channel bytes; version 2 had no PROFILE record.
+
+static constexpr uint8_t kTelemetryVersion = 3;
+
+enum class TelemetryRecord : uint8_t {
+    HELLO = 1,
+    TICK = 2,
+    REED = 3,
+    EVENT = 4,
+    PROFILE = 5
+};
+
+// TICK flags.
+static constexpr uint8_t kTelemetryStalled = 0x01;
+
+struct TelemetryTick {
+    uint8_t channel;
+    uint32_t tick;
+    uint32_t timeMs;
+    FeedArmState state;
+    uint8_t flags;
+    float feedArmAngle;
+    float tensionArmAngle;
+    float tensionAngle;
+    uint16_t rawFeedPot;
+    uint16_t rawTensionPot;
+    uint32_t pulseCount;
+    uint32_t unstickCount;
+};
+
+struct TelemetryReed {
+    uint8_t channel;
+    uint32_t pulseCount;
+    uint64_t stampUs;
+    uint32_t periodUs;
+};
+
+struct TelemetryProfile {
+    ProfileScope scope;
+    ProfileStats stats;
+};
+
+struct TelemetryHello {
+    uint8_t version;
+    uint16_t periodMs;
+};
+
+// Largest encoded frame including COBS overhead and the delimiter.
+static constexpr size_t kTelemetryMaxFrame = 48;
+
+// COBS. out must hold len + len / 254 + 1 bytes. Returns the encoded length
+// (without delimiter).
+size_t cobsEncode(const uint8_t* in, size_t len, uint8_t* out);
+// Returns the decoded length, or 0 if the input is malformed.
+size_t cobsDecode(const uint8_t* in, size_t len, uint8_t* out);
+
+// CRC-16/CCITT-FALSE.
+uint16_t crc16Ccitt(const uint8_t* data, size_t len);
+
+// Builds complete frames (delimiter included) into a caller buffer of at
+// least kTelemetryMaxFrame bytes. Returns the frame length.
+class TelemetryEncoder {
+public:
+    size_t hello(uint16_t periodMs, uint8_t* out);
+    size_t tick(const TelemetryTick& t, uint8_t* out);
+    size_t reed(const TelemetryReed& r, uint8_t* out);
+    size_t event(const FeedArmEvent& ev, uint8_t* out);
+    size_t profile(const TelemetryProfile& p, uint8_t* out);
+
+private:
+    size_t finish(uint8_t* raw, size_t len, uint8_t* out);
+
+    uint8_t _seq = 0;
+};
+
+// Incremental frame decoder for the host side.
+class TelemetryDecoder {
+public:
+    // Feed one byte. Returns true when a valid record has been decoded;
+    // read it with type() and the accessor for that type.
+    bool feed(uint8_t b);
+
+    TelemetryRecord type() const { return _type; }
+    const TelemetryHello& hello() const { return _hello; }
+    const TelemetryTick& tick() const { return _tick; }
+    const TelemetryReed& reed() const { return _reed; }
+    const FeedArmEvent& event() const { return _event; }
+    const TelemetryProfile& profile() const { return _profile; }
+
+    uint32_t frames() const { return _frames; }
+    uint32_t badFrames() const { return _badFrames; }
+    // Frames missing according to the sequence counter.
+    uint32_t lostFrames() const { return _lostFrames; }
+
+private:
+    bool parse(const uint8_t* raw, size_t len);
+
+    uint8_t _buf[64] = {};
+    size_t _len = 0;
+    bool _overflow = false;
+    bool _haveSeq = false;
+    uint8_t _lastSeq = 0;
+
+    TelemetryRecord _type = TelemetryRecord::HELLO;
+    TelemetryHello _hello = {};
+    TelemetryTick _tick = {};
+    TelemetryReed _reed = {};
+    FeedArmEvent _event = {};
+    TelemetryProfile _profile = {};
+
+    uint32_t _frames = 0;
+    uint32_t _badFrames = 0;
+    uint32_t _lostFrames = 0;
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include "Config.h"
+
+// Feed arm + tension arm pot angles -> filament tension in newtons.
+// The arm is a dancer in equilibrium: the extension spring from the feed
+// arm's anchor to the tension arm tip lifts it, and the filament wrapped
+// over its wheel pulls it down with tension x path gain. So
+//   tension = spring torque(feed, tension angle) / path gain
+// with the geometry from cad/*.scad and the spring's rate and free length
+// from Config. Arm inertia and pivot friction are ignored, which is fine
+// for anything slower than a breakaway snap.
+//
+// The model needs trig and a square root, so it is tabulated once per
+// config: every 2.5° of feed arm by every 5° of tension arm, in mN. A tick's
+// lookup is four table reads and a bilinear interpolation.
+class TensionModel {
+public:
+    static constexpr uint8_t kFeedSteps = 64;       // 0-160° in 2.5° steps
+    static constexpr uint8_t kTensionSteps = 32;    // 0-160° in 5° steps
+
+    // Rebuild the table if the geometry or spring changed. True if it did.
+    bool build(const Config& cfg);
+
+    float newtons(float feedDeg, float tensionDeg) const {
+        float fx = clampIndex(feedDeg * (kFeedSteps / 160.0f), kFeedSteps);
+        float tx = clampIndex(tensionDeg * (kTensionSteps / 160.0f), kTensionSteps);
+        uint8_t f = (uint8_t)fx;
+        uint8_t t = (uint8_t)tx;
+        if (f == kFeedSteps) f--;
+        if (t == kTensionSteps) t--;
+        float ff = fx - f;
+        float tf = tx - t;
+        const uint16_t* r0 = _mN[f];
+        const uint16_t* r1 = _mN[f + 1];
+        float lo = r0[t] + (r0[t + 1] - r0[t]) * tf;
+        float hi = r1[t] + (r1[t + 1] - r1[t]) * tf;
+        return (lo + (hi - lo) * ff) * 0.001f;
+    }
+
+    // The model itself, untabulated (N, 0 when the spring is slack).
+    static float solve(const Config& cfg, float feedDeg, float tensionDeg);
+
+    // Spring rate (N/mm) that makes the model read `newtons` at these
+    // angles, keeping the free length. 0 if the spring is slack there.
+    static float springRateFor(const Config& cfg, float feedDeg, float tensionDeg,
+                               float newtons);
+
+private:
+    static float clampIndex(float x, uint8_t max) {
+        return x < 0 ? 0 : x > max ? max : x;
+    }
+
+    // What the table was built from.
+    float _key[7] = {};
+    bool _built = false;
+    uint16_t _mN[kFeedSteps + 1][kTensionSteps + 1] = {};
+};
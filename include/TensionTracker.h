@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include "Config.h"
+
+// Spring tension tracking.
+// Spool drag grows as the spool empties (the same hub friction acts at a
+// smaller radius), so a spring tension set for a full spool lets the arm
+// sag toward the jam threshold by the end. This outer loop averages where
+// the arm rests while printing and nudges the tension servo to keep it at
+// feedArmRestAngle:
+//   - only ticks in MONITORING with the detector calm and a reed pulse
+//     within tensionTrackIdleMs are averaged,
+//   - after startup or an unstick it averages a full warm-up before acting,
+//   - it starts correcting beyond tensionTrackStartDeg and stops inside
+//     tensionTrackStopDeg, so it doesn't hunt around the set point,
+//   - nudges are at least tensionTrackIntervalMs apart and capped at
+//     tensionTrackMaxDegPerMin,
+//   - it never goes below the operator's tension: an arm riding high is
+//     as likely slack filament after a breakaway as too much spring.
+
+class TensionTracker {
+public:
+    // Start over: drop the average and warm up again.
+    void restart(uint32_t nowMs);
+
+    // One eligible tick. Returns true and sets newTension when a nudge is
+    // due; the caller moves the servo. baseTension is the operator's
+    // setting, the lowest a nudge goes.
+    bool update(const Config& cfg, uint32_t nowMs, float armAngle, float tension,
+                float baseTension, float& newTension);
+
+    // Averaged resting angle, and whether it is warmed up.
+    float restingAngle() const { return _average; }
+    bool ready() const { return _started && _sampledMs >= _warmupMs; }
+    bool correcting() const { return _correcting; }
+    uint32_t nudges() const { return _nudges; }
+
+private:
+    float _average = 0;
+    uint32_t _lastMs = 0;
+    uint32_t _sampledMs = 0;        // averaged time since restart()
+    uint32_t _warmupMs = 0;
+    uint32_t _lastNudgeMs = 0;
+    bool _started = false;
+    bool _correcting = false;
+    uint32_t _nudges = 0;
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include "Config.h"
+
+// Unstick escalation.
+// Each jam is worked through Config::unstickLadder, gentlest stage first.
+// An attempt the pot or reed doesn't confirm moves straight on to the next
+// stage; the jam is given up on (full cooldown) once the ladder runs out.
+// Every attempt is counted per stage, and a new jam starts at the stage
+// with the best success rate so far, so a spool that always needs a hard
+// yank stops wasting time on the gentle ones.
+
+struct UnstickStageStats {
+    uint32_t attempts;
+    uint32_t successes;
+};
+
+class UnstickLadder {
+public:
+    // Forget all stats (e.g. new spool).
+    void clear();
+
+    // A new jam. Returns the stage to try first.
+    uint8_t begin(const Config& cfg);
+
+    // Outcome of one attempt. A success ends the jam.
+    void record(uint8_t stage, bool success);
+
+    // Stage to escalate to after `stage` failed, or -1 when the ladder is
+    // exhausted.
+    int next(const Config& cfg, uint8_t stage) const;
+
+    // Every stage failed; the jam is left to the full cooldown.
+    void giveUp() { _exhausted++; }
+
+    // Stage with the best smoothed success rate; ties go to the gentler one.
+    uint8_t bestStage(const Config& cfg) const;
+
+    // Laplace-smoothed: an untried stage scores 0.5.
+    float successRate(uint8_t stage) const;
+
+    const UnstickStageStats& stats(uint8_t stage) const { return _stats[stage]; }
+    uint32_t jams() const { return _jams; }
+    uint32_t cleared() const { return _cleared; }
+    uint32_t exhausted() const { return _exhausted; }
+
+private:
+    UnstickStageStats _stats[kMaxUnstickStages] = {};
+    uint32_t _jams = 0;
+    uint32_t _cleared = 0;
+    uint32_t _exhausted = 0;
+};
@@ -1,44 +1,178 @@
 #pragma once
 
-#include <Arduino.h>
+#include "Hal.h"
+#include "Platform.h"
 
-// Reed switch on the filament guide wheel.
-// A magnet on the wheel triggers the reed switch once per revolution.
-// Tracks pulse count and time since last pulse to detect:
-//   - Normal feed (pulses arriving regularly)
-//   - Stall (no pulses = filament stopped)
-//   - Provides approximate feed rate via pulse frequency
+#ifdef ARDUINO
+#include <soc/gpio_struct.h>
+#endif
+
+// Guide wheel encoder.
+// The filament turns a guide wheel, and one or more magnets on it trigger a
+// reed switch (or a hall sensor) as they pass. The ISR stamps every accepted
+// pulse with a microsecond timestamp into a small lock-free ring, which gives:
+//   - Normal feed (pulses arriving regularly) and the period between pulses
+//   - Stall (no pulse within a few expected periods = filament stopped)
+//   - Feed rate and period jitter from the recent pulses
+// A quadrature sensor (two channels) is decoded on every edge of both and
+// also gives direction. Only new forward travel counts as a pulse there, so
+// a wheel rocking on an edge doesn't read as feed.
+//
+// With the wheel's pulses per revolution and diameter set, pulses become
+// filament: a position interpolated between pulses and a speed in mm/s.
+// Every consumer of periods and rates (stall detection, debounce) scales
+// with the resolution, so N pulses per revolution notice a stall N times
+// sooner.
+
+// Period statistics over the pulses in the history ring.
+struct ReedStats {
+    uint8_t intervals;      // periods measured (0 = not enough pulses)
+    uint32_t lastPeriodUs;  // most recent pulse to pulse
+    uint32_t meanPeriodUs;
+    uint32_t minPeriodUs;
+    uint32_t maxPeriodUs;
+    uint32_t jitterUs;      // standard deviation of the periods
+};
 
 class ReedSwitch {
 public:
-    void begin(uint8_t pin);
+    // Pulse timestamps kept for period/rate estimation.
+    static constexpr uint8_t kHistory = 16;   // power of two
+
+    void begin(uint8_t pin, EdgeInput& gpio, Clock& clock);
+
+    // Two-channel quadrature sensor instead of a single switch. Counts
+    // every edge of both channels (4 per line).
+    void beginQuadrature(uint8_t pinA, uint8_t pinB, EdgeInput& gpio, Clock& clock);
+
+    // Pulses per wheel revolution (magnets, or 4 x lines for quadrature)
+    // and the diameter the filament runs on.
+    void setWheel(uint16_t pulsesPerRev, float diameterMm);
+    float mmPerPulse() const { return _mmPerPulse; }
+
+    // Debounce on measured intervals: an edge closer than `fraction` of the
+    // last pulse period is contact bounce. Quadrature needs none. Clamped to [minUs, maxUs].
+    void setDebounce(uint32_t minUs, uint32_t maxUs, float fraction);
 
     // Check if filament has stalled (no pulses within timeout).
     bool isStalled(uint32_t timeoutMs) const;
 
-    // Pulses per second (averaged over recent window).
+    // Adaptive stall: no pulse within `periods` expected pulse periods
+    // (rolling mean), clamped to [minMs, maxMs]. Falls back to maxMs until
+    // enough pulses have been seen to know the period.
+    bool isStalled(float periods, uint32_t minMs, uint32_t maxMs) const;
+
+    // Pulses per second from the recent periods. Decays toward zero as
+    // the time since the last pulse grows, so a stopped wheel reads as stopped.
     float pulsesPerSec() const;
 
-    // Total pulse count since startup.
-    uint32_t pulseCount() const { return _pulseCount; }
+    // Latest pulse-to-pulse period in microseconds (0 if unknown).
+    uint32_t lastPeriodUs() const;
+
+    // Rolling period statistics. Returns false if fewer than two pulses.
+    bool stats(ReedStats& out) const;
+
+    // Pulse count since startup or the last reset().
+    uint32_t pulseCount() const { return _head - _resetHead; }
+
+    // Edges rejected by the debounce.
+    uint32_t rejectedCount() const { return _rejected; }
 
-    // Pulses since last call to sample() — for periodic checking.
-    uint32_t sample();
+    // Net pulses since begin(), never reset; goes down when a quadrature
+    // wheel turns backward.
+    int32_t position() const { return _position; }
 
-    // Time in ms since the last reed switch pulse.
+    // Filament through the wheel since begin() (mm), interpolated between
+    // pulses at the current rate, never beyond the next pulse.
+    float positionMm() const;
+
+    // Feed rate (mm/s).
+    float speedMmPerSec() const { return pulsesPerSec() * _mmPerPulse; }
+
+    // Time in ms since the last reed switch pulse (or since reset if none).
     uint32_t timeSinceLastPulseMs() const;
 
-    // Reset counters.
+    // Timestamp of the newest pulse in Clock::micros() time (0 if none
+    // since reset).
+    uint64_t lastPulseUs() const;
+
+    // Reset counters and forget the period history.
     void reset();
 
-    // ISR handler — must be public for the static trampoline.
-    void IRAM_ATTR handleInterrupt();
+    // ISR handlers — must be public for the static trampolines.
+    void IRAM_ATTR handleInterrupt(uint64_t nowUs);
+    void IRAM_ATTR handleQuadrature(uint64_t nowUs);
 
 private:
+    // Copy the newest timestamps (oldest first). Returns how many were copied.
+    uint8_t snapshot(uint32_t* stamps) const;
+
+    // Record an accepted pulse. ISR only.
+    void IRAM_ATTR accept(uint32_t stampUs, uint64_t nowUs);
+
+    // Quadrature channel level (A = 0, B = 1) from the edge ISR.
+    bool channelHigh(uint8_t ch) const;
+
     uint8_t _pin = 0;
-    volatile uint32_t _pulseCount = 0;
-    volatile uint32_t _lastPulseTimeMs = 0;
-    uint32_t _lastSampleCount = 0;
-    uint32_t _lastSampleTimeMs = 0;
-    float _pulsesPerSec = 0;
+    uint8_t _pinB = 0;
+    Clock* _clock = nullptr;
+    EdgeInput* _gpio = nullptr;
+    // Quadrature pins as a bit in the GPIO input registers (pins 32 and up
+    // in the second one). The edge ISR can run while an NVS or LittleFS
+    // write has the flash cache off, so it reads the register itself: no
+    // vtable, no gpio_get_level. EdgeInput::level() is for everyone else.
+    uint32_t _levelMask[2] = {};
+    bool _levelBank1[2] = {};
+    float _mmPerPulse = 78.54f;     // one magnet on a 25 mm wheel
+
+    // Written only by the ISR. Ring stamps are the low 32 bits of the
+    // microsecond clock; differences stay valid across its wrap.
+    volatile uint32_t _stampsUs[kHistory] = {};
+    volatile uint32_t _head = 0;            // total accepted pulses
+    volatile uint64_t _lastPulseUs = 0;
+    volatile uint32_t _lastPeriodUs = 0;
+    volatile uint32_t _rejected = 0;
+    volatile int32_t _position = 0;
+    volatile int32_t _highWater = 0;        // furthest position reached
+    volatile uint8_t _quadState = 0;        // last A/B levels
+
+    // Written only outside the ISR.
+    volatile uint32_t _resetHead = 0;       // _head at the last reset()
+    uint64_t _resetUs = 0;
+
+    // Debounce parameters, read by the ISR. Fraction is Q8 so the ISR
+    // stays integer-only.
+    volatile uint32_t _debounceMinUs = 2000;
+    volatile uint32_t _debounceMaxUs = 50000;
+    volatile uint32_t _debounceFracQ8 = 77;     // ~0.3
+};
+
+// Inline so the ISR never calls out of IRAM for it.
+inline __attribute__((always_inline)) bool ReedSwitch::channelHigh(uint8_t ch) const {
+#ifdef ARDUINO
+    uint32_t in = _levelBank1[ch] ? GPIO.in1.val : GPIO.in;
+    return (in & _levelMask[ch]) != 0;
+#else
+    return _gpio->level(ch ? _pinB : _pin);
+#endif
+}
+
+// Filament used, from the wheel's position: the total since boot and the
+// current print's share. A print starts with the first movement after the
+// wheel has been still for printGapMs, or when startPrint() says so.
+class FilamentOdometer {
+public:
+    // One tick: the wheel's net position and the time since its last pulse.
+    void update(int32_t position, uint32_t msSinceMove, uint32_t printGapMs);
+    void startPrint();
+
+    int32_t totalPulses() const { return _position; }
+    int32_t printPulses() const { return _position - _printStart; }
+    uint32_t prints() const { return _prints; }
+
+private:
+    int32_t _position = 0;
+    int32_t _printStart = 0;
+    uint32_t _prints = 0;
+    bool _idle = true;
 };
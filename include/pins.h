@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+
 // ESP32-S3 WROOM pin map.
 // GPIO 26-37 are RESERVED (internal flash/PSRAM on WROOM-N8R8).
 // GPIO 19-20 are USB D-/D+ (used for serial/JTAG).
@@ -23,8 +25,49 @@
 
 // --- Reed Switch (filament wheel rotation detection) ---
 // Magnet on guide wheel, reed switch on arm/mount.
-// One pulse per revolution = filament is moving.
+// One pulse per magnet = filament is moving. A quadrature sensor uses this
+// pin for channel A and wheelB below for channel B.
 #define PIN_REED_SWITCH         4   // interrupt capable
+#define PIN_WHEEL_B             40  // quadrature channel B (wheelQuadrature)
+
+// --- Printer Link (PrinterLink.h) ---
+// UART1 to the printer's host on the UART0 pins: nothing else is free with
+// four channels fitted. They are also wired to the board's USB-UART bridge,
+// so the console and uploads go over native USB (platformio.ini) and the
+// bridge's USB port must stay unplugged while the link is wired, or its TX
+// fights the printer's on GPIO 44. The ROM's boot messages still go out on
+// GPIO 43 at reset; the host drops them as lines without a valid checksum.
+// 3.3 V levels.
+#define PIN_PRINTER_TX          43
+#define PIN_PRINTER_RX          44
 
 // --- Status LED (Freenove onboard RGB is GPIO 48) ---
 #define PIN_STATUS_LED          2
+
+// --- Feed Channels ---
+// One channel per feed arm: two servos, two pots and a reed switch each.
+// Channel 0 is the single-arm wiring above. Pots must be ADC1 pins
+// (GPIO 1-10): the continuous ADC only scans ADC1. GPIO 3 is a strapping
+// pin, but only when the JTAG-select eFuse is burned.
+#ifndef FEED_CHANNELS
+#define FEED_CHANNELS 1         // channels fitted; override with -D FEED_CHANNELS=n
+#endif
+
+static constexpr uint8_t kNoPin = 0xff;
+
+struct ChannelPins {
+    uint8_t feedServo;
+    uint8_t tensionServo;
+    uint8_t feedPot;
+    uint8_t tensionPot;
+    uint8_t reed;
+    uint8_t wheelB;     // quadrature channel B, or kNoPin
+};
+
+static constexpr ChannelPins kChannelPins[] = {
+    { PIN_SERVO_FEED_ARM, PIN_SERVO_TENSION, PIN_POT_FEED_ARM, PIN_POT_TENSION,
+      PIN_REED_SWITCH, PIN_WHEEL_B },
+    { 15, 16,  8,  9, 11, 41 },    // pots ADC1_CH7, CH8
+    { 17, 18,  1, 10, 12, 42 },    // pots ADC1_CH0, CH9
+    { 38, 39,  3,  5, 21, 47 },    // pots ADC1_CH2, CH4
+};
@@ -0,0 +1,261 @@
+#include "ArmSpectrum.h"
+
+#include <cmath>
+#include "Platform.h"
+#include "Profiler.h"
+
+#if defined(ARDUINO) && __has_include(<esp_dsp.h>)
+#include <esp_dsp.h>
+#define FFX_ESP_DSP 1
+#endif
+
+constexpr uint16_t ArmSpectrum::kBandStart[];
+
+static constexpr float kTwoPi = 6.28318530718f;
+
+// Band energy floor (deg^2, 0.1° RMS): a few ADC counts of arm motion.
+// Below it, dB swings between near-silent windows would read as anomalies.
+static constexpr float kFloorDeg2 = 0.01f;
+
+// --- Tables ---
+
+// Twiddles W_N^k = cos - i sin(2πk/N) for k < N/2, N = kFrames; a shorter
+// FFT strides through them. Built on first use, which is configure() in
+// begin(), before the control task starts.
+struct SpectrumTables {
+    float cos[ArmSpectrum::kFrames / 2];
+    float sin[ArmSpectrum::kFrames / 2];
+    float hann[ArmSpectrum::kFrames];
+
+    SpectrumTables() {
+        const uint16_t n = ArmSpectrum::kFrames;
+        for (uint16_t k = 0; k < n / 2; k++) {
+            cos[k] = cosf(kTwoPi * k / n);
+            sin[k] = sinf(kTwoPi * k / n);
+        }
+        for (uint16_t i = 0; i < n; i++) hann[i] = 0.5f * (1.0f - cosf(kTwoPi * i / n));
+#ifdef FFX_ESP_DSP
+        dsps_fft2r_init_fc32(nullptr, CONFIG_DSP_MAX_FFT_SIZE);
+#endif
+    }
+};
+
+static const SpectrumTables& tables() {
+    static SpectrumTables t;
+    return t;
+}
+
+// --- FFT kernels ---
+
+const char* fftImplName(FftImpl impl) {
+    switch (impl) {
+        case FftImpl::SCALAR:  return "scalar";
+        case FftImpl::ESP_DSP: return "esp-dsp";
+        default:               return "?";
+    }
+}
+
+bool fftAvailable(FftImpl impl) {
+#ifdef FFX_ESP_DSP
+    return true;
+#else
+    return impl == FftImpl::SCALAR;
+#endif
+}
+
+// Iterative radix-2 decimation in time: bit-reverse, then butterflies.
+static void fftScalar(float* d, uint16_t n) {
+    for (uint16_t i = 1, j = 0; i < n; i++) {
+        uint16_t bit = n >> 1;
+        for (; j & bit; bit >>= 1) j ^= bit;
+        j ^= bit;
+        if (i < j) {
+            float re = d[2 * i], im = d[2 * i + 1];
+            d[2 * i] = d[2 * j];
+            d[2 * i + 1] = d[2 * j + 1];
+            d[2 * j] = re;
+            d[2 * j + 1] = im;
+        }
+    }
+    const SpectrumTables& t = tables();
+    for (uint16_t len = 2; len <= n; len <<= 1) {
+        uint16_t half = len / 2;
+        uint16_t step = ArmSpectrum::kFrames / len;
+        for (uint16_t i = 0; i < n; i += len) {
+            for (uint16_t k = 0; k < half; k++) {
+                float wr = t.cos[k * step];
+                float wi = -t.sin[k * step];
+                float* a = d + 2 * (i + k);
+                float* b = d + 2 * (i + k + half);
+                float br = b[0] * wr - b[1] * wi;
+                float bi = b[0] * wi + b[1] * wr;
+                b[0] = a[0] - br;
+                b[1] = a[1] - bi;
+                a[0] += br;
+                a[1] += bi;
+            }
+        }
+    }
+}
+
+void fftComplex(float* data, uint16_t n, FftImpl impl) {
+#ifdef FFX_ESP_DSP
+    if (impl == FftImpl::ESP_DSP) {
+        dsps_fft2r_fc32(data, n);
+        dsps_bit_rev_fc32(data, n);
+        return;
+    }
+#endif
+    (void)impl;
+    fftScalar(data, n);
+}
+
+// --- ArmSpectrum ---
+
+void ArmSpectrum::configure(const Config& cfg) {
+    tables();
+    uint8_t decimation = cfg.spectrumDecimation ? cfg.spectrumDecimation : 1;
+    float frameHz = 1000.0f / (cfg.monitorIntervalMs * decimation);
+    // A new frame rate moves every bin: start over.
+    if (frameHz != _frameHz) {
+        restart();
+        relearn();
+    }
+    _cfg = cfg;
+    _cfg.spectrumDecimation = decimation;
+    _frameHz = frameHz;
+    _features.frameHz = frameHz;
+}
+
+void ArmSpectrum::restart() {
+    _acc = 0;
+    _accTicks = 0;
+    _head = 0;
+    _filled = 0;
+    _sinceAnalysis = 0;
+    _features.anomaly = 0;
+}
+
+void ArmSpectrum::relearn() {
+    _baselineWindows = 0;
+    _features.anomaly = 0;
+}
+
+float ArmSpectrum::bandLowHz(uint8_t band) const {
+    return kBandStart[band] * _frameHz / kFrames;
+}
+
+float ArmSpectrum::bandHighHz(uint8_t band) const {
+    return (kBandStart[band + 1] - 1) * _frameHz / kFrames;
+}
+
+bool ArmSpectrum::push(float angleDeg) {
+    _acc += angleDeg;
+    if (++_accTicks < _cfg.spectrumDecimation) return false;
+    _frames[_head] = _acc / _accTicks;
+    _head = (_head + 1) % kFrames;
+    _acc = 0;
+    _accTicks = 0;
+    if (_filled < kFrames) _filled++;
+    if (_filled < kFrames || ++_sinceAnalysis < kHop) return false;
+    _sinceAnalysis = 0;
+    analyse();
+    return true;
+}
+
+void ArmSpectrum::analyse() {
+    PROFILE_SCOPE(SPECTRUM);
+    const SpectrumTables& t = tables();
+    const uint16_t n = kFrames;
+    const uint16_t m = n / 2;
+
+    // Least-squares line through the window (oldest frame first), so slow
+    // drift doesn't leak into the low bins.
+    float sum = 0, sumTx = 0;
+    for (uint16_t i = 0; i < n; i++) {
+        float x = _frames[(_head + i) % n];
+        sum += x;
+        sumTx += i * x;
+    }
+    float mean = sum / n;
+    float tMean = (n - 1) * 0.5f;
+    float slope = (sumTx - tMean * sum) / (n * ((float)n * n - 1.0f) / 12.0f);
+
+    // Detrend and window; even frames go to the real parts, odd to the
+    // imaginary, for the half-length complex FFT.
+    for (uint16_t i = 0; i < n; i++) {
+        float x = _frames[(_head + i) % n] - mean - slope * (i - tMean);
+        _work[i] = x * t.hann[i];
+    }
+    fftComplex(_work, m, _impl);
+
+    // Split into the real signal's bins 1..n/2 and turn them into one-sided
+    // power in deg^2: Parseval, scaled for the Hann window's mean square (3/8).
+    const float scale = 2.0f / ((float)n * n * 0.375f);
+    _power[0] = 0;
+    for (uint16_t k = 1; k <= m; k++) {
+        uint16_t a = k % m;
+        uint16_t b = (m - k) % m;
+        float zr = _work[2 * a], zi = _work[2 * a + 1];
+        float cr = _work[2 * b], ci = -_work[2 * b + 1];    // conj(Z[m-k])
+        float er = 0.5f * (zr + cr), ei = 0.5f * (zi + ci);
+        float or_ = 0.5f * (zi - ci), oi = -0.5f * (zr - cr);
+        float wr = k < m ? t.cos[k] : -1.0f;
+        float wi = k < m ? -t.sin[k] : 0.0f;
+        float xr = er + wr * or_ - wi * oi;
+        float xi = ei + wr * oi + wi * or_;
+        _power[k] = (xr * xr + xi * xi) * (k < m ? scale : scale * 0.5f);
+    }
+
+    ArmSpectrumFeatures& f = _features;
+    float total = 0;
+    uint16_t peak = 1;
+    for (uint16_t k = 1; k <= m; k++) {
+        total += _power[k];
+        if (_power[k] > _power[peak]) peak = k;
+    }
+    for (uint8_t b = 0; b < kBands; b++) {
+        float e = 0;
+        for (uint16_t k = kBandStart[b]; k < kBandStart[b + 1]; k++) e += _power[k];
+        f.bandDb[b] = 10.0f * log10f(e + kFloorDeg2);
+    }
+    f.rmsDeg = sqrtf(total);
+
+    // The window spreads a tone over three bins: interpolate its centre
+    // and count all three as the peak.
+    float offset = 0;
+    float share = _power[peak];
+    if (peak > 1 && peak < m) {
+        float l = logf(_power[peak - 1] + 1e-12f);
+        float c = logf(_power[peak] + 1e-12f);
+        float r = logf(_power[peak + 1] + 1e-12f);
+        float den = l - 2.0f * c + r;
+        if (den < 0) offset = 0.5f * (l - r) / den;
+        share += _power[peak - 1] + _power[peak + 1];
+    }
+    f.peakHz = (peak + offset) * _frameHz / n;
+    f.peakShare = total > 0 ? share / total : 0;
+    f.windows++;
+
+    // Score against the baseline, then learn from the window.
+    if (_baselineWindows < kWarmupWindows) {
+        f.anomaly = 0;
+        _baselineWindows++;
+        for (uint8_t b = 0; b < kBands; b++) {
+            _baselineDb[b] += (f.bandDb[b] - _baselineDb[b]) / _baselineWindows;
+        }
+        return;
+    }
+    float worst = 0;
+    for (uint8_t b = 0; b < kBands; b++) {
+        float excess = f.bandDb[b] - _baselineDb[b];
+        if (excess > worst) worst = excess;
+    }
+    f.anomaly = _cfg.spectrumAnomalyDb > 0 ? worst / _cfg.spectrumAnomalyDb : 0;
+    // A spool that keeps wobbling becomes the new normal, but a quarter as
+    // fast, so a growing tangle stays ahead of it.
+    float adapt = f.anomaly < 0.5f ? _cfg.spectrumAdapt : _cfg.spectrumAdapt * 0.25f;
+    for (uint8_t b = 0; b < kBands; b++) {
+        _baselineDb[b] += (f.bandDb[b] - _baselineDb[b]) * adapt;
+    }
+}
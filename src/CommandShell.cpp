@@ -0,0 +1,103 @@
+#include "CommandShell.h"
+
+#include <cctype>
+#include <cstdlib>
+#include "Platform.h"
+
+// --- LineAssembler ---
+
+bool LineAssembler::feed(char c) {
+    if (c == '\r' || c == '\n') {
+        bool ready = !_discarding && _len > 0;
+        _buf[_len] = '\0';
+        _len = 0;
+        _discarding = false;
+        return ready;
+    }
+    if (_discarding) return false;
+
+    if (c == '\b' || c == 0x7f) {
+        if (_len > 0) _len--;
+        return false;
+    }
+    if (_len >= kMaxLine - 1) {
+        _discarding = true;
+        _overflows++;
+        _len = 0;
+        return false;
+    }
+    _buf[_len++] = c;
+    return false;
+}
+
+// --- CommandShell ---
+
+void CommandShell::begin(const CommandSpec* table, size_t count, ReadByte readByte, void* ctx) {
+    _table = table;
+    _count = count;
+    _readByte = readByte;
+    _ctx = ctx;
+}
+
+void CommandShell::poll(uint32_t nowMs) {
+    for (uint16_t i = 0; i < kBytesPerPoll; i++) {
+        int c = _readByte(_ctx);
+        if (c < 0) break;
+        if (_line.feed((char)c)) {
+            // One command per pass; the rest of the input waits for the next.
+            dispatch(_line.line());
+            break;
+        }
+    }
+
+    if (_job && !_job->poll(nowMs)) {
+        _job = nullptr;
+    }
+}
+
+void CommandShell::startJob(ShellJob* job, uint32_t nowMs) {
+    if (_job && _job != job) _job->cancel();
+    _job = job;
+    // First slice runs right away so output starts with the command.
+    if (_job && !_job->poll(nowMs)) {
+        _job = nullptr;
+    }
+}
+
+void CommandShell::dispatch(const char* line) {
+    while (*line == ' ' || *line == '\t') line++;
+    if (*line == '\0') return;
+
+    // A new command stops a streaming job.
+    if (_job) {
+        _job->cancel();
+        _job = nullptr;
+    }
+
+    char key = (char)tolower((unsigned char)*line);
+    const char* args = line + 1;
+    while (*args == ' ' || *args == '\t') args++;
+
+    for (size_t i = 0; i < _count; i++) {
+        if (_table[i].key == key) {
+            _table[i].handler(*this, args);
+            return;
+        }
+    }
+    logPrintf("Unknown command: '%c'. Type 'h' for help.\n", *line);
+}
+
+void CommandShell::printHelp() const {
+    logPrintf("=== Commands ===\n");
+    for (size_t i = 0; i < _count; i++) {
+        logPrintf("  %-10s - %s\n", _table[i].usage, _table[i].help);
+    }
+}
+
+bool parseFloatArg(const char* args, float& out) {
+    char* end = nullptr;
+    float v = strtof(args, &end);
+    if (end == args) return false;
+    out = v;
+    return true;
+}
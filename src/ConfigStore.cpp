@@ -0,0 +1,273 @@
+#include "ConfigStore.h"
+
+#include <cstddef>
+#include <cstring>
+
+static constexpr uint32_t kConfigMagic = 0x43584646;     // "FFXC"
+static constexpr size_t kHeaderBytes = 12;
+
+// --- Field table ---
+// Ids are permanent: append new fields, never renumber or reuse.
+
+struct ConfigField {
+    uint8_t id;
+    uint16_t offset;
+    uint8_t size;
+};
+
+#define CONFIG_FIELD(id, member) \
+    { id, (uint16_t)offsetof(Config, member), (uint8_t)sizeof(Config::member) }
+
+static const ConfigField kFields[] = {
+    CONFIG_FIELD(1, feedArmRestAngle),
+    CONFIG_FIELD(2, feedArmJamAngle),
+    CONFIG_FIELD(3, unstickLadder),
+    CONFIG_FIELD(4, unstickStages),
+    CONFIG_FIELD(5, unstickShakeDeg),
+    CONFIG_FIELD(6, unstickAdaptive),
+    CONFIG_FIELD(7, unstickCooldownMs),
+    CONFIG_FIELD(8, unstickMaxDegPerSec),
+    CONFIG_FIELD(9, unstickAccelDegPerSec2),
+    CONFIG_FIELD(10, unstickArriveTolDeg),
+    CONFIG_FIELD(11, unstickSettleMs),
+    CONFIG_FIELD(12, unstickReedPulses),
+    CONFIG_FIELD(13, unstickReturnTimeoutMs),
+    CONFIG_FIELD(14, unstickCooldownMinMs),
+    CONFIG_FIELD(15, unstickRecoveredDeg),
+    CONFIG_FIELD(16, jamDetector),
+    CONFIG_FIELD(17, jamAlpha),
+    CONFIG_FIELD(18, jamBeta),
+    CONFIG_FIELD(19, jamSlipDegPerSec),
+    CONFIG_FIELD(20, jamMarginDeg),
+    CONFIG_FIELD(21, jamFloorAdapt),
+    CONFIG_FIELD(22, jamSettleMs),
+    CONFIG_FIELD(23, jamHorizonSec),
+    CONFIG_FIELD(24, jamReedMovingWeight),
+    CONFIG_FIELD(25, jamConfidence),
+    CONFIG_FIELD(26, tensionServoAngle),
+    CONFIG_FIELD(27, tensionAngleMin),
+    CONFIG_FIELD(28, tensionAngleMax),
+    CONFIG_FIELD(29, potFeedMin),
+    CONFIG_FIELD(30, potFeedMax),
+    CONFIG_FIELD(31, potTensionMin),
+    CONFIG_FIELD(32, potTensionMax),
+    CONFIG_FIELD(33, potSamples),
+    CONFIG_FIELD(34, potSampleRateHz),
+    CONFIG_FIELD(35, potFilter),
+    CONFIG_FIELD(36, reedStallTimeoutMs),
+    CONFIG_FIELD(37, reedStallPeriods),
+    CONFIG_FIELD(38, reedStallMinMs),
+    CONFIG_FIELD(39, reedDebounceFraction),
+    CONFIG_FIELD(40, reedDebounceMinUs),
+    CONFIG_FIELD(41, reedDebounceMaxUs),
+    CONFIG_FIELD(42, reedFilter),
+    CONFIG_FIELD(43, reedMinPulsesPerSec),
+    CONFIG_FIELD(44, recorderPreMs),
+    CONFIG_FIELD(45, recorderPostMs),
+    CONFIG_FIELD(46, recorderCaptures),
+    CONFIG_FIELD(47, recorderControlEntries),
+    CONFIG_FIELD(48, monitorIntervalMs),
+    CONFIG_FIELD(49, controlBudgetUs),
+    CONFIG_FIELD(50, baudRate),
+    CONFIG_FIELD(51, telemetryBinary),
+    CONFIG_FIELD(52, potFeedCal),
+    CONFIG_FIELD(53, potTensionCal),
+    CONFIG_FIELD(54, potCalFeedMinDeg),
+    CONFIG_FIELD(55, potCalFeedMaxDeg),
+    CONFIG_FIELD(56, potCalSettleMs),
+    CONFIG_FIELD(57, potCalSamples),
+    CONFIG_FIELD(58, tensionTrack),
+    CONFIG_FIELD(59, tensionTrackTauSec),
+    CONFIG_FIELD(60, tensionTrackWarmupMs),
+    CONFIG_FIELD(61, tensionTrackStartDeg),
+    CONFIG_FIELD(62, tensionTrackStopDeg),
+    CONFIG_FIELD(63, tensionTrackGain),
+    CONFIG_FIELD(64, tensionTrackIntervalMs),
+    CONFIG_FIELD(65, tensionTrackMaxDegPerMin),
+    CONFIG_FIELD(66, tensionTrackMaxConfidence),
+    CONFIG_FIELD(67, tensionTrackIdleMs),
+    CONFIG_FIELD(68, feedArmLengthMm),
+    CONFIG_FIELD(69, springAnchorMm),
+    CONFIG_FIELD(70, tensionArmLengthMm),
+    CONFIG_FIELD(71, pivotSpacingMm),
+    CONFIG_FIELD(72, pathGain),
+    CONFIG_FIELD(73, springRate),
+    CONFIG_FIELD(74, springFreeMm),
+    CONFIG_FIELD(75, jamTensionN),
+    CONFIG_FIELD(76, wheelPulsesPerRev),
+    CONFIG_FIELD(77, wheelDiameterMm),
+    CONFIG_FIELD(78, wheelQuadrature),
+    CONFIG_FIELD(79, odometerPrintGapMs),
+    CONFIG_FIELD(80, printerLink),
+    CONFIG_FIELD(81, printerBaud),
+    CONFIG_FIELD(82, printerLinkTimeoutMs),
+    CONFIG_FIELD(83, printerRetryMs),
+    CONFIG_FIELD(84, printerHold),
+    CONFIG_FIELD(85, printerSlipMarginMm),
+    CONFIG_FIELD(86, jamWobbleGain),
+    CONFIG_FIELD(87, spectrum),
+    CONFIG_FIELD(88, spectrumDecimation),
+    CONFIG_FIELD(89, spectrumAnomalyDb),
+    CONFIG_FIELD(90, spectrumAdapt),
+    CONFIG_FIELD(91, lowPower),
+    CONFIG_FIELD(92, idleAfterMs),
+    CONFIG_FIELD(93, idleTickMs),
+    CONFIG_FIELD(94, idleWakeDeg),
+    CONFIG_FIELD(95, idleCpuMhz),
+    CONFIG_FIELD(96, wakeBudgetUs),
+};
+
+#undef CONFIG_FIELD
+
+static const ConfigField* findField(uint8_t id) {
+    for (const ConfigField& f : kFields) {
+        if (f.id == id) return &f;
+    }
+    return nullptr;
+}
+
+// --- Little-endian helpers ---
+
+static void putU16(uint8_t* p, uint16_t v) {
+    p[0] = v & 0xff;
+    p[1] = v >> 8;
+}
+
+static void putU32(uint8_t* p, uint32_t v) {
+    putU16(p, v & 0xffff);
+    putU16(p + 2, v >> 16);
+}
+
+static uint16_t getU16(const uint8_t* p) {
+    return p[0] | (uint16_t)p[1] << 8;
+}
+
+static uint32_t getU32(const uint8_t* p) {
+    return getU16(p) | (uint32_t)getU16(p + 2) << 16;
+}
+
+// --- CRC ---
+
+uint32_t crc32(const uint8_t* data, size_t len) {
+    // IEEE 802.3, reflected. Bitwise: blobs are small and only read at boot.
+    uint32_t crc = 0xffffffff;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (uint8_t b = 0; b < 8; b++) {
+            crc = (crc >> 1) ^ (0xedb88320 & (0 - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+// --- Blob ---
+
+const char* configLoadResultName(ConfigLoadResult result) {
+    switch (result) {
+        case ConfigLoadResult::LOADED:   return "loaded";
+        case ConfigLoadResult::MIGRATED: return "migrated";
+        case ConfigLoadResult::DEFAULTS: return "defaults";
+        case ConfigLoadResult::CORRUPT:  return "corrupt";
+        default:                         return "unknown";
+    }
+}
+
+size_t encodeConfig(const Config& cfg, uint8_t* out, size_t len) {
+    // Field values are stored as their in-memory bytes; both ends are the
+    // same little-endian ESP32 build.
+    const uint8_t* base = reinterpret_cast<const uint8_t*>(&cfg);
+    size_t n = kHeaderBytes;
+    for (const ConfigField& f : kFields) {
+        if (n + 2 + f.size > len) return 0;
+        out[n++] = f.id;
+        out[n++] = f.size;
+        memcpy(&out[n], base + f.offset, f.size);
+        n += f.size;
+    }
+    size_t payload = n - kHeaderBytes;
+    putU32(out, kConfigMagic);
+    putU16(out + 4, kConfigVersion);
+    putU16(out + 6, (uint16_t)payload);
+    putU32(out + 8, crc32(out + kHeaderBytes, payload));
+    return n;
+}
+
+ConfigLoadResult decodeConfig(const uint8_t* blob, size_t len, Config& cfg) {
+    if (len < kHeaderBytes || getU32(blob) != kConfigMagic) return ConfigLoadResult::CORRUPT;
+    uint16_t version = getU16(blob + 4);
+    size_t payload = getU16(blob + 6);
+    if (version == 0 || version > kConfigVersion || kHeaderBytes + payload > len ||
+        crc32(blob + kHeaderBytes, payload) != getU32(blob + 8)) {
+        return ConfigLoadResult::CORRUPT;
+    }
+
+    // Decode into a copy so a malformed record leaves cfg alone.
+    Config out = cfg;
+    uint8_t* base = reinterpret_cast<uint8_t*>(&out);
+    const uint8_t* p = blob + kHeaderBytes;
+    const uint8_t* end = p + payload;
+    while (p < end) {
+        if (end - p < 2 || end - p - 2 < p[1]) return ConfigLoadResult::CORRUPT;
+        const ConfigField* f = findField(p[0]);
+        if (f && f->size == p[1]) memcpy(base + f->offset, p + 2, f->size);
+        p += 2 + p[1];
+    }
+
+    if (version < kConfigVersion) {
+        migrateConfig(out, version);
+        cfg = out;
+        return ConfigLoadResult::MIGRATED;
+    }
+    cfg = out;
+    return ConfigLoadResult::LOADED;
+}
+
+void migrateConfig(Config& cfg, uint16_t fromVersion) {
+    // One case per version bump, falling through to the newest, e.g.
+    //   case 1: cfg.someAngle = 160.0f - cfg.someAngle;   // axis flipped in v2
+    switch (fromVersion) {
+    default:
+        break;
+    }
+    (void)cfg;
+}
+
+// --- Store ---
+
+void ConfigStore::key(uint8_t channel, char* out) {
+    // NVS keys are at most 15 characters.
+    out[0] = 'c';
+    out[1] = 'f';
+    out[2] = 'g';
+    out[3] = (char)('0' + channel % 10);
+    out[4] = '\0';
+}
+
+ConfigLoadResult ConfigStore::load(uint8_t channel, Config& cfg) {
+    if (!_storage) return ConfigLoadResult::DEFAULTS;
+    uint8_t blob[kConfigBlobMax];
+    char k[8];
+    key(channel, k);
+    size_t n = _storage->read(k, blob, sizeof(blob));
+    _lastBytes = n;
+    if (n == 0) return ConfigLoadResult::DEFAULTS;
+    return decodeConfig(blob, n, cfg);
+}
+
+bool ConfigStore::save(uint8_t channel, const Config& cfg) {
+    if (!_storage) return false;
+    uint8_t blob[kConfigBlobMax];
+    size_t n = encodeConfig(cfg, blob, sizeof(blob));
+    if (n == 0) return false;
+    char k[8];
+    key(channel, k);
+    _lastBytes = n;
+    return _storage->write(k, blob, n);
+}
+
+bool ConfigStore::erase(uint8_t channel) {
+    if (!_storage) return false;
+    char k[8];
+    key(channel, k);
+    return _storage->erase(k);
+}
@@ -1,5 +1,10 @@
 #include "FeedArmController.h"
 
+#include <cmath>
+#include <cstdio>
+#include "IdleMonitor.h"
+#include "Profiler.h"
+
 const char* feedArmStateName(FeedArmState state) {
     switch (state) {
         case FeedArmState::MONITORING:   return "MONITORING";
@@ -7,70 +12,149 @@ const char* feedArmStateName(FeedArmState state) {
         case FeedArmState::HOLD_UNSTICK: return "HOLD_UNSTICK";
         case FeedArmState::RETURNING:    return "RETURNING";
         case FeedArmState::COOLDOWN:     return "COOLDOWN";
+        case FeedArmState::CALIBRATING:  return "CALIBRATING";
         default:                         return "UNKNOWN";
     }
 }
 
-void FeedArmController::begin(const Config& cfg, uint8_t feedServoPin,
-                               uint8_t tensionServoPin, uint8_t feedPotPin,
-                               uint8_t tensionPotPin, ReedSwitch* reed) {
+const char* printerActivityName(PrinterActivity activity) {
+    switch (activity) {
+        case PrinterActivity::IDLE:      return "idle";
+        case PrinterActivity::TRAVEL:    return "travel";
+        case PrinterActivity::EXTRUDING: return "extruding";
+        case PrinterActivity::PAUSED:    return "paused";
+        default:                         return "unknown";
+    }
+}
+
+int formatFeedArmEvent(const FeedArmEvent& ev, char* buf, size_t len) {
+    switch (ev.type) {
+    case FeedArmEventType::STATE_CHANGE:
+        return snprintf(buf, len, "[FeedArm] %s -> %s",
+                        feedArmStateName(ev.from), feedArmStateName(ev.to));
+    case FeedArmEventType::JAM_DETECTED:
+        return snprintf(buf, len, "[FeedArm] JAM! Arm angle=%.0f° (%s, confidence=%.2f) stall=%s",
+                        ev.a, jamPathName((JamPath)ev.n), ev.b, ev.flag ? "YES" : "no");
+    case FeedArmEventType::TENSION_RELAXED:
+        return snprintf(buf, len, "[FeedArm] Tension relaxed: %.0f° -> %.0f°", ev.a, ev.b);
+    case FeedArmEventType::SERVO_ATTACHED:
+        return snprintf(buf, len, "[FeedArm] Servo ATTACHED — driving to unstick angle");
+    case FeedArmEventType::UNSTICK_COMPLETE:
+        return snprintf(buf, len, "[FeedArm] Unstick #%u complete. Returning to %.0f°",
+                        (unsigned)ev.n, ev.a);
+    case FeedArmEventType::SERVO_DETACHED:
+        return snprintf(buf, len, "[FeedArm] Servo DETACHED — back to monitoring");
+    case FeedArmEventType::TENSION_RESTORED:
+        return snprintf(buf, len, "[FeedArm] Tension restored to %.0f°", ev.a);
+    case FeedArmEventType::TENSION_SET:
+        return snprintf(buf, len, "[FeedArm] Tension set to %.0f°", ev.a);
+    case FeedArmEventType::MANUAL_UNSTICK:
+        return snprintf(buf, len, "[FeedArm] Manual unstick triggered.");
+    case FeedArmEventType::UNSTICK_CONFIRMED:
+        return snprintf(buf, len, "[FeedArm] Unstick confirmed by %s after %u ms (arm=%.0f°)",
+                        ev.flag ? "reed" : "pot", (unsigned)ev.n, ev.a);
+    case FeedArmEventType::UNSTICK_STAGE:
+        return snprintf(buf, len, "[FeedArm] %s stage %u: %.0f°, tension %.0f°",
+                        ev.flag ? "Escalating to" : "Unstick", (unsigned)ev.n, ev.a, ev.b);
+    case FeedArmEventType::UNSTICK_RESULT:
+        return snprintf(buf, len, "[FeedArm] Stage %u %s (success rate %.0f%%)",
+                        (unsigned)ev.n, ev.flag ? "cleared the jam" : "failed", ev.a * 100.0f);
+    case FeedArmEventType::UNSTICK_GAVE_UP:
+        return snprintf(buf, len, "[FeedArm] All %u stages failed — cooling down",
+                        (unsigned)ev.n);
+    case FeedArmEventType::TENSION_TRACKED:
+        return snprintf(buf, len, "[FeedArm] Tension tracked to %.1f° (arm resting at %.1f°)",
+                        ev.a, ev.b);
+    case FeedArmEventType::POT_SWEEP_DONE:
+        return snprintf(buf, len, "[FeedArm] Pot sweep done: feed %.0f, tension %.0f counts%s",
+                        ev.a, ev.b, ev.flag ? "" : " (a pot wasn't monotonic, keeping its old map)");
+    case FeedArmEventType::SPOOL_WOBBLE:
+        return snprintf(buf, len, "[FeedArm] Spool wobble: %.3f Hz (%u%% of arm motion), anomaly %.2f",
+                        ev.a, (unsigned)ev.n, ev.b);
+    case FeedArmEventType::IDLE_ENTERED:
+        return snprintf(buf, len, "[Power] Idle after %.0fs quiet, ticking every %ums",
+                        ev.a, (unsigned)ev.n);
+    case FeedArmEventType::IDLE_WOKE:
+        return snprintf(buf, len, "[Power] Awake (%s) after %.0fs idle",
+                        wakeReasonName((WakeReason)ev.n), ev.a);
+    }
+    return snprintf(buf, len, "[FeedArm] event %u", (unsigned)ev.type);
+}
+
+void FeedArmController::begin(const Config& cfg, const FeedArmIo& io,
+                              uint8_t feedServoPin, uint8_t tensionServoPin,
+                              uint8_t feedPotPin, uint8_t tensionPotPin,
+                              ReedSwitch* reed) {
     _cfg = cfg;
     _reed = reed;
+    _clock = io.clock;
+    _pots = io.pots;
+    _feedServo = io.feedServo;
+    _tensionServo = io.tensionServo;
     _feedServoPin = feedServoPin;
     _tensionServoPin = tensionServoPin;
     _feedPotPin = feedPotPin;
     _tensionPotPin = tensionPotPin;
 
-    // Configure ADC pins for potentiometers.
-    analogReadResolution(12);       // 0-4095
-    analogSetAttenuation(ADC_11db); // 0-3.3V range
-    pinMode(_feedPotPin, INPUT);
-    pinMode(_tensionPotPin, INPUT);
+    // Background sampling of both pots.
+    const uint8_t potPins[] = { _feedPotPin, _tensionPotPin };
+    _pots->begin(potPins, 2, _cfg.potSampleRateHz, _cfg.potSamples);
+    // Let the first window fill before taking initial readings.
+    _clock->delayMs(_cfg.potSamples * 1000 / _cfg.potSampleRateHz + 10);
 
     // Tension servo: attach and hold position (stays locked during printing).
-    _tensionServo.setPeriodHertz(50);
-    _tensionServo.attach(_tensionServoPin, 500, 2500);
+    _tensionServo->attach(_tensionServoPin, 500, 2500);
     _tensionAngle = _cfg.tensionServoAngle;
-    _tensionServo.write((int)_tensionAngle);
+    _baseTensionAngle = _tensionAngle;
+    _tensionServo->write(_tensionAngle);
 
-    // Feed servo: configure but start DETACHED.
+    // Feed servo: start DETACHED.
     // During monitoring, the arm floats freely with the spring.
     // The pot reads the actual angle.
-    _feedServo.setPeriodHertz(50);
     _feedServoAttached = false;
+    _feedMotion.begin(_feedServo);
     // Don't attach yet — arm should float in MONITORING state.
 
     _state = FeedArmState::MONITORING;
-    _stateEnteredAt = millis();
-    _lastReedSampleTime = millis();
+    _stateEnteredAt = _clock->millis();
+    _stallCheckedAt = _stateEnteredAt;
     _unstickCount = 0;
+    _tracker.restart(_stateEnteredAt);
+    selectDetector();
+    selectFilters();
+    _spectrum.configure(_cfg);
+
+    configureReed();
 
     // Read initial angles from pots.
-    _feedArmAngle = readPotAngle(_feedPotPin, _cfg.potFeedMin, _cfg.potFeedMax);
-    _tensionArmAngle = readPotAngle(_tensionPotPin, _cfg.potTensionMin, _cfg.potTensionMax);
+    _feedArmAngle = readPotAngle(_feedPotPin, _feedTable, _feedFilter);
+    _tensionArmAngle = readPotAngle(_tensionPotPin, _tensionTable, _tensionFilter);
+    _filamentTension = _tensionModel.newtons(_feedArmAngle, _tensionArmAngle);
 
-    Serial.printf("[FeedArm] Init. Feed pot=%.0f° Tension pot=%.0f°\n",
-                  _feedArmAngle, _tensionArmAngle);
-    Serial.printf("[FeedArm] Jam threshold=%.0f° Unstick=%.0f° Tension cmd=%.0f°\n",
-                  _cfg.feedArmJamAngle, _cfg.feedArmUnstickAngle, _tensionAngle);
-    Serial.printf("[FeedArm] Feed servo DETACHED (arm floating with spring)\n");
+    logPrintf("[FeedArm] Init. Feed pot=%.0f° Tension pot=%.0f°\n",
+              _feedArmAngle, _tensionArmAngle);
+    logPrintf("[FeedArm] Jam threshold=%.0f° Unstick ladder=%u stages Tension cmd=%.0f°\n",
+              _cfg.feedArmJamAngle, _cfg.unstickStages, _tensionAngle);
+    logPrintf("[FeedArm] Feed servo DETACHED (arm floating with spring)\n");
 }
 
 void FeedArmController::update() {
-    uint32_t now = millis();
+    PROFILE_SCOPE(ARM_UPDATE);
+    uint32_t now = _clock->millis();
     uint32_t elapsed = now - _stateEnteredAt;
 
     // Always read pot angles — gives actual arm position regardless of servo state.
-    _feedArmAngle = readPotAngle(_feedPotPin, _cfg.potFeedMin, _cfg.potFeedMax);
-    _tensionArmAngle = readPotAngle(_tensionPotPin, _cfg.potTensionMin, _cfg.potTensionMax);
-
-    // Sample reed switch periodically.
-    if (now - _lastReedSampleTime >= 1000) {
-        if (_reed) {
-            _reed->sample();
-            _filamentStalled = _reed->isStalled(_cfg.reedStallTimeoutMs);
-        }
-        _lastReedSampleTime = now;
+    _feedArmAngle = readPotAngle(_feedPotPin, _feedTable, _feedFilter);
+    _tensionArmAngle = readPotAngle(_tensionPotPin, _tensionTable, _tensionFilter);
+    _filamentTension = _tensionModel.newtons(_feedArmAngle, _tensionArmAngle);
+
+    // Reed stall check every tick — pulses are timestamped by the ISR, so
+    // this reacts within a few pulse periods rather than a fixed timeout.
+    if (_reed) {
+        updateStall(now);
+        _odometer.update(_reed->position(), _reed->timeSinceLastPulseMs(),
+                         _cfg.odometerPrintGapMs);
+        if (_recorder) recordReed();
     }
 
     switch (_state) {
@@ -79,130 +163,553 @@ void FeedArmController::update() {
         // Feed servo is DETACHED. Arm floats with spring.
         // Pot reads actual arm angle driven by spring tension vs filament pull.
         // Jam detection: angle drops below threshold (filament pulling arm toward spool).
+        if (_cfg.spectrum) updateSpectrum();
         if (isJamDetected()) {
-            Serial.printf("[FeedArm] JAM! Arm angle=%.0f° (threshold=%.0f°) stall=%s\n",
-                          _feedArmAngle, _cfg.feedArmJamAngle,
-                          _filamentStalled ? "YES" : "no");
+            emit(FeedArmEventType::JAM_DETECTED, _feedArmAngle,
+                 _detector->confidence(), (uint32_t)_detector->path(), _filamentStalled);
             transitionTo(FeedArmState::UNSTICKING);
+        } else {
+            trackTension(now);
         }
         break;
 
     case FeedArmState::UNSTICKING:
-        // Relax tension servo first so feed arm doesn't fight spring + jam.
-        // Then attach feed servo and drive to unstick angle.
-        if (!_feedServoAttached) {
-            _savedTensionAngle = _tensionAngle;
-            _tensionServo.write((int)_cfg.tensionAngleMin);
-            Serial.printf("[FeedArm] Tension relaxed: %.0f° -> %.0f° (min)\n",
-                          _savedTensionAngle, _cfg.tensionAngleMin);
-
-            _feedServo.attach(_feedServoPin, 500, 2500);
-            _feedServoAttached = true;
-            Serial.println("[FeedArm] Servo ATTACHED — driving to unstick angle");
+        // Servo follows the profile out to the stage's angle (started in
+        // enterState), then shakes: down from wherever the arm got to and
+        // back up. The spool may break free on the way, which ends it.
+        if (!_unstickConfirmed && reedResumed()) confirmUnstick(true);
+        if (_feedMotion.update(_clock->micros())) {
+            if (_shakeLegs > 0 && !_unstickConfirmed) {
+                float to = _shakeLegs % 2 == 0
+                    ? fmaxf(_feedArmAngle - _cfg.unstickShakeDeg, 0.0f)
+                    : _cfg.unstickLadder[_stage].angle;
+                _shakeLegs--;
+                _feedMotion.moveTo(_feedArmAngle, to, _cfg.unstickMaxDegPerSec,
+                                   _cfg.unstickAccelDegPerSec2, _clock->micros());
+            } else {
+                transitionTo(FeedArmState::HOLD_UNSTICK);
+            }
         }
-        _feedServo.write((int)_cfg.feedArmUnstickAngle);
-        transitionTo(FeedArmState::HOLD_UNSTICK);
         break;
 
     case FeedArmState::HOLD_UNSTICK:
-        // Hold the unstick position for the configured duration.
-        // Servo stays attached and holding.
-        if (elapsed >= _cfg.unstickHoldTimeMs) {
+        // Hold until the filament is shown to be free: the spool turning, or
+        // (for a yank) the arm sitting at the unstick angle instead of being
+        // held short by the snag. Otherwise give up once the pull (profile
+        // included) has lasted the stage's hold time.
+        if (!_unstickConfirmed) {
+            if (reedResumed()) {
+                confirmUnstick(true);
+            } else if (_cfg.unstickLadder[_stage].angle > _cfg.feedArmRestAngle &&
+                       _feedMotion.reached(_feedArmAngle, _cfg.unstickArriveTolDeg)) {
+                if (!_atTarget) {
+                    _atTarget = true;
+                    _atTargetSince = now;
+                } else if (now - _atTargetSince >= _cfg.unstickSettleMs) {
+                    confirmUnstick(false);
+                }
+            } else {
+                _atTarget = false;
+            }
+        }
+        if (_unstickConfirmed ||
+            now - _unstickStartedAt >= _cfg.unstickLadder[_stage].holdMs) {
             transitionTo(FeedArmState::RETURNING);
         }
         break;
 
     case FeedArmState::RETURNING:
-        // Drive back to rest angle, then detach.
-        _feedServo.write((int)_cfg.feedArmRestAngle);
-        _unstickCount++;
-        Serial.printf("[FeedArm] Unstick #%u complete. Returning to %.0f°\n",
-                      _unstickCount, _cfg.feedArmRestAngle);
-        transitionTo(FeedArmState::COOLDOWN);
+        // Profile back to rest; done once the pot shows the arm at or below
+        // rest (the spring takes it from there), or after a timeout if
+        // something holds the arm up.
+        if (!_unstickConfirmed && reedResumed()) confirmUnstick(true);
+        if (_feedMotion.update(_clock->micros()) &&
+            (_feedArmAngle <= _cfg.feedArmRestAngle + _cfg.unstickArriveTolDeg ||
+             elapsed >= _feedMotion.durationMs() + _cfg.unstickReturnTimeoutMs)) {
+            transitionTo(FeedArmState::COOLDOWN);
+        }
         break;
 
     case FeedArmState::COOLDOWN:
-        // Wait before detaching servo and returning to monitoring.
-        // Keep servo attached briefly so it reaches rest position.
-        if (elapsed >= _cfg.unstickCooldownMs) {
-            // Detach feed servo — arm floats with spring again.
-            if (_feedServoAttached) {
-                _feedServo.detach();
-                _feedServoAttached = false;
-                Serial.println("[FeedArm] Servo DETACHED — back to monitoring");
+        // Servo detached and tension restored (enterState). Once the spring
+        // has re-tensioned, judge the attempt: confirmed ends the jam,
+        // unconfirmed escalates to the next stage. Only an exhausted ladder
+        // waits the full cooldown, so a hard snag isn't hammered.
+        if (!_unstickConfirmed && reedResumed()) confirmUnstick(true);
+        if (!_attemptJudged && elapsed >= _cfg.unstickCooldownMinMs) {
+            _attemptJudged = true;
+            _ladder.record(_stage, _unstickConfirmed);
+            emit(FeedArmEventType::UNSTICK_RESULT, _ladder.successRate(_stage), 0,
+                 _stage + 1, _unstickConfirmed);
+            if (!_unstickConfirmed) {
+                int next = _ladder.next(_cfg, _stage);
+                if (next >= 0) {
+                    _stage = (uint8_t)next;
+                    _escalating = true;
+                    transitionTo(FeedArmState::UNSTICKING);
+                    break;
+                }
+                _ladder.giveUp();
+                emit(FeedArmEventType::UNSTICK_GAVE_UP, 0, 0, _stage - _firstStage + 1);
             }
-            // Restore tension servo to its pre-unstick angle.
-            _tensionAngle = _savedTensionAngle;
-            _tensionServo.write((int)_tensionAngle);
-            Serial.printf("[FeedArm] Tension restored to %.0f°\n", _tensionAngle);
-            // Reset reed switch to avoid false stall after unstick action.
-            if (_reed) _reed->reset();
+        }
+        if (!_attemptJudged) break;
+        if (elapsed >= _cfg.unstickCooldownMs ||
+            (_unstickConfirmed && elapsed >= _cfg.unstickCooldownMinMs &&
+             _feedArmAngle >= _cfg.feedArmRestAngle - _cfg.unstickRecoveredDeg)) {
             transitionTo(FeedArmState::MONITORING);
         }
         break;
+
+    case FeedArmState::CALIBRATING:
+        updateCalibration(now);
+        break;
     }
 }
 
+void FeedArmController::updateConfig(const Config& cfg) {
+    // tensionServoAngle is the operator's setting. Only a new one moves the
+    // servo; any other push keeps the tracked angle.
+    bool newBase = cfg.tensionServoAngle != _cfg.tensionServoAngle;
+    // Resetting restarts the detector's settle window: only for its own settings.
+    bool newDetector = jamDetectorConfigChanged(_cfg, cfg);
+    _cfg = cfg;
+    if (newBase && constrain(cfg.tensionServoAngle, cfg.tensionAngleMin, cfg.tensionAngleMax) !=
+                   _baseTensionAngle) {
+        setTensionAngle(cfg.tensionServoAngle);
+    }
+    if (newDetector) selectDetector();
+    selectFilters();
+    _spectrum.configure(_cfg);
+    _pots->setWindow(_cfg.potSamples);
+    configureReed();
+}
+
 void FeedArmController::triggerUnstick() {
     if (_state == FeedArmState::MONITORING || _state == FeedArmState::COOLDOWN) {
-        Serial.println("[FeedArm] Manual unstick triggered.");
+        emit(FeedArmEventType::MANUAL_UNSTICK);
         transitionTo(FeedArmState::UNSTICKING);
     }
 }
 
+bool FeedArmController::startCalibration() {
+    if (_state != FeedArmState::MONITORING) return false;
+    transitionTo(FeedArmState::CALIBRATING);
+    return true;
+}
+
+bool FeedArmController::takeCalibration(PotSweepResult& out) {
+    if (!_calReady) return false;
+    out = _calResult;
+    _calReady = false;
+    return true;
+}
+
 void FeedArmController::setTensionAngle(float angle) {
     _tensionAngle = constrain(angle, _cfg.tensionAngleMin, _cfg.tensionAngleMax);
-    _tensionServo.write((int)_tensionAngle);
-    Serial.printf("[FeedArm] Tension set to %.0f°\n", _tensionAngle);
+    _baseTensionAngle = _tensionAngle;
+    _tensionServo->write(_tensionAngle);
+    // Judge the new setting afresh before tracking moves it.
+    _tracker.restart(_clock->millis());
+    emit(FeedArmEventType::TENSION_SET, _tensionAngle);
+}
+
+void FeedArmController::trackTension(uint32_t now) {
+    // Every calm monitoring tick counts, sticking spells included: the
+    // reed pulses too rarely to tell them from moving ones, and averaging
+    // only just after pulses would see the arm after each breakaway. Long
+    // reed silence means nothing is printing, or the spool has run out.
+    if (!_reed || _reed->timeSinceLastPulseMs() > _cfg.tensionTrackIdleMs ||
+        _detector->confidence() > _cfg.tensionTrackMaxConfidence) {
+        return;
+    }
+    float to = 0;
+    if (!_tracker.update(_cfg, now, _feedArmAngle, _tensionAngle, _baseTensionAngle, to)) return;
+    _tensionAngle = to;
+    _tensionServo->write(_tensionAngle);
+    // The detector's learned breakaway level belongs to the old tension,
+    // and the spring settles again. _cfg keeps the operator's angle: the
+    // comms side's copy is the one that gets saved.
+    _trajectoryDetector.relearn();
+    _detector->reset(_cfg);
+    emit(FeedArmEventType::TENSION_TRACKED, _tensionAngle, _tracker.restingAngle());
+}
+
+void FeedArmController::updateSpectrum() {
+    // Only printing says anything about the spool. An idle arm just sits,
+    // and a window straddling the restart would see a step.
+    if (!_reed || _reed->timeSinceLastPulseMs() > _cfg.tensionTrackIdleMs) {
+        _spectrum.restart();
+        _wobbling = false;
+        return;
+    }
+    // Leave out the spring re-tensioning after an unstick, and carry on
+    // the window across it: the unstick doesn't cure a tangle, and a
+    // window of evidence takes minutes to gather.
+    if (_clock->millis() - _stateEnteredAt < _cfg.jamSettleMs) return;
+    if (!_spectrum.push(_feedArmAngle)) return;
+    const ArmSpectrumFeatures& f = _spectrum.features();
+    bool wobbling = f.anomaly >= 1.0f;
+    if (wobbling && !_wobbling) {
+        emit(FeedArmEventType::SPOOL_WOBBLE, f.peakHz, f.anomaly,
+             (uint32_t)(f.peakShare * 100.0f + 0.5f));
+    }
+    _wobbling = wobbling;
+}
+
+void FeedArmController::setPrinterFeed(const PrinterFeed& feed) {
+    _printer = feed;
+    _printerAt = _clock->millis();
+}
+
+bool FeedArmController::printerKnown(uint32_t now) const {
+    return _printer.activity != PrinterActivity::UNKNOWN &&
+           now - _printerAt <= _cfg.printerLinkTimeoutMs;
+}
+
+float FeedArmController::expectedFeed() const {
+    return printerKnown(_clock->millis()) ? _printer.mmPerSec : -1.0f;
+}
+
+void FeedArmController::updateStall(uint32_t now) {
+    uint32_t dt = now - _stallCheckedAt;
+    _stallCheckedAt = now;
+    uint32_t pulses = _reed->pulseCount();
+    if (pulses != _feedPulseBase) {
+        _feedPulseBase = pulses;
+        _feedSincePulseMm = 0;
+    }
+    if (!printerKnown(now)) {
+        _feedSincePulseMm = 0;
+        _filamentStalled = _reed->isStalled(_cfg.reedStallPeriods, _cfg.reedStallMinMs,
+                                            _cfg.reedStallTimeoutMs);
+        return;
+    }
+    // The printer says how much filament it has asked for. The wheel must
+    // keep up, give or take what the arm can give up; a travel move or a
+    // pause asks for nothing, so the wheel stopping then isn't a stall.
+    _feedSincePulseMm += _printer.mmPerSec * dt * 0.001f;
+    _filamentStalled = _feedSincePulseMm > _reed->mmPerPulse() + _cfg.printerSlipMarginMm;
+}
+
+void FeedArmController::configureReed() {
+    if (!_reed) return;
+    // The longest bounce window is per revolution: a fast spin past
+    // several magnets must not read as bounce.
+    uint16_t perRev = _cfg.wheelPulsesPerRev ? _cfg.wheelPulsesPerRev : 1;
+    _reed->setDebounce(_cfg.reedDebounceMinUs, _cfg.reedDebounceMaxUs / perRev,
+                       _cfg.reedDebounceFraction);
+    _reed->setWheel(perRev, _cfg.wheelDiameterMm);
 }
 
 float FeedArmController::filamentPulsesPerSec() const {
     return _reed ? _reed->pulsesPerSec() : 0;
 }
 
+float FeedArmController::filamentSpeed() const {
+    return _reed ? _reed->speedMmPerSec() : 0;
+}
+
+float FeedArmController::filamentUsedMm() const {
+    return _reed ? _odometer.totalPulses() * _reed->mmPerPulse() : 0;
+}
+
+float FeedArmController::printUsedMm() const {
+    return _reed ? _odometer.printPulses() * _reed->mmPerPulse() : 0;
+}
+
+void FeedArmController::recordReed() {
+    // One record per tick with new pulses, stamped with the newest pulse.
+    uint64_t stampUs = _reed->lastPulseUs();
+    uint32_t pulses = _reed->pulseCount();
+    if (stampUs == 0 || stampUs == _recordedPulseUs) return;
+    uint32_t n = pulses > _recordedPulses ? pulses - _recordedPulses : 1;
+    _recorder->recordControl(RecordKind::REED, n > 0xffff ? 0xffff : (uint16_t)n, stampUs,
+                             _channel);
+    _recordedPulseUs = stampUs;
+    _recordedPulses = pulses;
+}
+
 void FeedArmController::transitionTo(FeedArmState newState) {
-    if (newState != _state) {
-        Serial.printf("[FeedArm] %s -> %s\n",
-                      feedArmStateName(_state), feedArmStateName(newState));
+    if (_recorder && newState != _state) {
+        uint64_t nowUs = _clock->micros();
+        _recorder->recordControl(RecordKind::STATE, (uint16_t)newState, nowUs, _channel);
+        if (newState == FeedArmState::UNSTICKING) _recorder->trigger(nowUs);
     }
+    if (newState != _state && _events) {
+        FeedArmEvent ev = {};
+        ev.timeMs = _clock->millis();
+        ev.type = FeedArmEventType::STATE_CHANGE;
+        ev.from = _state;
+        ev.to = newState;
+        ev.channel = _channel;
+        _events->push(ev);
+    }
+    FeedArmState from = _state;
     _state = newState;
-    _stateEnteredAt = millis();
+    _stateEnteredAt = _clock->millis();
+    if (newState != from) enterState();
+}
+
+void FeedArmController::enterState() {
+    uint64_t nowUs = _clock->micros();
+
+    switch (_state) {
+    case FeedArmState::MONITORING:
+        // Reset reed switch to avoid false stall after unstick action.
+        if (_reed) _reed->reset();
+        // The servo has just been driving the arm; start the estimate afresh.
+        _detector->reset(_cfg);
+        _tracker.restart(_stateEnteredAt);
+        break;
+
+    case FeedArmState::UNSTICKING: {
+        // A fresh jam starts wherever the ladder has done best; an
+        // escalation carries on from the stage that just failed.
+        if (!_escalating) {
+            _stage = _firstStage = _ladder.begin(_cfg);
+        }
+        const UnstickStage& st = _cfg.unstickLadder[_stage];
+
+        // Relax the tension servo as far as the stage asks, then attach the
+        // feed servo and drive to the stage's angle.
+        if (!_feedServoAttached) {
+            _savedTensionAngle = _tensionAngle;
+            float relaxed = _tensionAngle - st.relax * (_tensionAngle - _cfg.tensionAngleMin);
+            if (relaxed < _tensionAngle) {
+                _tensionServo->write(relaxed);
+                emit(FeedArmEventType::TENSION_RELAXED, _savedTensionAngle, relaxed);
+            }
+
+            _feedServo->attach(_feedServoPin, 500, 2500);
+            _feedServoAttached = true;
+            emit(FeedArmEventType::SERVO_ATTACHED);
+            emit(FeedArmEventType::UNSTICK_STAGE, st.angle, relaxed, _stage + 1, _escalating);
+        }
+        _escalating = false;
+        _unstickStartedAt = _stateEnteredAt;
+        _unstickPulseBase = _reed ? _reed->pulseCount() : 0;
+        _unstickConfirmed = false;
+        _shakeLegs = st.shakes * 2;
+        // Start from the measured angle so the servo doesn't jump to
+        // wherever it was last commanded.
+        _feedMotion.moveTo(_feedArmAngle, st.angle,
+                           _cfg.unstickMaxDegPerSec, _cfg.unstickAccelDegPerSec2, nowUs);
+        break;
+    }
+
+    case FeedArmState::HOLD_UNSTICK:
+        _atTarget = false;
+        break;
+
+    case FeedArmState::RETURNING:
+        // From where the arm actually is. If the snag held it below rest
+        // there's nothing to drive back, so the servo just holds it there.
+        _feedMotion.moveTo(_feedArmAngle, fminf(_feedArmAngle, _cfg.feedArmRestAngle),
+                           _cfg.unstickMaxDegPerSec, _cfg.unstickAccelDegPerSec2, nowUs);
+        _unstickCount++;
+        emit(FeedArmEventType::UNSTICK_COMPLETE, _cfg.feedArmRestAngle, 0, _unstickCount);
+        break;
+
+    case FeedArmState::COOLDOWN:
+        _attemptJudged = false;
+        // Detach feed servo — arm floats with spring again.
+        if (_feedServoAttached) {
+            _feedServo->detach();
+            _feedServoAttached = false;
+            emit(FeedArmEventType::SERVO_DETACHED);
+        }
+        // Restore tension servo to its pre-unstick angle.
+        _tensionAngle = _savedTensionAngle;
+        _tensionServo->write(_tensionAngle);
+        emit(FeedArmEventType::TENSION_RESTORED, _tensionAngle);
+        break;
+
+    case FeedArmState::CALIBRATING:
+        // Hold the tension arm wherever the sweep puts it; the commanded
+        // tension comes back at the end.
+        _savedTensionAngle = _tensionAngle;
+        _feedServo->attach(_feedServoPin, 500, 2500);
+        _feedServoAttached = true;
+        for (uint8_t i = 0; i < kPotCalPoints; i++) {
+            _calFeedSum[i] = 0;
+            _calTensionSum[i] = 0;
+        }
+        _calReady = false;
+        _calStep = 0;
+        startCalibrationStep();
+        break;
+    }
+}
+
+// Sweep point visited at a step: up through the points, then back down, so
+// gear backlash and pot hysteresis average out.
+static uint8_t calPoint(uint8_t step) {
+    return step < kPotCalPoints ? step : (uint8_t)(2 * kPotCalPoints - 1 - step);
+}
+
+void FeedArmController::startCalibrationStep() {
+    float feedTo = _cfg.feedArmRestAngle;
+    float tensionTo = _savedTensionAngle;
+    if (_calStep < 2 * kPotCalPoints) {
+        float t = (float)calPoint(_calStep) / (kPotCalPoints - 1);
+        feedTo = _cfg.potCalFeedMinDeg + t * (_cfg.potCalFeedMaxDeg - _cfg.potCalFeedMinDeg);
+        tensionTo = _cfg.tensionAngleMin + t * (_cfg.tensionAngleMax - _cfg.tensionAngleMin);
+    }
+    _tensionServo->write(tensionTo);
+    // The first move starts from the measured angle; later ones from the
+    // last setpoint, which doesn't depend on the map being calibrated.
+    float from = _calStep == 0 ? _feedArmAngle : _feedMotion.target();
+    _feedMotion.moveTo(from, feedTo, _cfg.unstickMaxDegPerSec, _cfg.unstickAccelDegPerSec2,
+                       _clock->micros());
+    _calSampling = false;
+    _calTicks = 0;
+}
+
+void FeedArmController::updateCalibration(uint32_t now) {
+    if (!_calSampling) {
+        if (!_feedMotion.update(_clock->micros())) return;
+        _calSampling = true;
+        _calSince = now;
+    }
+    // Let both arms (and the pot window) settle before sampling.
+    if (now - _calSince < _cfg.potCalSettleMs) return;
+    if (_calStep == 2 * kPotCalPoints) {
+        finishCalibration();
+        return;
+    }
+
+    uint8_t point = calPoint(_calStep);
+    _calFeedSum[point] += _rawFeedPot;
+    _calTensionSum[point] += _rawTensionPot;
+    uint8_t samples = _cfg.potCalSamples ? _cfg.potCalSamples : 1;
+    if (++_calTicks < samples) return;
+    _calStep++;
+    startCalibrationStep();
+}
+
+void FeedArmController::finishCalibration() {
+    uint32_t div = 2 * (_cfg.potCalSamples ? _cfg.potCalSamples : 1);
+    PotCalibration& feed = _calResult.feed;
+    PotCalibration& tension = _calResult.tension;
+    feed.points = tension.points = kPotCalPoints;
+    feed.fromDeg = _cfg.potCalFeedMinDeg;
+    feed.toDeg = _cfg.potCalFeedMaxDeg;
+    tension.fromDeg = _cfg.tensionAngleMin;
+    tension.toDeg = _cfg.tensionAngleMax;
+    for (uint8_t i = 0; i < kPotCalPoints; i++) {
+        feed.adc[i] = (uint16_t)((_calFeedSum[i] + div / 2) / div);
+        tension.adc[i] = (uint16_t)((_calTensionSum[i] + div / 2) / div);
+    }
+    bool feedOk = potCalibrationValid(feed);
+    bool tensionOk = potCalibrationValid(tension);
+    if (!feedOk) feed.points = 0;
+    if (!tensionOk) tension.points = 0;
+    _calReady = true;
+    emit(FeedArmEventType::POT_SWEEP_DONE,
+         fabsf((float)feed.adc[kPotCalPoints - 1] - feed.adc[0]),
+         fabsf((float)tension.adc[kPotCalPoints - 1] - tension.adc[0]), kPotCalPoints,
+         feedOk && tensionOk);
+
+    _feedServo->detach();
+    _feedServoAttached = false;
+    _tensionAngle = _savedTensionAngle;
+    transitionTo(FeedArmState::MONITORING);
+}
+
+void FeedArmController::confirmUnstick(bool byReed) {
+    _unstickConfirmed = true;
+    emit(FeedArmEventType::UNSTICK_CONFIRMED, _feedArmAngle, 0,
+         _clock->millis() - _unstickStartedAt, byReed);
+}
+
+bool FeedArmController::reedResumed() const {
+    return _reed && _reed->pulseCount() - _unstickPulseBase >= _cfg.unstickReedPulses;
+}
+
+void FeedArmController::emit(FeedArmEventType type, float a, float b, uint32_t n,
+                             bool flag) {
+    if (!_events) return;
+    FeedArmEvent ev = {};
+    ev.timeMs = _clock->millis();
+    ev.type = type;
+    ev.from = ev.to = _state;
+    ev.flag = flag;
+    ev.a = a;
+    ev.b = b;
+    ev.n = n;
+    ev.channel = _channel;
+    _events->push(ev);
 }
 
 bool FeedArmController::isJamDetected() {
-    // Primary: pot angle below jam threshold.
-    // When filament is stuck, extruder pull increases tension on the spring arm,
-    // pulling it toward the spool (decreasing angle).
-    if (_feedArmAngle <= _cfg.feedArmJamAngle) {
-        return true;
+    JamInputs in;
+    in.nowMs = _clock->millis();
+    in.angle = _feedArmAngle;
+    in.tension = _filamentTension;
+    in.stalled = _filamentStalled;
+    in.msSinceReed = _reed ? _reed->timeSinceLastPulseMs() : UINT32_MAX;
+    in.pulsesPerSec = _reed ? _reed->pulsesPerSec() : 0;
+    in.wobble = _cfg.spectrum ? _spectrum.anomaly() : 0;
+    if (_reedFilter) {
+        // Milli-pulses per second keeps the fixed-point stages precise.
+        in.pulsesPerSec = _reedFilter->push((int32_t)(in.pulsesPerSec * 1000.0f)) * 0.001f;
     }
+    return _detector->update(in);
+}
 
-    // Secondary: reed switch shows filament has stalled AND arm angle is
-    // noticeably below rest (filament tension is building but hasn't hit
-    // the hard threshold yet). This catches slow-developing jams.
-    if (_filamentStalled && _feedArmAngle < (_cfg.feedArmRestAngle - 15.0f)) {
-        return true;
+void FeedArmController::selectDetector() {
+    if (_customDetector) {
+        _detector = _customDetector;
+    } else if (_cfg.jamDetector == JamDetectorType::THRESHOLD) {
+        _detector = &_thresholdDetector;
+    } else {
+        _detector = &_trajectoryDetector;
     }
+    _detector->reset(_cfg);
+}
 
-    return false;
+void FeedArmController::selectFilters() {
+    // A saved sweep table wins over the two-point range.
+    if (!_feedTable.build(_cfg.potFeedCal)) _feedTable.linear(_cfg.potFeedMin, _cfg.potFeedMax);
+    if (!_tensionTable.build(_cfg.potTensionCal)) {
+        _tensionTable.linear(_cfg.potTensionMin, _cfg.potTensionMax);
+    }
+    _tensionModel.build(_cfg);
+
+    // Only a change of chain restarts the filters; other config updates
+    // keep their history.
+    if (!_filtersSelected || _cfg.potFilter != _potFilterType) {
+        _feedFilter = _feedFilters.select(_cfg.potFilter);
+        _tensionFilter = _tensionFilters.select(_cfg.potFilter);
+        _potFilterType = _cfg.potFilter;
+    }
+    if (!_filtersSelected || _cfg.reedFilter != _reedFilterType) {
+        _reedFilter = _reedFilters.select(_cfg.reedFilter);
+        _reedFilterType = _cfg.reedFilter;
+    }
+    _filtersSelected = true;
 }
 
-float FeedArmController::readPotAngle(uint8_t pin, uint16_t adcMin, uint16_t adcMax) {
+void FeedArmController::setJamDetector(JamDetector* detector) {
+    _customDetector = detector;
+    selectDetector();
+}
+
+float FeedArmController::readPotAngle(uint8_t pin, const PotTable& table, SignalFilter* filter) {
     uint16_t raw = readPotSmoothed(pin);
 
     // Store raw for calibration display.
     if (pin == _feedPotPin) _rawFeedPot = raw;
     else if (pin == _tensionPotPin) _rawTensionPot = raw;
 
-    // Map ADC range to 0-160 degrees.
-    float angle = (float)(raw - adcMin) / (float)(adcMax - adcMin) * 160.0f;
-    return constrain(angle, 0.0f, 160.0f);
+    int32_t counts = filter ? filter->push(raw) : raw;
+    return table.centiDegrees(counts) * 0.01f;
 }
 
 uint16_t FeedArmController::readPotSmoothed(uint8_t pin) {
-    uint32_t sum = 0;
-    for (uint8_t i = 0; i < _cfg.potSamples; i++) {
-        sum += analogRead(pin);
-    }
-    return sum / _cfg.potSamples;
+    PROFILE_SCOPE(POT_READ);
+    // Newest windowed mean from the background sampler — no ADC access here.
+    int ch = _pots->channelIndex(pin);
+    return ch >= 0 ? _pots->read(ch) : 0;
 }
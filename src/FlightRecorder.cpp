@@ -0,0 +1,173 @@
+#include "FlightRecorder.h"
+
+#include "Platform.h"
+
+const char* recordKindName(RecordKind kind) {
+    switch (kind) {
+    case RecordKind::POT:           return "pot";
+    case RecordKind::REED:          return "reed";
+    case RecordKind::FEED_SERVO:    return "feed_servo";
+    case RecordKind::TENSION_SERVO: return "tension_servo";
+    case RecordKind::STATE:         return "state";
+    case RecordKind::TRIGGER:       return "trigger";
+    }
+    return "?";
+}
+
+static uint32_t nextPow2(uint32_t n) {
+    uint32_t p = 1;
+    while (p < n) p <<= 1;
+    return p;
+}
+
+// --- SampleLog ---
+
+bool SampleLog::begin(void* storage, uint32_t capacity) {
+    if (!storage || capacity < 2 || (capacity & (capacity - 1))) return false;
+    _buf = static_cast<RecordSample*>(storage);
+    _mask = capacity - 1;
+    _head.store(0, std::memory_order_release);
+    return true;
+}
+
+uint32_t SampleLog::findFrom(uint32_t head, uint32_t fromUs) const {
+    uint32_t lo = head > capacity() ? head - capacity() : 0;
+    uint32_t hi = head;
+    // Once wrapped, leave some slack at the old end: those slots are the
+    // next ones the producer overwrites.
+    if (head > capacity()) lo += 64;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        // Signed difference keeps the comparison valid across the 32-bit wrap.
+        if ((int32_t)(_buf[mid & _mask].us - fromUs) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+bool SampleLog::copy(uint32_t from, uint32_t to, RecordSample* out) const {
+    for (uint32_t i = from; i < to; i++) {
+        *out++ = _buf[i & _mask];
+    }
+    // Anything older than head - capacity may have been rewritten mid-copy.
+    return head() - from <= capacity();
+}
+
+// --- FlightRecorder ---
+
+bool FlightRecorder::begin(const Config& cfg, uint8_t potChannels, Allocator alloc) {
+    _enabled = false;
+    _preMs = cfg.recorderPreMs;
+    _postMs = cfg.recorderPostMs;
+    _slots = constrain(cfg.recorderCaptures, (uint8_t)1, kMaxCaptures);
+
+    uint32_t windowMs = _preMs + _postMs;
+    _potCap = (uint32_t)((uint64_t)cfg.potSampleRateHz * potChannels * windowMs / 1000) + 256;
+    _ctlCap = cfg.recorderControlEntries;
+
+    // Live rings hold two windows, so the copy has a full window of slack
+    // before the producer can lap it.
+    uint32_t potLive = nextPow2(_potCap * 2);
+    uint32_t ctlLive = nextPow2(_ctlCap * 2);
+
+    void* potMem = alloc(potLive * sizeof(RecordSample));
+    void* ctlMem = alloc(ctlLive * sizeof(RecordSample));
+    if (!_pot.begin(potMem, potLive) || !_ctl.begin(ctlMem, ctlLive)) {
+        logPrintf("[Recorder] Can't allocate live rings (%u KB)\n",
+                  (unsigned)((potLive + ctlLive) * sizeof(RecordSample) / 1024));
+        return false;
+    }
+    for (uint8_t i = 0; i < _slots; i++) {
+        _captures[i] = {};
+        _captures[i].pot = static_cast<RecordSample*>(alloc(_potCap * sizeof(RecordSample)));
+        _captures[i].ctl = static_cast<RecordSample*>(alloc(_ctlCap * sizeof(RecordSample)));
+        if (!_captures[i].pot || !_captures[i].ctl) {
+            // Keep the slots that did fit.
+            _slots = i;
+            break;
+        }
+    }
+    if (_slots == 0) {
+        logPrintf("[Recorder] No memory for captures\n");
+        return false;
+    }
+
+    uint32_t totalKb = (uint32_t)(((potLive + ctlLive) + (uint64_t)_slots * (_potCap + _ctlCap)) *
+                                  sizeof(RecordSample) / 1024);
+    logPrintf("[Recorder] %ums pre / %ums post, %u captures, %u KB\n",
+              (unsigned)_preMs, (unsigned)_postMs, _slots, (unsigned)totalKb);
+    _enabled = true;
+    return true;
+}
+
+void FlightRecorder::trigger(uint64_t nowUs) {
+    if (!_enabled) return;
+    _triggers++;
+    if (_pending.load(std::memory_order_acquire)) {
+        _merged++;
+        return;
+    }
+    _pendingUs = (uint32_t)nowUs;
+    recordControl(RecordKind::TRIGGER, (uint16_t)_triggers, nowUs);
+    _pending.store(true, std::memory_order_release);
+}
+
+void FlightRecorder::service(uint64_t nowUs) {
+    if (!_pending.load(std::memory_order_acquire)) return;
+    uint32_t trig = _pendingUs;
+    if ((int32_t)((uint32_t)nowUs - trig) < (int32_t)(_postMs * 1000)) return;
+
+    // Oldest unlocked slot (empty slots have seq 0, so they go first).
+    int8_t slot = -1;
+    for (uint8_t i = 0; i < _slots; i++) {
+        if (i == _locked) continue;
+        if (slot < 0 || _captures[i].seq < _captures[slot].seq) slot = i;
+    }
+    if (slot < 0) return;   // single slot and it's being dumped; try later
+
+    RecorderCapture& cap = _captures[slot];
+    uint32_t fromUs = trig - _preMs * 1000;
+
+    uint32_t potHead = _pot.head();
+    uint32_t potFrom = _pot.findFrom(potHead, fromUs);
+    if (potHead - potFrom > _potCap) potFrom = potHead - _potCap;
+    uint32_t ctlHead = _ctl.head();
+    uint32_t ctlFrom = _ctl.findFrom(ctlHead, fromUs);
+    if (ctlHead - ctlFrom > _ctlCap) ctlFrom = ctlHead - _ctlCap;
+
+    cap.seq = 0;    // invalid while being rewritten
+    bool ok = _pot.copy(potFrom, potHead, cap.pot);
+    ok &= _ctl.copy(ctlFrom, ctlHead, cap.ctl);
+    cap.potCount = potHead - potFrom;
+    cap.ctlCount = ctlHead - ctlFrom;
+    cap.triggerUs = trig;
+    cap.torn = !ok;
+    cap.seq = ++_seq;
+
+    _pending.store(false, std::memory_order_release);
+}
+
+const RecorderCapture* FlightRecorder::capture(uint8_t i) const {
+    if (i >= _slots || _captures[i].seq == 0) return nullptr;
+    return &_captures[i];
+}
+
+// --- CaptureReader ---
+
+bool CaptureReader::next(RecordSample& out) {
+    if (!_cap) return false;
+    bool havePot = _pi < _cap->potCount;
+    bool haveCtl = _ci < _cap->ctlCount;
+    if (!havePot && !haveCtl) return false;
+
+    if (havePot && (!haveCtl ||
+                    (int32_t)(_cap->pot[_pi].us - _cap->ctl[_ci].us) <= 0)) {
+        out = _cap->pot[_pi++];
+    } else {
+        out = _cap->ctl[_ci++];
+    }
+    return true;
+}
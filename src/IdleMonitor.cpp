@@ -0,0 +1,113 @@
+#include "IdleMonitor.h"
+
+#include <cmath>
+#include "Platform.h"
+
+const char* wakeReasonName(WakeReason reason) {
+    switch (reason) {
+        case WakeReason::REED:      return "reed";
+        case WakeReason::ARM_MOVED: return "arm";
+        case WakeReason::STATE:     return "state";
+        case WakeReason::PRINTER:   return "printer";
+        case WakeReason::COMMAND:   return "command";
+        default:                    return "none";
+    }
+}
+
+void IdleMonitor::configure(const Config& cfg) {
+    _cfg = cfg;
+    if (!_cfg.lowPower) _settled = false;
+}
+
+bool IdleMonitor::update(uint32_t nowMs, const IdleInput* in, uint8_t count) {
+    if (!_cfg.lowPower) {
+        if (_idle) leave(WakeReason::COMMAND, nowMs);
+        return false;
+    }
+    if (!_settled) {
+        settle(nowMs, in, count);
+        return false;
+    }
+
+    WakeReason why = WakeReason::NONE;
+    for (uint8_t i = 0; i < count && why == WakeReason::NONE; i++) {
+        if (in[i].state != FeedArmState::MONITORING) {
+            why = WakeReason::STATE;
+        } else if (in[i].pulses != _pulses[i]) {
+            why = WakeReason::REED;
+        } else if (fabsf(in[i].armDeg - _restDeg[i]) > _cfg.idleWakeDeg) {
+            why = WakeReason::ARM_MOVED;
+        } else if (in[i].printer == PrinterActivity::EXTRUDING ||
+                   in[i].printer == PrinterActivity::TRAVEL) {
+            why = WakeReason::PRINTER;
+        }
+    }
+    if (why != WakeReason::NONE) {
+        if (_idle) leave(why, nowMs);
+        // Anything that moved starts the quiet time over from here.
+        settle(nowMs, in, count);
+        return false;
+    }
+
+    if (!_idle && nowMs - _quietSinceMs >= _cfg.idleAfterMs) enter(nowMs);
+    return _idle;
+}
+
+void IdleMonitor::wake(WakeReason reason, uint32_t nowMs) {
+    if (_idle) leave(reason, nowMs);
+    _quietSinceMs = nowMs;
+}
+
+void IdleMonitor::enter(uint32_t nowMs) {
+    _idle = true;
+    _idleSinceMs = nowMs;
+    _stats.idleEntries++;
+    _event = {};
+    _event.timeMs = nowMs;
+    _event.type = FeedArmEventType::IDLE_ENTERED;
+    _event.a = _cfg.idleAfterMs / 1000.0f;
+    _event.n = _cfg.idleTickMs;
+    _eventPending = true;
+}
+
+void IdleMonitor::leave(WakeReason reason, uint32_t nowMs) {
+    _idle = false;
+    _lastWake = reason;
+    _stats.wakes[(uint8_t)reason]++;
+    _stats.idleMs += nowMs - _idleSinceMs;
+    _quietSinceMs = nowMs;
+    _event = {};
+    _event.timeMs = nowMs;
+    _event.type = FeedArmEventType::IDLE_WOKE;
+    _event.a = (nowMs - _idleSinceMs) / 1000.0f;
+    _event.n = (uint32_t)reason;
+    _eventPending = true;
+}
+
+void IdleMonitor::settle(uint32_t nowMs, const IdleInput* in, uint8_t count) {
+    for (uint8_t i = 0; i < count && i < kMaxFeedChannels; i++) {
+        _pulses[i] = in[i].pulses;
+        _restDeg[i] = in[i].armDeg;
+    }
+    _quietSinceMs = nowMs;
+    _settled = true;
+}
+
+void IdleMonitor::recordWakeLatency(uint32_t us) {
+    _stats.latencySamples++;
+    _stats.lastLatencyUs = us;
+    _stats.totalLatencyUs += us;
+    if (us > _stats.worstLatencyUs) _stats.worstLatencyUs = us;
+    if (us > _cfg.wakeBudgetUs) _stats.overBudget++;
+}
+
+void IdleMonitor::clearStats() {
+    _stats = {};
+}
+
+bool IdleMonitor::takeEvent(FeedArmEvent& out) {
+    if (!_eventPending) return false;
+    out = _event;
+    _eventPending = false;
+    return true;
+}
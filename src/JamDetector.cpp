@@ -0,0 +1,173 @@
+#include "JamDetector.h"
+
+#include "Platform.h"
+
+const char* jamPathName(JamPath path) {
+    switch (path) {
+        case JamPath::ANGLE:      return "angle";
+        case JamPath::TENSION:    return "tension";
+        case JamPath::STALL:      return "stall";
+        case JamPath::TRAJECTORY: return "trajectory";
+        case JamPath::MANUAL:     return "manual";
+        default:                  return "none";
+    }
+}
+
+bool jamDetectorConfigChanged(const Config& a, const Config& b) {
+    return a.jamDetector != b.jamDetector ||
+           a.feedArmJamAngle != b.feedArmJamAngle ||
+           a.feedArmRestAngle != b.feedArmRestAngle ||
+           a.tensionServoAngle != b.tensionServoAngle ||
+           a.jamTensionN != b.jamTensionN ||
+           a.jamAlpha != b.jamAlpha ||
+           a.jamBeta != b.jamBeta ||
+           a.jamConfidence != b.jamConfidence ||
+           a.jamFloorAdapt != b.jamFloorAdapt ||
+           a.jamHorizonSec != b.jamHorizonSec ||
+           a.jamMarginDeg != b.jamMarginDeg ||
+           a.jamReedMovingWeight != b.jamReedMovingWeight ||
+           a.jamSettleMs != b.jamSettleMs ||
+           a.jamSlipDegPerSec != b.jamSlipDegPerSec ||
+           a.jamWobbleGain != b.jamWobbleGain;
+}
+
+// --- ThresholdJamDetector ---
+
+void ThresholdJamDetector::reset(const Config& cfg) {
+    _cfg = cfg;
+    _confidence = 0;
+}
+
+bool ThresholdJamDetector::update(const JamInputs& in) {
+    // Primary: pot angle below jam threshold.
+    // When filament is stuck, extruder pull increases tension on the spring arm,
+    // pulling it toward the spool (decreasing angle).
+    // With jamTensionN set, the same rule runs on estimated force, which
+    // doesn't move when the tension servo changes the spring's preload.
+    if (_cfg.jamTensionN > 0) {
+        _confidence = in.tension / _cfg.jamTensionN;
+        if (in.tension >= _cfg.jamTensionN) {
+            _path = JamPath::TENSION;
+            return true;
+        }
+    } else {
+        float span = _cfg.feedArmRestAngle - _cfg.feedArmJamAngle;
+        _confidence = span > 0 ? (_cfg.feedArmRestAngle - in.angle) / span : 0;
+        if (in.angle <= _cfg.feedArmJamAngle) {
+            _path = JamPath::ANGLE;
+            return true;
+        }
+    }
+
+    // Secondary: reed switch shows filament has stalled AND arm angle is
+    // noticeably below rest (filament tension is building but hasn't hit
+    // the hard threshold yet). This catches slow-developing jams.
+    if (in.stalled && in.angle < (_cfg.feedArmRestAngle - 15.0f)) {
+        _confidence = 1.0f;
+        _path = JamPath::STALL;
+        return true;
+    }
+
+    return false;
+}
+
+// --- TrajectoryJamDetector ---
+
+void TrajectoryJamDetector::reset(const Config& cfg) {
+    // Tension or detector settings changed: the learned level no longer applies.
+    if (cfg.tensionServoAngle != _cfg.tensionServoAngle ||
+        cfg.jamMarginDeg != _cfg.jamMarginDeg) {
+        relearn();
+    }
+    _cfg = cfg;
+    _fallback.reset(cfg);
+    _primed = false;
+    _velocity = 0;
+    _slipping = false;
+    _confidence = 0;
+}
+
+void TrajectoryJamDetector::relearn() {
+    _floorValid = false;
+    _floor = 0;
+}
+
+bool TrajectoryJamDetector::update(const JamInputs& in) {
+    bool fallback = _fallback.update(in);
+
+    if (!_primed) {
+        _angle = _troughMin = in.angle;
+        _lastMs = in.nowMs;
+        _settleUntilMs = in.nowMs + _cfg.jamSettleMs;
+        _primed = true;
+        _confidence = _fallback.confidence();
+        _path = _fallback.path();
+        return fallback;
+    }
+
+    float dt = (in.nowMs - _lastMs) / 1000.0f;
+    _lastMs = in.nowMs;
+    if (dt <= 0) return false;
+
+    // Alpha-beta: predict, then correct both states from the residual.
+    float predicted = _angle + _velocity * dt;
+    float residual = in.angle - predicted;
+    _angle = predicted + _cfg.jamAlpha * residual;
+    _velocity += _cfg.jamBeta * residual / dt;
+
+    // Spring still coming back to tension after an unstick: the arm's
+    // swings say nothing about the spool yet.
+    if ((int32_t)(in.nowMs - _settleUntilMs) < 0) {
+        _troughMin = _angle;
+        _slipping = _velocity > 0;
+        _confidence = _fallback.confidence();
+        _path = _fallback.path();
+        return fallback;
+    }
+
+    // Breakaway: a fast upward swing ends a stick phase. The lowest angle
+    // since the previous one is where the spool let go.
+    if (!_slipping && _velocity > _cfg.jamSlipDegPerSec) {
+        _slipping = true;
+        if (!_floorValid || _troughMin < _floor) {
+            _floor = _troughMin;
+        } else {
+            // Shallower than before: creep up slowly so one early release
+            // doesn't move the level much.
+            _floor += (_troughMin - _floor) * _cfg.jamFloorAdapt;
+        }
+        _floorValid = true;
+    } else if (_slipping && _velocity < 0) {
+        _slipping = false;
+        _troughMin = _angle;
+    }
+    if (_angle < _troughMin) _troughMin = _angle;
+
+    if (!_floorValid) {
+        _confidence = _fallback.confidence();
+        _path = _fallback.path();
+        return fallback;
+    }
+
+    // Depth below the breakaway level now, and one horizon ahead.
+    float ahead = _angle + (_velocity < 0 ? _velocity * _cfg.jamHorizonSec : 0);
+    float byNow = (_floor - _angle) / _cfg.jamMarginDeg;
+    float byForecast = (_floor - ahead) / (2.0f * _cfg.jamMarginDeg);
+    float score = byNow > byForecast ? byNow : byForecast;
+
+    // Filament still turning the wheel: more likely drag than a snag.
+    if (!in.stalled && in.pulsesPerSec > 0) score *= _cfg.jamReedMovingWeight;
+    // The spool has started catching once a revolution: a snag is coming.
+    if (score > 0 && in.wobble >= 1.0f) score *= 1.0f + _cfg.jamWobbleGain;
+    _confidence = score;
+
+    // Backstop: the threshold rule always fires, so this is never later
+    // than the plain detector.
+    if (fallback) {
+        if (_confidence < 1.0f) _confidence = 1.0f;
+        _path = _fallback.path();
+        return true;
+    }
+    _path = JamPath::TRAJECTORY;
+    return _confidence >= _cfg.jamConfidence;
+}
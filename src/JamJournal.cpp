@@ -0,0 +1,500 @@
+#include "JamJournal.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include "Platform.h"
+
+static constexpr uint32_t kJournalMagic = 0x4A584646;   // 'FFXJ'
+
+const char* jamOutcomeName(JamOutcome outcome) {
+    switch (outcome) {
+        case JamOutcome::FREED:         return "freed";
+        case JamOutcome::FREED_BY_REED: return "freed-reed";
+        case JamOutcome::GAVE_UP:       return "gave-up";
+        case JamOutcome::INTERRUPTED:   return "interrupted";
+        default:                        return "unknown";
+    }
+}
+
+// --- Encoding ---
+
+static size_t putVarint(uint32_t v, uint8_t* out) {
+    size_t n = 0;
+    while (v >= 0x80) {
+        out[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    out[n++] = (uint8_t)v;
+    return n;
+}
+
+static uint32_t zigzag(int32_t v) {
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static int32_t unzigzag(uint32_t v) {
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+// Tenths, clamped at zero: angles are never negative.
+static uint32_t tenths(float v) {
+    return v > 0 ? (uint32_t)lroundf(v * 10.0f) : 0;
+}
+
+int formatJournalDumpLine(uint8_t segment, const uint8_t* data, size_t len, char* out) {
+    static const char kHex[] = "0123456789abcdef";
+    int n = snprintf(out, kJournalDumpLine, "J %u ", segment);
+    for (size_t i = 0; i < len && i < kJournalDumpBytes; i++) {
+        out[n++] = kHex[data[i] >> 4];
+        out[n++] = kHex[data[i] & 0x0f];
+    }
+    out[n++] = '\n';
+    out[n] = 0;
+    return n;
+}
+
+void encodeJournalHeader(uint32_t sequence, uint8_t* out) {
+    memcpy(out, &kJournalMagic, 4);
+    out[4] = kJournalVersion;
+    memcpy(out + 5, &sequence, 4);
+}
+
+bool decodeJournalHeader(const uint8_t* data, size_t len, uint32_t& sequence) {
+    if (len < kJournalHeaderBytes) return false;
+    uint32_t magic;
+    memcpy(&magic, data, 4);
+    if (magic != kJournalMagic || data[4] != kJournalVersion) return false;
+    memcpy(&sequence, data + 5, 4);
+    return true;
+}
+
+size_t encodeJournalEntry(const JournalEntry& e, JournalDeltas& deltas, uint8_t* out) {
+    size_t n = 0;
+    out[n++] = (uint8_t)((uint8_t)e.kind | (e.channel << 4));
+    switch (e.kind) {
+    case JournalKind::SESSION:
+        n += putVarint(e.boot, out + n);
+        deltas = {};
+        break;
+    case JournalKind::SPOOL:
+        n += putVarint(e.spoolTag, out + n);
+        n += putVarint(e.spoolM, out + n);
+        break;
+    case JournalKind::JAM: {
+        const JamRecord& j = e.jam;
+        uint8_t ch = e.channel < kMaxFeedChannels ? e.channel : 0;
+        n += putVarint(j.uptimeS - deltas.uptimeS, out + n);
+        out[n++] = (uint8_t)(((uint8_t)j.path << 4) | (uint8_t)j.outcome);
+        n += putVarint(j.attempts, out + n);
+        n += putVarint(zigzag((int32_t)(j.print - deltas.print[ch])), out + n);
+        n += putVarint(j.printMm / 10, out + n);
+        n += putVarint(j.spoolTag, out + n);
+        n += putVarint(j.spoolM, out + n);
+        n += putVarint(tenths(j.armDeg), out + n);
+        n += putVarint(tenths(j.tensionDeg), out + n);
+        n += putVarint(j.clearMs / 10, out + n);
+        deltas.uptimeS = j.uptimeS;
+        deltas.print[ch] = j.print;
+        break;
+    }
+    }
+    return n;
+}
+
+// --- JournalDecoder ---
+
+bool JournalDecoder::begin(const uint8_t* data, size_t len) {
+    _data = data;
+    _len = len;
+    _pos = kJournalHeaderBytes;
+    _framed = kJournalHeaderBytes;
+    _truncated = false;
+    _deltas = {};
+    return decodeJournalHeader(data, len, _sequence);
+}
+
+bool JournalDecoder::varint(uint32_t& out) {
+    out = 0;
+    for (uint8_t shift = 0; shift < 35; shift += 7) {
+        if (_pos >= _len) return false;
+        uint8_t b = _data[_pos++];
+        out |= (uint32_t)(b & 0x7f) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+bool JournalDecoder::next(JournalEntry& out) {
+    if (!_data || _pos >= _len) return false;
+    uint8_t tag = _data[_pos++];
+    out = {};
+    out.kind = (JournalKind)(tag & 0x0f);
+    out.channel = tag >> 4;
+    uint32_t v[9];
+    bool ok = false;
+
+    switch (out.kind) {
+    case JournalKind::SESSION:
+        ok = varint(out.boot);
+        if (ok) _deltas = {};
+        break;
+    case JournalKind::SPOOL:
+        ok = varint(v[0]) && varint(out.spoolM);
+        out.spoolTag = (uint16_t)v[0];
+        break;
+    case JournalKind::JAM: {
+        ok = varint(v[0]) && _pos < _len;
+        if (!ok) break;
+        uint8_t packed = _data[_pos++];
+        for (uint8_t i = 1; i < 9 && ok; i++) ok = varint(v[i]);
+        if (!ok) break;
+        uint8_t ch = out.channel < kMaxFeedChannels ? out.channel : 0;
+        JamRecord& j = out.jam;
+        j.channel = out.channel;
+        j.uptimeS = _deltas.uptimeS + v[0];
+        j.path = (JamPath)(packed >> 4);
+        j.outcome = (JamOutcome)(packed & 0x0f);
+        j.attempts = (uint8_t)v[1];
+        j.print = _deltas.print[ch] + unzigzag(v[2]);
+        j.printMm = v[3] * 10;
+        j.spoolTag = (uint16_t)v[4];
+        j.spoolM = v[5];
+        j.armDeg = v[6] * 0.1f;
+        j.tensionDeg = v[7] * 0.1f;
+        j.clearMs = v[8] * 10;
+        _deltas.uptimeS = j.uptimeS;
+        _deltas.print[ch] = j.print;
+        break;
+    }
+    default:
+        // Unknown kind: nothing after it can be framed.
+        _pos = _len;
+        return false;
+    }
+
+    if (!ok) {
+        _truncated = true;
+        _pos = _len;
+        return false;
+    }
+    _framed = _pos;
+    return true;
+}
+
+// --- JamTracker ---
+
+bool JamTracker::onEvent(const FeedArmEvent& ev, const JamContext& ctx, JamRecord& out) {
+    if (ev.channel >= kMaxFeedChannels) return false;
+    Open& o = _open[ev.channel];
+
+    switch (ev.type) {
+    case FeedArmEventType::JAM_DETECTED:
+    case FeedArmEventType::MANUAL_UNSTICK: {
+        bool manual = ev.type == FeedArmEventType::MANUAL_UNSTICK;
+        // A manual unstick during a jam's cooldown is part of that jam.
+        if (manual && o.active) break;
+        o = {};
+        o.active = true;
+        o.startMs = ev.timeMs;
+        JamRecord& r = o.rec;
+        r.channel = ev.channel;
+        r.uptimeS = ctx.uptimeS;
+        r.path = manual ? JamPath::MANUAL : (JamPath)ev.n;
+        r.armDeg = manual ? ctx.armDeg : ev.a;
+        r.tensionDeg = ctx.tensionDeg;
+        r.print = ctx.print;
+        r.printMm = ctx.printMm > 0 ? (uint32_t)ctx.printMm : 0;
+        break;
+    }
+    case FeedArmEventType::UNSTICK_STAGE:
+        if (o.active && o.rec.attempts < 255) o.rec.attempts++;
+        break;
+    case FeedArmEventType::UNSTICK_CONFIRMED:
+        if (o.active) o.byReed = ev.flag;
+        break;
+    case FeedArmEventType::UNSTICK_RESULT:
+        if (o.active && ev.flag) o.freed = true;
+        break;
+    case FeedArmEventType::UNSTICK_GAVE_UP:
+        if (o.active) o.gaveUp = true;
+        break;
+    case FeedArmEventType::STATE_CHANGE:
+        if (!o.active || ev.to != FeedArmState::MONITORING) break;
+        o.active = false;
+        o.rec.outcome = o.gaveUp ? JamOutcome::GAVE_UP
+                      : !o.freed ? JamOutcome::INTERRUPTED
+                      : o.byReed ? JamOutcome::FREED_BY_REED
+                                 : JamOutcome::FREED;
+        o.rec.clearMs = ev.timeMs - o.startMs;
+        out = o.rec;
+        return true;
+    default:
+        break;
+    }
+    return false;
+}
+
+// --- JamJournal ---
+
+void JamJournal::begin(JournalStorage* storage, Clock* clock) {
+    _storage = storage;
+    _clock = clock;
+    _used = 0;
+    _sequence = 0;
+    _current = 0;
+
+    // The newest segment is the one with the highest sequence; the ring
+    // runs back from it through consecutive sequence numbers.
+    uint32_t seqs[kJournalSegments] = {};
+    bool valid[kJournalSegments] = {};
+    for (uint8_t s = 0; s < kJournalSegments; s++) {
+        uint8_t header[kJournalHeaderBytes];
+        if (_storage->size(s) < kJournalHeaderBytes) continue;
+        if (_storage->read(s, 0, header, sizeof(header)) != sizeof(header)) continue;
+        valid[s] = decodeJournalHeader(header, sizeof(header), seqs[s]);
+        if (valid[s] && seqs[s] >= _sequence) {
+            _sequence = seqs[s];
+            _current = s;
+        }
+    }
+    for (uint8_t back = 0; back < kJournalSegments; back++) {
+        uint8_t s = (uint8_t)((_current + kJournalSegments - back) % kJournalSegments);
+        if (!valid[s] || seqs[s] != _sequence - back) break;
+        _used++;
+    }
+
+    // Replay oldest first: last boot number, each channel's spool, totals.
+    _torn = false;
+    uint8_t* buf = new uint8_t[kJournalSegmentBytes];
+    for (uint8_t i = 0; i < _used; i++) {
+        size_t len = readSegment(i, 0, buf, kJournalSegmentBytes);
+        JournalDecoder dec;
+        if (!dec.begin(buf, len)) continue;
+        _storedBytes += len;
+        JournalEntry e;
+        while (dec.next(e)) {
+            replay(e);
+            if (e.kind == JournalKind::JAM) _segmentJams[physical(i)]++;
+        }
+        // Anything after a cut-short entry would be misframed.
+        if (i == _used - 1) _torn = dec.truncated() || dec.framed() != _storage->size(_current);
+    }
+    delete[] buf;
+    _currentBytes = _used ? _storage->size(_current) : 0;
+    _boot++;
+    _sessionWritten = false;
+
+    logPrintf("[Journal] %u jam(s) in %u segment(s), %u bytes; boot %u%s\n",
+              _storedJams, _used, _storedBytes, _boot, _torn ? " (torn tail)" : "");
+}
+
+void JamJournal::replay(const JournalEntry& e) {
+    uint8_t ch = e.channel < kMaxFeedChannels ? e.channel : 0;
+    switch (e.kind) {
+    case JournalKind::SESSION:
+        _boot = e.boot;
+        break;
+    case JournalKind::SPOOL:
+        _spool[ch].tag = e.spoolTag;
+        _spool[ch].mm = e.spoolM * 1000.0f;
+        _spool[ch].checkpointM = e.spoolM;
+        break;
+    case JournalKind::JAM:
+        _storedJams++;
+        _spool[ch].tag = e.jam.spoolTag;
+        if (e.jam.spoolM * 1000.0f > _spool[ch].mm) {
+            _spool[ch].mm = e.jam.spoolM * 1000.0f;
+            _spool[ch].checkpointM = e.jam.spoolM;
+        }
+        break;
+    }
+}
+
+bool JamJournal::push(const JournalEntry& e) {
+    if (_count >= kQueueDepth) {
+        _dropped++;
+        return false;
+    }
+    _queue[_count++] = e;
+    return true;
+}
+
+bool JamJournal::record(const JamRecord& jam) {
+    uint8_t ch = jam.channel < kMaxFeedChannels ? jam.channel : 0;
+    JournalEntry e = {};
+    e.kind = JournalKind::JAM;
+    e.channel = ch;
+    e.jam = jam;
+    e.jam.boot = _boot;
+    e.jam.spoolTag = _spool[ch].tag;
+    e.jam.spoolM = spoolM(ch);
+    return push(e);
+}
+
+void JamJournal::setSpool(uint8_t channel, uint16_t tag) {
+    if (channel >= kMaxFeedChannels) return;
+    _spool[channel] = { tag, 0, 0 };
+    JournalEntry e = {};
+    e.kind = JournalKind::SPOOL;
+    e.channel = channel;
+    e.spoolTag = tag;
+    push(e);
+}
+
+void JamJournal::addFilament(uint8_t channel, float mm) {
+    if (channel >= kMaxFeedChannels || mm <= 0) return;
+    Spool& sp = _spool[channel];
+    sp.mm += mm;
+    uint32_t m = (uint32_t)(sp.mm / 1000.0f);
+    if (m < sp.checkpointM + kJournalSpoolCheckpointM) return;
+    // Kept every few metres so a reboot loses little of the odometer.
+    sp.checkpointM = m;
+    // Only the newest checkpoint matters; one still queued is moved on.
+    for (uint8_t i = _count; i-- > 0;) {
+        JournalEntry& q = _queue[i];
+        if (q.kind != JournalKind::SPOOL || q.channel != channel) continue;
+        if (q.spoolTag == sp.tag && q.spoolM > 0) {
+            q.spoolM = m;
+            return;
+        }
+        break;
+    }
+    JournalEntry e = {};
+    e.kind = JournalKind::SPOOL;
+    e.channel = channel;
+    e.spoolTag = sp.tag;
+    e.spoolM = m;
+    push(e);
+}
+
+uint8_t JamJournal::flush() {
+    if (!_storage || _count == 0) return 0;
+    uint64_t startUs = _clock ? _clock->micros() : 0;
+
+    uint8_t written = 0;
+    if (_torn) {
+        // Never append after a partial entry; a fresh segment has the SESSION.
+        if (!startSegment()) return 0;
+    } else if (!_sessionWritten) {
+        // A fresh segment starts with one anyway.
+        if (_used == 0) {
+            if (!startSegment()) return 0;
+        } else {
+            JournalEntry session = {};
+            session.kind = JournalKind::SESSION;
+            session.boot = _boot;
+            if (!write(session)) return 0;
+        }
+        _sessionWritten = true;
+    }
+    for (; written < _count; written++) {
+        if (!write(_queue[written])) break;
+        if (_queue[written].kind == JournalKind::JAM) {
+            _storedJams++;
+            _segmentJams[_current]++;
+        }
+    }
+    // Whatever didn't make it stays queued for the next flush.
+    memmove(_queue, _queue + written, (_count - written) * sizeof(JournalEntry));
+    _count -= written;
+
+    if (_clock) {
+        _lastFlushUs = (uint32_t)(_clock->micros() - startUs);
+        if (_lastFlushUs > _worstFlushUs) _worstFlushUs = _lastFlushUs;
+    }
+    return written;
+}
+
+bool JamJournal::write(const JournalEntry& e) {
+    uint8_t bytes[kJournalMaxEntry];
+    size_t len = encodeJournalEntry(e, _deltas, bytes);
+    if (_currentBytes + len <= kJournalSegmentBytes) return append(bytes, len);
+
+    // Full: the entry was encoded against the old segment's deltas, so
+    // start the next one (which resets them) and encode it again.
+    if (!startSegment()) return false;
+    len = encodeJournalEntry(e, _deltas, bytes);
+    return append(bytes, len);
+}
+
+bool JamJournal::append(const uint8_t* data, size_t len) {
+    if (!_storage->append(_current, data, len)) {
+        // Some of it may have landed; the retry goes to a new segment.
+        _writeErrors++;
+        _torn = true;
+        return false;
+    }
+    _currentBytes += len;
+    _storedBytes += len;
+    return true;
+}
+
+bool JamJournal::startSegment() {
+    // One whose header never made it is used again rather than left in the
+    // ring, where it would hide every segment before it.
+    bool reuse = _used > 0 && _currentBytes == 0;
+    uint8_t next = _used && !reuse ? (uint8_t)((_current + 1) % kJournalSegments) : _current;
+    if (!reuse && _used == kJournalSegments) {
+        // Overwriting the oldest.
+        _storedBytes -= (uint32_t)_storage->size(next);
+        _storedJams -= _segmentJams[next];
+        _used--;
+    }
+    _storage->erase(next);
+    _segmentJams[next] = 0;
+    _current = next;
+    _currentBytes = 0;
+    _torn = false;
+    if (!reuse) {
+        _sequence++;
+        _used++;
+    }
+
+    uint8_t header[kJournalHeaderBytes];
+    encodeJournalHeader(_sequence, header);
+    if (!append(header, sizeof(header))) return false;
+
+    // Self-contained: the boot number and every known spool up front.
+    uint8_t bytes[kJournalMaxEntry];
+    JournalEntry e = {};
+    e.kind = JournalKind::SESSION;
+    e.boot = _boot;
+    if (!append(bytes, encodeJournalEntry(e, _deltas, bytes))) return false;
+    _sessionWritten = true;
+    for (uint8_t ch = 0; ch < kMaxFeedChannels; ch++) {
+        if (_spool[ch].tag == 0 && _spool[ch].mm <= 0) continue;
+        e = {};
+        e.kind = JournalKind::SPOOL;
+        e.channel = ch;
+        e.spoolTag = _spool[ch].tag;
+        e.spoolM = spoolM(ch);
+        if (!append(bytes, encodeJournalEntry(e, _deltas, bytes))) return false;
+    }
+    return true;
+}
+
+void JamJournal::erase() {
+    for (uint8_t s = 0; s < kJournalSegments; s++) _storage->erase(s);
+    _used = 0;
+    _current = 0;
+    _currentBytes = 0;
+    _sessionWritten = false;
+    _torn = false;
+    _storedJams = 0;
+    _storedBytes = 0;
+    memset(_segmentJams, 0, sizeof(_segmentJams));
+}
+
+uint8_t JamJournal::physical(uint8_t index) const {
+    // index 0 = oldest.
+    return (uint8_t)((_current + kJournalSegments - (_used - 1 - index)) % kJournalSegments);
+}
+
+size_t JamJournal::segmentSize(uint8_t index) {
+    return index < _used ? _storage->size(physical(index)) : 0;
+}
+
+size_t JamJournal::readSegment(uint8_t index, size_t offset, void* buf, size_t len) {
+    return index < _used ? _storage->read(physical(index), offset, buf, len) : 0;
+}
@@ -0,0 +1,47 @@
+#include "PotTable.h"
+
+#include <cmath>
+
+bool potCalibrationValid(const PotCalibration& cal) {
+    if (cal.points < 2 || cal.points > kPotCalPoints) return false;
+    bool rising = cal.adc[1] > cal.adc[0];
+    for (uint8_t i = 1; i < cal.points; i++) {
+        if (cal.adc[i] == cal.adc[i - 1] || (cal.adc[i] > cal.adc[i - 1]) != rising) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void PotTable::linear(uint16_t adcMin, uint16_t adcMax) {
+    PotCalibration cal = {};
+    cal.points = 2;
+    cal.fromDeg = 0.0f;
+    cal.toDeg = 160.0f;
+    cal.adc[0] = adcMin;
+    cal.adc[1] = adcMax != adcMin ? adcMax : adcMin + 1;
+    build(cal);
+}
+
+bool PotTable::build(const PotCalibration& cal) {
+    if (!potCalibrationValid(cal)) return false;
+
+    uint8_t last = cal.points - 1;
+    bool rising = cal.adc[last] > cal.adc[0];
+    float stepDeg = (cal.toDeg - cal.fromDeg) / last;
+    // Segment i runs from point i to i+1 in ascending ADC order.
+    auto point = [&](uint8_t i) { return rising ? i : (uint8_t)(last - i); };
+
+    uint8_t seg = 0;
+    for (uint16_t b = 0; b <= kBins; b++) {
+        int32_t counts = (int32_t)b << kBinBits;
+        while (seg + 1 < last && counts > cal.adc[point(seg + 1)]) seg++;
+        uint8_t p0 = point(seg);
+        uint8_t p1 = point(seg + 1);
+        float a0 = cal.fromDeg + stepDeg * p0;
+        float a1 = cal.fromDeg + stepDeg * p1;
+        float t = (float)(counts - cal.adc[p0]) / ((int32_t)cal.adc[p1] - cal.adc[p0]);
+        _cdeg[b] = (int32_t)lroundf((a0 + t * (a1 - a0)) * 100.0f);
+    }
+    return true;
+}
@@ -0,0 +1,190 @@
+#include "PrinterLink.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "Platform.h"
+
+// --- Framing ---
+
+static uint8_t lineChecksum(const char* s, size_t len) {
+    uint8_t x = 0;
+    for (size_t i = 0; i < len; i++) x ^= (uint8_t)s[i];
+    return x;
+}
+
+static int hexDigit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+size_t formatPrinterLinkLine(char* buf, size_t len, char type, uint32_t seq,
+                             const char* fields) {
+    int n = fields && *fields
+        ? snprintf(buf, len, "%c %u %s", type, (unsigned)seq, fields)
+        : snprintf(buf, len, "%c %u", type, (unsigned)seq);
+    if (n < 0 || (size_t)n + 4 >= len) return 0;
+    n += snprintf(buf + n, len - n, "*%02X\n", lineChecksum(buf, n));
+    return (size_t)n;
+}
+
+bool parsePrinterLinkLine(char* line, PrinterLinkLine& out) {
+    char* star = strrchr(line, '*');
+    if (!star || hexDigit(star[1]) < 0 || hexDigit(star[2]) < 0 || star[3] != '\0') {
+        return false;
+    }
+    uint8_t sum = (uint8_t)(hexDigit(star[1]) << 4 | hexDigit(star[2]));
+    if (sum != lineChecksum(line, star - line)) return false;
+    *star = '\0';
+
+    if (line[0] == '\0' || line[1] != ' ') return false;
+    char* end = nullptr;
+    unsigned long seq = strtoul(line + 2, &end, 10);
+    if (end == line + 2) return false;
+    while (*end == ' ') end++;
+    out.type = line[0];
+    out.seq = (uint32_t)seq;
+    out.fields = end;
+    return true;
+}
+
+// --- PrinterLink ---
+
+void PrinterLink::begin(const Config& cfg, CommandShell::ReadByte readByte,
+                        WriteBytes writeBytes, void* ctx) {
+    _cfg = cfg;
+    _readByte = readByte;
+    _writeBytes = writeBytes;
+    _ctx = ctx;
+}
+
+void PrinterLink::poll(uint32_t nowUs) {
+    for (uint16_t i = 0; i < kBytesPerPoll; i++) {
+        int c = _readByte(_ctx);
+        if (c < 0) break;
+        // Every line is short and answered at once, so unlike the shell
+        // there is no reason to leave the rest for the next pass.
+        if (_line.feed((char)c)) {
+            char line[LineAssembler::kMaxLine];
+            memcpy(line, _line.line(), sizeof(line));
+            handle(line, nowUs);
+        }
+    }
+
+    if (_pending && nowUs - _lastSentUs >= _cfg.printerRetryMs * 1000) {
+        _retries++;
+        sendRequest(nowUs);
+    }
+}
+
+void PrinterLink::handle(char* line, uint32_t nowUs) {
+    PrinterLinkLine msg;
+    if (!parsePrinterLinkLine(line, msg)) {
+        _badLines++;
+        return;
+    }
+
+    switch (msg.type) {
+    case 'F': {
+        char* end = nullptr;
+        float rate = strtof(msg.fields, &end);
+        if (end == msg.fields) {
+            _badLines++;
+            return;
+        }
+        while (*end == ' ') end++;
+        PrinterActivity activity;
+        switch (*end) {
+            case 'I': activity = PrinterActivity::IDLE; break;
+            case 'T': activity = PrinterActivity::TRAVEL; break;
+            case 'E': activity = PrinterActivity::EXTRUDING; break;
+            case 'P': activity = PrinterActivity::PAUSED; break;
+            default:
+                _badLines++;
+                return;
+        }
+        long tool = end[1] == ' ' ? strtol(end + 2, nullptr, 10) : 0;
+        _activity = activity;
+        _mmPerSec = activity == PrinterActivity::EXTRUDING && rate > 0 ? rate : 0;
+        _tool = tool >= 0 && tool < kMaxFeedChannels ? (uint8_t)tool : 0;
+        _reportUs = nowUs;
+        _reports++;
+        send('K', msg.seq, nullptr);
+        break;
+    }
+    case 'A':
+        if (_pending && msg.seq == _seq) {
+            _pending = false;
+            _lastRttUs = nowUs - _firstSentUs;
+            if (_lastRttUs > _worstRttUs) _worstRttUs = _lastRttUs;
+        }
+        break;
+    default:
+        _badLines++;
+        break;
+    }
+}
+
+void PrinterLink::onEvent(const FeedArmEvent& ev, uint32_t nowUs) {
+    if (ev.type != FeedArmEventType::STATE_CHANGE || !_cfg.printerHold) return;
+    if (ev.from == FeedArmState::MONITORING) hold(ev.channel, true, nowUs);
+    if (ev.to == FeedArmState::MONITORING) hold(ev.channel, false, nowUs);
+}
+
+void PrinterLink::hold(uint8_t channel, bool on, uint32_t nowUs) {
+    if (channel >= kMaxFeedChannels) return;
+    bool was = _holdMask != 0;
+    if (on) {
+        _holdMask |= 1u << channel;
+    } else {
+        _holdMask &= ~(1u << channel);
+    }
+    if ((_holdMask != 0) == was) return;
+
+    // A new request supersedes one still unanswered; its round trip is
+    // timed from here.
+    _seq++;
+    _requestChannel = channel;
+    _pending = true;
+    _firstSentUs = nowUs;
+    sendRequest(nowUs);
+}
+
+void PrinterLink::sendRequest(uint32_t nowUs) {
+    char fields[8];
+    snprintf(fields, sizeof(fields), "%u", _requestChannel);
+    send(_holdMask ? 'H' : 'R', _seq, fields);
+    _lastSentUs = nowUs;
+}
+
+void PrinterLink::send(char type, uint32_t seq, const char* fields) {
+    char buf[32];
+    size_t len = formatPrinterLinkLine(buf, sizeof(buf), type, seq, fields);
+    if (!len || _writeBytes(_ctx, buf, len) < len) _droppedLines++;
+}
+
+bool PrinterLink::up(uint32_t nowUs) const {
+    return _reports > 0 && nowUs - _reportUs <= _cfg.printerLinkTimeoutMs * 1000;
+}
+
+PrinterFeed PrinterLink::feedFor(uint8_t channel, uint32_t nowUs) const {
+    PrinterFeed feed = { PrinterActivity::UNKNOWN, 0 };
+    if (!up(nowUs)) return feed;
+    if (channel != _tool) {
+        feed.activity = PrinterActivity::IDLE;
+        return feed;
+    }
+    feed.activity = _activity;
+    feed.mmPerSec = _mmPerSec;
+    return feed;
+}
+
+void PrinterLink::clearStats() {
+    _lastRttUs = 0;
+    _worstRttUs = 0;
+    _badLines = 0;
+    _retries = 0;
+    _droppedLines = 0;
+}
@@ -0,0 +1,140 @@
+#include "Profiler.h"
+
+#include <cstdio>
+
+#ifndef ARDUINO
+#include <chrono>
+#endif
+
+#ifdef FFX_PROFILE
+Profiler profiler;
+#endif
+
+const char* profileScopeName(ProfileScope scope) {
+    switch (scope) {
+        case ProfileScope::CONTROL_TICK: return "control-tick";
+        case ProfileScope::ARM_UPDATE:   return "arm-update";
+        case ProfileScope::POT_READ:     return "pot-read";
+        case ProfileScope::TICK_WAKE:    return "tick-wake";
+        case ProfileScope::TICK_JITTER:  return "tick-jitter";
+        case ProfileScope::LOOP_PASS:    return "loop-pass";
+        case ProfileScope::SHELL_POLL:   return "shell-poll";
+        case ProfileScope::STATUS_PRINT: return "status-print";
+        case ProfileScope::TELEMETRY:    return "telemetry";
+        case ProfileScope::PRINTER_LINK: return "printer-link";
+        case ProfileScope::SPECTRUM:     return "spectrum";
+        default:                         return "unknown";
+    }
+}
+
+// Scopes measured in microseconds rather than cycles.
+static bool scopeInUs(ProfileScope scope) {
+    return scope == ProfileScope::TICK_WAKE || scope == ProfileScope::TICK_JITTER;
+}
+
+// --- Cycle counter ---
+
+#ifdef ARDUINO
+uint32_t profileCycles() {
+    return ESP.getCycleCount();
+}
+
+uint32_t profileCyclesPerUs() {
+    return ESP.getCpuFreqMHz();
+}
+#else
+// The host has no portable cycle counter; nanoseconds stand in for cycles.
+uint32_t profileCycles() {
+    return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+uint32_t profileCyclesPerUs() {
+    return 1000;
+}
+#endif
+
+// --- Histogram ---
+
+uint16_t ProfileHistogram::bucketOf(uint32_t value) {
+    if (value < kSub) return (uint16_t)value;
+    uint8_t msb = 31 - __builtin_clz(value);
+    uint8_t shift = msb - kSubBits;
+    uint32_t sub = (value >> shift) & (kSub - 1);
+    return (uint16_t)((shift + 1) * kSub + sub);
+}
+
+uint32_t ProfileHistogram::bucketLow(uint16_t bucket) {
+    if (bucket < kSub) return bucket;
+    uint8_t shift = bucket / kSub - 1;
+    uint32_t sub = bucket % kSub;
+    return (kSub + sub) << shift;
+}
+
+void ProfileHistogram::record(uint32_t value) {
+    if (_clearPending.load(std::memory_order_acquire)) clear();
+    _counts[bucketOf(value)]++;
+    _count++;
+    if (value < _min) _min = value;
+    if (value > _max) _max = value;
+}
+
+void ProfileHistogram::clear() {
+    for (uint32_t& c : _counts) c = 0;
+    _count = 0;
+    _min = UINT32_MAX;
+    _max = 0;
+    _clearPending.store(false, std::memory_order_release);
+}
+
+uint32_t ProfileHistogram::percentile(float p) const {
+    if (_count == 0) return 0;
+    uint32_t rank = (uint32_t)(p * (_count - 1)) + 1;
+    uint32_t seen = 0;
+    for (uint16_t b = 0; b < kBuckets; b++) {
+        seen += _counts[b];
+        if (seen < rank) continue;
+        uint32_t low = bucketLow(b);
+        uint32_t width = b < kSub ? 1 : 1u << (b / kSub - 1);
+        uint32_t mid = low + width / 2;
+        // The extremes are known exactly.
+        return constrain(mid, _min, _max);
+    }
+    return _max;
+}
+
+// --- Profiler ---
+
+ProfileStats Profiler::stats(ProfileScope scope) const {
+    const ProfileHistogram& h = _hist[(uint8_t)scope];
+    // ns per unit, in 1/1000ths so a 240 MHz cycle (4.17 ns) keeps its fraction.
+    uint64_t milliNs = scopeInUs(scope) ? 1000000 : 1000000 / profileCyclesPerUs();
+    auto ns = [milliNs](uint32_t v) {
+        uint64_t n = (uint64_t)v * milliNs / 1000;
+        return n > UINT32_MAX ? UINT32_MAX : (uint32_t)n;
+    };
+    ProfileStats st;
+    st.count = h.count();
+    st.minNs = ns(h.min());
+    st.p50Ns = ns(h.percentile(0.50f));
+    st.p90Ns = ns(h.percentile(0.90f));
+    st.p99Ns = ns(h.percentile(0.99f));
+    st.maxNs = ns(h.max());
+    return st;
+}
+
+void Profiler::clear() {
+    for (ProfileHistogram& h : _hist) h.requestClear();
+}
+
+// --- Formatting ---
+
+const char* const kProfileHeader =
+    "scope            count      min      p50      p90      p99      max  (us)";
+
+int formatProfileLine(ProfileScope scope, const ProfileStats& st, char* buf, size_t len) {
+    return snprintf(buf, len, "%-13s %8u %8.2f %8.2f %8.2f %8.2f %8.2f",
+                    profileScopeName(scope), (unsigned)st.count, st.minNs / 1000.0f,
+                    st.p50Ns / 1000.0f, st.p90Ns / 1000.0f, st.p99Ns / 1000.0f,
+                    st.maxNs / 1000.0f);
+}
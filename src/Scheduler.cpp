@@ -0,0 +1,123 @@
+#include "Scheduler.h"
+
+void Scheduler::begin(Clock& clock) {
+    _clock = &clock;
+}
+
+int8_t Scheduler::add(const char* name, uint32_t periodUs, uint32_t delayUs, JobFn fn,
+                      void* ctx) {
+    if (!fn || !_clock) return -1;
+    // Reuse a freed slot before growing.
+    int8_t id = -1;
+    for (uint8_t i = 0; i < _slots; i++) {
+        if (!_jobs[i].fn) {
+            id = (int8_t)i;
+            break;
+        }
+    }
+    if (id < 0) {
+        if (_slots >= kMaxJobs) return -1;
+        id = (int8_t)_slots++;
+    }
+    Job& job = _jobs[id];
+    job.name = name;
+    job.fn = fn;
+    job.ctx = ctx;
+    job.periodUs = periodUs;
+    job.dueUs = _clock->micros() + delayUs;
+    job.stats = {};
+    return id;
+}
+
+int8_t Scheduler::every(const char* name, uint32_t periodUs, JobFn fn, void* ctx) {
+    if (periodUs == 0) return -1;
+    return add(name, periodUs, periodUs, fn, ctx);
+}
+
+int8_t Scheduler::after(const char* name, uint32_t delayUs, JobFn fn, void* ctx) {
+    return add(name, 0, delayUs, fn, ctx);
+}
+
+void Scheduler::setPeriod(int8_t id, uint32_t periodUs) {
+    if (!valid(id) || periodUs == 0 || _jobs[id].periodUs == 0) return;
+    if (periodUs == _jobs[id].periodUs) return;
+    _jobs[id].periodUs = periodUs;
+    _jobs[id].dueUs = _clock->micros() + periodUs;
+}
+
+void Scheduler::cancel(int8_t id) {
+    if (!valid(id)) return;
+    _jobs[id].fn = nullptr;
+    _jobs[id].name = nullptr;
+}
+
+uint8_t Scheduler::run() {
+    if (!_clock) return 0;
+    uint8_t ran = 0;
+    // Bounded, so a one-shot that keeps re-arming itself at zero delay
+    // can't hold the loop.
+    for (uint8_t pass = 0; pass < kMaxJobs * 2; pass++) {
+        uint64_t nowUs = _clock->micros();
+        int8_t next = -1;
+        for (uint8_t i = 0; i < _slots; i++) {
+            const Job& job = _jobs[i];
+            if (!job.fn || job.dueUs > nowUs) continue;
+            if (next < 0 || job.dueUs < _jobs[next].dueUs) next = (int8_t)i;
+        }
+        if (next < 0) break;
+
+        Job& job = _jobs[next];
+        uint64_t dueUs = job.dueUs;
+        uint32_t lateUs = (uint32_t)(nowUs - dueUs);
+        if (lateUs > job.stats.worstLateUs) job.stats.worstLateUs = lateUs;
+        job.stats.runs++;
+
+        // Reschedule before running, so the job may cancel or re-arm itself.
+        JobFn fn = job.fn;
+        void* ctx = job.ctx;
+        if (job.periodUs) {
+            job.dueUs += job.periodUs;
+            if (job.dueUs <= nowUs) {
+                uint64_t missed = (nowUs - job.dueUs) / job.periodUs + 1;
+                job.dueUs += missed * job.periodUs;
+                job.stats.skipped += (uint32_t)missed;
+            }
+        } else {
+            job.fn = nullptr;
+        }
+
+        fn(ctx, dueUs);
+        ran++;
+
+        // A one-shot's slot is free, or already holds a new job.
+        uint32_t runUs = (uint32_t)(_clock->micros() - nowUs);
+        if (_jobs[next].fn == fn && _jobs[next].periodUs && runUs > _jobs[next].stats.worstRunUs) {
+            _jobs[next].stats.worstRunUs = runUs;
+        }
+    }
+    return ran;
+}
+
+uint64_t Scheduler::nextDueUs() const {
+    uint64_t due = UINT64_MAX;
+    for (uint8_t i = 0; i < _slots; i++) {
+        if (_jobs[i].fn && _jobs[i].dueUs < due) due = _jobs[i].dueUs;
+    }
+    return due;
+}
+
+const char* Scheduler::name(int8_t id) const {
+    return valid(id) ? _jobs[id].name : nullptr;
+}
+
+uint32_t Scheduler::periodUs(int8_t id) const {
+    return valid(id) ? _jobs[id].periodUs : 0;
+}
+
+SchedulerJobStats Scheduler::stats(int8_t id) const {
+    return valid(id) ? _jobs[id].stats : SchedulerJobStats{};
+}
+
+void Scheduler::clearStats() {
+    for (uint8_t i = 0; i < _slots; i++) _jobs[i].stats = {};
+}
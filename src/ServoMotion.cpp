@@ -0,0 +1,62 @@
+#include "ServoMotion.h"
+
+#include <cmath>
+
+void TrapezoidProfile::plan(float from, float to, float maxVel, float accel) {
+    _from = from;
+    _to = to;
+    float dist = fabsf(to - from);
+    _dir = to >= from ? 1.0f : -1.0f;
+    _accel = accel > 0 ? accel : 1.0f;
+    if (maxVel <= 0) maxVel = 1.0f;
+
+    // Distance covered ramping up to maxVel and back down again.
+    float rampDist = maxVel * maxVel / _accel;
+    if (dist >= rampDist) {
+        _peakVel = maxVel;
+        _tAccel = maxVel / _accel;
+        _tCruise = _tAccel + (dist - rampDist) / maxVel;
+    } else {
+        _peakVel = sqrtf(dist * _accel);
+        _tAccel = _tCruise = _peakVel / _accel;
+    }
+    _total = _tCruise + _tAccel;
+}
+
+float TrapezoidProfile::position(float t) const {
+    if (t <= 0) return _from;
+    if (t >= _total) return _to;
+
+    float d;
+    if (t < _tAccel) {
+        d = 0.5f * _accel * t * t;
+    } else if (t < _tCruise) {
+        d = 0.5f * _peakVel * _tAccel + _peakVel * (t - _tAccel);
+    } else {
+        float left = _total - t;
+        d = fabsf(_to - _from) - 0.5f * _accel * left * left;
+    }
+    return _from + _dir * d;
+}
+
+void ServoMotion::moveTo(float from, float to, float maxVel, float accel, uint64_t nowUs) {
+    _profile.plan(from, to, maxVel, accel);
+    _startUs = nowUs;
+    _done = false;
+    update(nowUs);
+}
+
+bool ServoMotion::update(uint64_t nowUs) {
+    if (_done) return true;
+    float t = (nowUs - _startUs) * 1e-6f;
+    _setpoint = _profile.position(t);
+    _done = t >= _profile.duration();
+    if (_servo) _servo->write(_setpoint);
+    return _done;
+}
+
+bool ServoMotion::reached(float measured, float tol) const {
+    float to = _profile.to();
+    if (_profile.from() <= to) return measured >= to - tol;
+    return measured <= to + tol;
+}
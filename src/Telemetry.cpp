@@ -0,0 +1,269 @@
+#include "Telemetry.h"
+
+#include <cmath>
+#include <cstring>
+
+// --- Little-endian field packing ---
+
+namespace {
+
+struct Writer {
+    uint8_t* p;
+    size_t n = 0;
+
+    void u8(uint8_t v) { p[n++] = v; }
+    void u16(uint16_t v) { u8(v & 0xff); u8(v >> 8); }
+    void u32(uint32_t v) { u16(v & 0xffff); u16(v >> 16); }
+    void u64(uint64_t v) { u32((uint32_t)v); u32((uint32_t)(v >> 32)); }
+    void cdeg(float deg) { u16((uint16_t)(int16_t)lroundf(deg * 100.0f)); }
+    void fixed(float v) { u32((uint32_t)(int32_t)lroundf(v * 100.0f)); }
+};
+
+struct Reader {
+    const uint8_t* p;
+    size_t len;
+    size_t n = 0;
+
+    bool ok(size_t need) const { return n + need <= len; }
+    uint8_t u8() { return p[n++]; }
+    uint16_t u16() { uint16_t lo = u8(); return lo | (uint16_t)u8() << 8; }
+    uint32_t u32() { uint32_t lo = u16(); return lo | (uint32_t)u16() << 16; }
+    uint64_t u64() { uint64_t lo = u32(); return lo | (uint64_t)u32() << 32; }
+    float cdeg() { return (int16_t)u16() / 100.0f; }
+    float fixed() { return (int32_t)u32() / 100.0f; }
+};
+
+}  // namespace
+
+// --- COBS / CRC ---
+
+size_t cobsEncode(const uint8_t* in, size_t len, uint8_t* out) {
+    size_t codeAt = 0;
+    size_t o = 1;
+    uint8_t code = 1;
+    for (size_t i = 0; i < len; i++) {
+        if (in[i] == 0) {
+            out[codeAt] = code;
+            codeAt = o++;
+            code = 1;
+            continue;
+        }
+        out[o++] = in[i];
+        if (++code == 0xff) {
+            out[codeAt] = code;
+            codeAt = o++;
+            code = 1;
+        }
+    }
+    out[codeAt] = code;
+    return o;
+}
+
+size_t cobsDecode(const uint8_t* in, size_t len, uint8_t* out) {
+    size_t i = 0;
+    size_t o = 0;
+    while (i < len) {
+        uint8_t code = in[i++];
+        if (code == 0 || i + code - 1 > len) return 0;
+        for (uint8_t k = 1; k < code; k++) {
+            out[o++] = in[i++];
+        }
+        if (code != 0xff && i < len) out[o++] = 0;
+    }
+    return o;
+}
+
+uint16_t crc16Ccitt(const uint8_t* data, size_t len) {
+    uint16_t crc = 0xffff;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (uint8_t b = 0; b < 8; b++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+// --- Encoder ---
+
+size_t TelemetryEncoder::finish(uint8_t* raw, size_t len, uint8_t* out) {
+    uint16_t crc = crc16Ccitt(raw, len);
+    raw[len++] = crc & 0xff;
+    raw[len++] = crc >> 8;
+    size_t n = cobsEncode(raw, len, out);
+    out[n++] = 0;
+    _seq++;
+    return n;
+}
+
+size_t TelemetryEncoder::hello(uint16_t periodMs, uint8_t* out) {
+    uint8_t raw[kTelemetryMaxFrame];
+    Writer w{raw};
+    w.u8((uint8_t)TelemetryRecord::HELLO);
+    w.u8(_seq);
+    w.u8(kTelemetryVersion);
+    w.u16(periodMs);
+    return finish(raw, w.n, out);
+}
+
+size_t TelemetryEncoder::tick(const TelemetryTick& t, uint8_t* out) {
+    uint8_t raw[kTelemetryMaxFrame];
+    Writer w{raw};
+    w.u8((uint8_t)TelemetryRecord::TICK);
+    w.u8(_seq);
+    w.u8(t.channel);
+    w.u32(t.tick);
+    w.u32(t.timeMs);
+    w.u8((uint8_t)t.state);
+    w.u8(t.flags);
+    w.cdeg(t.feedArmAngle);
+    w.cdeg(t.tensionArmAngle);
+    w.cdeg(t.tensionAngle);
+    w.u16(t.rawFeedPot);
+    w.u16(t.rawTensionPot);
+    w.u32(t.pulseCount);
+    w.u32(t.unstickCount);
+    return finish(raw, w.n, out);
+}
+
+size_t TelemetryEncoder::reed(const TelemetryReed& r, uint8_t* out) {
+    uint8_t raw[kTelemetryMaxFrame];
+    Writer w{raw};
+    w.u8((uint8_t)TelemetryRecord::REED);
+    w.u8(_seq);
+    w.u8(r.channel);
+    w.u32(r.pulseCount);
+    w.u64(r.stampUs);
+    w.u32(r.periodUs);
+    return finish(raw, w.n, out);
+}
+
+size_t TelemetryEncoder::event(const FeedArmEvent& ev, uint8_t* out) {
+    uint8_t raw[kTelemetryMaxFrame];
+    Writer w{raw};
+    w.u8((uint8_t)TelemetryRecord::EVENT);
+    w.u8(_seq);
+    w.u8(ev.channel);
+    w.u32(ev.timeMs);
+    w.u8((uint8_t)ev.type);
+    w.u8((uint8_t)ev.from);
+    w.u8((uint8_t)ev.to);
+    w.u8(ev.flag ? 1 : 0);
+    w.fixed(ev.a);
+    w.fixed(ev.b);
+    w.u32(ev.n);
+    return finish(raw, w.n, out);
+}
+
+size_t TelemetryEncoder::profile(const TelemetryProfile& p, uint8_t* out) {
+    uint8_t raw[kTelemetryMaxFrame];
+    Writer w{raw};
+    w.u8((uint8_t)TelemetryRecord::PROFILE);
+    w.u8(_seq);
+    w.u8((uint8_t)p.scope);
+    w.u32(p.stats.count);
+    w.u32(p.stats.minNs);
+    w.u32(p.stats.p50Ns);
+    w.u32(p.stats.p90Ns);
+    w.u32(p.stats.p99Ns);
+    w.u32(p.stats.maxNs);
+    return finish(raw, w.n, out);
+}
+
+// --- Decoder ---
+
+bool TelemetryDecoder::feed(uint8_t b) {
+    if (b != 0) {
+        if (_len < sizeof(_buf)) {
+            _buf[_len++] = b;
+        } else {
+            _overflow = true;
+        }
+        return false;
+    }
+
+    // Delimiter: decode whatever was collected.
+    size_t len = _len;
+    bool overflow = _overflow;
+    _len = 0;
+    _overflow = false;
+    if (len == 0) return false;
+
+    uint8_t raw[sizeof(_buf)];
+    size_t n = overflow ? 0 : cobsDecode(_buf, len, raw);
+    if (n < 4 || crc16Ccitt(raw, n - 2) != (uint16_t)(raw[n - 2] | raw[n - 1] << 8) ||
+        !parse(raw, n - 2)) {
+        _badFrames++;
+        return false;
+    }
+    _frames++;
+    return true;
+}
+
+bool TelemetryDecoder::parse(const uint8_t* raw, size_t len) {
+    Reader r{raw, len};
+    TelemetryRecord type = (TelemetryRecord)r.u8();
+    uint8_t seq = r.u8();
+
+    switch (type) {
+    case TelemetryRecord::HELLO:
+        if (!r.ok(3)) return false;
+        _hello.version = r.u8();
+        _hello.periodMs = r.u16();
+        // New session: don't count the restart as loss.
+        _haveSeq = false;
+        break;
+    case TelemetryRecord::TICK:
+        if (!r.ok(29)) return false;
+        _tick.channel = r.u8();
+        _tick.tick = r.u32();
+        _tick.timeMs = r.u32();
+        _tick.state = (FeedArmState)r.u8();
+        _tick.flags = r.u8();
+        _tick.feedArmAngle = r.cdeg();
+        _tick.tensionArmAngle = r.cdeg();
+        _tick.tensionAngle = r.cdeg();
+        _tick.rawFeedPot = r.u16();
+        _tick.rawTensionPot = r.u16();
+        _tick.pulseCount = r.u32();
+        _tick.unstickCount = r.u32();
+        break;
+    case TelemetryRecord::REED:
+        if (!r.ok(17)) return false;
+        _reed.channel = r.u8();
+        _reed.pulseCount = r.u32();
+        _reed.stampUs = r.u64();
+        _reed.periodUs = r.u32();
+        break;
+    case TelemetryRecord::EVENT:
+        if (!r.ok(21)) return false;
+        _event.channel = r.u8();
+        _event.timeMs = r.u32();
+        _event.type = (FeedArmEventType)r.u8();
+        _event.from = (FeedArmState)r.u8();
+        _event.to = (FeedArmState)r.u8();
+        _event.flag = r.u8() != 0;
+        _event.a = r.fixed();
+        _event.b = r.fixed();
+        _event.n = r.u32();
+        break;
+    case TelemetryRecord::PROFILE:
+        if (!r.ok(25)) return false;
+        _profile.scope = (ProfileScope)r.u8();
+        _profile.stats.count = r.u32();
+        _profile.stats.minNs = r.u32();
+        _profile.stats.p50Ns = r.u32();
+        _profile.stats.p90Ns = r.u32();
+        _profile.stats.p99Ns = r.u32();
+        _profile.stats.maxNs = r.u32();
+        break;
+    default:
+        return false;
+    }
+
+    if (_haveSeq) _lostFrames += (uint8_t)(seq - _lastSeq - 1);
+    _haveSeq = true;
+    _lastSeq = seq;
+    _type = type;
+    return true;
+}
@@ -0,0 +1,60 @@
+#include "TensionModel.h"
+
+#include <cmath>
+
+static constexpr float kDegToRad = 0.01745329252f;
+
+// Spring torque on the feed arm per N/mm of spring rate (N·mm), and the
+// spring's stretch (mm). Pivots: tension arm at the origin, feed arm
+// pivotSpacingMm along +X, both angles from +X.
+static float torquePerRate(const Config& cfg, float feedDeg, float tensionDeg, float& stretch) {
+    float rx = cfg.springAnchorMm * cosf(feedDeg * kDegToRad);
+    float ry = cfg.springAnchorMm * sinf(feedDeg * kDegToRad);
+    float dx = cfg.tensionArmLengthMm * cosf(tensionDeg * kDegToRad) - (cfg.pivotSpacingMm + rx);
+    float dy = cfg.tensionArmLengthMm * sinf(tensionDeg * kDegToRad) - ry;
+    float len = hypotf(dx, dy);
+    stretch = len - cfg.springFreeMm;
+    if (stretch <= 0 || len <= 0) return 0;     // extension spring goes slack
+    return stretch * (rx * dy - ry * dx) / len;
+}
+
+// Filament path gained per radian of feed arm lift (mm).
+static float pathGainMm(const Config& cfg) {
+    return cfg.pathGain * cfg.feedArmLengthMm;
+}
+
+float TensionModel::solve(const Config& cfg, float feedDeg, float tensionDeg) {
+    float gain = pathGainMm(cfg);
+    if (gain <= 0) return 0;
+    float stretch = 0;
+    float n = cfg.springRate * torquePerRate(cfg, feedDeg, tensionDeg, stretch) / gain;
+    return n > 0 ? n : 0;
+}
+
+float TensionModel::springRateFor(const Config& cfg, float feedDeg, float tensionDeg,
+                                  float newtons) {
+    float stretch = 0;
+    float perRate = torquePerRate(cfg, feedDeg, tensionDeg, stretch);
+    if (perRate <= 0 || newtons <= 0) return 0;
+    return newtons * pathGainMm(cfg) / perRate;
+}
+
+bool TensionModel::build(const Config& cfg) {
+    const float key[7] = { cfg.feedArmLengthMm, cfg.springAnchorMm, cfg.tensionArmLengthMm,
+                           cfg.pivotSpacingMm, cfg.pathGain, cfg.springRate,
+                           cfg.springFreeMm };
+    bool same = _built;
+    for (uint8_t i = 0; i < 7 && same; i++) same = key[i] == _key[i];
+    if (same) return false;
+
+    for (uint8_t f = 0; f <= kFeedSteps; f++) {
+        for (uint8_t t = 0; t <= kTensionSteps; t++) {
+            float n = solve(cfg, f * (160.0f / kFeedSteps), t * (160.0f / kTensionSteps));
+            float mN = n * 1000.0f + 0.5f;
+            _mN[f][t] = mN > 65535.0f ? 65535 : (uint16_t)mN;
+        }
+    }
+    for (uint8_t i = 0; i < 7; i++) _key[i] = key[i];
+    _built = true;
+    return true;
+}
@@ -0,0 +1,57 @@
+#include "TensionTracker.h"
+
+#include <cmath>
+
+void TensionTracker::restart(uint32_t nowMs) {
+    _started = false;
+    _sampledMs = 0;
+    _warmupMs = 0;
+    _correcting = false;
+    _lastNudgeMs = nowMs;
+}
+
+bool TensionTracker::update(const Config& cfg, uint32_t nowMs, float armAngle, float tension,
+                            float baseTension, float& newTension) {
+    _warmupMs = cfg.tensionTrackWarmupMs;
+    if (!_started) {
+        _started = true;
+        _average = armAngle;
+        _lastMs = nowMs;
+        return false;
+    }
+
+    // Time-based EMA, so skipped ticks don't change its time constant. A
+    // long gap (ineligible ticks) counts as one tick.
+    uint32_t dtMs = nowMs - _lastMs;
+    _lastMs = nowMs;
+    if (dtMs > cfg.monitorIntervalMs) dtMs = cfg.monitorIntervalMs;
+    float tauMs = cfg.tensionTrackTauSec * 1000.0f;
+    float k = tauMs > dtMs ? dtMs / tauMs : 1.0f;
+    _average += (armAngle - _average) * k;
+    // Only counted up to the warm-up, so weeks of monitoring can't wrap it.
+    if (_sampledMs < _warmupMs) _sampledMs += dtMs;
+
+    if (!cfg.tensionTrack || _sampledMs < _warmupMs) return false;
+
+    // Positive: the arm sags below rest and needs more spring.
+    float err = cfg.feedArmRestAngle - _average;
+    if (fabsf(err) > cfg.tensionTrackStartDeg) _correcting = true;
+    else if (fabsf(err) < cfg.tensionTrackStopDeg) _correcting = false;
+    if (!_correcting || nowMs - _lastNudgeMs < cfg.tensionTrackIntervalMs) return false;
+
+    float limit = cfg.tensionTrackMaxDegPerMin * cfg.tensionTrackIntervalMs / 60000.0f;
+    float step = err * cfg.tensionTrackGain;
+    if (step > limit) step = limit;
+    if (step < -limit) step = -limit;
+    float to = tension + step;
+    // A high arm may only be slack filament after a breakaway overrun, so
+    // tension is never taken below what the operator set.
+    float floor = baseTension > cfg.tensionAngleMin ? baseTension : cfg.tensionAngleMin;
+    if (to < floor) to = floor;
+    if (to > cfg.tensionAngleMax) to = cfg.tensionAngleMax;
+    _lastNudgeMs = nowMs;
+    if (fabsf(to - tension) < 0.1f) return false;     // pinned at a limit or the base
+    newTension = to;
+    _nudges++;
+    return true;
+}
@@ -0,0 +1,49 @@
+#include "UnstickLadder.h"
+
+static uint8_t stageCount(const Config& cfg) {
+    uint8_t n = cfg.unstickStages;
+    if (n < 1) n = 1;
+    if (n > kMaxUnstickStages) n = kMaxUnstickStages;
+    return n;
+}
+
+void UnstickLadder::clear() {
+    for (UnstickStageStats& s : _stats) s = {};
+    _jams = _cleared = _exhausted = 0;
+}
+
+uint8_t UnstickLadder::begin(const Config& cfg) {
+    _jams++;
+    return cfg.unstickAdaptive ? bestStage(cfg) : 0;
+}
+
+void UnstickLadder::record(uint8_t stage, bool success) {
+    if (stage >= kMaxUnstickStages) return;
+    _stats[stage].attempts++;
+    if (success) {
+        _stats[stage].successes++;
+        _cleared++;
+    }
+}
+
+int UnstickLadder::next(const Config& cfg, uint8_t stage) const {
+    return stage + 1 < stageCount(cfg) ? stage + 1 : -1;
+}
+
+uint8_t UnstickLadder::bestStage(const Config& cfg) const {
+    uint8_t best = 0;
+    float bestRate = successRate(0);
+    for (uint8_t i = 1; i < stageCount(cfg); i++) {
+        float rate = successRate(i);
+        if (rate > bestRate) {
+            best = i;
+            bestRate = rate;
+        }
+    }
+    return best;
+}
+
+float UnstickLadder::successRate(uint8_t stage) const {
+    const UnstickStageStats& s = _stats[stage];
+    return (s.successes + 1.0f) / (s.attempts + 2.0f);
+}
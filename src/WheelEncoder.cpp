@@ -1,78 +1,263 @@
 #include "WheelEncoder.h"
 
-// Static instance pointer for ISR trampoline.
-static ReedSwitch* _isrInstance = nullptr;
+#include <cmath>
 
-static void IRAM_ATTR reedISR() {
-    if (_isrInstance) {
-        _isrInstance->handleInterrupt();
-    }
+static constexpr uint32_t kHistoryMask = ReedSwitch::kHistory - 1;
+
+// ISR trampolines; the instance rides along as the callback argument.
+static void IRAM_ATTR reedEdge(void* arg, uint64_t nowUs) {
+    static_cast<ReedSwitch*>(arg)->handleInterrupt(nowUs);
+}
+
+static void IRAM_ATTR quadratureEdge(void* arg, uint64_t nowUs) {
+    static_cast<ReedSwitch*>(arg)->handleQuadrature(nowUs);
 }
 
-void ReedSwitch::begin(uint8_t pin) {
+// Position step for [previous AB][new AB]; 0 for no change or a skipped
+// state (both channels changed at once, direction unknown).
+static DRAM_ATTR const int8_t kQuadratureStep[16] = {
+     0, -1,  1,  0,
+     1,  0,  0, -1,
+    -1,  0,  0,  1,
+     0,  1, -1,  0,
+};
+
+void ReedSwitch::begin(uint8_t pin, EdgeInput& gpio, Clock& clock) {
     _pin = pin;
-    _pulseCount = 0;
-    _lastPulseTimeMs = 0;
-    _lastSampleCount = 0;
-    _lastSampleTimeMs = millis();
-    _pulsesPerSec = 0;
-
-    pinMode(_pin, INPUT_PULLUP);
-
-    _isrInstance = this;
-    // Reed switch closes when magnet passes — falling edge.
-    attachInterrupt(digitalPinToInterrupt(_pin), reedISR, FALLING);
-}
-
-void IRAM_ATTR ReedSwitch::handleInterrupt() {
-    // Simple debounce: ignore pulses within 50ms of each other.
-    // At typical filament feed rates, the wheel won't spin faster
-    // than ~5 rev/sec (200ms per rev), so 50ms debounce is safe.
-    uint32_t now = millis();
-    if (now - _lastPulseTimeMs > 50) {
-        _pulseCount++;
-        _lastPulseTimeMs = now;
+    _clock = &clock;
+    _head = 0;
+    _lastPeriodUs = 0;
+    _rejected = 0;
+    _position = 0;
+    _highWater = 0;
+    reset();
+
+    // Reed switch closes when magnet passes — falling edge, pulled up.
+    gpio.attachFalling(_pin, true, reedEdge, this);
+}
+
+void ReedSwitch::beginQuadrature(uint8_t pinA, uint8_t pinB, EdgeInput& gpio, Clock& clock) {
+    _pin = pinA;
+    _pinB = pinB;
+    _clock = &clock;
+    _gpio = &gpio;
+    _levelMask[0] = 1u << (pinA & 31);
+    _levelMask[1] = 1u << (pinB & 31);
+    _levelBank1[0] = pinA >= 32;
+    _levelBank1[1] = pinB >= 32;
+    _head = 0;
+    _lastPeriodUs = 0;
+    _rejected = 0;
+    _position = 0;
+    _highWater = 0;
+    reset();
+
+    gpio.attachChange(pinA, true, quadratureEdge, this);
+    gpio.attachChange(pinB, true, quadratureEdge, this);
+    _quadState = (gpio.level(pinA) ? 2 : 0) | (gpio.level(pinB) ? 1 : 0);
+}
+
+void ReedSwitch::setWheel(uint16_t pulsesPerRev, float diameterMm) {
+    if (pulsesPerRev == 0) pulsesPerRev = 1;
+    _mmPerPulse = 3.14159265f * diameterMm / pulsesPerRev;
+}
+
+void ReedSwitch::setDebounce(uint32_t minUs, uint32_t maxUs, float fraction) {
+    _debounceMinUs = minUs;
+    _debounceMaxUs = maxUs > minUs ? maxUs : minUs;
+    _debounceFracQ8 = (uint32_t)(constrain(fraction, 0.0f, 1.0f) * 256.0f);
+}
+
+void IRAM_ATTR ReedSwitch::handleInterrupt(uint64_t nowUs) {
+    // Ring stamps keep 32 bits, which wrap after ~71 minutes — far beyond
+    // any pulse period we care about.
+    uint32_t stampUs = (uint32_t)nowUs;
+    uint32_t head = _head;
+
+    if (head > 0) {
+        uint32_t interval = stampUs - _stampsUs[(head - 1) & kHistoryMask];
+
+        // Debounce relative to how fast the wheel is actually turning:
+        // bounce is a small fraction of a pulse period at any feed rate.
+        uint32_t debounceUs = _debounceMaxUs;
+        if (_lastPeriodUs > 0) {
+            debounceUs = (uint32_t)(((uint64_t)_lastPeriodUs * _debounceFracQ8) >> 8);
+            if (debounceUs < _debounceMinUs) debounceUs = _debounceMinUs;
+            if (debounceUs > _debounceMaxUs) debounceUs = _debounceMaxUs;
+        }
+        if (interval < debounceUs) {
+            _rejected = _rejected + 1;
+            return;
+        }
     }
+    _position = _position + 1;
+    accept(stampUs, nowUs);
 }
 
-bool ReedSwitch::isStalled(uint32_t timeoutMs) const {
-    // If we've never seen a pulse, don't report stall until timeout
-    // from startup (gives the system time to start).
-    if (_lastPulseTimeMs == 0) {
-        return (millis() > timeoutMs);
+void IRAM_ATTR ReedSwitch::handleQuadrature(uint64_t nowUs) {
+    // Either channel changed; the levels say which way.
+    uint8_t state = (channelHigh(0) ? 2 : 0) | (channelHigh(1) ? 1 : 0);
+    uint8_t prev = _quadState;
+    int8_t step = kQuadratureStep[(prev << 2) | state];
+    _quadState = state;
+    if (step == 0) {
+        if (state != prev) _rejected = _rejected + 1;
+        return;
     }
-    return (millis() - _lastPulseTimeMs) > timeoutMs;
+    int32_t position = _position + step;
+    _position = position;
+    // Backing up and coming forward again covers the same filament twice.
+    if (position <= _highWater) return;
+    _highWater = position;
+    accept((uint32_t)nowUs, nowUs);
 }
 
-float ReedSwitch::pulsesPerSec() const {
-    return _pulsesPerSec;
+void IRAM_ATTR ReedSwitch::accept(uint32_t stampUs, uint64_t nowUs) {
+    uint32_t head = _head;
+    if (head > 0) _lastPeriodUs = stampUs - _stampsUs[(head - 1) & kHistoryMask];
+    _stampsUs[head & kHistoryMask] = stampUs;
+    _lastPulseUs = nowUs;
+    _head = head + 1;   // publish last, readers key off _head
+}
+
+uint8_t ReedSwitch::snapshot(uint32_t* stamps) const {
+    // Seqlock on _head: if the ISR fired while copying, copy again.
+    for (;;) {
+        uint32_t head = _head;
+        uint32_t n = head - _resetHead;
+        if (n > kHistory) n = kHistory;
+        for (uint32_t i = 0; i < n; i++) {
+            stamps[i] = _stampsUs[(head - n + i) & kHistoryMask];
+        }
+        if (_head == head) return (uint8_t)n;
+    }
+}
+
+bool ReedSwitch::stats(ReedStats& out) const {
+    uint32_t stamps[kHistory];
+    uint8_t n = snapshot(stamps);
+    out = {};
+    if (n < 2) return false;
+
+    uint64_t sum = 0;
+    out.minPeriodUs = UINT32_MAX;
+    for (uint8_t i = 1; i < n; i++) {
+        uint32_t period = stamps[i] - stamps[i - 1];
+        sum += period;
+        if (period < out.minPeriodUs) out.minPeriodUs = period;
+        if (period > out.maxPeriodUs) out.maxPeriodUs = period;
+    }
+    out.intervals = n - 1;
+    out.lastPeriodUs = stamps[n - 1] - stamps[n - 2];
+    out.meanPeriodUs = (uint32_t)(sum / out.intervals);
+
+    float var = 0;
+    for (uint8_t i = 1; i < n; i++) {
+        float d = (float)(stamps[i] - stamps[i - 1]) - (float)out.meanPeriodUs;
+        var += d * d;
+    }
+    out.jitterUs = (uint32_t)sqrtf(var / out.intervals);
+    return true;
 }
 
-uint32_t ReedSwitch::sample() {
-    uint32_t now = millis();
-    uint32_t count = _pulseCount;  // atomic on ESP32
+uint32_t ReedSwitch::lastPeriodUs() const {
+    return pulseCount() >= 2 ? _lastPeriodUs : 0;
+}
 
-    uint32_t deltaPulses = count - _lastSampleCount;
-    uint32_t deltaTimeMs = now - _lastSampleTimeMs;
+bool ReedSwitch::isStalled(uint32_t timeoutMs) const {
+    return timeSinceLastPulseMs() > timeoutMs;
+}
 
-    if (deltaTimeMs > 0) {
-        _pulsesPerSec = (float)deltaPulses / ((float)deltaTimeMs / 1000.0f);
+bool ReedSwitch::isStalled(float periods, uint32_t minMs, uint32_t maxMs) const {
+    uint32_t limitMs = maxMs;
+    ReedStats st;
+    if (stats(st)) {
+        uint32_t expectedMs = (uint32_t)(st.meanPeriodUs / 1000.0f * periods);
+        limitMs = constrain(expectedMs, minMs, maxMs);
     }
+    return timeSinceLastPulseMs() > limitMs;
+}
 
-    _lastSampleCount = count;
-    _lastSampleTimeMs = now;
-    return deltaPulses;
+float ReedSwitch::pulsesPerSec() const {
+    ReedStats st;
+    if (!stats(st) || st.meanPeriodUs == 0) return 0;
+
+    float rate = 1e6f / st.meanPeriodUs;
+
+    // Once we're overdue for the next pulse, the wheel is slower than the
+    // history says — bound the rate by the time we've been waiting.
+    uint32_t sinceMs = timeSinceLastPulseMs();
+    if (sinceMs * 1000.0f > st.meanPeriodUs) {
+        float bound = 1000.0f / sinceMs;
+        if (bound < rate) rate = bound;
+    }
+    return rate;
 }
 
 uint32_t ReedSwitch::timeSinceLastPulseMs() const {
-    if (_lastPulseTimeMs == 0) return millis();  // never pulsed
-    return millis() - _lastPulseTimeMs;
+    // No pulse since reset: measure from the reset, which gives the system
+    // the full timeout to start feeding.
+    uint64_t sinceUs;
+    for (;;) {
+        uint32_t head = _head;
+        uint64_t fromUs = (head == _resetHead) ? _resetUs : _lastPulseUs;
+        if (_head == head) {
+            sinceUs = _clock->micros() - fromUs;
+            break;
+        }
+    }
+    return (uint32_t)(sinceUs / 1000);
+}
+
+float ReedSwitch::positionMm() const {
+    int32_t position;
+    uint64_t lastUs;
+    for (;;) {
+        uint32_t head = _head;
+        position = _position;
+        lastUs = _lastPulseUs;
+        if (_head == head) break;
+    }
+    float pulses = (float)position;
+    uint32_t periodUs = lastPeriodUs();
+    if (periodUs > 0 && lastUs > 0) {
+        // Carry on at the last rate, but stop short of the next pulse: it
+        // may never come.
+        float frac = (float)(_clock->micros() - lastUs) / periodUs;
+        pulses += frac < 0.99f ? frac : 0.99f;
+    }
+    return pulses * _mmPerPulse;
+}
+
+uint64_t ReedSwitch::lastPulseUs() const {
+    for (;;) {
+        uint32_t head = _head;
+        uint64_t us = (head == _resetHead) ? 0 : _lastPulseUs;
+        if (_head == head) return us;
+    }
 }
 
 void ReedSwitch::reset() {
-    _pulseCount = 0;
-    _lastPulseTimeMs = 0;
-    _lastSampleCount = 0;
-    _lastSampleTimeMs = millis();
-    _pulsesPerSec = 0;
+    // The ISR owns the ring; reset just moves the baseline forward.
+    _resetUs = _clock->micros();
+    _resetHead = _head;
+}
+
+// --- FilamentOdometer ---
+
+void FilamentOdometer::update(int32_t position, uint32_t msSinceMove, uint32_t printGapMs) {
+    if (_idle && position != _position) {
+        // Moving again after a long stop: a new print, from where it stood.
+        _printStart = _position;
+        _prints++;
+        _idle = false;
+    }
+    _position = position;
+    if (msSinceMove > printGapMs) _idle = true;
+}
+
+void FilamentOdometer::startPrint() {
+    _printStart = _position;
+    _prints++;
+    _idle = false;
 }
@@ -0,0 +1,282 @@
+#include "ControlTask.h"
+
+#include <esp_timer.h>
+#include "Profiler.h"
+
+// Static instance pointer for the timer ISR trampoline.
+static ControlTask* _timerInstance = nullptr;
+
+static void IRAM_ATTR controlTimerISR() {
+    if (_timerInstance) {
+        _timerInstance->onTimer();
+    }
+}
+
+static void controlTaskEntry(void* arg) {
+    static_cast<ControlTask*>(arg)->run();
+}
+
+bool ControlTask::begin(FeedArmController* arms, ReedSwitch* reeds, uint8_t count,
+                        uint32_t periodMs) {
+    if (count == 0 || count > kMaxFeedChannels) return false;
+    _arms = arms;
+    _reeds = reeds;
+    _count = count;
+    for (uint8_t i = 0; i < _count; i++) {
+        _arms[i].setChannel(i);
+        // One task updates every channel, so it stays the ring's only producer.
+        _arms[i].setEventSink(&_events);
+    }
+    _budgetUs = _arms[0].config().controlBudgetUs;
+    _periodUs = periodMs * 1000;
+    _idle.configure(_arms[0].config());
+
+    if (xTaskCreatePinnedToCore(controlTaskEntry, "control", 4096, this,
+                                kControlPriority, &_task, kControlCore) != pdPASS) {
+        Serial.println("[Control] Task create failed");
+        return false;
+    }
+
+    // 80 MHz APB / 80 = 1 us timer ticks.
+    _timerInstance = this;
+    _timer = timerBegin(kControlTimer, 80, true);
+    timerAttachInterrupt(_timer, controlTimerISR, true);
+    timerAlarmWrite(_timer, (uint64_t)periodMs * 1000, true);
+    timerAlarmEnable(_timer);
+
+    Serial.printf("[Control] Task on core %d, prio %u, period %ums, %u channel(s), "
+                  "budget %uus\n", (int)kControlCore, (unsigned)kControlPriority,
+                  periodMs, _count, _budgetUs);
+    return true;
+}
+
+void IRAM_ATTR ControlTask::onTimer() {
+    _releaseUs = (uint64_t)esp_timer_get_time();
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(_task, &woken);
+    if (woken) portYIELD_FROM_ISR();
+}
+
+void ControlTask::run() {
+    for (;;) {
+        uint64_t releaseUs;
+        if (_idleMode) {
+            releaseUs = idleWait();
+        } else {
+            // Each notification is one timer period. More than one pending
+            // means the previous tick overran and periods were skipped.
+            uint32_t pending = ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            if (pending > 1) _missedTicks += pending - 1;
+            releaseUs = _releaseUs;
+        }
+#ifdef FFX_PROFILE
+        // How late the task woke, and how far the start-to-start period
+        // strayed from the timer's.
+        uint64_t startUs = (uint64_t)esp_timer_get_time();
+        PROFILE_RECORD(TICK_WAKE, (uint32_t)(startUs - releaseUs));
+        if (_lastStartUs) {
+            int64_t drift = (int64_t)(startUs - _lastStartUs) - (int64_t)_periodUs;
+            PROFILE_RECORD(TICK_JITTER, (uint32_t)(drift < 0 ? -drift : drift));
+        }
+        _lastStartUs = startUs;
+#endif
+        if (_clearTiming) {
+            for (uint8_t i = 0; i < _count; i++) {
+                _worstLatencyUs[i] = 0;
+                _overBudget[i] = 0;
+            }
+            _clearTiming = false;
+        }
+        if (_clearWake) {
+            _idle.clearStats();
+            _clearWake = false;
+        }
+
+        ControlCommand cmd;
+        while (_commands.pop(cmd)) {
+            applyCommand(cmd);
+            _idle.wake(WakeReason::COMMAND, millis());
+        }
+        for (uint8_t i = 0; i < _count; i++) {
+            const Config* cfg = _configs[i].pending();
+            if (!cfg) continue;
+            _arms[i].updateConfig(*cfg);
+            if (i == 0) {
+                _budgetUs = cfg->controlBudgetUs;
+                _idle.configure(*cfg);
+                if (_power) _power->configure(*cfg);
+            }
+            _configs[i].release();
+        }
+        for (uint8_t i = 0; i < _count; i++) {
+            PrinterFeed feed;
+            if (!_printerFeeds[i].take(feed)) continue;
+            _arms[i].setPrinterFeed(feed);
+            _printerActivity[i] = feed.activity;
+        }
+        // Back to the fast tick before the controllers run, if anything
+        // above woke the board.
+        syncPowerMode();
+
+        _tick++;
+        PROFILE_SCOPE(CONTROL_TICK);
+        for (uint8_t i = 0; i < _count; i++) {
+            _arms[i].update();
+            uint32_t latencyUs = (uint32_t)((uint64_t)esp_timer_get_time() - releaseUs);
+            if (latencyUs > _worstLatencyUs[i]) _worstLatencyUs[i] = latencyUs;
+            if (latencyUs > _budgetUs) _overBudget[i]++;
+            publishStatus(i, latencyUs);
+            PotSweepResult sweep;
+            if (_arms[i].takeCalibration(sweep)) _sweeps[i].publish(sweep);
+        }
+        updateIdle();
+        if (_listener) xTaskNotifyGive(_listener);
+    }
+}
+
+uint64_t ControlTask::idleWait() {
+    uint64_t wakeUs = 0;
+    WakeReason why = _power->waitIdleTick(_idle.tickMs() * 1000, wakeUs);
+    // After a light sleep the held pot readings are stale: the tick waits
+    // for the scan to restart, and how long that took is the wake latency.
+    uint32_t latencyUs;
+    if (_power->waitFreshSamples(wakeUs, latencyUs)) _idle.recordWakeLatency(latencyUs);
+    if (why != WakeReason::NONE) _idle.wake(why, millis());
+    // Only the release moves on; the idle tick is its own period.
+    _lastStartUs = 0;
+    return wakeUs;
+}
+
+void ControlTask::updateIdle() {
+    if (!_power) return;
+    IdleInput in[kMaxFeedChannels];
+    for (uint8_t i = 0; i < _count; i++) {
+        in[i].state = _arms[i].state();
+        in[i].pulses = _reeds ? _reeds[i].pulseCount() : 0;
+        in[i].armDeg = _arms[i].feedArmAngle();
+        in[i].printer = _printerActivity[i];
+    }
+    _idle.update(millis(), in, _count);
+    // Entries and wakes (idleWait()'s too) go out as events for comms to print.
+    FeedArmEvent ev;
+    if (_idle.takeEvent(ev)) _events.push(ev);
+    syncPowerMode();
+}
+
+void ControlTask::syncPowerMode() {
+    if (!_power || _idle.idle() == _idleMode) return;
+    _idleMode = _idle.idle();
+    if (_idleMode) {
+        timerAlarmDisable(_timer);
+        _power->enterIdle();
+    } else {
+        _power->exitIdle();
+        // Restart the period from now, and drop a release left over from
+        // before the timer stopped.
+        timerWrite(_timer, 0);
+        timerAlarmEnable(_timer);
+        ulTaskNotifyTake(pdTRUE, 0);
+    }
+}
+
+bool ControlTask::send(uint8_t channel, ControlCommandType type, float value) {
+    if (channel >= _count) return false;
+    ControlCommand cmd = { channel, type, value };
+    return _commands.push(cmd);
+}
+
+bool ControlTask::setConfig(uint8_t channel, const Config& cfg) {
+    if (channel >= _count) return false;
+    return _configs[channel].publish(cfg);
+}
+
+bool ControlTask::setPrinterFeed(uint8_t channel, const PrinterFeed& feed) {
+    if (channel >= _count) return false;
+    return _printerFeeds[channel].publish(feed);
+}
+
+bool ControlTask::takePotSweep(uint8_t channel, PotSweepResult& out) {
+    return channel < _count && _sweeps[channel].take(out);
+}
+
+bool ControlTask::latestStatus(FeedArmStatus* out) {
+    FeedArmStatus st;
+    while (_status.pop(st)) {}
+    bool got = false;
+    for (uint8_t i = 0; i < _count; i++) {
+        if (_latest[i].take(out[i])) got = true;
+    }
+    return got;
+}
+
+ChannelTiming ControlTask::timing(uint8_t channel) const {
+    ChannelTiming t = {};
+    if (channel < _count) {
+        t.worstLatencyUs = _worstLatencyUs[channel];
+        t.overBudget = _overBudget[channel];
+    }
+    return t;
+}
+
+void ControlTask::clearTiming() {
+    // Done by the control task between ticks so it never races an update.
+    _clearTiming = true;
+}
+
+void ControlTask::applyCommand(const ControlCommand& cmd) {
+    FeedArmController& arm = _arms[cmd.channel];
+    switch (cmd.type) {
+    case ControlCommandType::UNSTICK:
+        arm.triggerUnstick();
+        break;
+    case ControlCommandType::SET_TENSION:
+        arm.setTensionAngle(cmd.value);
+        break;
+    case ControlCommandType::CLEAR_UNSTICK_STATS:
+        arm.clearUnstickStats();
+        break;
+    case ControlCommandType::CALIBRATE_POTS:
+        arm.startCalibration();
+        break;
+    case ControlCommandType::START_PRINT:
+        arm.startPrint();
+        break;
+    }
+}
+
+void ControlTask::publishStatus(uint8_t ch, uint32_t latencyUs) {
+    const FeedArmController* arm = &_arms[ch];
+    ReedSwitch* reed = _reeds ? &_reeds[ch] : nullptr;
+    FeedArmStatus st;
+    st.channel = ch;
+    st.tick = _tick;
+    st.timeMs = millis();
+    st.state = arm->state();
+    st.feedArmAngle = arm->feedArmAngle();
+    st.tensionArmAngle = arm->tensionArmAngle();
+    st.tensionAngle = arm->tensionAngle();
+    st.filamentTension = arm->filamentTension();
+    st.rawFeedPot = arm->rawFeedPot();
+    st.rawTensionPot = arm->rawTensionPot();
+    st.unstickCount = arm->unstickCount();
+    st.filamentStalled = arm->filamentStalled();
+    st.pulsesPerSec = reed ? reed->pulsesPerSec() : 0;
+    st.pulseCount = reed ? reed->pulseCount() : 0;
+    st.filamentSpeed = arm->filamentSpeed();
+    st.expectedFeed = arm->expectedFeed();
+    st.filamentUsedMm = arm->filamentUsedMm();
+    st.printUsedMm = arm->printUsedMm();
+    st.printCount = arm->printCount();
+    st.msSinceLastPulse = reed ? reed->timeSinceLastPulseMs() : 0;
+    st.lastPulseUs = reed ? reed->lastPulseUs() : 0;
+    ReedStats rs = {};
+    if (reed) reed->stats(rs);
+    st.reedPeriodUs = rs.lastPeriodUs;
+    st.reedJitterUs = rs.jitterUs;
+    st.spectrum = arm->spectrum().features();
+    st.latencyUs = latencyUs;
+    // A full ring means comms is behind and drops this tick; telemetry
+    // counts the gap from the tick numbers. The mailbox always has the newest.
+    _status.push(st);
+    _latest[ch].publish(st);
+}
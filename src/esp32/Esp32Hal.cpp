@@ -0,0 +1,237 @@
+#include "Esp32Hal.h"
+
+#include <cstdarg>
+#include <driver/gpio.h>
+#include <driver/ledc.h>
+#include <esp_timer.h>
+#include <LittleFS.h>
+
+// --- Clock ---
+
+uint32_t Esp32Clock::millis() {
+    return ::millis();
+}
+
+uint64_t Esp32Clock::micros() {
+    return (uint64_t)esp_timer_get_time();
+}
+
+void Esp32Clock::delayMs(uint32_t ms) {
+    ::delay(ms);
+}
+
+// --- Servo ---
+
+static constexpr uint32_t kServoFrameUs = 20000;   // 50 Hz
+static constexpr uint8_t kServoDutyBits = 14;      // widest the S3 LEDC timer allows
+
+uint8_t Esp32ServoOutput::_sleepTimers = 0;
+
+bool Esp32ServoOutput::begin(uint8_t ledcChannel, bool keepInSleep) {
+    if (ledcChannel >= kLedcChannels) return false;
+    _ledc = ledcChannel;
+    if (ledcSetup(_ledc, 1000000 / kServoFrameUs, kServoDutyBits) == 0) return false;
+    // Same timer ledcSetup() picked: channels pair up on timers.
+    if (keepInSleep) _sleepTimers |= 1u << ((_ledc / 2) % LEDC_TIMER_MAX);
+    return true;
+}
+
+bool Esp32ServoOutput::useSleepClock(bool sleep) {
+    // APB stops in light sleep. Clocked from the internal RC oscillator the
+    // timer keeps going, so a holding servo keeps its pulses. The duty is a
+    // share of the frame, so it carries over the switch unchanged.
+    bool ok = true;
+    for (uint8_t t = 0; t < LEDC_TIMER_MAX; t++) {
+        if (!(_sleepTimers & (1u << t))) continue;
+        ledc_timer_config_t timer = {};
+        timer.speed_mode = LEDC_LOW_SPEED_MODE;
+        timer.duty_resolution = (ledc_timer_bit_t)kServoDutyBits;
+        timer.timer_num = (ledc_timer_t)t;
+        timer.freq_hz = 1000000 / kServoFrameUs;
+        timer.clk_cfg = sleep ? LEDC_USE_RTC8M_CLK : LEDC_USE_APB_CLK;
+        if (ledc_timer_config(&timer) != ESP_OK) ok = false;
+    }
+    return ok;
+}
+
+bool Esp32ServoOutput::attach(uint8_t pin, uint16_t minUs, uint16_t maxUs) {
+    if (_ledc >= kLedcChannels) return false;
+    _minUs = minUs;
+    _maxUs = maxUs;
+    _pin = pin;
+    ledcAttachPin(_pin, _ledc);
+    _attached = true;
+    return true;
+}
+
+void Esp32ServoOutput::detach() {
+    if (!_attached) return;
+    // No pulses: the servo goes limp and the arm floats.
+    ledcWrite(_ledc, 0);
+    ledcDetachPin(_pin);
+    _attached = false;
+}
+
+void Esp32ServoOutput::write(float angle) {
+    if (!_attached) return;
+    angle = constrain(angle, 0.0f, 180.0f);
+    float us = _minUs + angle * (_maxUs - _minUs) / 180.0f;
+    ledcWrite(_ledc, (uint32_t)(us * (1u << kServoDutyBits) / kServoFrameUs + 0.5f));
+}
+
+// --- Edge interrupts ---
+
+// Slots live in DRAM so the ISR never touches flash.
+struct EdgeSlot {
+    EdgeCallback cb;
+    void* arg;
+    uint8_t pin;
+    int mode;           // FALLING or CHANGE
+    bool sleepLevel;    // level when armWake() ran
+};
+static DRAM_ATTR EdgeSlot _edgeSlots[Esp32EdgeInput::kMaxPins];
+static uint8_t _edgeSlotCount = 0;
+
+static void IRAM_ATTR edgeISR(void* arg) {
+    // Timestamp first so the callback sees the edge time, not its own latency.
+    uint64_t nowUs = (uint64_t)esp_timer_get_time();
+    EdgeSlot* slot = static_cast<EdgeSlot*>(arg);
+    slot->cb(slot->arg, nowUs);
+}
+
+bool Esp32EdgeInput::attachFalling(uint8_t pin, bool pullup, EdgeCallback cb, void* arg) {
+    return attach(pin, pullup, cb, arg, FALLING);
+}
+
+bool Esp32EdgeInput::attachChange(uint8_t pin, bool pullup, EdgeCallback cb, void* arg) {
+    return attach(pin, pullup, cb, arg, CHANGE);
+}
+
+bool Esp32EdgeInput::attach(uint8_t pin, bool pullup, EdgeCallback cb, void* arg, int mode) {
+    if (_edgeSlotCount >= kMaxPins) return false;
+    EdgeSlot* slot = &_edgeSlots[_edgeSlotCount++];
+    slot->cb = cb;
+    slot->arg = arg;
+    slot->pin = pin;
+    slot->mode = mode;
+
+    pinMode(pin, pullup ? INPUT_PULLUP : INPUT);
+    attachInterruptArg(digitalPinToInterrupt(pin), edgeISR, slot, mode);
+    return true;
+}
+
+bool Esp32EdgeInput::level(uint8_t pin) {
+    return gpio_get_level((gpio_num_t)pin) != 0;
+}
+
+void Esp32EdgeInput::armWake() {
+    for (uint8_t i = 0; i < _edgeSlotCount; i++) {
+        EdgeSlot& slot = _edgeSlots[i];
+        gpio_num_t pin = (gpio_num_t)slot.pin;
+        slot.sleepLevel = gpio_get_level(pin) != 0;
+        // Wake-up needs a level interrupt; with the CPU's interrupt off it
+        // only wakes the chip instead of firing over and over once awake.
+        gpio_intr_disable(pin);
+        gpio_wakeup_enable(pin, slot.sleepLevel ? GPIO_INTR_LOW_LEVEL : GPIO_INTR_HIGH_LEVEL);
+    }
+}
+
+bool Esp32EdgeInput::disarmWake(uint64_t nowUs) {
+    bool changed = false;
+    for (uint8_t i = 0; i < _edgeSlotCount; i++) {
+        EdgeSlot& slot = _edgeSlots[i];
+        gpio_num_t pin = (gpio_num_t)slot.pin;
+        gpio_wakeup_disable(pin);
+        bool level = gpio_get_level(pin) != 0;
+        if (level != slot.sleepLevel) {
+            changed = true;
+            // The interrupt is still off, so this is the only caller.
+            if (slot.mode == CHANGE || (slot.mode == FALLING && !level)) slot.cb(slot.arg, nowUs);
+        }
+        gpio_set_intr_type(pin, slot.mode == FALLING ? GPIO_INTR_NEGEDGE : GPIO_INTR_ANYEDGE);
+        gpio_intr_enable(pin);
+    }
+    return changed;
+}
+
+// --- Config storage ---
+
+bool Esp32ConfigStorage::begin() {
+    _open = _prefs.begin("ffx", false);
+    return _open;
+}
+
+size_t Esp32ConfigStorage::read(const char* key, void* buf, size_t len) {
+    // getBytes() returns 0 for a missing key or one larger than buf.
+    return _open ? _prefs.getBytes(key, buf, len) : 0;
+}
+
+bool Esp32ConfigStorage::write(const char* key, const void* buf, size_t len) {
+    return _open && _prefs.putBytes(key, buf, len) == len;
+}
+
+bool Esp32ConfigStorage::erase(const char* key) {
+    return _open && _prefs.remove(key);
+}
+
+// --- Journal storage ---
+
+bool Esp32JournalStorage::begin() {
+    // Formats the partition on first use.
+    _mounted = LittleFS.begin(true);
+    if (!_mounted) Serial.println("[Journal] LittleFS mount failed");
+    return _mounted;
+}
+
+void Esp32JournalStorage::path(uint8_t segment, char* out) {
+    snprintf(out, 16, "/jam%u.bin", segment);
+}
+
+size_t Esp32JournalStorage::size(uint8_t segment) {
+    char p[16];
+    path(segment, p);
+    if (!_mounted || !LittleFS.exists(p)) return 0;
+    File f = LittleFS.open(p, "r");
+    size_t n = f ? f.size() : 0;
+    f.close();
+    return n;
+}
+
+size_t Esp32JournalStorage::read(uint8_t segment, size_t offset, void* buf, size_t len) {
+    char p[16];
+    path(segment, p);
+    if (!_mounted || !LittleFS.exists(p)) return 0;
+    File f = LittleFS.open(p, "r");
+    if (!f) return 0;
+    size_t n = f.seek(offset) ? f.read(static_cast<uint8_t*>(buf), len) : 0;
+    f.close();
+    return n;
+}
+
+bool Esp32JournalStorage::append(uint8_t segment, const void* buf, size_t len) {
+    char p[16];
+    path(segment, p);
+    if (!_mounted) return false;
+    File f = LittleFS.open(p, "a");
+    if (!f) return false;
+    size_t n = f.write(static_cast<const uint8_t*>(buf), len);
+    f.close();
+    return n == len;
+}
+
+bool Esp32JournalStorage::erase(uint8_t segment) {
+    char p[16];
+    path(segment, p);
+    return _mounted && (!LittleFS.exists(p) || LittleFS.remove(p));
+}
+
+// --- Logging ---
+
+void logPrintf(const char* fmt, ...) {
+    char buf[192];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    Serial.print(buf);
+}
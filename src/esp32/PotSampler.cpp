@@ -0,0 +1,235 @@
+#include "PotSampler.h"
+
+#include <driver/adc.h>
+#include <esp_timer.h>
+
+// Conversions per DMA frame. Small frames keep the newest sample fresh:
+// at 2 kHz per pot a 32-result frame lands every 8 ms with one arm's two
+// pots, every 2 ms with four arms' eight.
+static constexpr uint32_t kFrameResults = 32;
+static constexpr uint32_t kFrameBytes = kFrameResults * SOC_ADC_DIGI_RESULT_BYTES;
+
+// Driver-side pool that buffers frames while the task is busy.
+static constexpr uint32_t kPoolBytes = kFrameBytes * 8;
+
+static constexpr uint16_t kRingMask = PotSampler::kRingSize - 1;
+
+static void potSamplerTask(void* arg) {
+    static_cast<PotSampler*>(arg)->drain();
+}
+
+bool PotSampler::begin(const uint8_t* pins, uint8_t count, uint32_t sampleRateHz,
+                       uint8_t window) {
+    if (_running || count == 0 || count > kMaxChannels) return false;
+
+    analogReadResolution(12);       // 0-4095
+    analogSetAttenuation(ADC_11db); // 0-3.3V range
+    for (uint8_t i = 0; i < count; i++) {
+        _pins[i] = pins[i];
+        pinMode(_pins[i], INPUT);
+        _head[i] = 0;
+        _sum[i] = 0;
+        _filtered[i] = 0;
+    }
+    _count = count;
+    _window = _pendingWindow = constrain(window, (uint8_t)1, (uint8_t)kRingSize);
+    _overruns = 0;
+
+    if (!startDma(sampleRateHz)) {
+        Serial.println("[PotADC] Continuous ADC unavailable, using analogRead()");
+        return false;
+    }
+    return true;
+}
+
+bool PotSampler::startDma(uint32_t sampleRateHz) {
+    uint32_t chanMask = 0;
+    for (uint8_t i = 0; i < _count; i++) {
+        // Continuous mode here is ADC1-only; ADC2 channels report >= 10.
+        int8_t adcCh = digitalPinToAnalogChannel(_pins[i]);
+        if (adcCh < 0 || adcCh >= SOC_ADC_MAX_CHANNEL_NUM) {
+            Serial.printf("[PotADC] GPIO%u is not an ADC1 pin\n", _pins[i]);
+            return false;
+        }
+        _adcChannel[i] = (uint8_t)adcCh;
+        chanMask |= 1u << adcCh;
+    }
+
+    // The digital controller rate is the total across the scan pattern.
+    uint32_t totalHz = sampleRateHz * _count;
+    totalHz = constrain(totalHz, (uint32_t)SOC_ADC_SAMPLE_FREQ_THRES_LOW,
+                        (uint32_t)SOC_ADC_SAMPLE_FREQ_THRES_HIGH);
+
+    adc_digi_init_config_t initCfg = {};
+    initCfg.max_store_buf_size = kPoolBytes;
+    initCfg.conv_num_each_intr = kFrameBytes;
+    initCfg.adc1_chan_mask = chanMask;
+    initCfg.adc2_chan_mask = 0;
+    if (adc_digi_initialize(&initCfg) != ESP_OK) {
+        Serial.println("[PotADC] DMA init failed");
+        return false;
+    }
+
+    static_assert(kMaxChannels <= SOC_ADC_PATT_LEN_MAX, "scan pattern too long");
+    adc_digi_pattern_config_t pattern[kMaxChannels] = {};
+    for (uint8_t i = 0; i < _count; i++) {
+        pattern[i].atten = ADC_ATTEN_DB_11;     // 0-3.3V range
+        pattern[i].channel = _adcChannel[i];
+        pattern[i].unit = 0;                    // ADC1 (pattern unit index)
+        pattern[i].bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+    }
+
+    adc_digi_configuration_t digiCfg = {};
+    digiCfg.conv_limit_en = false;
+    digiCfg.conv_limit_num = 250;
+    digiCfg.pattern_num = _count;
+    digiCfg.adc_pattern = pattern;
+    digiCfg.sample_freq_hz = totalHz;
+    digiCfg.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+    digiCfg.format = ADC_DIGI_OUTPUT_FORMAT_TYPE2;
+    if (adc_digi_controller_configure(&digiCfg) != ESP_OK) {
+        Serial.println("[PotADC] DMA configure failed");
+        adc_digi_deinitialize();
+        return false;
+    }
+
+    _conversionUs = 1000000 / totalHz;
+
+    adc_digi_start();
+    _running = true;
+
+    // Core 0 keeps the drain off the Arduino loop core.
+    TaskHandle_t handle = nullptr;
+    xTaskCreatePinnedToCore(potSamplerTask, "potadc", 3072, this, 5, &handle, 0);
+    _task = handle;
+
+    Serial.printf("[PotADC] Continuous ADC: %u ch @ %u Hz each, window=%u\n",
+                  _count, totalHz / _count, _window);
+    return true;
+}
+
+void PotSampler::end() {
+    if (!_running) return;
+    if (_task) {
+        vTaskDelete((TaskHandle_t)_task);
+        _task = nullptr;
+    }
+    adc_digi_stop();
+    adc_digi_deinitialize();
+    _running = false;
+}
+
+void PotSampler::pause() {
+    if (!_running || _paused) return;
+    adc_digi_stop();
+    _paused = true;
+    // Let the drain task empty the pool, so the first frame after resume()
+    // is a new one.
+    vTaskDelay(1);
+}
+
+void PotSampler::resume() {
+    if (!_running || !_paused) return;
+    _resumedUs = 0;
+    _resuming = true;
+    _paused = false;
+    adc_digi_start();
+}
+
+int PotSampler::channelIndex(uint8_t pin) const {
+    for (uint8_t i = 0; i < _count; i++) {
+        if (_pins[i] == pin) return i;
+    }
+    return -1;
+}
+
+uint16_t PotSampler::read(uint8_t ch) {
+    if (_running) return _filtered[ch];
+
+    // No DMA: burst-average the window directly.
+    uint32_t sum = 0;
+    for (uint8_t i = 0; i < _pendingWindow; i++) {
+        sum += analogRead(_pins[ch]);
+    }
+    return sum / _pendingWindow;
+}
+
+uint16_t PotSampler::latestRaw(uint8_t ch) const {
+    uint32_t head = _head[ch];
+    if (head == 0) return 0;
+    return _ring[ch][(head - 1) & kRingMask];
+}
+
+void PotSampler::setWindow(uint8_t window) {
+    _pendingWindow = constrain(window, (uint8_t)1, (uint8_t)kRingSize);
+}
+
+void PotSampler::drain() {
+    uint8_t frame[kFrameBytes];
+
+    for (;;) {
+        uint32_t len = 0;
+        esp_err_t err = adc_digi_read_bytes(frame, sizeof(frame), &len, ADC_MAX_DELAY);
+        if (err == ESP_ERR_INVALID_STATE) {
+            // Pool overflowed; the frame we got is still valid.
+            _overruns++;
+        } else if (err != ESP_OK) {
+            continue;
+        }
+
+        if (_pendingWindow != _window) applyWindow();
+        if (_resuming) {
+            _resumedUs = esp_timer_get_time();
+            _resuming = false;
+        }
+
+        // The frame's last conversion is roughly now; earlier ones are spaced
+        // one conversion period apart.
+        uint32_t results = len / SOC_ADC_DIGI_RESULT_BYTES;
+        uint64_t stampUs = _recorder ? esp_timer_get_time() - (uint64_t)results * _conversionUs : 0;
+
+        for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= len;
+             i += SOC_ADC_DIGI_RESULT_BYTES) {
+            const adc_digi_output_data_t* p =
+                reinterpret_cast<const adc_digi_output_data_t*>(&frame[i]);
+            stampUs += _conversionUs;
+            if (p->type2.unit != 0) continue;
+            for (uint8_t ch = 0; ch < _count; ch++) {
+                if (_adcChannel[ch] == p->type2.channel) {
+                    push(ch, p->type2.data);
+                    if (_recorder) _recorder->recordPot(ch, p->type2.data, stampUs);
+                    break;
+                }
+            }
+        }
+    }
+}
+
+void PotSampler::push(uint8_t ch, uint16_t value) {
+    // Running sum over the last _window samples: drop the oldest, add the newest.
+    uint32_t head = _head[ch];
+    if (head >= _window) {
+        _sum[ch] -= _ring[ch][(head - _window) & kRingMask];
+    }
+    _ring[ch][head & kRingMask] = value;
+    _sum[ch] += value;
+    head++;
+
+    uint32_t n = head < _window ? head : _window;
+    _filtered[ch] = _sum[ch] / n;
+    _head[ch] = head;
+}
+
+void PotSampler::applyWindow() {
+    _window = _pendingWindow;
+    for (uint8_t ch = 0; ch < _count; ch++) {
+        uint32_t head = _head[ch];
+        uint32_t n = head < _window ? head : _window;
+        uint32_t sum = 0;
+        for (uint32_t k = 1; k <= n; k++) {
+            sum += _ring[ch][(head - k) & kRingMask];
+        }
+        _sum[ch] = sum;
+        if (n > 0) _filtered[ch] = sum / n;
+    }
+}
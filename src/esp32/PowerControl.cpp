@@ -0,0 +1,101 @@
+#include "PowerControl.h"
+
+#include <driver/gpio.h>
+#include <driver/uart.h>
+#include <esp_sleep.h>
+#include <esp_timer.h>
+
+// Longest wait for the pot scan to come back before giving up on the
+// measurement (the tick runs on the held readings either way).
+static constexpr uint32_t kFreshTimeoutUs = 50000;
+
+// RX edges that wake the chip from the printer's UART. The bytes that do
+// it are lost; the host resends its report.
+static constexpr int kUartWakeEdges = 3;
+
+void PowerControl::begin(const Config& cfg, PotSampler* pots, Esp32EdgeInput* edges,
+                         const uint8_t* holdPins, uint8_t holdCount, int uartNum) {
+    _cfg = cfg;
+    _pots = pots;
+    _edges = edges;
+    _uart = uartNum;
+    _activeMhz = getCpuFrequencyMhz();
+
+    // Pins otherwise switch to their sleep configuration (input, floating).
+    for (uint8_t i = 0; i < holdCount; i++) gpio_sleep_sel_dis((gpio_num_t)holdPins[i]);
+    // The RC oscillator clocks the servo PWM while idle; keep it running asleep.
+    esp_sleep_pd_config(ESP_PD_DOMAIN_RTC8M, ESP_PD_OPTION_ON);
+    if (_uart >= 0) uart_set_wakeup_threshold((uart_port_t)_uart, kUartWakeEdges);
+
+    Serial.printf("[Power] Low power %s: idle after %us, %ums ticks at %u MHz (active %u MHz)\n",
+                  _cfg.lowPower ? "on" : "off", _cfg.idleAfterMs / 1000, _cfg.idleTickMs,
+                  _cfg.idleCpuMhz, _activeMhz);
+}
+
+void PowerControl::enterIdle() {
+    // Servos onto the RC clock before APB slows with the CPU, and back
+    // once it is up to speed again.
+    Esp32ServoOutput::useSleepClock(true);
+    setCpuFrequencyMhz(_cfg.idleCpuMhz);
+}
+
+void PowerControl::exitIdle() {
+    setCpuFrequencyMhz(_activeMhz);
+    Esp32ServoOutput::useSleepClock(false);
+}
+
+WakeReason PowerControl::waitIdleTick(uint32_t tickUs, uint64_t& wakeUs) {
+    _paused = false;
+    if (!_sleepAllowed) {
+        // Commands and configs are picked up at the tick; a reed pulse
+        // shows up as a changed count.
+        vTaskDelay(pdMS_TO_TICKS(tickUs / 1000));
+        wakeUs = (uint64_t)esp_timer_get_time();
+        return WakeReason::NONE;
+    }
+
+    _pots->pause();
+    _paused = true;
+    _edges->armWake();
+    esp_sleep_enable_gpio_wakeup();
+    if (_uart >= 0) esp_sleep_enable_uart_wakeup(_uart);
+    esp_sleep_enable_timer_wakeup(tickUs);
+
+    uint64_t sleepUs = (uint64_t)esp_timer_get_time();
+    esp_light_sleep_start();
+    wakeUs = (uint64_t)esp_timer_get_time();
+    esp_sleep_wakeup_cause_t cause = esp_sleep_get_wakeup_cause();
+
+    bool edge = _edges->disarmWake(wakeUs);
+    esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_ALL);
+    _pots->resume();
+
+    _sleeps++;
+    _sleptUs += wakeUs - sleepUs;
+    if (cause == ESP_SLEEP_WAKEUP_TIMER && wakeUs > sleepUs + tickUs) {
+        uint32_t exitUs = (uint32_t)(wakeUs - sleepUs - tickUs);
+        if (exitUs > _worstExitUs) _worstExitUs = exitUs;
+    }
+
+    if (edge || cause == ESP_SLEEP_WAKEUP_GPIO) return WakeReason::REED;
+    if (cause == ESP_SLEEP_WAKEUP_UART) return WakeReason::PRINTER;
+    return WakeReason::NONE;
+}
+
+bool PowerControl::waitFreshSamples(uint64_t wakeUs, uint32_t& latencyUs) {
+    if (!_paused) return false;
+    _paused = false;
+    // The drain task shares this core at a lower priority: block, don't spin.
+    while (!_pots->resumedUs()) {
+        if ((uint64_t)esp_timer_get_time() - wakeUs > kFreshTimeoutUs) return false;
+        vTaskDelay(1);
+    }
+    latencyUs = (uint32_t)(_pots->resumedUs() - wakeUs);
+    return true;
+}
+
+void PowerControl::clearStats() {
+    _sleeps = 0;
+    _sleptUs = 0;
+    _worstExitUs = 0;
+}
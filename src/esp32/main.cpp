@@ -0,0 +1,1260 @@
+#include <Arduino.h>
+#include <esp_timer.h>
+#include "pins.h"
+#include "Config.h"
+#include "CommandShell.h"
+#include "ConfigStore.h"
+#include "WheelEncoder.h"
+#include "FeedArmController.h"
+#include "ControlTask.h"
+#include "Esp32Hal.h"
+#include "FlightRecorder.h"
+#include "JamJournal.h"
+#include "PotSampler.h"
+#include "PowerControl.h"
+#include "PrinterLink.h"
+#include "Profiler.h"
+#include "Scheduler.h"
+#include "Telemetry.h"
+
+static constexpr uint8_t kChannels = FEED_CHANNELS;
+static_assert(kChannels >= 1 && kChannels <= kMaxFeedChannels, "FEED_CHANNELS out of range");
+static_assert(kChannels * 2 <= Esp32EdgeInput::kMaxPins, "not enough wheel interrupt slots");
+static_assert(kChannels * 2 <= Esp32ServoOutput::kLedcChannels, "not enough LEDC channels");
+static_assert(kChannels * 2 <= PotSampler::kMaxChannels, "not enough ADC scan slots");
+
+// Per-channel settings. Every arm starts from the defaults in Config.h,
+// overlaid at boot with whatever was saved to NVS ('w'). Board-wide
+// settings (baud rate, tick period, telemetry, recorder, tick budget) are
+// taken from channel 0.
+Config configs[kChannels];
+
+Esp32ConfigStorage configStorage;
+ConfigStore configStore;
+ConfigLoadResult configLoaded[kChannels] = {};
+bool configUnsaved[kChannels] = {};
+bool configPending[kChannels] = {};   // waiting for the control task to take it
+
+// A 'w' not yet written: NVS writes wait for flashBusy() like the journal's.
+enum class ConfigFlash : uint8_t { NONE, SAVE, ERASE };
+ConfigFlash configFlash = ConfigFlash::NONE;
+
+// Hardware behind the controllers' HAL interfaces. One ADC scan samples
+// every channel's pots; each controller reads its own through a view.
+Esp32Clock sysClock;
+Esp32EdgeInput gpio;
+PotSampler potSampler;
+
+// PSRAM flight recorder. The controllers see the servos through recording
+// wrappers so every command lands in the history.
+FlightRecorder recorder;
+
+// One feed arm's servos (each on its own LEDC channel) and pot view.
+struct ChannelHw {
+    Esp32ServoOutput feedServo;
+    Esp32ServoOutput tensionServo;
+    RecordingServo feedServoRec;
+    RecordingServo tensionServoRec;
+    SharedPotInput pots;
+};
+
+ChannelHw channelHw[kChannels];
+ReedSwitch reedSwitches[kChannels];
+FeedArmController feedArms[kChannels];
+ControlTask control;
+
+// Low-power idle between prints (Config::lowPower). The control task
+// decides when; the loop decides whether light sleep is allowed.
+PowerControl power;
+
+// Comms-side jobs (Scheduler.h). loop() sleeps until the next one is due,
+// or until the control task or the printer's UART has something for it.
+Scheduler scheduler;
+TaskHandle_t loopTask = nullptr;
+esp_timer_handle_t loopWake = nullptr;
+
+static constexpr uint32_t kLedMs = 50;           // finest blink is 100 ms
+static constexpr uint32_t kStatusPrintMs = 5000;
+static constexpr uint32_t kShellPollMs = 10;     // typing latency, job steps
+static constexpr uint32_t kRecorderMs = 10;
+
+// Newest snapshot per channel from the control task. The loop never reads
+// the controllers directly once the task is running.
+FeedArmStatus status[kChannels] = {};
+
+// Channel the shell commands act on ('a').
+uint8_t selected = 0;
+
+// Longest single loop() pass, for checking the serial path stays bounded,
+// and how much of the time the loop was awake at all.
+uint32_t worstLoopUs = 0;
+uint64_t loopBusyUs = 0;
+uint64_t loopSinceUs = 0;
+
+// --- Event Printer ---
+// Formats controller events on the comms core.
+void printEvent(const FeedArmEvent& ev) {
+    char line[96];
+    formatFeedArmEvent(ev, line, sizeof(line));
+    if (kChannels > 1) Serial.printf("[Ch%u] ", ev.channel);
+    Serial.println(line);
+}
+
+// --- Unstick Stats ---
+// Comms-side copy of each controller's escalation stats, rebuilt from its
+// events so the shell never reads controller state.
+UnstickLadder unstickStats[kChannels];
+
+void trackUnstick(const FeedArmEvent& ev) {
+    if (ev.channel >= kChannels) return;
+    UnstickLadder& stats = unstickStats[ev.channel];
+    switch (ev.type) {
+    case FeedArmEventType::UNSTICK_STAGE:
+        if (!ev.flag) stats.begin(configs[ev.channel]);
+        break;
+    case FeedArmEventType::UNSTICK_RESULT:
+        stats.record(ev.n - 1, ev.flag);
+        break;
+    case FeedArmEventType::UNSTICK_GAVE_UP:
+        stats.giveUp();
+        break;
+    default:
+        break;
+    }
+}
+
+// --- Jam Journal ---
+// Every jam as a compact record on flash (JamJournal.h), built here from
+// the controllers' events. Records queue in RAM; flashJob writes them
+// out only between prints, since a flash write stalls code running from
+// flash on both cores, the control task's included.
+Esp32JournalStorage journalStorage;
+JamJournal journal;
+JamTracker jamTracker;
+float journalUsedMm[kChannels] = {};
+
+static constexpr uint32_t kFlashJobMs = 1000;
+
+void journalEvent(const FeedArmEvent& ev) {
+    if (ev.channel >= kChannels) return;
+    const FeedArmStatus& st = status[ev.channel];
+    JamContext ctx = { (uint32_t)(esp_timer_get_time() / 1000000), st.feedArmAngle,
+                       st.tensionAngle, st.printCount, st.printUsedMm };
+    JamRecord jam;
+    if (jamTracker.onEvent(ev, ctx, jam)) journal.record(jam);
+}
+
+// Flash writes and erases pause the cache on both cores, and with it the
+// control task, so they wait until nothing needs watching: every channel
+// monitoring with no jam open, and the board idle (low power) or every
+// wheel still for a print gap. Returns why not, or null.
+const char* flashBusy() {
+    for (uint8_t i = 0; i < kChannels; i++) {
+        if (jamTracker.open(i) || status[i].state != FeedArmState::MONITORING) {
+            return "a channel is handling a jam";
+        }
+        if (!control.idle() && status[i].msSinceLastPulse < configs[i].odometerPrintGapMs) {
+            return "filament is moving";
+        }
+    }
+    return nullptr;
+}
+
+// Feed each spool's odometer from the newest snapshots.
+void journalFilament() {
+    for (uint8_t i = 0; i < kChannels; i++) {
+        journal.addFilament(i, status[i].filamentUsedMm - journalUsedMm[i]);
+        journalUsedMm[i] = status[i].filamentUsedMm;
+    }
+}
+
+// --- Binary Telemetry ---
+// Every control tick, reed pulse and event as a COBS frame (Telemetry.h).
+// Frames that don't fit in the USB TX buffer are dropped rather than
+// waited for; the host sees the gap in the sequence numbers.
+TelemetryEncoder telemetry;
+bool telemetryOn = false;
+uint32_t telemetryDropped = 0;
+uint32_t lastReedCount[kChannels] = {};
+
+void sendFrame(const uint8_t* frame, size_t len) {
+    if ((size_t)Serial.availableForWrite() < len) {
+        telemetryDropped++;
+        return;
+    }
+    Serial.write(frame, len);
+}
+
+void sendTelemetry(const FeedArmStatus& st) {
+    uint8_t frame[kTelemetryMaxFrame];
+
+    if (st.pulseCount != lastReedCount[st.channel]) {
+        TelemetryReed r = { st.channel, st.pulseCount, st.lastPulseUs, st.reedPeriodUs };
+        sendFrame(frame, telemetry.reed(r, frame));
+        lastReedCount[st.channel] = st.pulseCount;
+    }
+
+    TelemetryTick t;
+    t.channel = st.channel;
+    t.tick = st.tick;
+    t.timeMs = st.timeMs;
+    t.state = st.state;
+    t.flags = st.filamentStalled ? kTelemetryStalled : 0;
+    t.feedArmAngle = st.feedArmAngle;
+    t.tensionArmAngle = st.tensionArmAngle;
+    t.tensionAngle = st.tensionAngle;
+    t.rawFeedPot = st.rawFeedPot;
+    t.rawTensionPot = st.rawTensionPot;
+    t.pulseCount = st.pulseCount;
+    t.unstickCount = st.unstickCount;
+    sendFrame(frame, telemetry.tick(t, frame));
+}
+
+#ifdef FFX_PROFILE
+// Profile summaries ride along with the stream, one frame per scope.
+static constexpr uint32_t kProfileSendMs = 1000;
+
+void sendProfile() {
+    uint8_t frame[kTelemetryMaxFrame];
+    for (uint8_t i = 0; i < (uint8_t)ProfileScope::COUNT; i++) {
+        TelemetryProfile p;
+        p.scope = (ProfileScope)i;
+        p.stats = profiler.stats(p.scope);
+        sendFrame(frame, telemetry.profile(p, frame));
+    }
+}
+#endif
+
+void setTelemetry(bool on) {
+    telemetryOn = on;
+    if (on) {
+        uint8_t frame[kTelemetryMaxFrame];
+        sendFrame(frame, telemetry.hello((uint16_t)configs[0].monitorIntervalMs, frame));
+        for (uint8_t i = 0; i < kChannels; i++) lastReedCount[i] = status[i].pulseCount;
+    }
+}
+
+// --- Printer Link ---
+// The printer's host on UART1 (PrinterLink.h). Reports go to every
+// controller through the control task; controller state changes become
+// hold/release requests.
+PrinterLink printerLink;
+bool printerLinkOn = false;
+
+static int readPrinterByte(void*) {
+    return Serial1.available() > 0 ? Serial1.read() : -1;
+}
+
+static size_t writePrinterBytes(void*, const char* data, size_t len) {
+    if ((size_t)Serial1.availableForWrite() < len) return 0;
+    return Serial1.write((const uint8_t*)data, len);
+}
+
+void servicePrinterLink() {
+    uint32_t nowUs = micros();
+    printerLink.poll(nowUs);
+    // The control task takes at most one per tick; a refused offer is
+    // simply superseded by the next pass's.
+    for (uint8_t i = 0; i < kChannels; i++) {
+        control.setPrinterFeed(i, printerLink.feedFor(i, nowUs));
+    }
+}
+
+// --- Config Updates ---
+// Shell edits go to configs[] and then to the controller as a whole struct
+// through the control task's config swap. If the previous edit hasn't been
+// picked up yet, loop() retries.
+
+void applyConfig(uint8_t ch) {
+    configPending[ch] = !control.setConfig(ch, configs[ch]);
+    configUnsaved[ch] = true;
+    if (ch == 0) printerLink.setConfig(configs[0]);
+}
+
+void retryPendingConfigs() {
+    for (uint8_t i = 0; i < kChannels; i++) {
+        if (configPending[i]) configPending[i] = !control.setConfig(i, configs[i]);
+    }
+}
+
+// Carry out a pending 'w'. flashJob retries it until flashBusy() passes.
+void writeConfigFlash() {
+    ConfigFlash op = configFlash;
+    configFlash = ConfigFlash::NONE;
+    if (op == ConfigFlash::ERASE) {
+        for (uint8_t i = 0; i < kChannels; i++) {
+            configStore.erase(i);
+            configUnsaved[i] = false;
+            configLoaded[i] = ConfigLoadResult::DEFAULTS;
+        }
+        Serial.println("Saved config erased");
+    } else if (op == ConfigFlash::SAVE) {
+        // Every channel in one go; each is one NVS blob.
+        for (uint8_t i = 0; i < kChannels; i++) {
+            if (!configStore.save(i, configs[i])) {
+                Serial.printf("Config save failed (channel %u)\n", i);
+                return;
+            }
+            configUnsaved[i] = false;
+        }
+        Serial.printf("Config v%u saved (%u channel(s), %u bytes each)\n", kConfigVersion,
+                      kChannels, (unsigned)configStore.lastBlobBytes());
+    }
+}
+
+// --- Serial Commands ---
+// Input is assembled a byte at a time by CommandShell, so a partial line
+// never holds up the loop. Handlers only queue work for the control task or
+// print; anything that takes longer runs as a ShellJob stepped from loop().
+
+CommandShell shell;
+
+static int readSerialByte(void*) {
+    return Serial.available() > 0 ? Serial.read() : -1;
+}
+
+// Hand calibration, for an arm the servo can't sweep: streams raw pot
+// readings for a few seconds while the operator moves the arms to their
+// endpoints, then applies the extremes seen as the pot range (dropping any
+// sweep table). A pot that didn't move far enough keeps its old range. Any
+// other command stops it without applying anything.
+class PotCalibrationJob : public ShellJob {
+public:
+    static constexpr uint32_t kDurationMs = 5000;
+    static constexpr uint32_t kIntervalMs = 100;
+    static constexpr uint16_t kMinSpan = 1000;     // ADC counts, of 4095
+
+    void start(uint32_t nowMs) {
+        _startMs = nowMs;
+        _nextMs = nowMs;
+        _ch = selected;
+        _feed = PotRange();
+        _tension = PotRange();
+        Serial.printf("=== Hand Pot Calibration, channel %u (5 sec) ===\n", _ch);
+        Serial.println("Move both arms to each of their endpoints.");
+    }
+
+    bool poll(uint32_t nowMs) override {
+        const FeedArmStatus& st = status[_ch];
+        _feed.add(st.rawFeedPot);
+        _tension.add(st.rawTensionPot);
+        if (nowMs - _startMs >= kDurationMs) {
+            finish();
+            return false;
+        }
+        if ((int32_t)(nowMs - _nextMs) >= 0) {
+            Serial.printf("  Feed: raw=%4d -> %.0f°  |  Tension: raw=%4d -> %.0f°\n",
+                          st.rawFeedPot, st.feedArmAngle,
+                          st.rawTensionPot, st.tensionArmAngle);
+            _nextMs += kIntervalMs;
+        }
+        return true;
+    }
+
+    void cancel() override {
+        Serial.println("=== Calibration stopped, nothing applied ===");
+    }
+
+private:
+    struct PotRange {
+        uint16_t lo = UINT16_MAX;
+        uint16_t hi = 0;
+
+        void add(uint16_t raw) {
+            if (raw < lo) lo = raw;
+            if (raw > hi) hi = raw;
+        }
+        bool usable() const { return hi > lo && hi - lo >= kMinSpan; }
+    };
+
+    // Keep the pot's direction: a reversed pot has min > max.
+    static bool apply(const PotRange& r, uint16_t& min, uint16_t& max, PotCalibration& table,
+                      const char* name) {
+        if (!r.usable()) {
+            Serial.printf("  %s: only %d counts of travel, kept %u-%u\n", name,
+                          r.hi > r.lo ? r.hi - r.lo : 0, min, max);
+            return false;
+        }
+        bool reversed = min > max;
+        min = reversed ? r.hi : r.lo;
+        max = reversed ? r.lo : r.hi;
+        table.points = 0;
+        Serial.printf("  %s: %u-%u\n", name, min, max);
+        return true;
+    }
+
+    void finish() {
+        Serial.println("=== Calibration done ===");
+        Config& cfg = configs[_ch];
+        bool feed = apply(_feed, cfg.potFeedMin, cfg.potFeedMax, cfg.potFeedCal, "Feed pot");
+        bool tension = apply(_tension, cfg.potTensionMin, cfg.potTensionMax,
+                             cfg.potTensionCal, "Tension pot");
+        if (feed || tension) {
+            applyConfig(_ch);
+            Serial.println("Applied. 'w' saves it.");
+        }
+    }
+
+    uint32_t _startMs = 0;
+    uint32_t _nextMs = 0;
+    uint8_t _ch = 0;
+    PotRange _feed;
+    PotRange _tension;
+};
+
+PotCalibrationJob calibrationJob;
+
+// Streams one frozen flight-recorder capture as CSV, a few lines per loop
+// pass and only while the USB TX buffer has room.
+class RecorderDumpJob : public ShellJob {
+public:
+    static constexpr uint16_t kLinesPerPoll = 32;
+
+    bool start(uint8_t slot) {
+        const RecorderCapture* cap = recorder.capture(slot);
+        if (!cap) return false;
+        _cap = cap;
+        recorder.lock(slot);
+        _reader.begin(cap);
+        Serial.printf("# capture %u seq=%u trigger_us=%u pot=%u control=%u%s\n",
+                      slot, cap->seq, cap->triggerUs, cap->potCount, cap->ctlCount,
+                      cap->torn ? " TORN" : "");
+        Serial.println("t_us,kind,ch,value");
+        return true;
+    }
+
+    bool poll(uint32_t) override {
+        RecordSample s;
+        for (uint16_t i = 0; i < kLinesPerPoll; i++) {
+            if (Serial.availableForWrite() < 48) return true;
+            if (!_reader.next(s)) {
+                Serial.println("# end");
+                recorder.lock(-1);
+                return false;
+            }
+            // Times relative to the trigger; negative = before the jam.
+            Serial.printf("%d,%s,%u,%u\n", (int32_t)(s.us - _cap->triggerUs),
+                          recordKindName(s.kind), s.ch, s.value);
+        }
+        return true;
+    }
+
+    void cancel() override {
+        Serial.println("# dump stopped");
+        recorder.lock(-1);
+    }
+
+private:
+    const RecorderCapture* _cap = nullptr;
+    CaptureReader _reader;
+};
+
+RecorderDumpJob dumpJob;
+
+// Streams the jam journal as "J <segment> <hex>" lines for the host
+// summariser (program journal), one chunk per line.
+class JournalDumpJob : public ShellJob {
+public:
+    static constexpr uint16_t kLinesPerPoll = 8;
+
+    void start() {
+        _segment = 0;
+        _offset = 0;
+        Serial.printf("# jam journal: %u segment(s), %u bytes, %u jam(s), %u queued\n",
+                      journal.segmentsUsed(), journal.storedBytes(), journal.storedJams(),
+                      journal.pending());
+    }
+
+    bool poll(uint32_t) override {
+        uint8_t chunk[kJournalDumpBytes];
+        char line[kJournalDumpLine];
+        for (uint16_t i = 0; i < kLinesPerPoll; i++) {
+            if ((size_t)Serial.availableForWrite() < sizeof(line)) return true;
+            size_t n = journal.readSegment(_segment, _offset, chunk, sizeof(chunk));
+            if (n == 0) {
+                if (++_segment >= journal.segmentsUsed()) {
+                    Serial.println("# end");
+                    return false;
+                }
+                _offset = 0;
+                continue;
+            }
+            formatJournalDumpLine(_segment, chunk, n, line);
+            Serial.print(line);
+            _offset += n;
+        }
+        return true;
+    }
+
+    void cancel() override {
+        Serial.println("# dump stopped");
+    }
+
+private:
+    uint8_t _segment = 0;
+    size_t _offset = 0;
+};
+
+JournalDumpJob journalDumpJob;
+
+static void cmdChannel(CommandShell&, const char* args) {
+    float ch = 0;
+    if (parseFloatArg(args, ch)) {
+        if (ch < 0 || ch >= kChannels) {
+            Serial.printf("Channels are 0-%u\n", kChannels - 1);
+            return;
+        }
+        selected = (uint8_t)ch;
+    }
+    Serial.printf("Channel %u of %u selected\n", selected, kChannels);
+}
+
+static void cmdUnstick(CommandShell&, const char*) {
+    control.send(selected, ControlCommandType::UNSTICK);
+}
+
+static void cmdTension(CommandShell&, const char* args) {
+    float angle = 0;
+    if (parseFloatArg(args, angle) && angle > 0) {
+        control.send(selected, ControlCommandType::SET_TENSION, angle);
+        configs[selected].tensionServoAngle = angle;
+        applyConfig(selected);
+    } else {
+        Serial.printf("Tension angle: cmd=%.0f° actual=%.0f°\n",
+                      status[selected].tensionAngle, status[selected].tensionArmAngle);
+    }
+}
+
+static void cmdJamAngle(CommandShell&, const char* args) {
+    float angle = 0;
+    if (parseFloatArg(args, angle) && angle > 0) {
+        configs[selected].feedArmJamAngle = angle;
+        applyConfig(selected);
+        Serial.printf("Jam threshold set to %.0f°\n", angle);
+    }
+}
+
+static void cmdRestAngle(CommandShell&, const char* args) {
+    float angle = 0;
+    if (parseFloatArg(args, angle) && angle > 0) {
+        configs[selected].feedArmRestAngle = angle;
+        applyConfig(selected);
+        Serial.printf("Rest angle set to %.0f°\n", angle);
+    }
+}
+
+static void cmdJamTension(CommandShell&, const char* args) {
+    float newtons = 0;
+    if (parseFloatArg(args, newtons) && newtons >= 0) {
+        configs[selected].jamTensionN = newtons;
+        applyConfig(selected);
+        if (newtons > 0) Serial.printf("Jam threshold set to %.2f N\n", newtons);
+        else Serial.println("Jam threshold back to the angle");
+    }
+}
+
+static void cmdSpringRate(CommandShell&, const char* args) {
+    // A known weight hangs from the filament past the arm, with the spool
+    // held, so the filament tension is its weight.
+    float grams = 0;
+    if (!parseFloatArg(args, grams) || grams <= 0) {
+        Serial.printf("Spring rate: %.3f N/mm. Hang a weight on the filament, hold the "
+                      "spool, then 'k <grams>'\n", configs[selected].springRate);
+        return;
+    }
+    const FeedArmStatus& st = status[selected];
+    if (st.state != FeedArmState::MONITORING) {
+        Serial.println("Wait for the arm to float (monitoring) first");
+        return;
+    }
+    float rate = TensionModel::springRateFor(configs[selected], st.feedArmAngle,
+                                             st.tensionArmAngle, grams * 0.00981f);
+    if (rate <= 0) {
+        Serial.println("Spring is slack at these angles; raise the tension and retry");
+        return;
+    }
+    configs[selected].springRate = rate;
+    applyConfig(selected);
+    Serial.printf("Spring rate set to %.3f N/mm (arm %.1f°, tension arm %.1f°)\n", rate,
+                  st.feedArmAngle, st.tensionArmAngle);
+}
+
+static void cmdOdometer(CommandShell&, const char* args) {
+    if (*args == 'r') {
+        control.send(selected, ControlCommandType::START_PRINT);
+        Serial.println("Print odometer restarted");
+        return;
+    }
+    for (uint8_t i = 0; i < kChannels; i++) {
+        const FeedArmStatus& st = status[i];
+        Serial.printf("  Channel %u: %.2f m this print (#%u), %.2f m since boot, %.1f mm/s\n",
+                      i, st.printUsedMm / 1000.0f, st.printCount,
+                      st.filamentUsedMm / 1000.0f, st.filamentSpeed);
+    }
+}
+
+static void cmdCalibrate(CommandShell& sh, const char* args) {
+    if (*args == 'h') {
+        calibrationJob.start(millis());
+        sh.startJob(&calibrationJob, millis());
+        return;
+    }
+    if (status[selected].state != FeedArmState::MONITORING) {
+        Serial.println("Wait for the arm to be back in MONITORING");
+        return;
+    }
+    control.send(selected, ControlCommandType::CALIBRATE_POTS);
+    Serial.printf("Sweeping channel %u's servos (printer should be idle)...\n", selected);
+}
+
+// A finished sweep: keep the tables for the pots that passed and hand the
+// config back to the controller.
+void applyPotSweep(uint8_t ch, const PotSweepResult& sweep) {
+    Config& cfg = configs[ch];
+    const PotCalibration* cals[] = { &sweep.feed, &sweep.tension };
+    PotCalibration* dest[] = { &cfg.potFeedCal, &cfg.potTensionCal };
+    const char* names[] = { "Feed", "Tension" };
+    bool applied = false;
+    for (uint8_t p = 0; p < 2; p++) {
+        const PotCalibration& cal = *cals[p];
+        if (kChannels > 1) Serial.printf("[Ch%u] ", ch);
+        if (!cal.points) {
+            Serial.printf("%s pot: readings not monotonic, table not applied\n", names[p]);
+            continue;
+        }
+        *dest[p] = cal;
+        applied = true;
+        Serial.printf("%s pot:", names[p]);
+        for (uint8_t i = 0; i < cal.points; i++) Serial.printf(" %u", cal.adc[i]);
+        Serial.printf("  (%.0f-%.0f°)\n", cal.fromDeg, cal.toDeg);
+    }
+    if (applied) {
+        applyConfig(ch);
+        Serial.println("Pot tables applied. 'w' saves them.");
+    }
+}
+
+static void cmdStatus(CommandShell& sh, const char* args) {
+    if (*args == 'r') {
+        control.clearTiming();
+        scheduler.clearStats();
+        worstLoopUs = 0;
+        loopBusyUs = 0;
+        loopSinceUs = esp_timer_get_time();
+        Serial.println("Tick latency and loop stats cleared");
+        return;
+    }
+    const FeedArmStatus& st = status[selected];
+    const Config& cfg = configs[selected];
+    const UnstickLadder& ladder = unstickStats[selected];
+    Serial.printf("=== Feed Arm Status (channel %u of %u) ===\n", selected, kChannels);
+    Serial.printf("  State:           %s\n", feedArmStateName(st.state));
+    Serial.printf("  Feed arm angle:  %.0f° (pot raw: %d)\n",
+                  st.feedArmAngle, st.rawFeedPot);
+    Serial.printf("  Tension angle:   %.0f° cmd / %.0f° actual (pot raw: %d)\n",
+                  st.tensionAngle, st.tensionArmAngle,
+                  st.rawTensionPot);
+    Serial.printf("  Filament tension: %.2f N (spring %.2f N/mm)\n",
+                  st.filamentTension, cfg.springRate);
+    Serial.printf("  Wheel pulses:    %u total, %.1f/sec (%.1f mm/s)\n",
+                  st.pulseCount, st.pulsesPerSec, st.filamentSpeed);
+    if (st.expectedFeed >= 0) {
+        Serial.printf("  Printer feed:    %.1f mm/s commanded\n", st.expectedFeed);
+    }
+    Serial.printf("  Filament used:   %.2f m this print (#%u), %.2f m since boot\n",
+                  st.printUsedMm / 1000.0f, st.printCount, st.filamentUsedMm / 1000.0f);
+    Serial.printf("  Filament stall:  %s (last pulse %ums ago)\n",
+                  st.filamentStalled ? "YES" : "no",
+                  st.msSinceLastPulse);
+    Serial.printf("  Pulse period:    %.3fs (jitter %.3fs)\n",
+                  st.reedPeriodUs / 1e6f, st.reedJitterUs / 1e6f);
+    Serial.printf("  Unstick count:   %u\n", st.unstickCount);
+    if (cfg.jamTensionN > 0) {
+        Serial.printf("  Jam threshold:   %.2f N\n", cfg.jamTensionN);
+    } else {
+        Serial.printf("  Jam threshold:   %.0f°\n", cfg.feedArmJamAngle);
+    }
+    Serial.printf("  Rest angle:      %.0f°\n", cfg.feedArmRestAngle);
+    Serial.printf("  Unstick ladder:  %u stages, next jam starts at %u\n",
+                  cfg.unstickStages, ladder.bestStage(cfg) + 1);
+    Serial.printf("  Config:          %s at boot%s\n",
+                  configLoadResultName(configLoaded[selected]),
+                  configUnsaved[selected] ? ", unsaved changes" : "");
+    Serial.printf("  Control ticks:   %u (%u missed, %u events dropped)\n",
+                  st.tick, control.missedTicks(), control.droppedEvents());
+    for (uint8_t i = 0; i < kChannels; i++) {
+        ChannelTiming t = control.timing(i);
+        Serial.printf("  Tick latency %u:  %uus now, %uus worst, %u over %uus budget\n",
+                      i, status[i].latencyUs, t.worstLatencyUs, t.overBudget,
+                      configs[0].controlBudgetUs);
+    }
+    uint64_t loopUs = esp_timer_get_time() - loopSinceUs;
+    Serial.printf("  Loop:            %.1f%% awake, %uus worst pass, %u long lines dropped\n",
+                  loopUs ? 100.0 * loopBusyUs / loopUs : 0.0, worstLoopUs, sh.overflows());
+    for (uint8_t i = 0; i < scheduler.slots(); i++) {
+        if (!scheduler.name(i)) continue;
+        SchedulerJobStats js = scheduler.stats(i);
+        Serial.printf("  Job %-9s    every %ums, %u runs, %u skipped, %uus late / %uus run worst\n",
+                      scheduler.name(i), scheduler.periodUs(i) / 1000, js.runs, js.skipped,
+                      js.worstLateUs, js.worstRunUs);
+    }
+}
+
+static void cmdLadder(CommandShell&, const char* args) {
+    const Config& cfg = configs[selected];
+    UnstickLadder& ladder = unstickStats[selected];
+    if (*args == 'r') {
+        ladder.clear();
+        control.send(selected, ControlCommandType::CLEAR_UNSTICK_STATS);
+        Serial.println("Unstick stats cleared");
+        return;
+    }
+    uint8_t start = cfg.unstickAdaptive ? ladder.bestStage(cfg) : 0;
+    Serial.printf("=== Unstick Ladder, channel %u (%s start) ===\n", selected,
+                  cfg.unstickAdaptive ? "adaptive" : "fixed");
+    Serial.printf("  Jams: %u, cleared %u, gave up %u\n", ladder.jams(),
+                  ladder.cleared(), ladder.exhausted());
+    for (uint8_t i = 0; i < cfg.unstickStages && i < kMaxUnstickStages; i++) {
+        const UnstickStage& stage = cfg.unstickLadder[i];
+        const UnstickStageStats& n = ladder.stats(i);
+        Serial.printf("  %u: %3.0f° %4ums relax %3.0f%% shakes %u  %u/%u cleared (%.0f%%)%s\n",
+                      i + 1, stage.angle, stage.holdMs, stage.relax * 100.0f, stage.shakes,
+                      n.successes, n.attempts, ladder.successRate(i) * 100.0f,
+                      i == start ? "  <- next" : "");
+    }
+}
+
+static void cmdTelemetry(CommandShell&, const char* args) {
+    float on = 0;
+    setTelemetry(parseFloatArg(args, on) ? on != 0 : !telemetryOn);
+    if (!telemetryOn) {
+        Serial.printf("Telemetry off (%u frames dropped)\n", telemetryDropped);
+    }
+}
+
+static void cmdRecorder(CommandShell& sh, const char* args) {
+    float slot = 0;
+    if (parseFloatArg(args, slot)) {
+        if (!dumpJob.start((uint8_t)slot)) {
+            Serial.printf("No capture in slot %d\n", (int)slot);
+            return;
+        }
+        sh.startJob(&dumpJob, millis());
+        return;
+    }
+
+    if (!recorder.enabled()) {
+        Serial.println("Flight recorder disabled (no PSRAM)");
+        return;
+    }
+    Serial.printf("=== Flight Recorder (%ums pre / %ums post) ===\n",
+                  recorder.preMs(), recorder.postMs());
+    Serial.printf("  Triggers: %u (%u inside an earlier window)\n",
+                  recorder.triggers(), recorder.merged());
+    for (uint8_t i = 0; i < recorder.captureSlots(); i++) {
+        const RecorderCapture* cap = recorder.capture(i);
+        if (!cap) continue;
+        Serial.printf("  [%u] seq %u  trigger %.3fs  %u pot + %u control samples%s\n",
+                      i, cap->seq, cap->triggerUs / 1e6f, cap->potCount, cap->ctlCount,
+                      cap->torn ? "  TORN" : "");
+    }
+}
+
+static void cmdSaveConfig(CommandShell&, const char* args) {
+    configFlash = ConfigFlash::SAVE;
+    if (*args == 'r') {
+        for (uint8_t i = 0; i < kChannels; i++) {
+            configs[i] = Config();
+            applyConfig(i);
+        }
+        Serial.println("Defaults applied");
+        configFlash = ConfigFlash::ERASE;
+    }
+    if (const char* why = flashBusy()) {
+        Serial.printf("Not writing flash while %s; will once it stops\n", why);
+        return;
+    }
+    writeConfigFlash();
+}
+
+static void cmdPrinterLink(CommandShell&, const char* args) {
+    if (!printerLinkOn) {
+        Serial.println("Printer link off (printerLink in Config.h)");
+        return;
+    }
+    if (*args == 'r') {
+        printerLink.clearStats();
+        Serial.println("Printer link stats cleared");
+        return;
+    }
+    uint32_t nowUs = micros();
+    Serial.printf("=== Printer Link (UART1 %u baud) ===\n", configs[0].printerBaud);
+    Serial.printf("  Link:        %s, %u reports\n", printerLink.up(nowUs) ? "up" : "DOWN",
+                  printerLink.reports());
+    for (uint8_t i = 0; i < kChannels; i++) {
+        PrinterFeed feed = printerLink.feedFor(i, nowUs);
+        Serial.printf("  Channel %u:   %s, %.2f mm/s commanded, %.2f mm/s measured\n", i,
+                      printerActivityName(feed.activity), feed.mmPerSec,
+                      status[i].filamentSpeed);
+    }
+    Serial.printf("  Hold:        %s%s\n", printerLink.holding() ? "requested" : "none",
+                  printerLink.acknowledged() ? "" : " (awaiting ack)");
+    Serial.printf("  Round trip:  %.1f ms last, %.1f ms worst\n",
+                  printerLink.lastRttUs() / 1000.0f, printerLink.worstRttUs() / 1000.0f);
+    Serial.printf("  Errors:      %u bad lines, %u retries, %u lines dropped\n",
+                  printerLink.badLines(), printerLink.retries(), printerLink.droppedLines());
+}
+
+static void cmdSpectrum(CommandShell&, const char* args) {
+    if (*args == 'b') {
+        // Both FFT kernels on this core, on a scratch window of noise.
+        static ArmSpectrum bench;
+        const Config& cfg = configs[selected];
+        bench.configure(cfg);
+        uint32_t ticks = (uint32_t)ArmSpectrum::kFrames * cfg.spectrumDecimation;
+        for (uint32_t t = 0; t < ticks; t++) bench.push(90.0f + random(200) * 0.01f);
+        const uint16_t runs = 200;
+        Serial.printf("=== Spectrum kernels (%u-point complex FFT, %u runs) ===\n",
+                      ArmSpectrum::kFrames / 2, runs);
+        for (FftImpl impl : { FftImpl::SCALAR, FftImpl::ESP_DSP }) {
+            if (!fftAvailable(impl)) {
+                Serial.printf("  %-8s not built in\n", fftImplName(impl));
+                continue;
+            }
+            alignas(16) static float data[ArmSpectrum::kFrames];
+            for (uint16_t i = 0; i < ArmSpectrum::kFrames; i++) data[i] = (float)(i % 7) - 3.0f;
+            uint32_t t0 = micros();
+            for (uint16_t r = 0; r < runs; r++) fftComplex(data, ArmSpectrum::kFrames / 2, impl);
+            uint32_t t1 = micros();
+            bench.setImpl(impl);
+            for (uint16_t r = 0; r < runs; r++) bench.analyse();
+            uint32_t t2 = micros();
+            Serial.printf("  %-8s FFT %.1fus, whole window %.1fus\n", fftImplName(impl),
+                          (float)(t1 - t0) / runs, (float)(t2 - t1) / runs);
+        }
+        return;
+    }
+    const Config& cfg = configs[selected];
+    const ArmSpectrumFeatures& f = status[selected].spectrum;
+    if (!cfg.spectrum) {
+        Serial.println("Arm spectrum off (spectrum in Config.h)");
+        return;
+    }
+    Serial.printf("=== Arm Spectrum (channel %u, %.2f Hz frames, %u-frame window) ===\n",
+                  selected, f.frameHz, ArmSpectrum::kFrames);
+    if (f.windows == 0) {
+        Serial.println("  No window yet: it fills while printing");
+        return;
+    }
+    Serial.printf("  Windows:     %u\n", f.windows);
+    Serial.printf("  Peak:        %.4f Hz (%.0f s period), %.0f%% of arm motion\n",
+                  f.peakHz, f.peakHz > 0 ? 1.0f / f.peakHz : 0.0f, f.peakShare * 100.0f);
+    Serial.printf("  Motion:      %.2f° RMS\n", f.rmsDeg);
+    float binHz = f.frameHz / ArmSpectrum::kFrames;
+    for (uint8_t b = 0; b < ArmSpectrum::kBands; b++) {
+        Serial.printf("  Band %u:      %.4f-%.4f Hz  %6.1f dB\n", b,
+                      ArmSpectrum::kBandStart[b] * binHz,
+                      (ArmSpectrum::kBandStart[b + 1] - 1) * binHz, f.bandDb[b]);
+    }
+    Serial.printf("  Anomaly:     %.2f%s\n", f.anomaly,
+                  f.anomaly >= 1.0f ? " (WOBBLE: spool catching once a revolution?)" : "");
+}
+
+static void cmdProfile(CommandShell&, const char* args) {
+#ifdef FFX_PROFILE
+    if (*args == 'r') {
+        profiler.clear();
+        Serial.println("Profile cleared");
+        return;
+    }
+    char line[96];
+    Serial.printf("=== Profile (%u MHz) ===\n", profileCyclesPerUs());
+    Serial.println(kProfileHeader);
+    for (uint8_t i = 0; i < (uint8_t)ProfileScope::COUNT; i++) {
+        ProfileScope scope = (ProfileScope)i;
+        formatProfileLine(scope, profiler.stats(scope), line, sizeof(line));
+        Serial.println(line);
+    }
+#else
+    (void)args;
+    Serial.println("Profiling not built in (add -D FFX_PROFILE)");
+#endif
+}
+
+static void cmdJournal(CommandShell& sh, const char* args) {
+    if (!strncmp(args, "dump", 4)) {
+        // What is still queued goes out with the next flush, not this dump.
+        journalDumpJob.start();
+        sh.startJob(&journalDumpJob, millis());
+        return;
+    }
+    if (!strncmp(args, "erase", 5)) {
+        if (const char* why = flashBusy()) {
+            Serial.printf("Not erasing while %s; try again between prints\n", why);
+            return;
+        }
+        journal.erase();
+        Serial.println("Jam journal erased");
+        return;
+    }
+    if (!strncmp(args, "tag", 3)) {
+        float tag = 0;
+        if (!parseFloatArg(args + 3, tag) || tag < 0 || tag > 65535) {
+            Serial.println("Usage: g tag <0-65535> (labels the spool just loaded)");
+            return;
+        }
+        journal.setSpool(selected, (uint16_t)tag);
+        Serial.printf("Channel %u: new spool, tag %u\n", selected, (unsigned)tag);
+        return;
+    }
+    Serial.printf("=== Jam Journal (boot %u) ===\n", journal.boot());
+    Serial.printf("  Stored:      %u jam(s), %u bytes in %u of %u segments\n",
+                  journal.storedJams(), journal.storedBytes(), journal.segmentsUsed(),
+                  kJournalSegments);
+    Serial.printf("  Queue:       %u waiting, %u dropped, %u write errors\n",
+                  journal.pending(), journal.dropped(), journal.writeErrors());
+    Serial.printf("  Flush:       %uus last, %uus worst\n",
+                  journal.lastFlushUs(), journal.worstFlushUs());
+    for (uint8_t i = 0; i < kChannels; i++) {
+        Serial.printf("  Spool %u:     tag %u, %u m used\n", i, journal.spoolTag(i),
+                      journal.spoolM(i));
+    }
+}
+
+static void cmdPower(CommandShell&, const char* args) {
+    if (*args == 'r') {
+        control.clearWakeStats();
+        power.clearStats();
+        Serial.println("Wake stats cleared");
+        return;
+    }
+    const Config& cfg = configs[0];
+    const WakeStats& w = control.wakeStats();
+    Serial.printf("=== Power (low power %s) ===\n", cfg.lowPower ? "on" : "off");
+    Serial.printf("  Mode:        %s, CPU %u MHz, light sleep %s\n",
+                  control.idle() ? "idle" : "active", power.cpuMhz(),
+                  power.sleepAllowed() ? "allowed" : "off (USB host or printer link)");
+    Serial.printf("  Idle:        %u time(s), %.1f min total; after %us quiet, %ums ticks\n",
+                  w.idleEntries, w.idleMs / 60000.0f, cfg.idleAfterMs / 1000, cfg.idleTickMs);
+    Serial.printf("  Light sleep: %u sleeps, %.1f min asleep, %uus worst exit\n",
+                  power.sleeps(), power.sleptUs() / 60e6f, power.worstExitUs());
+    Serial.printf("  Wakes:      ");
+    for (uint8_t r = (uint8_t)WakeReason::REED; r < (uint8_t)WakeReason::COUNT; r++) {
+        Serial.printf(" %s %u", wakeReasonName((WakeReason)r), w.wakes[r]);
+    }
+    Serial.printf(" (last: %s)\n", wakeReasonName(control.lastWake()));
+    Serial.printf("  Wake latency: %uus last, %uus mean, %uus worst, %u of %u over %uus\n",
+                  w.lastLatencyUs,
+                  w.latencySamples ? (uint32_t)(w.totalLatencyUs / w.latencySamples) : 0,
+                  w.worstLatencyUs, w.overBudget, w.latencySamples, cfg.wakeBudgetUs);
+}
+
+static void cmdHelp(CommandShell& sh, const char*) {
+    sh.printHelp();
+}
+
+static const CommandSpec kCommands[] = {
+    { 'a', "a [ch]",    "Select the feed channel for the other commands",  cmdChannel },
+    { 'u', "u",         "Manual unstick trigger",                          cmdUnstick },
+    { 't', "t <angle>", "Set tension servo angle (spring calibration)",    cmdTension },
+    { 'j', "j <angle>", "Set jam threshold angle",                         cmdJamAngle },
+    { 'r', "r <angle>", "Set rest angle",                                  cmdRestAngle },
+    { 'n', "n <N>",     "Set jam threshold as filament tension (0 = angle)", cmdJamTension },
+    { 'k', "k <grams>", "Calibrate spring rate against a hanging weight",  cmdSpringRate },
+    { 'c', "c [hand]",  "Pot calibration by servo sweep / by hand (5 sec)", cmdCalibrate },
+    { 's', "s [reset]", "Print status / clear tick latency and loop stats", cmdStatus },
+    { 'o', "o [reset]", "Filament odometer / start a new print",           cmdOdometer },
+    { 'e', "e [reset]", "Unstick ladder stats / clear them (new spool)",   cmdLadder },
+    { 'b', "b [0|1]",   "Binary telemetry stream on/off",                  cmdTelemetry },
+    { 'l', "l [reset]", "Printer link status / clear its stats",           cmdPrinterLink },
+    { 'v', "v [bench]", "Arm spectrum / time the FFT kernels",              cmdSpectrum },
+    { 'f', "f [slot]",  "Flight recorder captures / dump one as CSV",      cmdRecorder },
+    { 'w', "w [reset]", "Save config to flash / erase it (defaults)",      cmdSaveConfig },
+    { 'p', "p [reset]", "Hot-path timing histograms / clear them",         cmdProfile },
+    { 'z', "z [reset]", "Low-power idle and wake latency / clear the stats", cmdPower },
+    { 'g', "g [cmd]",   "Jam journal / dump, tag <n> (new spool), erase",  cmdJournal },
+    { 'h', "h",         "This help",                                       cmdHelp },
+    { '?', "?",         "This help",                                       cmdHelp },
+};
+
+// --- Loop Jobs ---
+
+// Print whatever the control task reported since the last pass. Runs on
+// every wake-up: the control task wakes the loop after each tick.
+static void drainControl() {
+    FeedArmEvent ev;
+    while (control.pollEvent(ev)) {
+        trackUnstick(ev);
+        journalEvent(ev);
+        if (printerLinkOn) printerLink.onEvent(ev, micros());
+        if (telemetryOn) {
+            uint8_t frame[kTelemetryMaxFrame];
+            sendFrame(frame, telemetry.event(ev, frame));
+        } else {
+            printEvent(ev);
+        }
+    }
+
+    // Every tick goes out when streaming. Everything else (LED, status
+    // line, journal) goes by the newest, even when the stream fell behind.
+    if (telemetryOn) {
+        FeedArmStatus st;
+        while (control.pollStatus(st)) {
+            PROFILE_SCOPE(TELEMETRY);
+            sendTelemetry(st);
+        }
+    }
+    control.latestStatus(status);
+
+    for (uint8_t i = 0; i < kChannels; i++) {
+        PotSweepResult sweep;
+        if (control.takePotSweep(i, sweep)) applyPotSweep(i, sweep);
+    }
+    retryPendingConfigs();
+}
+
+// One LED for every channel: the busiest one sets the pattern.
+static void ledJob(void*, uint64_t nowUs) {
+    uint32_t now = (uint32_t)(nowUs / 1000);
+    bool unsticking = false;
+    bool recovering = false;
+    bool stalled = false;
+    for (uint8_t i = 0; i < kChannels; i++) {
+        FeedArmState state = status[i].state;
+        if (state == FeedArmState::UNSTICKING || state == FeedArmState::HOLD_UNSTICK) {
+            unsticking = true;
+        } else if (state != FeedArmState::MONITORING) {
+            recovering = true;
+        } else if (status[i].filamentStalled) {
+            stalled = true;
+        }
+    }
+    if (unsticking) {
+        // Rapid blink during unstick action.
+        digitalWrite(PIN_STATUS_LED, (now / 100) % 2 == 0);
+    } else if (recovering) {
+        digitalWrite(PIN_STATUS_LED, LOW);
+    } else if (stalled) {
+        // Fast blink if filament stalled (warning).
+        digitalWrite(PIN_STATUS_LED, (now / 250) % 2 == 0);
+    } else {
+        // Slow heartbeat in normal operation.
+        digitalWrite(PIN_STATUS_LED, (now / 1000) % 2 == 0);
+    }
+}
+
+// Periodic status print, one line per channel.
+static void statusJob(void*, uint64_t) {
+    if (telemetryOn) return;
+    PROFILE_SCOPE(STATUS_PRINT);
+    for (uint8_t i = 0; i < kChannels; i++) {
+        const FeedArmStatus& st = status[i];
+        if (kChannels > 1) Serial.printf("[Ch%u] ", i);
+        Serial.printf("[Status] %s | Angle:%.0f° | Tension:%.2fN | Feed:%.1fmm/s | Unsticks:%u%s\n",
+                      feedArmStateName(st.state),
+                      st.feedArmAngle,
+                      st.filamentTension,
+                      st.filamentSpeed,
+                      st.unstickCount,
+                      st.filamentStalled ? " STALL" : "");
+    }
+}
+
+// Freeze a capture once its post-trigger window has passed.
+static void recorderJob(void*, uint64_t nowUs) {
+    recorder.service(nowUs);
+}
+
+#ifdef FFX_PROFILE
+static void profileJob(void*, uint64_t) {
+    if (telemetryOn) sendProfile();
+}
+#endif
+
+// Handle serial commands and step any running job.
+static void shellJob(void*, uint64_t nowUs) {
+    PROFILE_SCOPE(SHELL_POLL);
+    shell.poll((uint32_t)(nowUs / 1000));
+}
+
+// Request retries and the link timeout; incoming lines also wake the loop.
+static void printerJob(void*, uint64_t) {
+    PROFILE_SCOPE(PRINTER_LINK);
+    servicePrinterLink();
+}
+
+// Write queued journal records and a deferred 'w' once flashBusy()
+// allows: the flash write stalls the control task, which mustn't miss a
+// jam mid-print.
+static void flashJob(void*, uint64_t) {
+    journalFilament();
+    if (flashBusy()) return;
+    if (configFlash != ConfigFlash::NONE) writeConfigFlash();
+    if (journal.pending()) journal.flush();
+}
+
+static void wakeLoop(void*) {
+    xTaskNotifyGive(loopTask);
+}
+
+static void startLoopJobs(const Config& config) {
+    loopTask = xTaskGetCurrentTaskHandle();
+    esp_timer_create_args_t args = {};
+    args.callback = wakeLoop;
+    args.name = "loop-wake";
+    esp_timer_create(&args, &loopWake);
+    control.setListener(loopTask);
+
+    scheduler.begin(sysClock);
+    scheduler.every("led", kLedMs * 1000, ledJob);
+    scheduler.every("status", kStatusPrintMs * 1000, statusJob);
+    scheduler.every("recorder", kRecorderMs * 1000, recorderJob);
+    scheduler.every("shell", kShellPollMs * 1000, shellJob);
+    scheduler.every("flash", kFlashJobMs * 1000, flashJob);
+    if (printerLinkOn) {
+        scheduler.every("printer", config.printerRetryMs * 1000, printerJob);
+        Serial1.onReceive([]() { xTaskNotifyGive(loopTask); });
+    }
+#ifdef FFX_PROFILE
+    scheduler.every("profile", kProfileSendMs * 1000, profileJob);
+#endif
+    loopSinceUs = esp_timer_get_time();
+}
+
+static void* psramAlloc(size_t bytes) {
+    return ps_malloc(bytes);
+}
+
+void setup() {
+    // Saved settings first: one NVS read per channel, before anything that
+    // depends on them (baud rate included).
+    configStorage.begin();
+    configStore.begin(&configStorage);
+    journalStorage.begin();
+    for (uint8_t i = 0; i < kChannels; i++) {
+        configLoaded[i] = configStore.load(i, configs[i]);
+    }
+
+    const Config& config = configs[0];
+    Serial.begin(config.baudRate);
+    delay(1000);
+
+    Serial.println();
+    Serial.println("================================");
+    Serial.println("  3D Printer Feed Arm v0.2");
+    Serial.println("  Pot Angle + Reed Switch");
+    Serial.println("================================");
+
+    for (uint8_t i = 0; i < kChannels; i++) {
+        Serial.printf("[Config] Channel %u: %s\n", i, configLoadResultName(configLoaded[i]));
+    }
+    journal.begin(&journalStorage, &sysClock);
+
+    // Status LED.
+    pinMode(PIN_STATUS_LED, OUTPUT);
+    digitalWrite(PIN_STATUS_LED, LOW);
+
+    // Flight recorder in PSRAM. Without PSRAM it stays disabled and every
+    // record call is a no-op. Pot channel 2i/2i+1 is feed channel i.
+    recorder.begin(config, kChannels * 2, psramAlloc);
+    potSampler.setRecorder(&recorder);
+
+    // One continuous ADC scan over every channel's pots.
+    uint8_t potPins[kChannels * 2];
+    for (uint8_t i = 0; i < kChannels; i++) {
+        potPins[i * 2] = kChannelPins[i].feedPot;
+        potPins[i * 2 + 1] = kChannelPins[i].tensionPot;
+    }
+    potSampler.begin(potPins, kChannels * 2, config.potSampleRateHz, config.potSamples);
+
+    for (uint8_t i = 0; i < kChannels; i++) {
+        const ChannelPins& pins = kChannelPins[i];
+        ChannelHw& hw = channelHw[i];
+
+        // Wheel sensor on its own interrupt slot(s).
+        if (configs[i].wheelQuadrature && pins.wheelB != kNoPin) {
+            reedSwitches[i].beginQuadrature(pins.reed, pins.wheelB, gpio, sysClock);
+        } else {
+            reedSwitches[i].begin(pins.reed, gpio, sysClock);
+        }
+
+        // LEDC channels 2i and 2i+1, held for the life of the channel.
+        // On the RC clock with low power on, so they keep pulsing in sleep.
+        hw.feedServo.begin(i * 2, config.lowPower);
+        hw.tensionServo.begin(i * 2 + 1, config.lowPower);
+        hw.feedServoRec.begin(&hw.feedServo, &recorder, &sysClock, RecordKind::FEED_SERVO, i);
+        hw.tensionServoRec.begin(&hw.tensionServo, &recorder, &sysClock,
+                                 RecordKind::TENSION_SERVO, i);
+        hw.pots.setSource(&potSampler);
+
+        FeedArmIo io = { &sysClock, &hw.pots, &hw.feedServoRec, &hw.tensionServoRec };
+        feedArms[i].setRecorder(&recorder);
+        feedArms[i].begin(configs[i], io, pins.feedServo, pins.tensionServo,
+                          pins.feedPot, pins.tensionPot, &reedSwitches[i]);
+        Serial.printf("[Main] Channel %u initialized (servos %u/%u, pots %u/%u, reed %u).\n",
+                      i, pins.feedServo, pins.tensionServo, pins.feedPot, pins.tensionPot,
+                      pins.reed);
+    }
+
+    if (config.printerLink) {
+        Serial1.begin(config.printerBaud, SERIAL_8N1, PIN_PRINTER_RX, PIN_PRINTER_TX);
+        printerLink.begin(config, readPrinterByte, writePrinterBytes, nullptr);
+        printerLinkOn = true;
+        Serial.printf("[Main] Printer link on UART1 (rx %u, tx %u, %u baud).\n",
+                      PIN_PRINTER_RX, PIN_PRINTER_TX, config.printerBaud);
+    }
+
+    // Servos and the LED keep driving through light sleep; the wheel pins
+    // and the printer's UART wake it.
+    uint8_t holdPins[kChannels * 2 + 1];
+    for (uint8_t i = 0; i < kChannels; i++) {
+        holdPins[i * 2] = kChannelPins[i].feedServo;
+        holdPins[i * 2 + 1] = kChannelPins[i].tensionServo;
+    }
+    holdPins[kChannels * 2] = PIN_STATUS_LED;
+    power.begin(config, &potSampler, &gpio, holdPins, sizeof(holdPins),
+                printerLinkOn ? 1 : -1);
+    control.setPower(&power);
+
+    // Hand the controllers to the real-time task. From here on the loop only
+    // talks to them through the control task's rings.
+    control.begin(feedArms, reedSwitches, kChannels, config.monitorIntervalMs);
+
+    shell.begin(kCommands, sizeof(kCommands) / sizeof(kCommands[0]), readSerialByte, nullptr);
+
+    setTelemetry(config.telemetryBinary);
+    startLoopJobs(config);
+
+    Serial.println("[Main] Ready. Type 'h' for commands.");
+    Serial.println();
+}
+
+void loop() {
+    // Sleep until the next job's deadline, unless the control task or the
+    // UART wakes us first. Only the wait itself is off the CPU; everything
+    // below is counted as awake time.
+    uint64_t nowUs = esp_timer_get_time();
+    uint64_t dueUs = scheduler.nextDueUs();
+    if (dueUs > nowUs) {
+        if (dueUs != UINT64_MAX) esp_timer_start_once(loopWake, dueUs - nowUs);
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        esp_timer_stop(loopWake);   // fails harmlessly if it already fired
+    }
+
+    PROFILE_SCOPE(LOOP_PASS);
+    uint64_t startUs = esp_timer_get_time();
+    drainControl();
+    if (printerLinkOn) {
+        PROFILE_SCOPE(PRINTER_LINK);
+        servicePrinterLink();
+    }
+    scheduler.run();
+    // USB CDC drops while the chip sleeps, and a printer that is talking
+    // wants answers: sleep only with neither.
+    power.allowSleep(configs[0].lowPower && !Serial &&
+                     !(printerLinkOn && printerLink.up(micros())));
+
+    uint32_t passUs = (uint32_t)(esp_timer_get_time() - startUs);
+    loopBusyUs += passUs;
+    if (passUs > worstLoopUs) worstLoopUs = passUs;
+}
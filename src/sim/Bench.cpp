@@ -0,0 +1,585 @@
+#include "Bench.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <random>
+#include <vector>
+#include "ArmSpectrum.h"
+#include "Config.h"
+#include "Filters.h"
+#include "PotTable.h"
+#include "DetectionScorer.h"
+#include "Simulation.h"
+#include "Trace.h"
+#include "TraceReplay.h"
+
+// --- Scenarios ---
+
+struct BenchScenario {
+    const char* name;
+    const char* description;
+    void (*tweak)(RigParams& rig, SimOptions& opt);
+};
+
+static const BenchScenario kScenarios[] = {
+    { "nominal", "default rig, 2 snags/h",
+      [](RigParams&, SimOptions& opt) { opt.jamsPerHour = 2.0f; } },
+    { "wobbly-spool", "eccentric, sticky spool, no snags (false positives only)",
+      [](RigParams& rig, SimOptions& opt) {
+          rig.spoolWobble = 0.8f;
+          rig.spoolStaticDrag = 1.6f;
+          opt.jamsPerHour = 0.0f;
+      } },
+    { "heavy-snags", "snags holding 8-20 N, 2/h",
+      [](RigParams&, SimOptions& opt) {
+          opt.jamsPerHour = 2.0f;
+          opt.jamHoldMinN = 8.0f;
+          opt.jamHoldMaxN = 20.0f;
+      } },
+    { "fast-print", "4-12 mm/s extrusion, 2 snags/h",
+      [](RigParams&, SimOptions& opt) {
+          opt.jamsPerHour = 2.0f;
+          opt.extrudeMinMmS = 4.0f;
+          opt.extrudeMaxMmS = 12.0f;
+      } },
+    { "noisy-pots", "5x pot noise, 2 snags/h",
+      [](RigParams& rig, SimOptions& opt) {
+          rig.potNoise *= 5.0f;
+          opt.jamsPerHour = 2.0f;
+      } },
+    { "tangling-spool", "snags that start as a tangle catching once a revolution, 5 min ahead, 2/h",
+      [](RigParams&, SimOptions& opt) {
+          opt.jamsPerHour = 2.0f;
+          opt.tangleLeadS = 300.0f;
+          opt.tangleCatchN = 1.5f;
+      } },
+    { "print-gaps", "45 min prints, 30 min idle between them, 2 snags/h (some form in a gap)",
+      [](RigParams&, SimOptions& opt) {
+          opt.jamsPerHour = 2.0f;
+          opt.printMeanS = 2700.0f;
+          opt.idleGapMeanS = 1800.0f;
+      } },
+    { "emptying-spool", "40 m spool run to empty, drag x2.2 by the end, 2 snags/h",
+      [](RigParams& rig, SimOptions& opt) {
+          rig.spoolFilamentM = 40.0f;
+          rig.spoolEmptyDragScale = 2.2f;
+          opt.jamsPerHour = 2.0f;
+      } },
+};
+
+struct BenchCase {
+    std::string name;
+    std::string source;     // "sim" or trace path
+    double hours = 0;
+    double slipSeconds = 0;     // extruder gears slipping (sim only)
+    DetectionScorer score;
+};
+
+// --- Reporting ---
+
+static void printCase(const BenchCase& c) {
+    const DetectionScorer& d = c.score;
+    Percentiles lat = percentiles(d.latencyMs());
+    Percentiles cyc = percentiles(d.cycleMs());
+    Percentiles clr = percentiles(d.clearMs());
+    Percentiles tick = d.tickNs();
+    printf("%-14s %6.1fh  jams %3u det %3u miss %3u  lat p50/p90/p99 %6.2f/%6.2f/%6.2fs"
+           "  FP/h %5.2f  cycle p10/p50 %5.2f/%5.2fs  clear p50 %6.2fs  slip %5.1fs"
+           "  tick p99 %5.0fns\n",
+           c.name.c_str(), c.hours, d.jams(), d.detected(), d.undetected(),
+           lat.p50 / 1000.0, lat.p90 / 1000.0, lat.p99 / 1000.0,
+           c.hours > 0 ? d.falsePositives() / c.hours : 0.0,
+           cyc.p10 / 1000.0, cyc.p50 / 1000.0, clr.p50 / 1000.0, c.slipSeconds, tick.p99);
+}
+
+static void jsonEscape(FILE* f, const std::string& s) {
+    fputc('"', f);
+    for (char ch : s) {
+        if (ch == '"' || ch == '\\') fputc('\\', f);
+        fputc(ch, f);
+    }
+    fputc('"', f);
+}
+
+static void jsonPercentiles(FILE* f, const char* key, const Percentiles& p) {
+    fprintf(f, "\"%s\": {\"n\": %u, \"p10\": %.3f, \"p50\": %.3f, \"p90\": %.3f, "
+            "\"p99\": %.3f, \"max\": %.3f}",
+            key, p.n, p.p10, p.p50, p.p90, p.p99, p.max);
+}
+
+static bool writeJson(const char* path, const std::string& label,
+                      const std::vector<BenchCase>& cases) {
+    FILE* f = fopen(path, "w");
+    if (!f) return false;
+    fprintf(f, "{\n  \"label\": ");
+    jsonEscape(f, label);
+    fprintf(f, ",\n  \"cases\": [\n");
+    for (size_t i = 0; i < cases.size(); i++) {
+        const BenchCase& c = cases[i];
+        const DetectionScorer& d = c.score;
+        fprintf(f, "    {\"name\": ");
+        jsonEscape(f, c.name);
+        fprintf(f, ", \"source\": ");
+        jsonEscape(f, c.source);
+        fprintf(f, ", \"hours\": %.3f, \"jams\": %u, \"detected\": %u, \"undetected\": %u, "
+                   "\"redetections\": %u, \"false_positives\": %u, \"false_positives_per_hour\": %.4f,\n      ",
+                c.hours, d.jams(), d.detected(), d.undetected(), d.redetections(),
+                d.falsePositives(), c.hours > 0 ? d.falsePositives() / c.hours : 0.0);
+        fprintf(f, "\"extruder_slip_s\": %.3f,\n      ", c.slipSeconds);
+        jsonPercentiles(f, "latency_ms", percentiles(d.latencyMs()));
+        fprintf(f, ",\n      ");
+        jsonPercentiles(f, "unstick_cycle_ms", percentiles(d.cycleMs()));
+        fprintf(f, ",\n      ");
+        jsonPercentiles(f, "onset_to_clear_ms", percentiles(d.clearMs()));
+        fprintf(f, ",\n      ");
+        jsonPercentiles(f, "tick_ns", d.tickNs());
+        fprintf(f, "}%s\n", i + 1 < cases.size() ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+    fclose(f);
+    return true;
+}
+
+// --- Filter chains ---
+
+// Per-sample cost and accuracy of each selectable chain on a synthetic pot
+// signal: slow sweep, Gaussian noise and occasional spikes (loose wiper).
+static void benchFilters(uint32_t seed) {
+    static const SignalFilterType kTypes[] = {
+        SignalFilterType::NONE, SignalFilterType::MEDIAN, SignalFilterType::IIR,
+        SignalFilterType::MEDIAN_AVERAGE, SignalFilterType::HAMPEL_IIR
+    };
+    const uint32_t n = 2000000;
+
+    std::mt19937 rng(seed);
+    std::normal_distribution<float> noise(0.0f, 12.0f);
+    std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+    std::vector<int32_t> clean(n), input(n);
+    for (uint32_t i = 0; i < n; i++) {
+        float x = 2000.0f + 600.0f * sinf(i * 2e-4f);
+        clean[i] = (int32_t)x;
+        float v = x + noise(rng);
+        if (uniform(rng) < 0.005f) v += uniform(rng) < 0.5f ? 900.0f : -900.0f;
+        input[i] = (int32_t)constrain(v, 0.0f, 4095.0f);
+    }
+
+    printf("%-16s %8s %10s %10s\n", "filter", "ns/samp", "rms err", "max err");
+    for (SignalFilterType t : kTypes) {
+        FilterBank bank;
+        SignalFilter* f = bank.select(t);
+        std::vector<int32_t> out(n);
+
+        auto t0 = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < n; i++) {
+            out[i] = f ? f->push(input[i]) : input[i];
+        }
+        auto t1 = std::chrono::steady_clock::now();
+
+        double sq = 0;
+        int32_t worst = 0;
+        for (uint32_t i = 100; i < n; i++) {
+            int32_t e = out[i] - clean[i];
+            sq += (double)e * e;
+            if (abs(e) > worst) worst = abs(e);
+        }
+        double ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / n;
+        printf("%-16s %8.1f %10.2f %10d\n", signalFilterName(t), ns, sqrt(sq / (n - 100)), worst);
+    }
+}
+
+// --- Arm spectrum ---
+
+// Cost of one spectrum window on each FFT kernel built in (the complex FFT
+// alone, then the whole analysis), and how well it finds a tone: random
+// frequencies and phases over the band, plus noise and drift.
+static void benchSpectrum(const Config& cfg, uint32_t seed) {
+    const uint16_t n = ArmSpectrum::kFrames / 2;
+    const uint32_t runs = 20000;
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+    std::normal_distribution<float> noise(0.0f, 0.3f);
+
+    ArmSpectrum spectrum;
+    spectrum.configure(cfg);
+    const ArmSpectrumFeatures& f = spectrum.features();
+    uint32_t ticks = ArmSpectrum::kFrames * cfg.spectrumDecimation;
+    for (uint32_t t = 0; t < ticks; t++) spectrum.push(90.0f + noise(rng));
+
+    printf("%u-frame window at %.2f Hz frames (%u-point complex FFT), one every %u ticks\n",
+           ArmSpectrum::kFrames, f.frameHz, n, ArmSpectrum::kHop * cfg.spectrumDecimation);
+    printf("%-10s %12s %12s %14s\n", "kernel", "fft ns", "window ns", "ns per tick");
+    for (FftImpl impl : { FftImpl::SCALAR, FftImpl::ESP_DSP }) {
+        if (!fftAvailable(impl)) {
+            printf("%-10s   (not built in)\n", fftImplName(impl));
+            continue;
+        }
+        alignas(16) float data[ArmSpectrum::kFrames];
+        for (uint16_t i = 0; i < ArmSpectrum::kFrames; i++) data[i] = noise(rng);
+        auto t0 = std::chrono::steady_clock::now();
+        for (uint32_t r = 0; r < runs; r++) fftComplex(data, n, impl);
+        auto t1 = std::chrono::steady_clock::now();
+        spectrum.setImpl(impl);
+        for (uint32_t r = 0; r < runs; r++) spectrum.analyse();
+        auto t2 = std::chrono::steady_clock::now();
+        double fftNs = std::chrono::duration<double, std::nano>(t1 - t0).count() / runs;
+        double windowNs = std::chrono::duration<double, std::nano>(t2 - t1).count() / runs;
+        printf("%-10s %12.0f %12.0f %14.2f\n", fftImplName(impl), fftNs, windowNs,
+               windowNs / (ArmSpectrum::kHop * cfg.spectrumDecimation));
+    }
+
+    // Tones between the second bin and half the frame rate.
+    const uint32_t tones = 200;
+    std::vector<double> errBins;
+    uint32_t found = 0;
+    float binHz = f.frameHz / ArmSpectrum::kFrames;
+    for (uint32_t i = 0; i < tones; i++) {
+        float hz = binHz * (2.0f + uniform(rng) * (ArmSpectrum::kFrames / 2 - 4));
+        float phase = uniform(rng) * 6.2832f;
+        float amp = 0.5f + uniform(rng) * 3.0f;
+        float drift = (uniform(rng) - 0.5f) * 0.01f;
+        spectrum.restart();
+        for (uint32_t t = 0; t < ticks; t++) {
+            float s = t / (f.frameHz * cfg.spectrumDecimation);
+            spectrum.push(90.0f + amp * sinf(6.2832f * hz * s + phase) + drift * t + noise(rng));
+        }
+        spectrum.analyse();
+        double err = std::fabs(f.peakHz - hz) / binHz;
+        errBins.push_back(err);
+        if (err < 0.5) found++;
+    }
+    Percentiles err = percentiles(errBins);
+    printf("tone in noise: %u/%u peaks within half a bin, error p50/p99/max %.3f/%.3f/%.3f bins\n",
+           found, tones, err.p50, err.p99, err.max);
+}
+
+// --- Multi-channel tick latency ---
+
+// One rig and controller per channel, stepped in lockstep the way the
+// control task runs them: each tick updates channel 0, then 1, and so on.
+// A channel's latency is its own update plus every earlier channel's in the
+// same tick. Each rig has its own seed, and detection is scored per channel,
+// so state leaking between controllers would show up too.
+static void benchChannels(const Config& cfg, uint8_t channels, double hours, uint32_t seed) {
+    std::vector<std::unique_ptr<Simulation>> sims;
+    for (uint8_t i = 0; i < channels; i++) {
+        RigParams rig;
+        SimOptions opt;
+        opt.hours = hours;
+        opt.seed = seed + i;
+        kScenarios[0].tweak(rig, opt);
+        sims.emplace_back(new Simulation(cfg, rig, opt));
+        sims.back()->controller().setChannel(i);
+    }
+
+    uint64_t steps = (uint64_t)(hours * 3600.0 * 1e6 / SimOptions().stepUs);
+    for (uint64_t n = 0; n < steps; n++) {
+        for (auto& sim : sims) sim->step();
+    }
+    for (auto& sim : sims) sim->finish();
+
+    size_t ticks = sims[0]->score().tickCosts().size();
+    for (auto& sim : sims) ticks = std::min(ticks, sim->score().tickCosts().size());
+
+    const double budgetNs = cfg.controlBudgetUs * 1000.0;
+    printf("%u channels, %.1fh, %zu ticks, budget %uus per channel\n",
+           channels, hours, ticks, cfg.controlBudgetUs);
+    printf("%-3s %5s %4s %6s %8s  %18s  %26s %6s\n", "ch", "jams", "det", "FP/h",
+           "clear50", "update p50/p99 ns", "latency p50/p99/max ns", "over");
+
+    std::vector<double> latency(ticks, 0.0);
+    for (uint8_t i = 0; i < channels; i++) {
+        const DetectionScorer& d = sims[i]->score();
+        const std::vector<uint32_t>& cost = d.tickCosts();
+        uint32_t over = 0;
+        for (size_t t = 0; t < ticks; t++) {
+            latency[t] += cost[t];
+            if (latency[t] > budgetNs) over++;
+        }
+        Percentiles own = d.tickNs();
+        Percentiles lat = percentiles(latency);
+        printf("%-3u %5u %4u %6.2f %7.2fs  %8.0f/%9.0f  %8.0f/%8.0f/%8.0f %6u\n",
+               i, d.jams(), d.detected(), d.falsePositives() / hours,
+               percentiles(d.clearMs()).p50 / 1000.0, own.p50, own.p99,
+               lat.p50, lat.p99, lat.max, over);
+    }
+    Percentiles last = percentiles(latency);
+    printf("last channel p99 = %.2f%% of budget, %.4f%% of the %ums tick\n",
+           100.0 * last.p99 / budgetNs, 100.0 * last.p99 / (cfg.monitorIntervalMs * 1e6),
+           cfg.monitorIntervalMs);
+}
+
+// Runs the controller's servo sweep against a rig whose ADC bows away from
+// a straight line, then compares the angle each map gives over the whole
+// 0-160° range: the two-point endpoints against the sweep's table.
+static void benchPotCal(const Config& cfg, float bow, uint32_t seed) {
+    RigParams rig;
+    rig.potAdcBow = bow;
+    SimOptions opt;
+    opt.seed = seed;
+    opt.jamsPerHour = 0;
+    opt.travelFraction = 1.0f;      // printer idle
+    Simulation sim(cfg, rig, opt);
+
+    auto runFor = [&sim](double seconds) {
+        uint64_t end = sim.clock().micros() + (uint64_t)(seconds * 1e6);
+        while (sim.clock().micros() < end) sim.step();
+    };
+    runFor(2.0);
+    uint64_t startUs = sim.clock().micros();
+    sim.controller().startCalibration();
+    PotSweepResult sweep;
+    while (!sim.controller().takeCalibration(sweep)) {
+        if (sim.clock().micros() - startUs > 120000000ull) {
+            printf("pot sweep did not finish\n");
+            return;
+        }
+        sim.step();
+    }
+    double sweepS = (sim.clock().micros() - startUs) / 1e6;
+
+    printf("ADC bow %.0f counts, sweep %u points up and down in %.1fs\n", bow,
+           kPotCalPoints, sweepS);
+    printf("%-8s %-10s %9s %9s   %s\n", "pot", "map", "max err", "rms err", "table (counts)");
+    const PotCalibration* cals[] = { &sweep.feed, &sweep.tension };
+    const char* names[] = { "feed", "tension" };
+    for (uint8_t p = 0; p < 2; p++) {
+        PotTable linear;
+        linear.linear(p == 0 ? cfg.potFeedMin : cfg.potTensionMin,
+                      p == 0 ? cfg.potFeedMax : cfg.potTensionMax);
+        PotTable table;
+        bool ok = table.build(*cals[p]);
+        const PotTable* maps[] = { &linear, ok ? &table : nullptr };
+        const char* mapNames[] = { "two-point", "sweep" };
+        for (uint8_t m = 0; m < 2; m++) {
+            if (!maps[m]) {
+                printf("%-8s %-10s   (sweep not monotonic)\n", names[p], mapNames[m]);
+                continue;
+            }
+            double worst = 0;
+            double sumSq = 0;
+            int n = 0;
+            for (float a = 0.0f; a <= 160.0f; a += 0.5f, n++) {
+                int32_t counts = (int32_t)lroundf(sim.pots().counts(a));
+                double err = maps[m]->centiDegrees(counts) * 0.01 - a;
+                worst = std::max(worst, std::fabs(err));
+                sumSq += err * err;
+            }
+            printf("%-8s %-10s %8.2f° %8.2f°  ", names[p], mapNames[m], worst,
+                   std::sqrt(sumSq / n));
+            if (m == 1) {
+                for (uint8_t i = 0; i < cals[p]->points; i++) printf(" %u", cals[p]->adc[i]);
+            }
+            printf("\n");
+        }
+    }
+}
+
+// --- Entry ---
+
+int benchMain(int argc, char** argv) {
+    double hours = 4.0;
+    uint32_t seed = 1;
+    const char* jsonPath = nullptr;
+    const char* only = nullptr;
+    std::string label = "unlabelled";
+    std::vector<const char*> traces;
+    bool filtersOnly = false;
+    uint8_t channels = 0;
+    bool potCal = false;
+    float adcBow = 60.0f;
+    uint16_t wheelPulses = 0;
+    bool printerLink = false;
+    float linkLatencyMs = SimOptions().linkLatencyMs;
+    bool spectrumOnly = false;
+    Config cfg;
+
+    for (int i = 0; i < argc; i++) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (!strcmp(arg, "--hours") && hasValue) {
+            hours = atof(argv[++i]);
+        } else if (!strcmp(arg, "--seed") && hasValue) {
+            seed = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        } else if (!strcmp(arg, "--json") && hasValue) {
+            jsonPath = argv[++i];
+        } else if (!strcmp(arg, "--scenario") && hasValue) {
+            only = argv[++i];
+        } else if (!strcmp(arg, "--trace") && hasValue) {
+            traces.push_back(argv[++i]);
+        } else if (!strcmp(arg, "--label") && hasValue) {
+            label = argv[++i];
+        } else if (!strcmp(arg, "--detector") && hasValue) {
+            if (!parseDetector(argv[++i], cfg.jamDetector)) {
+                fprintf(stderr, "bench: unknown detector '%s'\n", argv[i]);
+                return 2;
+            }
+        } else if (!strcmp(arg, "--pot-filter") && hasValue) {
+            if (!parseSignalFilter(argv[++i], cfg.potFilter)) {
+                fprintf(stderr, "bench: unknown filter '%s'\n", argv[i]);
+                return 2;
+            }
+        } else if (!strcmp(arg, "--reed-filter") && hasValue) {
+            if (!parseSignalFilter(argv[++i], cfg.reedFilter)) {
+                fprintf(stderr, "bench: unknown filter '%s'\n", argv[i]);
+                return 2;
+            }
+        } else if (!strcmp(arg, "--filters")) {
+            filtersOnly = true;
+        } else if (!strcmp(arg, "--channels") && hasValue) {
+            int n = atoi(argv[++i]);
+            if (n < 1 || n > kMaxFeedChannels) {
+                fprintf(stderr, "bench: --channels must be 1-%u\n", kMaxFeedChannels);
+                return 2;
+            }
+            channels = (uint8_t)n;
+        } else if (!strcmp(arg, "--wheel-pulses") && hasValue) {
+            wheelPulses = (uint16_t)atoi(argv[++i]);
+            if (wheelPulses < 1) {
+                fprintf(stderr, "bench: --wheel-pulses must be at least 1\n");
+                return 2;
+            }
+            cfg.wheelPulsesPerRev = wheelPulses;
+        } else if (!strcmp(arg, "--jam-tension") && hasValue) {
+            cfg.jamTensionN = (float)atof(argv[++i]);
+        } else if (!strcmp(arg, "--printer-link")) {
+            printerLink = true;
+        } else if (!strcmp(arg, "--slip-margin") && hasValue) {
+            cfg.printerSlipMarginMm = (float)atof(argv[++i]);
+        } else if (!strcmp(arg, "--link-latency") && hasValue) {
+            linkLatencyMs = (float)atof(argv[++i]);
+        } else if (!strcmp(arg, "--no-spectrum")) {
+            cfg.spectrum = false;
+        } else if (!strcmp(arg, "--spectrum-db") && hasValue) {
+            cfg.spectrumAnomalyDb = (float)atof(argv[++i]);
+        } else if (!strcmp(arg, "--spectrum")) {
+            spectrumOnly = true;
+        } else if (!strcmp(arg, "--low-power")) {
+            cfg.lowPower = true;
+        } else if (!strcmp(arg, "--idle-tick") && hasValue) {
+            cfg.idleTickMs = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        } else if (!strcmp(arg, "--no-tension-track")) {
+            cfg.tensionTrack = false;
+        } else if (!strcmp(arg, "--pot-cal")) {
+            potCal = true;
+        } else if (!strcmp(arg, "--adc-bow") && hasValue) {
+            adcBow = (float)atof(argv[++i]);
+        } else {
+            fprintf(stderr, "bench: unknown option '%s'\n", arg);
+            return 2;
+        }
+    }
+
+    if (filtersOnly) {
+        benchFilters(seed);
+        return 0;
+    }
+    if (spectrumOnly) {
+        benchSpectrum(cfg, seed);
+        return 0;
+    }
+
+    simLogEnabled = false;
+    if (potCal) {
+        benchPotCal(cfg, adcBow, seed);
+        return 0;
+    }
+    if (channels) {
+        benchChannels(cfg, channels, hours, seed);
+        return 0;
+    }
+
+    std::vector<BenchCase> cases;
+
+    // With only --trace given, skip the synthetic suite.
+    bool runSuite = traces.empty() || only;
+    if (runSuite) {
+        for (const BenchScenario& sc : kScenarios) {
+            if (only && strcmp(only, sc.name) != 0) continue;
+            RigParams rig;
+            SimOptions opt;
+            opt.hours = hours;
+            opt.seed = seed;
+            sc.tweak(rig, opt);
+            if (wheelPulses) rig.wheelMagnets = wheelPulses;
+            opt.printerLink = printerLink;
+            opt.linkLatencyMs = linkLatencyMs;
+
+            Simulation sim(cfg, rig, opt);
+            sim.run();
+
+            cases.emplace_back();
+            BenchCase& c = cases.back();
+            c.name = sc.name;
+            c.source = "sim";
+            c.hours = sim.stats().simSeconds / 3600.0;
+            c.slipSeconds = sim.stats().slipSeconds;
+            c.score = sim.score();
+            printCase(c);
+            if (printerLink) {
+                const PrinterLink& link = sim.printerLink();
+                Percentiles rtt = percentiles(sim.printerHost().rttMs());
+                printf("%-14s link: report rtt p50/p99/max %.1f/%.1f/%.1f ms, %u holds, "
+                       "hold rtt worst %.1f ms, %u retries, %u bad lines\n", "",
+                       rtt.p50, rtt.p99, rtt.max, sim.printerHost().holds(),
+                       link.worstRttUs() / 1000.0, link.retries(),
+                       link.badLines() + sim.printerHost().badLines());
+            }
+            const SimStats& st = sim.stats();
+            if (st.tangles || st.wobbleWarnings) {
+                Percentiles lead = percentiles(st.warnLeadS);
+                printf("%-14s spectrum: %u wobble warnings (%.2f/h), %u/%u tangles warned, "
+                       "lead p10/p50 %.0f/%.0fs\n", "", st.wobbleWarnings,
+                       st.wobbleWarnings / c.hours, st.tanglesWarned, st.tangles,
+                       lead.p10, lead.p50);
+            }
+            if (cfg.lowPower) {
+                const WakeStats& w = sim.idleMonitor().stats();
+                printf("%-14s power: idle %.1f%% of the time, %.0f ticks/h, wakes reed %u arm %u "
+                       "state %u printer %u\n", "",
+                       st.simSeconds > 0 ? w.idleMs / 10.0 / st.simSeconds : 0.0,
+                       st.ticks / c.hours,
+                       w.wakes[(uint8_t)WakeReason::REED], w.wakes[(uint8_t)WakeReason::ARM_MOVED],
+                       w.wakes[(uint8_t)WakeReason::STATE], w.wakes[(uint8_t)WakeReason::PRINTER]);
+            }
+            if (wheelPulses) {
+                double fed = sim.rig().paidOut() * 1000.0;
+                double counted = sim.controller().filamentUsedMm();
+                printf("%-14s odometer %.1f m counted, %.1f m fed (%+.2f%%)\n", "",
+                       counted / 1000.0, fed / 1000.0,
+                       fed > 0 ? (counted - fed) / fed * 100.0 : 0.0);
+            }
+        }
+    }
+
+    for (const char* path : traces) {
+        std::vector<TraceRow> rows;
+        std::string err;
+        if (!loadTrace(path, rows, err)) {
+            fprintf(stderr, "bench: %s\n", err.c_str());
+            return 1;
+        }
+        cases.emplace_back();
+        BenchCase& c = cases.back();
+        const char* slash = strrchr(path, '/');
+        c.name = slash ? slash + 1 : path;
+        c.source = path;
+        c.hours = replayTrace(cfg, rows, c.score);
+        printCase(c);
+    }
+
+    if (cases.empty()) {
+        fprintf(stderr, "bench: no scenario named '%s'\n", only ? only : "");
+        return 2;
+    }
+    if (jsonPath && !writeJson(jsonPath, label, cases)) {
+        fprintf(stderr, "bench: can't write %s\n", jsonPath);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+// Jam-detection benchmark.
+//
+// Runs a fixed suite of closed-loop scenarios (synthetic traces from the rig
+// model) and any recorded traces given with --trace, then reports detection
+// latency percentiles, false positives per print-hour, unstick cycle time and
+// control-tick cost. --json writes the same numbers for comparing builds.
+//
+//   program bench [--hours H] [--seed N] [--scenario NAME] [--trace FILE]...
+//                 [--json FILE] [--label TEXT] [--detector threshold|trajectory]
+//                 [--pot-filter NAME] [--reed-filter NAME] [--no-tension-track]
+//                 [--jam-tension N] [--wheel-pulses N]
+//                 [--printer-link [--link-latency MS] [--slip-margin MM]]
+//                 [--no-spectrum | --spectrum-db DB] [--low-power [--idle-tick MS]]
+//   program bench --filters      (filter chain cost/accuracy only)
+//   program bench --spectrum     (arm spectrum cost per FFT kernel, tone accuracy)
+//   program bench --channels N   (N rigs in lockstep: per-channel tick latency)
+//   program bench --pot-cal [--adc-bow COUNTS]
+//                                (servo sweep on a bowed ADC: angle error
+//                                 before and after, sweep time)
+int benchMain(int argc, char** argv);
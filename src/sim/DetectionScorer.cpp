@@ -0,0 +1,83 @@
+#include "DetectionScorer.h"
+
+#include <algorithm>
+#include <cmath>
+
+Percentiles percentiles(std::vector<double> values) {
+    Percentiles p;
+    p.n = (uint32_t)values.size();
+    if (values.empty()) return p;
+    std::sort(values.begin(), values.end());
+    // Nearest-rank.
+    auto rank = [&](double q) {
+        size_t i = (size_t)std::ceil(q * values.size());
+        return values[i > 0 ? i - 1 : 0];
+    };
+    p.p10 = rank(0.10);
+    p.p50 = rank(0.50);
+    p.p90 = rank(0.90);
+    p.p99 = rank(0.99);
+    p.max = values.back();
+    return p;
+}
+
+void DetectionScorer::jamStarted(uint64_t us) {
+    if (_jamOpen) return;
+    _jamOpen = true;
+    _jamSeen = false;
+    _jamOnsetUs = us;
+    _jams++;
+}
+
+void DetectionScorer::jamEnded(uint64_t us) {
+    if (!_jamOpen) return;
+    _jamOpen = false;
+    if (_jamSeen) {
+        _cleared++;
+        _clearMs.push_back((us - _jamOnsetUs) / 1000.0);
+    } else {
+        _undetected++;
+    }
+}
+
+void DetectionScorer::event(const FeedArmEvent& ev, uint64_t us) {
+    switch (ev.type) {
+    case FeedArmEventType::JAM_DETECTED:
+        if (!_jamOpen) {
+            _falsePositives++;
+        } else if (_jamSeen) {
+            _redetections++;
+        } else {
+            _jamSeen = true;
+            _detected++;
+            _latencyMs.push_back((us - _jamOnsetUs) / 1000.0);
+        }
+        break;
+
+    case FeedArmEventType::STATE_CHANGE:
+        // Unstick cycle: leaving MONITORING until back in it.
+        if (ev.from == FeedArmState::MONITORING) {
+            _inCycle = true;
+            _cycleStartUs = us;
+        } else if (ev.to == FeedArmState::MONITORING && _inCycle) {
+            _inCycle = false;
+            _cycleMs.push_back((us - _cycleStartUs) / 1000.0);
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+void DetectionScorer::finish(uint64_t us) {
+    (void)us;
+    if (_jamOpen && !_jamSeen) {
+        _jamOpen = false;
+        _undetected++;
+    }
+}
+
+Percentiles DetectionScorer::tickNs() const {
+    return percentiles(std::vector<double>(_tickNs.begin(), _tickNs.end()));
+}
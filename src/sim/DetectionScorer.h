@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "FeedArmController.h"
+
+// Scores controller output against ground-truth jam labels.
+// Fed by the closed-loop simulation (labels = injected snags) and by trace
+// replay (labels = the trace's jam column), so both report the same numbers.
+
+struct Percentiles {
+    double p10 = 0;
+    double p50 = 0;
+    double p90 = 0;
+    double p99 = 0;
+    double max = 0;
+    uint32_t n = 0;
+};
+
+Percentiles percentiles(std::vector<double> values);
+
+class DetectionScorer {
+public:
+    // Ground truth.
+    void jamStarted(uint64_t us);
+    void jamEnded(uint64_t us);
+    bool jamOpen() const { return _jamOpen; }
+
+    // Controller output.
+    void event(const FeedArmEvent& ev, uint64_t us);
+    void tickCost(uint32_t ns) { _tickNs.push_back(ns); }
+
+    // Close out a jam still open at the end of the run.
+    void finish(uint64_t us);
+
+    uint32_t jams() const { return _jams; }
+    uint32_t detected() const { return _detected; }
+    uint32_t undetected() const { return _undetected; }   // ended or run over, no JAM event
+    uint32_t cleared() const { return _cleared; }         // ended after detection
+    uint32_t falsePositives() const { return _falsePositives; }
+    uint32_t redetections() const { return _redetections; }
+    uint32_t unstickCycles() const { return (uint32_t)_cycleMs.size(); }
+
+    const std::vector<double>& latencyMs() const { return _latencyMs; }
+    const std::vector<double>& clearMs() const { return _clearMs; }
+    const std::vector<double>& cycleMs() const { return _cycleMs; }
+    Percentiles tickNs() const;
+    // Raw per-tick cost, in tick order.
+    const std::vector<uint32_t>& tickCosts() const { return _tickNs; }
+
+private:
+    bool _jamOpen = false;
+    bool _jamSeen = false;
+    uint64_t _jamOnsetUs = 0;
+    uint64_t _cycleStartUs = 0;
+    bool _inCycle = false;
+
+    uint32_t _jams = 0;
+    uint32_t _detected = 0;
+    uint32_t _undetected = 0;
+    uint32_t _cleared = 0;
+    uint32_t _falsePositives = 0;
+    uint32_t _redetections = 0;
+
+    std::vector<double> _latencyMs;
+    std::vector<double> _clearMs;
+    std::vector<double> _cycleMs;
+    std::vector<uint32_t> _tickNs;
+};
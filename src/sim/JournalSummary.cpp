@@ -0,0 +1,300 @@
+#include "JournalSummary.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include "DetectionScorer.h"
+
+// --- MemJournalStorage ---
+
+size_t MemJournalStorage::size(uint8_t segment) {
+    return segment < kJournalSegments ? _segments[segment].size() : 0;
+}
+
+size_t MemJournalStorage::read(uint8_t segment, size_t offset, void* buf, size_t len) {
+    if (segment >= kJournalSegments || offset >= _segments[segment].size()) return 0;
+    size_t n = _segments[segment].size() - offset;
+    if (n > len) n = len;
+    memcpy(buf, _segments[segment].data() + offset, n);
+    return n;
+}
+
+bool MemJournalStorage::append(uint8_t segment, const void* buf, size_t len) {
+    if (segment >= kJournalSegments) return false;
+    const uint8_t* p = static_cast<const uint8_t*>(buf);
+    _segments[segment].insert(_segments[segment].end(), p, p + len);
+    return true;
+}
+
+bool MemJournalStorage::erase(uint8_t segment) {
+    if (segment >= kJournalSegments) return false;
+    _segments[segment].clear();
+    return true;
+}
+
+void writeJournalDump(JamJournal& journal, FILE* out) {
+    uint8_t chunk[kJournalDumpBytes];
+    char line[kJournalDumpLine];
+    for (uint8_t seg = 0; seg < journal.segmentsUsed(); seg++) {
+        size_t size = journal.segmentSize(seg);
+        for (size_t off = 0; off < size; off += sizeof(chunk)) {
+            size_t n = journal.readSegment(seg, off, chunk, sizeof(chunk));
+            if (n == 0) break;
+            formatJournalDumpLine(seg, chunk, n, line);
+            fputs(line, out);
+        }
+    }
+}
+
+// --- Summary ---
+
+static constexpr uint32_t kSpoolBucketM = 50;
+static constexpr uint32_t kPrintBucketM = 5;
+static constexpr uint32_t kMaxBuckets = 12;
+
+// Smallest doubling of step that fits maxM in kMaxBuckets rows.
+static uint32_t bucketSize(uint32_t maxM, uint32_t step) {
+    while (maxM / step >= kMaxBuckets) step *= 2;
+    return step;
+}
+
+static int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// "J <segment> <hex>" lines back into segments, in order of appearance.
+static bool readDump(FILE* in, std::vector<std::vector<uint8_t>>& segments) {
+    char line[512];
+    while (fgets(line, sizeof(line), in)) {
+        // The shell's replies and status lines share the capture.
+        if (line[0] != 'J' || line[1] != ' ') continue;
+        char* end = nullptr;
+        unsigned long seg = strtoul(line + 2, &end, 10);
+        if (end == line + 2 || *end != ' ' || seg > 255) continue;
+        if (seg >= segments.size()) segments.resize(seg + 1);
+        for (const char* p = end + 1; hexValue(p[0]) >= 0 && hexValue(p[1]) >= 0; p += 2) {
+            segments[seg].push_back((uint8_t)(hexValue(p[0]) << 4 | hexValue(p[1])));
+        }
+    }
+    return !segments.empty();
+}
+
+namespace {
+
+// One spool on one channel, from its tag to the next.
+struct SpoolRun {
+    uint16_t tag = 0;
+    uint32_t metres = 0;
+};
+
+struct TagStats {
+    uint32_t jams = 0;
+    uint32_t gaveUp = 0;
+    uint32_t spools = 0;
+    uint32_t metres = 0;
+};
+
+}  // namespace
+
+static void closeRun(SpoolRun& run, std::map<uint16_t, TagStats>& tags,
+                     std::vector<uint32_t>& spoolLengths) {
+    if (run.metres == 0 && run.tag == 0) return;
+    TagStats& t = tags[run.tag];
+    t.spools++;
+    t.metres += run.metres;
+    spoolLengths.push_back(run.metres);
+    run = {};
+}
+
+int journalMain(int argc, char** argv) {
+    const char* inPath = nullptr;
+    const char* csvPath = nullptr;
+    for (int i = 0; i < argc; i++) {
+        if (!strcmp(argv[i], "--csv") && i + 1 < argc) {
+            csvPath = argv[++i];
+        } else if (!inPath) {
+            inPath = argv[i];
+        } else {
+            fprintf(stderr, "journal: unexpected argument '%s'\n", argv[i]);
+            return 2;
+        }
+    }
+    if (!inPath) {
+        fprintf(stderr, "usage: program journal <dump|-> [--csv FILE]\n");
+        return 2;
+    }
+    FILE* in = strcmp(inPath, "-") == 0 ? stdin : fopen(inPath, "r");
+    if (!in) {
+        fprintf(stderr, "journal: can't open %s\n", inPath);
+        return 1;
+    }
+    std::vector<std::vector<uint8_t>> segments;
+    bool any = readDump(in, segments);
+    if (in != stdin) fclose(in);
+    if (!any) {
+        fprintf(stderr, "journal: no 'J' lines in %s\n", inPath);
+        return 1;
+    }
+
+    FILE* csv = nullptr;
+    if (csvPath) {
+        csv = fopen(csvPath, "w");
+        if (!csv) {
+            fprintf(stderr, "journal: can't write %s\n", csvPath);
+            return 1;
+        }
+        fprintf(csv, "boot,uptime_s,channel,path,outcome,attempts,print,print_m,spool_tag,"
+                     "spool_m,arm_deg,tension_deg,clear_s\n");
+    }
+
+    std::vector<JamRecord> jams;
+    std::map<uint16_t, TagStats> tags;
+    std::vector<uint32_t> spoolLengths;
+    SpoolRun runs[kMaxFeedChannels];
+    uint32_t boots = 0, lastBoot = 0, firstBoot = 0, badSegments = 0, truncated = 0;
+    size_t bytes = 0;
+
+    for (const std::vector<uint8_t>& seg : segments) {
+        JournalDecoder dec;
+        bytes += seg.size();
+        if (!dec.begin(seg.data(), seg.size())) {
+            badSegments++;
+            continue;
+        }
+        uint32_t boot = 0;
+        JournalEntry e;
+        while (dec.next(e)) {
+            uint8_t ch = e.channel < kMaxFeedChannels ? e.channel : 0;
+            switch (e.kind) {
+            case JournalKind::SESSION:
+                boot = e.boot;
+                // Every segment restates its boot; count each boot once.
+                if (!boots || boot != lastBoot) {
+                    if (!boots) firstBoot = boot;
+                    boots++;
+                    lastBoot = boot;
+                }
+                break;
+            case JournalKind::SPOOL:
+                // A new spool restarts the odometer.
+                if (e.spoolTag != runs[ch].tag || e.spoolM < runs[ch].metres) {
+                    closeRun(runs[ch], tags, spoolLengths);
+                    runs[ch].tag = e.spoolTag;
+                }
+                runs[ch].metres = e.spoolM;
+                break;
+            case JournalKind::JAM: {
+                JamRecord j = e.jam;
+                j.boot = boot;
+                jams.push_back(j);
+                if (j.spoolTag != runs[ch].tag) {
+                    closeRun(runs[ch], tags, spoolLengths);
+                    runs[ch].tag = j.spoolTag;
+                }
+                if (j.spoolM > runs[ch].metres) runs[ch].metres = j.spoolM;
+                TagStats& t = tags[j.spoolTag];
+                t.jams++;
+                if (j.outcome == JamOutcome::GAVE_UP) t.gaveUp++;
+                if (csv) {
+                    fprintf(csv, "%u,%u,%u,%s,%s,%u,%u,%.2f,%u,%u,%.1f,%.1f,%.2f\n",
+                            j.boot, j.uptimeS, j.channel, jamPathName(j.path),
+                            jamOutcomeName(j.outcome), j.attempts, j.print,
+                            j.printMm / 1000.0, j.spoolTag, j.spoolM, j.armDeg,
+                            j.tensionDeg, j.clearMs / 1000.0);
+                }
+                break;
+            }
+            }
+        }
+        if (dec.truncated()) truncated++;
+    }
+    for (SpoolRun& run : runs) closeRun(run, tags, spoolLengths);
+    if (csv) fclose(csv);
+
+    printf("=== Jam journal: %zu jam(s), boots %u-%u, %zu segment(s), %zu bytes",
+           jams.size(), firstBoot, lastBoot, segments.size(), bytes);
+    if (!jams.empty()) printf(" (%.1f bytes/jam)", (double)bytes / jams.size());
+    printf(" ===\n");
+    if (badSegments || truncated) {
+        printf("  Damaged:      %u segment(s) unreadable, %u cut short\n", badSegments, truncated);
+    }
+    if (jams.empty()) return 0;
+
+    uint32_t maxSpoolM = 0, maxPrintM = 0;
+    for (const JamRecord& j : jams) {
+        if (j.spoolM > maxSpoolM) maxSpoolM = j.spoolM;
+        if (j.printMm / 1000 > maxPrintM) maxPrintM = j.printMm / 1000;
+    }
+    uint32_t spoolStep = bucketSize(maxSpoolM, kSpoolBucketM);
+    uint32_t printStep = bucketSize(maxPrintM, kPrintBucketM);
+
+    uint32_t byPath[8] = {}, byOutcome[4] = {}, byAttempts[8] = {};
+    uint32_t byChannel[kMaxFeedChannels] = {};
+    std::vector<double> clearS;
+    std::vector<uint32_t> bySpoolBucket(maxSpoolM / spoolStep + 1);
+    std::vector<uint32_t> byPrintBucket(maxPrintM / printStep + 1);
+    for (const JamRecord& j : jams) {
+        byPath[(uint8_t)j.path & 7]++;
+        byOutcome[(uint8_t)j.outcome & 3]++;
+        byAttempts[j.attempts < 7 ? j.attempts : 7]++;
+        byChannel[j.channel < kMaxFeedChannels ? j.channel : 0]++;
+        if (j.path != JamPath::MANUAL) clearS.push_back(j.clearMs / 1000.0);
+        bySpoolBucket[j.spoolM / spoolStep]++;
+        byPrintBucket[j.printMm / 1000 / printStep]++;
+    }
+
+    printf("  Channels:    ");
+    for (uint8_t i = 0; i < kMaxFeedChannels; i++) {
+        if (byChannel[i]) printf(" %u: %u", i, byChannel[i]);
+    }
+    printf("\n  Paths:       ");
+    for (uint8_t i = 0; i < 8; i++) {
+        if (byPath[i]) printf(" %s %u", jamPathName((JamPath)i), byPath[i]);
+    }
+    printf("\n  Outcomes:    ");
+    for (uint8_t i = 0; i < 4; i++) {
+        if (byOutcome[i]) printf(" %s %u", jamOutcomeName((JamOutcome)i), byOutcome[i]);
+    }
+    printf("\n  Attempts:    ");
+    for (uint8_t i = 0; i < 8; i++) {
+        if (byAttempts[i]) printf(" %u%s: %u", i, i == 7 ? "+" : "", byAttempts[i]);
+    }
+    printf("\n");
+    if (!clearS.empty()) {
+        Percentiles p = percentiles(clearS);
+        printf("  Clear time:   p50 %.2f s, p90 %.2f s, max %.2f s\n", p.p50, p.p90, p.max);
+    }
+
+    printf("  By spool tag:\n");
+    for (const auto& kv : tags) {
+        const TagStats& t = kv.second;
+        printf("    tag %-5u  %4u jam(s), %u gave up, %u spool(s), %u m", kv.first, t.jams,
+               t.gaveUp, t.spools, t.metres);
+        if (t.metres) printf(", %.2f jams/100 m", 100.0 * t.jams / t.metres);
+        printf("\n");
+    }
+
+    // Per metre of filament that got that far, so a spool that was never
+    // finished doesn't make its end look clean.
+    printf("  Into the spool (jams per 100 m):\n");
+    for (size_t b = 0; b < bySpoolBucket.size(); b++) {
+        uint32_t from = (uint32_t)b * spoolStep;
+        uint32_t exposure = 0;
+        for (uint32_t len : spoolLengths) {
+            if (len > from) exposure += len - from < spoolStep ? len - from : spoolStep;
+        }
+        printf("    %4u-%-4u m  %4u jam(s)", from, from + spoolStep, bySpoolBucket[b]);
+        if (exposure) printf("  %6.2f /100 m over %u m", 100.0 * bySpoolBucket[b] / exposure,
+                             exposure);
+        printf("\n");
+    }
+    printf("  Into the print:\n");
+    for (size_t b = 0; b < byPrintBucket.size(); b++) {
+        printf("    %4u-%-4u m  %4u jam(s)\n", (uint32_t)b * printStep,
+               (uint32_t)(b + 1) * printStep, byPrintBucket[b]);
+    }
+    return 0;
+}
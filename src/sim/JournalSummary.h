@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdio>
+#include <vector>
+#include "JamJournal.h"
+
+// Host side of the jam journal (JamJournal.h).
+// `program journal` reads a dump captured from the board ('g dump', the
+// "J <segment> <hex>" lines; anything else in the capture is skipped) and
+// summarises it: jams by channel, detection path and outcome, unstick
+// attempts, clear times, jams per 100 m for each spool tag, and where in
+// the spool and in the print the jams happened.
+//
+//   program journal <dump|-> [--csv FILE]
+
+int journalMain(int argc, char** argv);
+
+// Segments in RAM, for the simulator's --journal.
+class MemJournalStorage : public JournalStorage {
+public:
+    size_t size(uint8_t segment) override;
+    size_t read(uint8_t segment, size_t offset, void* buf, size_t len) override;
+    bool append(uint8_t segment, const void* buf, size_t len) override;
+    bool erase(uint8_t segment) override;
+
+private:
+    std::vector<uint8_t> _segments[kJournalSegments];
+};
+
+// Write every stored segment as dump lines, as the board's 'g dump' does.
+void writeJournalDump(JamJournal& journal, FILE* out);
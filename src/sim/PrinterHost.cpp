@@ -0,0 +1,178 @@
+#include "PrinterHost.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+#include "DetectionScorer.h"
+
+void PrinterHost::begin(CommandShell::ReadByte readByte, PrinterLink::WriteBytes writeBytes,
+                        void* ctx, uint32_t reportMs) {
+    _readByte = readByte;
+    _writeBytes = writeBytes;
+    _ctx = ctx;
+    _reportUs = (uint64_t)reportMs * 1000;
+}
+
+void PrinterHost::setMotion(PrinterActivity activity, float mmPerSec, uint8_t tool) {
+    if (activity == _activity && mmPerSec == _mmPerSec && tool == _tool) return;
+    _activity = activity;
+    _mmPerSec = mmPerSec;
+    _tool = tool;
+    _changed = true;
+}
+
+void PrinterHost::poll(uint64_t nowUs) {
+    for (;;) {
+        int c = _readByte(_ctx);
+        if (c < 0) break;
+        if (_line.feed((char)c)) {
+            char line[LineAssembler::kMaxLine];
+            memcpy(line, _line.line(), sizeof(line));
+            handle(line, nowUs);
+        }
+    }
+    if (_changed || nowUs - _lastReportUs >= _reportUs) report(nowUs);
+}
+
+void PrinterHost::report(uint64_t nowUs) {
+    // One report in flight is timed; one overtaken by the next is lost.
+    if (_awaitingEcho) _lostEchoes++;
+    PrinterActivity activity = _held ? PrinterActivity::PAUSED : _activity;
+    static const char kStates[] = { 'I', 'I', 'T', 'E', 'P' };
+    char fields[24];
+    snprintf(fields, sizeof(fields), "%.2f %c %u",
+             activity == PrinterActivity::EXTRUDING ? _mmPerSec : 0.0f,
+             kStates[(uint8_t)activity], _tool);
+    _seq++;
+    send('F', _seq, fields);
+    _echoSeq = _seq;
+    _echoSentUs = nowUs;
+    _awaitingEcho = true;
+    _lastReportUs = nowUs;
+    _changed = false;
+}
+
+void PrinterHost::handle(char* line, uint64_t nowUs) {
+    PrinterLinkLine msg;
+    if (!parsePrinterLinkLine(line, msg)) {
+        _badLines++;
+        return;
+    }
+    switch (msg.type) {
+    case 'K':
+        if (_awaitingEcho && msg.seq == _echoSeq) {
+            _rttMs.push_back((nowUs - _echoSentUs) / 1000.0);
+            _awaitingEcho = false;
+        }
+        break;
+    case 'H':
+    case 'R': {
+        bool hold = msg.type == 'H';
+        if (hold && !_held) _holds++;
+        // Acknowledge repeats too: our earlier ack may have been lost.
+        send('A', msg.seq, nullptr);
+        if (hold != _held) {
+            _held = hold;
+            _changed = true;
+        }
+        break;
+    }
+    default:
+        _badLines++;
+        break;
+    }
+}
+
+void PrinterHost::send(char type, uint32_t seq, const char* fields) {
+    char buf[40];
+    size_t len = formatPrinterLinkLine(buf, sizeof(buf), type, seq, fields);
+    if (len) _writeBytes(_ctx, buf, len);
+}
+
+// --- Stand-in printer ---
+
+static int readStdin(void*) {
+    unsigned char c;
+    return read(STDIN_FILENO, &c, 1) == 1 ? c : -1;
+}
+
+static size_t writeStdout(void*, const char* data, size_t len) {
+    ssize_t n = write(STDOUT_FILENO, data, len);
+    return n > 0 ? (size_t)n : 0;
+}
+
+static void printRtt(const PrinterHost& host) {
+    Percentiles rtt = percentiles(host.rttMs());
+    fprintf(stderr, "[Printer] %u reports echoed, rtt p50/p99/max %.2f/%.2f/%.2f ms, "
+                    "%u lost, %u holds, %u bad lines\n",
+            rtt.n, rtt.p50, rtt.p99, rtt.max,
+            host.lostEchoes(), host.holds(), host.badLines());
+}
+
+int printerMain(int argc, char** argv) {
+    double seconds = 0;
+    uint32_t seed = 1;
+    uint32_t reportMs = 100;
+    uint8_t tool = 0;
+    for (int i = 0; i < argc; i++) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (!strcmp(arg, "--seconds") && hasValue) {
+            seconds = atof(argv[++i]);
+        } else if (!strcmp(arg, "--seed") && hasValue) {
+            seed = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        } else if (!strcmp(arg, "--report-ms") && hasValue) {
+            reportMs = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        } else if (!strcmp(arg, "--tool") && hasValue) {
+            tool = (uint8_t)atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "printer: unknown option '%s'\n", arg);
+            return 2;
+        }
+    }
+    fcntl(STDIN_FILENO, F_SETFL, fcntl(STDIN_FILENO, F_GETFL) | O_NONBLOCK);
+
+    // The same job shape as the simulator's (SimOptions).
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+    std::exponential_distribution<float> travel(1.0f / 1.5f);
+    std::exponential_distribution<float> extrude(1.0f / 4.0f);
+
+    PrinterHost host;
+    host.begin(readStdin, writeStdout, nullptr, reportMs);
+    auto start = std::chrono::steady_clock::now();
+    uint64_t segmentEndUs = 0;
+    uint64_t nextStatsUs = 10000000;
+    bool held = false;
+    for (;;) {
+        uint64_t nowUs = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        if (seconds > 0 && nowUs >= seconds * 1e6) break;
+        if (nowUs >= segmentEndUs) {
+            if (uniform(rng) < 0.3f) {
+                host.setMotion(PrinterActivity::TRAVEL, 0, tool);
+                segmentEndUs = nowUs + (uint64_t)(travel(rng) * 1e6);
+            } else {
+                host.setMotion(PrinterActivity::EXTRUDING, 1.0f + uniform(rng) * 5.0f, tool);
+                segmentEndUs = nowUs + (uint64_t)(extrude(rng) * 1e6);
+            }
+        }
+        host.poll(nowUs);
+        if (host.held() != held) {
+            held = host.held();
+            fprintf(stderr, "[Printer] %.3f %s\n", nowUs / 1e6, held ? "HOLD" : "release");
+        }
+        if (nowUs >= nextStatsUs) {
+            printRtt(host);
+            nextStatsUs += 10000000;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    printRtt(host);
+    return 0;
+}
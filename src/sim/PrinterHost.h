@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "PrinterLink.h"
+
+// Printer end of the printer link (PrinterLink.h), standing in for the
+// Klipper or Marlin macro: reports what the extruder is commanded to do,
+// honours hold/release and times each report's K echo.
+class PrinterHost {
+public:
+    void begin(CommandShell::ReadByte readByte, PrinterLink::WriteBytes writeBytes, void* ctx,
+               uint32_t reportMs);
+
+    // What the job wants the extruder to do. A change is reported at once,
+    // otherwise every reportMs.
+    void setMotion(PrinterActivity activity, float mmPerSec, uint8_t tool = 0);
+
+    void poll(uint64_t nowUs);
+
+    // The controller asked for a hold and hasn't released it. The printer
+    // reports PAUSED and the caller stops the extruder meanwhile.
+    bool held() const { return _held; }
+    uint32_t holds() const { return _holds; }
+
+    // Report -> echo round trips (ms), and reports never echoed.
+    const std::vector<double>& rttMs() const { return _rttMs; }
+    uint32_t lostEchoes() const { return _lostEchoes; }
+    uint32_t badLines() const { return _badLines; }
+
+private:
+    void report(uint64_t nowUs);
+    void handle(char* line, uint64_t nowUs);
+    void send(char type, uint32_t seq, const char* fields);
+
+    CommandShell::ReadByte _readByte = nullptr;
+    PrinterLink::WriteBytes _writeBytes = nullptr;
+    void* _ctx = nullptr;
+    LineAssembler _line;
+    uint64_t _reportUs = 0;
+
+    PrinterActivity _activity = PrinterActivity::IDLE;
+    float _mmPerSec = 0;
+    uint8_t _tool = 0;
+    bool _changed = true;
+    uint64_t _lastReportUs = 0;
+
+    uint32_t _seq = 0;
+    uint32_t _echoSeq = 0;          // report awaiting its echo
+    uint64_t _echoSentUs = 0;
+    bool _awaitingEcho = false;
+
+    bool _held = false;
+    uint32_t _holds = 0;
+    std::vector<double> _rttMs;
+    uint32_t _lostEchoes = 0;
+    uint32_t _badLines = 0;
+};
+
+// Stand-in printer on stdin/stdout: a synthetic print job's extrusion and
+// travel moves, reported over the link. Wire it to the board's UART with
+// e.g. socat /dev/ttyUSB0,raw,b115200 EXEC:"program printer".
+//
+//   program printer [--seconds S] [--seed N] [--report-ms MS] [--tool N]
+int printerMain(int argc, char** argv);
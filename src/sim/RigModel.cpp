@@ -0,0 +1,175 @@
+#include "RigModel.h"
+
+#include <algorithm>
+#include <cmath>
+
+static constexpr float kDegToRad = 0.01745329252f;
+static constexpr float kRadToDeg = 57.2957795131f;
+static constexpr float kTwoPi = 6.28318530718f;
+
+RigModel::RigModel(const RigParams& p, uint32_t seed)
+    : _p(p), _rng(seed), _noise(0.0f, p.potNoise), _uniform(0.0f, 1.0f) {
+    _pathGain = _p.pathGain * _p.feedArmLength / 1000.0f;
+    _arm = _p.restArmAngle * kDegToRad;
+    _tensionAngle = _tensionTarget = _p.restTensionAngle;
+    _feedTarget = _feedSetpoint = _p.restArmAngle;
+
+    // Solve the spring free length so the arm balances at its rest angle
+    // against the nominal spool drag: spring torque = drag * path gain.
+    _springFree = 0;
+    float perNewton = springTorque(_arm, _tensionAngle * kDegToRad);  // k=1 N/m, L0=0
+    float need = _p.spoolDrag * _pathGain;
+    float ax = _p.pivotSpacing + _p.springAnchorDist * cosf(_arm);
+    float ay = _p.springAnchorDist * sinf(_arm);
+    float bx = _p.tensionArmLength * cosf(_tensionAngle * kDegToRad);
+    float by = _p.tensionArmLength * sinf(_tensionAngle * kDegToRad);
+    float len = hypotf(bx - ax, by - ay) / 1000.0f;
+    // springTorque with L0=0 gives k*L*lever; lever = perNewton / (k*L).
+    float lever = perNewton / (_p.springRate * 1000.0f * len);
+    _springFree = len - need / (_p.springRate * 1000.0f * lever);
+
+    // Start taut at exactly the drag tension.
+    _tension = _p.spoolDrag;
+    _loopRef = _pathGain * _arm - _p.spoolDrag / _p.filamentStiffness;
+}
+
+float RigModel::springTorque(float armRad, float tensionRad) const {
+    // Pivots: tension arm at the origin, feed arm pivotSpacing along +X.
+    float a = _p.springAnchorDist / 1000.0f;
+    float rx = a * cosf(armRad);
+    float ry = a * sinf(armRad);
+    float ax = _p.pivotSpacing / 1000.0f + rx;
+    float ay = ry;
+    float bx = _p.tensionArmLength / 1000.0f * cosf(tensionRad);
+    float by = _p.tensionArmLength / 1000.0f * sinf(tensionRad);
+    float dx = bx - ax;
+    float dy = by - ay;
+    float len = hypotf(dx, dy);
+    if (len <= _springFree || len <= 0) return 0;   // extension spring goes slack
+    float force = _p.springRate * 1000.0f * (len - _springFree);
+    float fx = force * dx / len;
+    float fy = force * dy / len;
+    return rx * fy - ry * fx;
+}
+
+float RigModel::spoolRadius() const {
+    float remaining = 1.0f - (float)(_paid / _p.spoolFilamentM);
+    remaining = std::max(0.0f, remaining);
+    float re = _p.spoolEmptyRadius, rf = _p.spoolFullRadius;
+    return sqrtf(re * re + (rf * rf - re * re) * remaining) / 1000.0f;
+}
+
+void RigModel::setFeedServo(bool attached, float angle) {
+    if (attached && !_feedAttached) {
+        // Servo picks up from wherever the arm is.
+        _feedSetpoint = _arm * kRadToDeg;
+    }
+    _feedAttached = attached;
+    _feedTarget = angle;
+}
+
+void RigModel::jam(float holdN) {
+    _jammed = true;
+    _holdN = holdN;
+    _spoolVel = 0;
+}
+
+float RigModel::feedArmAngle() const {
+    return _arm * kRadToDeg;
+}
+
+void RigModel::step(float dt) {
+    // --- Servos ---
+    float slew = _p.servoSlew * dt;
+    _tensionAngle += std::max(-slew, std::min(slew, _tensionTarget - _tensionAngle));
+
+    float servoTorque = 0;
+    if (_feedAttached) {
+        _feedSetpoint += std::max(-slew, std::min(slew, _feedTarget - _feedSetpoint));
+        float err = _feedSetpoint * kDegToRad - _arm;
+        servoTorque = _p.servoKp * err - _p.servoKd * _armVel;
+        servoTorque = std::max(-_p.servoTorque, std::min(_p.servoTorque, servoTorque));
+    }
+
+    // --- Filament tension from loop stretch ---
+    double available = _loopRef + _paid - _extruded;
+    float stretch = (float)(_pathGain * _arm - available);
+    float extrudeVel = _slipping ? 0.0f : _extruderRate / 1000.0f;
+    float stretchRate = _pathGain * _armVel - (_spoolVel - extrudeVel);
+    _tension = stretch > 0
+        ? std::max(0.0f, _p.filamentStiffness * stretch + _p.filamentDamping * stretchRate)
+        : 0.0f;
+
+    // --- Arm ---
+    float torque = springTorque(_arm, _tensionAngle * kDegToRad) - _tension * _pathGain -
+                   _p.armDamping * _armVel + servoTorque;
+    _armTorque = torque;
+    _armVel += torque / _p.armInertia * dt;
+    _arm += _armVel * dt;
+    float lo = _p.armMinAngle * kDegToRad, hi = _p.armMaxAngle * kDegToRad;
+    if (_arm < lo) { _arm = lo; _armVel = std::max(0.0f, _armVel); }
+    if (_arm > hi) { _arm = hi; _armVel = std::min(0.0f, _armVel); }
+
+    // --- Spool ---
+    if (_jammed && _tension > _holdN) {
+        _jammed = false;
+        _tangleN = 0;
+    }
+    float radius = spoolRadius();
+    if (_jammed) {
+        _spoolVel = 0;
+    } else {
+        // Reel mass stays, filament mass goes with what's been paid out.
+        float remaining = std::max(0.0f, 1.0f - (float)(_paid / _p.spoolFilamentM));
+        float mass = 0.5f * _p.spoolMass * (0.2f + 0.8f * remaining);
+        float dragScale = 1.0f + (_p.spoolEmptyDragScale - 1.0f) * (1.0f - remaining);
+        float drag = _p.spoolDrag * dragScale * (1.0f + _p.spoolWobble * sinf(_spoolPhase));
+        float snag = 0;
+        if (_tangleN > 0) {
+            float c = std::max(0.0f, cosf(_spoolPhase));
+            c *= c;
+            snag = _tangleN * c * c * c * c;      // cos^8: ~60° wide
+        }
+        drag += snag;
+        if (_spoolVel <= 0 && _tension < _p.spoolStaticDrag * dragScale + snag) {
+            _spoolVel = 0;
+        } else {
+            _spoolVel += (_tension - drag) / mass * dt;
+            if (_spoolVel < 0) _spoolVel = 0;   // the spool never rewinds
+        }
+    }
+    _paid += _spoolVel * dt;
+    _spoolPhase = fmodf(_spoolPhase + _spoolVel * dt / radius, kTwoPi);
+
+    // --- Extruder ---
+    _slipping = _tension > _p.extruderGrip;
+    if (!_slipping) {
+        _extruded += _extruderRate / 1000.0f * dt;
+    }
+
+    // --- Guide wheel / reed ---
+    // Filament off the spool turns the wheel; one closure per magnet.
+    _wheelPhase += _spoolVel * dt / (_p.wheelDiameter / 2000.0f) * _p.wheelMagnets;
+    while (_wheelPhase >= kTwoPi) {
+        _wheelPhase -= kTwoPi;
+        if (_edgeCount < 8) _edgeDelaysUs[_edgeCount++] = 0;
+        if (_uniform(_rng) < _p.reedBounceProb && _edgeCount < 8) {
+            _edgeDelaysUs[_edgeCount++] = 100 + (uint32_t)(_uniform(_rng) * 900.0f);
+        }
+    }
+}
+
+bool RigModel::atRest() const {
+    // Torque small enough that a step moves the arm less than 1e-6 rad.
+    return _extruderRate == 0 && _spoolVel == 0 && _tangleN == 0 && !_slipping &&
+           fabsf(_armVel) < 1e-4f && fabsf(_armTorque) < 1e-5f &&
+           _tensionAngle == _tensionTarget &&
+           (!_feedAttached || _feedSetpoint == _feedTarget);
+}
+
+uint32_t RigModel::takeReedEdges(uint32_t* delaysUs, uint32_t max) {
+    uint32_t n = std::min(_edgeCount, max);
+    for (uint32_t i = 0; i < n; i++) delaysUs[i] = _edgeDelaysUs[i];
+    _edgeCount = 0;
+    return n;
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <cstdint>
+#include <random>
+
+// Physical model of the spool -> feed arm -> extruder filament path.
+//
+// Two servo arms pivot 25 mm apart (assembly.scad). An extension spring runs
+// from the feed arm's anchor (35 mm out) to the tension arm tip (50 mm out)
+// and lifts the feed arm. Filament runs off the spool, over the 25 mm guide
+// wheel at the end of the 120 mm feed arm and on to the extruder, so the arm
+// is a dancer: filament tension pulls it down (lower angle), the spring pulls
+// it up. The filament is modelled as a stiff spring so the spool, arm and
+// extruder can be integrated independently with a fixed explicit step.
+//
+// Units are SI internally; angles at the interface are degrees in the same
+// frame as the pots and servos (0-160).
+
+struct RigParams {
+    // --- Geometry (cad/*.scad, mm) ---
+    float feedArmLength = 120.0f;       // feed_arm.scad arm_length
+    float springAnchorDist = 35.0f;     // feed_arm.scad spring_anchor_dist
+    float tensionArmLength = 50.0f;     // tension_arm.scad arm_length
+    float pivotSpacing = 25.0f;         // assembly.scad servo_gap + servo_body_w
+    float wheelDiameter = 25.0f;        // guide_wheel.scad wheel_od
+    uint16_t wheelMagnets = 1;          // reed closures per revolution
+
+    // Filament path length gained per radian of feed arm lift, as a multiple
+    // of arm length (~1.5 for the wrap the base geometry gives).
+    float pathGain = 1.5f;
+
+    // --- Spring ---
+    float springRate = 0.7f;            // N/mm
+    // Free length is solved so the arm rests here at the nominal spool drag.
+    float restArmAngle = 90.0f;
+    float restTensionAngle = 80.0f;
+
+    // --- Arm ---
+    float armInertia = 1.7e-4f;         // kg·m², arm + wheel about the pivot
+    float armDamping = 2.0e-3f;         // N·m·s/rad, pivot + pot friction
+    float armMinAngle = 0.0f;           // hard stops
+    float armMaxAngle = 160.0f;
+
+    // --- Filament ---
+    float filamentStiffness = 1000.0f;  // N/m, filament + tube compliance
+    float filamentDamping = 3.0f;       // N·s/m
+    float extruderGrip = 25.0f;         // N, extruder gears slip above this
+
+    // --- Spool ---
+    float spoolMass = 1.0f;             // kg of filament + reel
+    float spoolFullRadius = 100.0f;     // mm
+    float spoolEmptyRadius = 45.0f;     // mm
+    float spoolFilamentM = 330.0f;      // m on a full 1 kg spool
+    float spoolDrag = 0.6f;             // N at the filament, kinetic
+    float spoolStaticDrag = 0.9f;       // N to break away from rest
+    float spoolWobble = 0.15f;          // drag modulation per revolution (0-1)
+    // Drag (both kinds) on an empty spool relative to a full one. Hub
+    // friction acting at a shrinking radius pulls harder on the filament.
+    float spoolEmptyDragScale = 1.0f;
+
+    // --- Servos (MG996R) ---
+    float servoTorque = 0.9f;           // N·m stall
+    float servoSlew = 350.0f;           // deg/s no-load
+    float servoKp = 5.0f;               // N·m/rad position loop
+    float servoKd = 0.05f;              // N·m·s/rad
+
+    // --- Sensors ---
+    float potNoise = 6.0f;              // ADC counts RMS per conversion
+    // ADC nonlinearity: readings sag below a straight line by up to this
+    // many counts mid-scale, none at the rails.
+    float potAdcBow = 0.0f;
+    float reedBounceProb = 0.2f;        // chance a closure chatters
+};
+
+class RigModel {
+public:
+    explicit RigModel(const RigParams& p = RigParams(), uint32_t seed = 1);
+
+    // Advance the model by dt seconds.
+    void step(float dt);
+
+    // --- Inputs ---
+    void setExtruderRate(float mmPerSec) { _extruderRate = mmPerSec; }
+
+    // Feed servo: attached = position-controlled, detached = arm floats.
+    void setFeedServo(bool attached, float angle);
+    void setTensionServo(float angle) { _tensionTarget = angle; }
+
+    // Snag the filament on the spool. It stays stuck until the filament
+    // tension exceeds holdN.
+    void jam(float holdN);
+    bool jammed() const { return _jammed; }
+
+    // A tangle: a crossed wrap that adds catchN of drag once a revolution,
+    // over about a sixth of it. Cleared when a snag on it pulls free.
+    void setTangle(float catchN) { _tangleN = catchN; }
+    float tangle() const { return _tangleN; }
+
+    // --- Outputs ---
+    float feedArmAngle() const;         // degrees
+    float tensionArmAngle() const { return _tensionAngle; }
+    float filamentTension() const { return _tension; }      // N
+    double paidOut() const { return _paid; }                // m off the spool
+    float spoolFeedRate() const { return _spoolVel * 1000.0f; }  // mm/s
+    double extrudedMm() const { return _extruded * 1000.0; }
+    bool extruderSlipping() const { return _slipping; }
+
+    // Reed closures since the last call. Each closure may chatter: bounce
+    // edges are returned as delays (µs) after the step they belong to.
+    uint32_t takeReedEdges(uint32_t* delaysUs, uint32_t max);
+
+    // One sample of pot conversion noise (ADC counts).
+    float potNoise() { return _noise(_rng); }
+    void setPotNoise(float rms) { _noise = std::normal_distribution<float>(0.0f, rms); }
+
+    // Nothing moving and nothing driving it: step() would leave the state
+    // as it is, so a caller may skip it.
+    bool atRest() const;
+
+    const RigParams& params() const { return _p; }
+
+private:
+    float springTorque(float armRad, float tensionRad) const;
+    float spoolRadius() const;
+
+    RigParams _p;
+    std::mt19937 _rng;
+    std::normal_distribution<float> _noise;
+    std::uniform_real_distribution<float> _uniform;
+
+    // Derived.
+    float _springFree = 0;      // m
+    float _pathGain = 0;        // m/rad
+
+    // State.
+    float _arm = 0;             // rad
+    float _armVel = 0;          // rad/s
+    float _tensionAngle = 80;   // deg (servo held)
+    float _tensionTarget = 80;
+    bool _feedAttached = false;
+    float _feedTarget = 90;     // deg
+    float _feedSetpoint = 90;   // deg, slew-limited
+
+    double _paid = 0;           // m off the spool
+    double _extruded = 0;       // m into the extruder
+    float _spoolVel = 0;        // m/s
+    float _spoolPhase = 0;      // rad
+    float _tension = 0;         // N
+    float _extruderRate = 0;    // mm/s
+    bool _slipping = false;
+    float _armTorque = 0;       // N·m, net, last step
+    double _loopRef = 0;        // m, path length at zero stretch
+
+    bool _jammed = false;
+    float _holdN = 0;
+    float _tangleN = 0;
+
+    float _wheelPhase = 0;      // rad
+    uint32_t _edgeCount = 0;
+    uint32_t _edgeDelaysUs[8] = {};
+};
@@ -0,0 +1,152 @@
+#include "SimHal.h"
+
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+
+bool simLogEnabled = true;
+
+// --- Pots ---
+
+bool SimPotInput::begin(const uint8_t* pins, uint8_t count, uint32_t sampleRateHz,
+                        uint8_t window) {
+    (void)sampleRateHz;
+    _count = count > 2 ? 2 : count;
+    for (uint8_t i = 0; i < _count; i++) _pins[i] = pins[i];
+    setWindow(window);
+    return true;
+}
+
+int SimPotInput::channelIndex(uint8_t pin) const {
+    for (uint8_t i = 0; i < _count; i++) {
+        if (_pins[i] == pin) return i;
+    }
+    return -1;
+}
+
+float SimPotInput::counts(float angle) const {
+    float adc = _adcMin + angle / 160.0f * (_adcMax - _adcMin);
+    float x = adc / 4095.0f;
+    return adc - 4.0f * _rig.params().potAdcBow * x * (1.0f - x);
+}
+
+uint16_t SimPotInput::read(uint8_t ch) {
+    float angle = ch == 0 ? _rig.feedArmAngle() : _rig.tensionArmAngle();
+    float adc = counts(angle);
+    // Averaging the window shrinks conversion noise by sqrt(window).
+    adc += _rig.potNoise() / sqrtf((float)_window);
+    if (adc < 0) adc = 0;
+    if (adc > 4095) adc = 4095;
+    _last[ch] = (uint16_t)lroundf(adc);
+    return _last[ch];
+}
+
+bool ReplayPotInput::begin(const uint8_t* pins, uint8_t count, uint32_t sampleRateHz,
+                           uint8_t window) {
+    (void)sampleRateHz;
+    (void)window;
+    _count = count > 2 ? 2 : count;
+    for (uint8_t i = 0; i < _count; i++) _pins[i] = pins[i];
+    return true;
+}
+
+int ReplayPotInput::channelIndex(uint8_t pin) const {
+    for (uint8_t i = 0; i < _count; i++) {
+        if (_pins[i] == pin) return i;
+    }
+    return -1;
+}
+
+// --- Servo ---
+
+bool SimServoOutput::attach(uint8_t pin, uint16_t minUs, uint16_t maxUs) {
+    (void)pin;
+    (void)minUs;
+    (void)maxUs;
+    _attached = true;
+    return true;
+}
+
+// --- Edge interrupts ---
+
+bool SimEdgeInput::attachFalling(uint8_t pin, bool pullup, EdgeCallback cb, void* arg) {
+    (void)pullup;
+    if (_count >= kMaxPins) return false;
+    _slots[_count++] = { pin, cb, arg };
+    return true;
+}
+
+bool SimEdgeInput::attachChange(uint8_t pin, bool pullup, EdgeCallback cb, void* arg) {
+    return attachFalling(pin, pullup, cb, arg);
+}
+
+bool SimEdgeInput::level(uint8_t pin) {
+    return !(_low >> pin & 1);
+}
+
+void SimEdgeInput::setLevel(uint8_t pin, bool high) {
+    if (high) _low &= ~(1ull << pin);
+    else _low |= 1ull << pin;
+}
+
+void SimEdgeInput::fire(uint8_t pin, uint64_t nowUs) {
+    for (uint8_t i = 0; i < _count; i++) {
+        if (_slots[i].pin == pin) _slots[i].cb(_slots[i].arg, nowUs);
+    }
+}
+
+// --- Serial line ---
+
+void SimUart::begin(SimClock* clock, uint32_t baud, uint32_t latencyUs) {
+    _clock = clock;
+    _byteUs = baud ? 10000000 / baud : 0;     // 8N1: ten bit times per byte
+    _latencyUs = latencyUs;
+}
+
+int SimUart::readA(void* uart) {
+    SimUart* u = static_cast<SimUart*>(uart);
+    return u->read(u->_bToA);
+}
+
+size_t SimUart::writeA(void* uart, const char* data, size_t len) {
+    SimUart* u = static_cast<SimUart*>(uart);
+    return u->write(u->_aToB, data, len);
+}
+
+int SimUart::readB(void* uart) {
+    SimUart* u = static_cast<SimUart*>(uart);
+    return u->read(u->_aToB);
+}
+
+size_t SimUart::writeB(void* uart, const char* data, size_t len) {
+    SimUart* u = static_cast<SimUart*>(uart);
+    return u->write(u->_bToA, data, len);
+}
+
+int SimUart::read(Direction& d) {
+    if (d.bytes.empty() || d.bytes.front().first > _clock->micros()) return -1;
+    uint8_t c = d.bytes.front().second;
+    d.bytes.pop_front();
+    return c;
+}
+
+size_t SimUart::write(Direction& d, const char* data, size_t len) {
+    uint64_t at = _clock->micros() + _latencyUs;
+    for (size_t i = 0; i < len; i++) {
+        // Bytes queue behind each other on the wire.
+        at = at > d.lastUs + _byteUs ? at : d.lastUs + _byteUs;
+        d.bytes.emplace_back(at, (uint8_t)data[i]);
+        d.lastUs = at;
+    }
+    return len;
+}
+
+// --- Logging ---
+
+void logPrintf(const char* fmt, ...) {
+    if (!simLogEnabled) return;
+    va_list args;
+    va_start(args, fmt);
+    vprintf(fmt, args);
+    va_end(args);
+}
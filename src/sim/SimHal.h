@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <utility>
+#include "Hal.h"
+#include "RigModel.h"
+
+// Simulator implementations of the hardware interfaces in Hal.h.
+// Time only moves when the sim advances it, so hours of printing run in
+// seconds and every run with the same seed is identical.
+
+class SimClock : public Clock {
+public:
+    uint32_t millis() override { return (uint32_t)(_nowUs / 1000); }
+    uint64_t micros() override { return _nowUs; }
+    void delayMs(uint32_t ms) override { _nowUs += (uint64_t)ms * 1000; }
+
+    void advanceUs(uint64_t us) { _nowUs += us; }
+    void setUs(uint64_t us) { _nowUs = us; }
+
+private:
+    uint64_t _nowUs = 0;
+};
+
+// Pots read straight off the model: feed arm on channel 0, tension arm on
+// channel 1, mapped through the same ADC endpoints the firmware is told about.
+class SimPotInput : public PotInput {
+public:
+    SimPotInput(RigModel& rig, uint16_t adcMin, uint16_t adcMax)
+        : _rig(rig), _adcMin(adcMin), _adcMax(adcMax) {}
+
+    bool begin(const uint8_t* pins, uint8_t count, uint32_t sampleRateHz,
+               uint8_t window) override;
+    int channelIndex(uint8_t pin) const override;
+    uint16_t read(uint8_t ch) override;
+    void setWindow(uint8_t window) override { _window = window ? window : 1; }
+
+    // What the controller was last handed on a channel (for trace recording).
+    uint16_t lastRead(uint8_t ch) const { return _last[ch]; }
+
+    // Noise-free reading for an arm angle, ADC bow included.
+    float counts(float angle) const;
+
+private:
+    RigModel& _rig;
+    uint16_t _adcMin;
+    uint16_t _adcMax;
+    uint8_t _pins[2] = {};
+    uint8_t _count = 0;
+    uint8_t _window = 1;
+    uint16_t _last[2] = {};
+};
+
+// Pots that read back whatever was last set — for replaying recorded traces.
+class ReplayPotInput : public PotInput {
+public:
+    bool begin(const uint8_t* pins, uint8_t count, uint32_t sampleRateHz,
+               uint8_t window) override;
+    int channelIndex(uint8_t pin) const override;
+    uint16_t read(uint8_t ch) override { return _value[ch]; }
+    void setWindow(uint8_t window) override { (void)window; }
+
+    void set(uint8_t ch, uint16_t value) { _value[ch] = value; }
+
+private:
+    uint8_t _pins[2] = {};
+    uint8_t _count = 0;
+    uint16_t _value[2] = {};
+};
+
+// Records what the controller commands; the sim forwards it to the model.
+class SimServoOutput : public ServoOutput {
+public:
+    bool attach(uint8_t pin, uint16_t minUs, uint16_t maxUs) override;
+    void detach() override { _attached = false; }
+    bool attached() const override { return _attached; }
+    void write(float angle) override { _angle = angle; }
+
+    float angle() const { return _angle; }
+
+private:
+    bool _attached = false;
+    float _angle = 90;
+};
+
+// Holds edge callbacks; the sim fires them at simulated edge times.
+class SimEdgeInput : public EdgeInput {
+public:
+    static constexpr uint8_t kMaxPins = 8;
+
+    bool attachFalling(uint8_t pin, bool pullup, EdgeCallback cb, void* arg) override;
+    bool attachChange(uint8_t pin, bool pullup, EdgeCallback cb, void* arg) override;
+    // Pins read high (pulled up) unless set.
+    bool level(uint8_t pin) override;
+    void setLevel(uint8_t pin, bool high);
+    void fire(uint8_t pin, uint64_t nowUs);
+
+private:
+    struct Slot {
+        uint8_t pin;
+        EdgeCallback cb;
+        void* arg;
+    };
+    Slot _slots[kMaxPins] = {};
+    uint8_t _count = 0;
+    uint64_t _low = 0;      // pins held low, one bit each
+};
+
+// A serial line between two ends, A and B. Each end reads what the other
+// wrote latencyUs later, and no faster than the baud rate carries it. The
+// static read/write hooks take the SimUart as their context, matching
+// CommandShell::ReadByte and PrinterLink::WriteBytes.
+class SimUart {
+public:
+    void begin(SimClock* clock, uint32_t baud, uint32_t latencyUs);
+
+    static int readA(void* uart);
+    static size_t writeA(void* uart, const char* data, size_t len);
+    static int readB(void* uart);
+    static size_t writeB(void* uart, const char* data, size_t len);
+
+private:
+    struct Direction {
+        std::deque<std::pair<uint64_t, uint8_t>> bytes;    // arrival time, byte
+        uint64_t lastUs = 0;                               // last byte's arrival
+    };
+
+    int read(Direction& d);
+    size_t write(Direction& d, const char* data, size_t len);
+
+    SimClock* _clock = nullptr;
+    uint32_t _byteUs = 0;
+    uint32_t _latencyUs = 0;
+    Direction _aToB;
+    Direction _bToA;
+};
+
+// Whether logPrintf output reaches stdout.
+extern bool simLogEnabled;
@@ -0,0 +1,363 @@
+#include "Simulation.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include "Profiler.h"
+
+Simulation::Simulation(const Config& cfg, const RigParams& rig, const SimOptions& opt)
+    : _cfg(cfg), _opt(opt), _rng(opt.seed), _rig(rig, opt.seed * 7919u + 1),
+      _pots(_rig, cfg.potFeedMin, cfg.potFeedMax) {
+    _clock.setUs(opt.startUs);
+    _reed.begin(kSimPinReed, _gpio, _clock);
+    FeedArmIo io = { &_clock, &_pots, &_feedServo, &_tensionServo };
+    _arm.setEventSink(&_events);
+    _arm.begin(_cfg, io, kSimPinFeedServo, kSimPinTensionServo, kSimPinFeedPot,
+               kSimPinTensionPot, &_reed);
+    _rig.setTensionServo(_tensionServo.angle());
+    _idle.configure(_cfg);
+    _nextTickUs = _clock.micros();
+
+    if (_opt.printerLink) {
+        _uart.begin(&_clock, _opt.linkBaud, (uint32_t)(_opt.linkLatencyMs * 1000.0f));
+        _link.begin(_cfg, SimUart::readA, SimUart::writeA, &_uart);
+        _host.begin(SimUart::readB, SimUart::writeB, &_uart, _opt.linkReportMs);
+    }
+}
+
+void Simulation::run() {
+    auto wallStart = std::chrono::steady_clock::now();
+    uint64_t endUs = _clock.micros() + (uint64_t)(_opt.hours * 3600.0 * 1e6);
+    while (_clock.micros() < endUs) {
+        step();
+    }
+    finish();
+    _stats.wallSeconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - wallStart).count();
+}
+
+void Simulation::step() {
+    uint64_t stepUs = (uint64_t)_opt.stepUs;
+    bool coast = _opt.coastIdle && !printing() && !_opt.printerLink &&
+                 _pendingEdgesUs.empty() && _rig.atRest();
+    if (coast && _nextTickUs > _clock.micros() + stepUs) stepUs = _nextTickUs - _clock.micros();
+    float dt = stepUs * 1e-6f;
+
+    updateJob(dt);
+    maybeInjectJam(dt);
+    if (_opt.printerLink) {
+        // The printer reports the job and stops the extruder while held.
+        PrinterActivity activity = !printing() ? PrinterActivity::IDLE
+                                 : _jobRate > 0 ? PrinterActivity::EXTRUDING
+                                 : PrinterActivity::TRAVEL;
+        _host.setMotion(activity, _jobRate);
+        _host.poll(_clock.micros());
+        _link.poll((uint32_t)_clock.micros());
+        _rig.setExtruderRate(_host.held() ? 0.0f : _jobRate);
+    }
+
+    if (!coast) _rig.step(dt);
+    _clock.advanceUs(stepUs);
+    _stats.simSeconds += dt;
+    if (_rig.extruderSlipping()) _stats.slipSeconds += dt;
+
+    pumpReedEdges();
+
+    // A snag the extruder (or an unstick) pulled free.
+    if (_score.jamOpen() && !_rig.jammed()) {
+        _score.jamEnded(_clock.micros());
+    }
+
+    if (_clock.micros() >= _nextTickUs) {
+        controlTick();
+        _nextTickUs += (uint64_t)_idle.tickMs() * 1000;
+    }
+}
+
+void Simulation::finish() {
+    _score.finish(_clock.micros());
+}
+
+bool Simulation::printing() const {
+    return _opt.printMeanS <= 0 || _printing;
+}
+
+void Simulation::updateJob(float dt) {
+    if (_opt.printMeanS > 0) {
+        _phaseLeftS -= dt;
+        if (_phaseLeftS <= 0) {
+            _printing = !_printing;
+            std::exponential_distribution<float> length(
+                1.0f / (_printing ? _opt.printMeanS : _opt.idleGapMeanS));
+            _phaseLeftS = length(_rng);
+            if (_printing) {
+                _segmentLeftS = 0;
+                if (_jamUnscored) {
+                    _score.jamStarted(_clock.micros());
+                    _jamUnscored = false;
+                }
+            } else {
+                _jobRate = 0;
+                _rig.setExtruderRate(0);
+            }
+        }
+        if (!_printing) {
+            _stats.gapSeconds += dt;
+            return;
+        }
+    }
+
+    _segmentLeftS -= dt;
+    if (_segmentLeftS > 0) return;
+
+    std::exponential_distribution<float> travel(1.0f / _opt.travelMeanS);
+    std::exponential_distribution<float> extrude(1.0f / _opt.extrudeMeanS);
+    if (_uniform(_rng) < _opt.travelFraction) {
+        _jobRate = 0;
+        _segmentLeftS = travel(_rng);
+    } else {
+        _jobRate = _opt.extrudeMinMmS +
+                   _uniform(_rng) * (_opt.extrudeMaxMmS - _opt.extrudeMinMmS);
+        _segmentLeftS = extrude(_rng);
+    }
+    _rig.setExtruderRate(_jobRate);
+}
+
+void Simulation::maybeInjectJam(float dt) {
+    if (_tangleLeftS > 0) {
+        // The catch grows until the wrap locks.
+        _tangleLeftS -= dt;
+        if (_tangleLeftS > 0) {
+            _rig.setTangle(_opt.tangleCatchN * (1.0f - _tangleLeftS / _opt.tangleLeadS));
+            return;
+        }
+        _rig.jam(_tangleHoldN);
+        _score.jamStarted(_clock.micros());
+        if (_tangleWarned) {
+            _stats.tanglesWarned++;
+            _stats.warnLeadS.push_back((_clock.micros() - _tangleWarnUs) / 1e6);
+        }
+        if (_opt.verbose) {
+            printf("%10.3f [Sim] Tangle locked, holds to %.1f N\n", _clock.micros() / 1e6,
+                   _tangleHoldN);
+        }
+        return;
+    }
+    if (_score.jamOpen() || _jamUnscored || _arm.state() != FeedArmState::MONITORING) return;
+    if (_uniform(_rng) >= _opt.jamsPerHour * dt / 3600.0f) return;
+
+    float hold = _opt.jamHoldMinN + _uniform(_rng) * (_opt.jamHoldMaxN - _opt.jamHoldMinN);
+    if (!printing()) {
+        // Nothing pulls on it until the next print starts.
+        if (_opt.tangleLeadS > 0) return;
+        _rig.jam(hold);
+        _jamUnscored = true;
+        if (_opt.verbose) {
+            printf("%10.3f [Sim] Spool snagged between prints, holds to %.1f N\n",
+                   _clock.micros() / 1e6, hold);
+        }
+        return;
+    }
+    if (_opt.tangleLeadS > 0) {
+        _tangleLeftS = _opt.tangleLeadS;
+        _tangleHoldN = hold;
+        _tangleWarned = false;
+        _stats.tangles++;
+        if (_opt.verbose) printf("%10.3f [Sim] Spool tangling\n", _clock.micros() / 1e6);
+        return;
+    }
+    _rig.jam(hold);
+    _score.jamStarted(_clock.micros());
+    if (_opt.verbose) {
+        printf("%10.3f [Sim] Spool snag, holds to %.1f N\n", _clock.micros() / 1e6, hold);
+    }
+}
+
+void Simulation::pumpReedEdges() {
+    uint32_t delays[8];
+    uint32_t n = _rig.takeReedEdges(delays, 8);
+    uint64_t now = _clock.micros();
+    for (uint32_t i = 0; i < n; i++) {
+        _pendingEdgesUs.push_back(now + delays[i]);
+    }
+    if (_pendingEdgesUs.empty()) return;
+
+    std::sort(_pendingEdgesUs.begin(), _pendingEdgesUs.end());
+    size_t fired = 0;
+    while (fired < _pendingEdgesUs.size() && _pendingEdgesUs[fired] <= now) {
+        _gpio.fire(kSimPinReed, _pendingEdgesUs[fired]);
+        if (_trace) {
+            _trace->write({ _pendingEdgesUs[fired], _pots.lastRead(0), _pots.lastRead(1),
+                            true, _score.jamOpen() });
+        }
+        fired++;
+    }
+    _pendingEdgesUs.erase(_pendingEdgesUs.begin(), _pendingEdgesUs.begin() + fired);
+
+    // The reed pin wakes an idle board: tick now rather than at the next
+    // idle tick.
+    if (fired && _idle.idle()) {
+        _idle.wake(WakeReason::REED, _clock.millis());
+        _nextTickUs = now;
+    }
+}
+
+void Simulation::controlTick() {
+    if (_opt.printerLink) _arm.setPrinterFeed(_link.feedFor(0, (uint32_t)_clock.micros()));
+    if (_opt.timeTicks) {
+        auto t0 = std::chrono::steady_clock::now();
+        _arm.update();
+        auto t1 = std::chrono::steady_clock::now();
+        _score.tickCost((uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+    } else {
+        _arm.update();
+    }
+
+    if (_trace) {
+        _trace->write({ _clock.micros(), _pots.lastRead(0), _pots.lastRead(1), false,
+                        _score.jamOpen() });
+    }
+
+    _rig.setFeedServo(_feedServo.attached(), _feedServo.angle());
+    _rig.setTensionServo(_tensionServo.angle());
+    _stats.ticks++;
+
+    if (_cfg.lowPower) {
+        IdleInput in = { _arm.state(), _reed.pulseCount(), _arm.feedArmAngle(),
+                         _opt.printerLink ? _link.feedFor(0, (uint32_t)_clock.micros()).activity
+                                          : PrinterActivity::UNKNOWN };
+        _idle.update(_clock.millis(), &in, 1);
+    }
+
+    FeedArmEvent ev;
+    if (_idle.takeEvent(ev)) _events.push(ev);
+    while (_events.pop(ev)) {
+        handleEvent(ev);
+    }
+
+    if (_journal) {
+        float used = _arm.filamentUsedMm();
+        _journal->addFilament(0, used - _journalUsedMm);
+        _journalUsedMm = used;
+        // Between prints only, as on the board.
+        bool quiet = _idle.idle() || _reed.timeSinceLastPulseMs() >= _cfg.odometerPrintGapMs;
+        if (_arm.state() == FeedArmState::MONITORING && !_jamTracker.open(0) && quiet) {
+            _journal->flush();
+        }
+    }
+}
+
+void Simulation::handleEvent(const FeedArmEvent& ev) {
+    if (_opt.verbose) {
+        char line[96];
+        formatFeedArmEvent(ev, line, sizeof(line));
+        printf("%10.3f %s\n", _clock.micros() / 1e6, line);
+    }
+
+    _score.event(ev, _clock.micros());
+    if (ev.type == FeedArmEventType::SPOOL_WOBBLE) {
+        _stats.wobbleWarnings++;
+        if (_tangleLeftS > 0 && !_tangleWarned) {
+            _tangleWarned = true;
+            _tangleWarnUs = _clock.micros();
+        }
+    }
+    if (_opt.printerLink) _link.onEvent(ev, (uint32_t)_clock.micros());
+    if (_journal) {
+        // Uptime from the 64-bit clock: millis() wraps after 49.7 days.
+        JamContext ctx = { (uint32_t)(_clock.micros() / 1000000), _arm.feedArmAngle(),
+                           _arm.tensionAngle(), _arm.printCount(), _arm.printUsedMm() };
+        JamRecord jam;
+        if (_jamTracker.onEvent(ev, ctx, jam)) _journal->record(jam);
+    }
+    if (_eventHook) _eventHook(_eventCtx, ev);
+}
+
+void Simulation::printSummary() const {
+    const SimStats& s = _stats;
+    const DetectionScorer& d = _score;
+    double hours = s.simSeconds / 3600.0;
+    printf("=== Simulation: %.2f h in %.2f s (%.0fx real time) ===\n",
+           hours, s.wallSeconds, s.wallSeconds > 0 ? s.simSeconds / s.wallSeconds : 0.0);
+    printf("  Extruded:           %.1f m\n", _rig.extrudedMm() / 1000.0);
+    printf("  Jams injected:      %u\n", d.jams());
+    printf("  Detected:           %u", d.detected());
+    if (d.detected()) {
+        Percentiles lat = percentiles(d.latencyMs());
+        printf(" (latency p50 %.2f s, max %.2f s)", lat.p50 / 1000.0, lat.max / 1000.0);
+    }
+    printf("\n");
+    printf("  Self-cleared:       %u\n", d.undetected());
+    printf("  Cleared by unstick: %u", d.cleared());
+    if (d.cleared()) {
+        printf(" (onset to clear p50 %.2f s)", percentiles(d.clearMs()).p50 / 1000.0);
+    }
+    printf("\n");
+    printf("  Re-detections:      %u\n", d.redetections());
+    printf("  False detections:   %u (%.2f per hour)\n", d.falsePositives(),
+           hours > 0 ? d.falsePositives() / hours : 0.0);
+    printf("  Unstick cycles:     %u\n", d.unstickCycles());
+    const UnstickLadder& ladder = _arm.unstickLadder();
+    printf("  Unstick ladder:     %u jams, %u cleared, %u exhausted\n",
+           ladder.jams(), ladder.cleared(), ladder.exhausted());
+    for (uint8_t i = 0; i < _cfg.unstickStages && i < kMaxUnstickStages; i++) {
+        const UnstickStageStats& st = ladder.stats(i);
+        printf("    stage %u (%3.0f°): %4u attempts, %4u cleared (%.0f%%)\n", i + 1,
+               _cfg.unstickLadder[i].angle, st.attempts, st.successes,
+               ladder.successRate(i) * 100.0f);
+    }
+    printf("  Extruder slipping:  %.1f s\n", s.slipSeconds);
+    printf("  Wobble warnings:    %u", s.wobbleWarnings);
+    if (s.tangles) printf(" (%u of %u tangles warned before locking)", s.tanglesWarned, s.tangles);
+    printf("\n");
+    if (_opt.printMeanS > 0) {
+        printf("  Between prints:     %.2f h\n", s.gapSeconds / 3600.0);
+    }
+    if (_cfg.lowPower) {
+        const WakeStats& w = _idle.stats();
+        printf("  Low power:          idle %.1f%% of the time, %u ticks (%.0f/h), wakes:",
+               s.simSeconds > 0 ? w.idleMs / 10.0 / s.simSeconds : 0.0, s.ticks,
+               hours > 0 ? s.ticks / hours : 0.0);
+        for (uint8_t r = 1; r < (uint8_t)WakeReason::COUNT; r++) {
+            printf(" %s %u", wakeReasonName((WakeReason)r), w.wakes[r]);
+        }
+        printf("\n");
+    }
+#ifdef FFX_PROFILE
+    // Only the controller's own scopes run in the sim; host ns, not cycles.
+    char line[96];
+    printf("  Profile:\n    %s\n", kProfileHeader);
+    for (ProfileScope scope : { ProfileScope::ARM_UPDATE, ProfileScope::POT_READ,
+                                ProfileScope::SPECTRUM }) {
+        formatProfileLine(scope, profiler.stats(scope), line, sizeof(line));
+        printf("    %s\n", line);
+    }
+#endif
+}
+
+bool parseDetector(const char* name, JamDetectorType& out) {
+    if (!strcmp(name, "threshold")) {
+        out = JamDetectorType::THRESHOLD;
+    } else if (!strcmp(name, "trajectory")) {
+        out = JamDetectorType::TRAJECTORY;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool parseSignalFilter(const char* name, SignalFilterType& out) {
+    static const SignalFilterType kTypes[] = {
+        SignalFilterType::NONE, SignalFilterType::MEDIAN, SignalFilterType::IIR,
+        SignalFilterType::MEDIAN_AVERAGE, SignalFilterType::HAMPEL_IIR
+    };
+    for (SignalFilterType t : kTypes) {
+        if (!strcmp(name, signalFilterName(t))) {
+            out = t;
+            return true;
+        }
+    }
+    return false;
+}
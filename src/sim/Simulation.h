@@ -0,0 +1,188 @@
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "Config.h"
+#include "DetectionScorer.h"
+#include "FeedArmController.h"
+#include "IdleMonitor.h"
+#include "JamJournal.h"
+#include "PrinterHost.h"
+#include "PrinterLink.h"
+#include "RigModel.h"
+#include "SimHal.h"
+#include "Trace.h"
+#include "WheelEncoder.h"
+
+// Closed-loop simulation: the real FeedArmController and ReedSwitch running
+// against RigModel on a virtual clock, with a synthetic print job and
+// randomly injected spool snags.
+
+struct SimOptions {
+    double hours = 8.0;             // simulated printing time
+    uint32_t seed = 1;
+    float stepUs = 500;             // physics step
+    uint64_t startUs = 0;           // uptime at boot (Clock::micros())
+    // Between prints, once the rig has settled, skip the physics and jump
+    // to the next control tick. Makes idle time nearly free.
+    bool coastIdle = false;
+    // Time every control tick for the cost percentiles. Four bytes a tick,
+    // so weeks-long runs turn it off.
+    bool timeTicks = true;
+
+    // Print job: alternating extrusion and travel segments.
+    float extrudeMinMmS = 1.0f;
+    float extrudeMaxMmS = 6.0f;
+    float extrudeMeanS = 4.0f;
+    float travelMeanS = 1.5f;
+    float travelFraction = 0.3f;
+
+    // Separate prints: with printMeanS set, prints of that mean length
+    // alternate with idle gaps. A snag that forms in a gap sits until the
+    // next print pulls on it, and is scored from then.
+    float printMeanS = 0.0f;
+    float idleGapMeanS = 1800.0f;
+
+    // Spool snags (Poisson), each holding until filament tension exceeds
+    // a strength drawn from [jamHoldMinN, jamHoldMaxN].
+    float jamsPerHour = 1.0f;
+    float jamHoldMinN = 4.5f;
+    float jamHoldMaxN = 12.0f;
+
+    // Tangles: with a lead time set, each snag starts as a crossed wrap
+    // whose once-a-revolution catch grows to tangleCatchN over tangleLeadS
+    // before it locks up. Scored from the lock-up, like any snag.
+    float tangleLeadS = 0.0f;
+    float tangleCatchN = 1.0f;
+
+    // Printer link (PrinterLink.h): the job is reported over a simulated
+    // UART, and the extruder stops while the controller holds it.
+    bool printerLink = false;
+    uint32_t linkBaud = 115200;
+    float linkLatencyMs = 2.0f;     // one way, on top of the byte times
+    uint32_t linkReportMs = 100;
+
+    bool verbose = false;           // print controller events
+};
+
+struct SimStats {
+    double simSeconds = 0;
+    double wallSeconds = 0;
+    double slipSeconds = 0;         // extruder gears slipping (starved)
+
+    // Spectrum warnings (SPOOL_WOBBLE): all of them, tangles that got one
+    // before locking up, and how long before.
+    uint32_t wobbleWarnings = 0;
+    uint32_t tangles = 0;
+    uint32_t tanglesWarned = 0;
+    std::vector<double> warnLeadS;
+
+    double gapSeconds = 0;          // between prints
+    uint32_t ticks = 0;             // control ticks run
+};
+
+// Command-line names -> config enums.
+bool parseDetector(const char* name, JamDetectorType& out);     // threshold, trajectory
+bool parseSignalFilter(const char* name, SignalFilterType& out); // signalFilterName()
+
+class Simulation {
+public:
+    Simulation(const Config& cfg, const RigParams& rig, const SimOptions& opt);
+
+    // Run for opt.hours of simulated time.
+    void run();
+
+    // Advance one physics step (and a control tick when one is due).
+    void step();
+
+    // Close out scoring after driving step() directly.
+    void finish();
+
+    const SimStats& stats() const { return _stats; }
+    const DetectionScorer& score() const { return _score; }
+    void printSummary() const;
+
+    // Record every pot sample the controller sees and every reed edge,
+    // labelled with the injected snags, for later replay.
+    void recordTo(TraceWriter* trace) { _trace = trace; }
+
+    // Journal every jam as the board does (JamJournal.h), flushing between
+    // jams. The caller owns the journal and its storage.
+    void journalTo(JamJournal* journal) { _journal = journal; }
+
+    // Called with every controller event, after the sim has scored it.
+    using EventHook = void (*)(void* ctx, const FeedArmEvent& ev);
+    void watchEvents(EventHook hook, void* ctx) {
+        _eventHook = hook;
+        _eventCtx = ctx;
+    }
+
+    RigModel& rig() { return _rig; }
+    SimPotInput& pots() { return _pots; }
+    SimClock& clock() { return _clock; }
+    FeedArmController& controller() { return _arm; }
+    const PrinterLink& printerLink() const { return _link; }
+    const PrinterHost& printerHost() const { return _host; }
+    const IdleMonitor& idleMonitor() const { return _idle; }
+
+private:
+    bool printing() const;
+    void updateJob(float dt);
+    void maybeInjectJam(float dt);
+    void pumpReedEdges();
+    void controlTick();
+    void handleEvent(const FeedArmEvent& ev);
+
+    Config _cfg;
+    SimOptions _opt;
+    std::mt19937 _rng;
+    std::uniform_real_distribution<float> _uniform{0.0f, 1.0f};
+
+    RigModel _rig;
+    SimClock _clock;
+    SimPotInput _pots;
+    SimServoOutput _feedServo;
+    SimServoOutput _tensionServo;
+    SimEdgeInput _gpio;
+    ReedSwitch _reed;
+    FeedArmController _arm;
+    FeedArmEventRing _events;
+
+    uint64_t _nextTickUs = 0;
+    std::vector<uint64_t> _pendingEdgesUs;
+
+    float _tangleLeftS = 0;         // > 0: a tangle growing toward a snag
+    float _tangleHoldN = 0;
+    bool _tangleWarned = false;
+    uint64_t _tangleWarnUs = 0;
+
+    float _segmentLeftS = 0;
+    float _jobRate = 0;             // what the job commands, held or not
+    bool _printing = false;         // with print gaps
+    double _phaseLeftS = 0;         // double: 0.5 ms steps vanish in a float past ~4.5 h
+    bool _jamUnscored = false;      // snagged in a gap, waiting for a print
+
+    IdleMonitor _idle;              // Config::lowPower
+
+    SimUart _uart;                  // A = controller, B = printer
+    PrinterLink _link;
+    PrinterHost _host;
+
+    DetectionScorer _score;
+    TraceWriter* _trace = nullptr;
+    JamJournal* _journal = nullptr;
+    JamTracker _jamTracker;
+    float _journalUsedMm = 0;
+    EventHook _eventHook = nullptr;
+    void* _eventCtx = nullptr;
+
+    SimStats _stats;
+};
+
+// Pins the sim wires up; values only need to be distinct.
+static constexpr uint8_t kSimPinFeedServo = 13;
+static constexpr uint8_t kSimPinTensionServo = 14;
+static constexpr uint8_t kSimPinFeedPot = 6;
+static constexpr uint8_t kSimPinTensionPot = 7;
+static constexpr uint8_t kSimPinReed = 4;
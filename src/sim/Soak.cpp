@@ -0,0 +1,401 @@
+#include "Soak.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+#include "Config.h"
+#include "DetectionScorer.h"
+#include "JournalSummary.h"
+#include "Simulation.h"
+
+static constexpr double kSoakMaxStateS = 600.0;     // longest non-MONITORING stretch
+static constexpr double kSoakMaxLatencyS = 3600.0;  // of printing, snag to detection
+static constexpr double kMillisWrapS = 4294967.296; // 2^32 ms
+static constexpr double kWrapWindowS = 86400.0;     // either side, for the report
+static constexpr double kDayS = 86400.0;
+static constexpr float kNoiseBurstGain = 5.0f;      // pot noise in a burst, x normal
+static constexpr uint32_t kMaxFailuresShown = 20;
+
+namespace {
+
+struct Detection {
+    double latencyS;
+    bool nearWrap;
+};
+
+// What must only go up within a boot, sampled once a simulated second.
+struct Counters {
+    float usedMm;
+    uint32_t prints;
+    uint32_t jams;
+    uint32_t cleared;
+    uint32_t exhausted;
+    uint32_t ticks;
+    double gapSeconds;
+};
+
+struct Soak {
+    Simulation* sim = nullptr;
+    uint32_t boot = 0;
+    double bootRunS = 0;            // run time at boot
+    uint64_t bootUs = 0;            // uptime at boot
+
+    FeedArmState state = FeedArmState::MONITORING;
+    uint64_t stateSinceUs = 0;
+    bool stateReported = false;
+    uint32_t seenDetected = 0;
+
+    uint32_t snagJams = 0;          // scorer's jam count when the snag opened
+    uint32_t snagDetected = 0;
+    double snagPrintS = 0;          // printing time it has gone undetected
+    bool snagReported = false;
+
+    std::vector<Detection> detections;
+    uint32_t failures = 0;
+};
+
+}  // namespace
+
+static double runSeconds(const Soak& s) {
+    if (!s.sim) return s.bootRunS;
+    return s.bootRunS + (s.sim->clock().micros() - s.bootUs) / 1e6;
+}
+
+static void fail(Soak& s, const char* fmt, ...) {
+    if (++s.failures > kMaxFailuresShown) return;
+    printf("  FAIL day %.3f boot %u: ", runSeconds(s) / kDayS, s.boot);
+    va_list args;
+    va_start(args, fmt);
+    vprintf(fmt, args);
+    va_end(args);
+    printf("\n");
+    if (s.failures == kMaxFailuresShown) printf("  (further failures not shown)\n");
+}
+
+static void onEvent(void* ctx, const FeedArmEvent& ev) {
+    Soak& s = *static_cast<Soak*>(ctx);
+    Simulation& sim = *s.sim;
+    uint64_t nowUs = sim.clock().micros();
+
+    // Events are drained in the tick that raised them.
+    if (ev.timeMs != sim.clock().millis()) {
+        char line[96];
+        formatFeedArmEvent(ev, line, sizeof(line));
+        fail(s, "event at %u ms, clock at %u ms: %s", ev.timeMs, sim.clock().millis(), line);
+    }
+    if (ev.type == FeedArmEventType::STATE_CHANGE) {
+        s.state = ev.to;
+        s.stateSinceUs = nowUs;
+        s.stateReported = false;
+    }
+    if (ev.type == FeedArmEventType::JAM_DETECTED && sim.score().detected() > s.seenDetected) {
+        s.seenDetected = sim.score().detected();
+        double uptimeS = nowUs / 1e6;
+        s.detections.push_back({ sim.score().latencyMs().back() / 1000.0,
+                                 fabs(uptimeS - kMillisWrapS) < kWrapWindowS });
+    }
+}
+
+static Counters sample(Simulation& sim) {
+    const FeedArmController& arm = sim.controller();
+    const UnstickLadder& ladder = arm.unstickLadder();
+    return { arm.filamentUsedMm(), arm.printCount(), ladder.jams(), ladder.cleared(),
+             ladder.exhausted(), sim.stats().ticks, sim.stats().gapSeconds };
+}
+
+static void check(Soak& s, const Config& cfg, const Counters& was, const Counters& now,
+                  double dtS) {
+    Simulation& sim = *s.sim;
+    uint64_t nowUs = sim.clock().micros();
+
+    FeedArmState state = sim.controller().state();
+    if (state != s.state) {
+        fail(s, "controller in %s, last reported %s", feedArmStateName(state),
+             feedArmStateName(s.state));
+        s.state = state;
+        s.stateSinceUs = nowUs;
+    }
+    double inStateS = (nowUs - s.stateSinceUs) / 1e6;
+    if (state != FeedArmState::MONITORING && inStateS > kSoakMaxStateS && !s.stateReported) {
+        fail(s, "%s for %.0f s", feedArmStateName(state), inStateS);
+        s.stateReported = true;
+    }
+
+    uint32_t tickMs = std::max(cfg.monitorIntervalMs, cfg.lowPower ? cfg.idleTickMs : 0);
+    double expected = dtS * 1000.0 / tickMs;
+    if (now.ticks - was.ticks + 1 < expected) {
+        fail(s, "%u control ticks in %.1f s", now.ticks - was.ticks, dtS);
+    }
+
+    if (now.usedMm < was.usedMm) fail(s, "filament used went back, %.0f -> %.0f mm",
+                                      was.usedMm, now.usedMm);
+    if (now.prints < was.prints) fail(s, "print count went back, %u -> %u", was.prints,
+                                      now.prints);
+    if (now.jams < was.jams || now.cleared < was.cleared || now.exhausted < was.exhausted) {
+        fail(s, "ladder counts went back");
+    }
+    if (now.cleared + now.exhausted > now.jams) {
+        fail(s, "ladder closed %u jams of %u", now.cleared + now.exhausted, now.jams);
+    }
+
+    // A snag is only detectable while something pulls on it.
+    const DetectionScorer& score = sim.score();
+    if (score.jams() != s.snagJams) {
+        s.snagJams = score.jams();
+        s.snagDetected = score.detected();
+        s.snagPrintS = 0;
+        s.snagReported = false;
+    }
+    if (score.jamOpen() && score.detected() == s.snagDetected) {
+        s.snagPrintS += dtS - (now.gapSeconds - was.gapSeconds);
+        if (s.snagPrintS > kSoakMaxLatencyS && !s.snagReported) {
+            fail(s, "snag undetected after %.0f s of printing", s.snagPrintS);
+            s.snagReported = true;
+        }
+    }
+}
+
+// Walk every stored segment: each boot once and in order, uptimes rising
+// within a boot, and the totals begin() replayed.
+static void checkJournal(Soak& s, JamJournal& journal) {
+    std::vector<uint8_t> buf(kJournalSegmentBytes);
+    uint32_t lastBoot = 0, lastUptimeS = 0, jams = 0;
+    for (uint8_t seg = 0; seg < journal.segmentsUsed(); seg++) {
+        size_t len = journal.readSegment(seg, 0, buf.data(), buf.size());
+        JournalDecoder dec;
+        if (!dec.begin(buf.data(), len)) {
+            fail(s, "journal segment %u unreadable", seg);
+            continue;
+        }
+        JournalEntry e;
+        while (dec.next(e)) {
+            if (e.kind == JournalKind::SESSION) {
+                if (e.boot < lastBoot) fail(s, "journal boot %u after boot %u", e.boot, lastBoot);
+                if (e.boot != lastBoot) lastUptimeS = 0;
+                lastBoot = e.boot;
+            } else if (e.kind == JournalKind::JAM) {
+                if (e.jam.uptimeS < lastUptimeS) {
+                    fail(s, "journal uptime went back in boot %u, %u -> %u s", lastBoot,
+                         lastUptimeS, e.jam.uptimeS);
+                }
+                lastUptimeS = e.jam.uptimeS;
+                jams++;
+            }
+        }
+        if (dec.truncated()) fail(s, "journal segment %u cut short", seg);
+    }
+    if (jams != journal.storedJams()) {
+        fail(s, "journal holds %u jams, begin() counted %u", jams, journal.storedJams());
+    }
+    if (journal.boot() != s.boot) fail(s, "journal boot %u, expected %u", journal.boot(), s.boot);
+    if (lastBoot >= journal.boot()) fail(s, "journal already has boot %u", lastBoot);
+}
+
+int soakMain(int argc, char** argv) {
+    double days = 60.0;
+    uint32_t seed = 1;
+    double uptimeDays = 45.0;
+    double rebootDays = 10.0;
+    double noisePerDay = 4.0;
+    bool verbose = false;
+    Config cfg;
+    SimOptions opt;
+    opt.jamsPerHour = 1.0f;
+    opt.printMeanS = 3600.0f;
+    opt.idleGapMeanS = 5400.0f;
+    opt.coastIdle = true;
+    opt.timeTicks = false;
+
+    for (int i = 0; i < argc; i++) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (!strcmp(arg, "--days") && hasValue) {
+            days = atof(argv[++i]);
+        } else if (!strcmp(arg, "--seed") && hasValue) {
+            seed = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        } else if (!strcmp(arg, "--uptime-days") && hasValue) {
+            uptimeDays = atof(argv[++i]);
+        } else if (!strcmp(arg, "--reboot-days") && hasValue) {
+            rebootDays = atof(argv[++i]);
+        } else if (!strcmp(arg, "--jams-per-hour") && hasValue) {
+            opt.jamsPerHour = (float)atof(argv[++i]);
+        } else if (!strcmp(arg, "--noise-per-day") && hasValue) {
+            noisePerDay = atof(argv[++i]);
+        } else if (!strcmp(arg, "--low-power")) {
+            cfg.lowPower = true;
+        } else if (!strcmp(arg, "-v") || !strcmp(arg, "--verbose")) {
+            verbose = true;
+        } else {
+            fprintf(stderr, "soak: unknown option '%s'\n", arg);
+            return 2;
+        }
+    }
+    if (days <= 0 || uptimeDays < 0 || rebootDays < 0) {
+        fprintf(stderr, "soak: --days must be positive, --uptime-days and --reboot-days not negative\n");
+        return 2;
+    }
+    opt.verbose = verbose;
+    simLogEnabled = verbose;
+
+    printf("=== Soak: %.1f days, first boot %.1f days up, reboots every %.1f days (+/-50%%), "
+           "%.1f snags/h, %.1f noise bursts/day, seed %u ===\n",
+           days, uptimeDays, rebootDays, opt.jamsPerHour, noisePerDay, seed);
+
+    auto wallStart = std::chrono::steady_clock::now();
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::exponential_distribution<double> burstGap(noisePerDay > 0 ? noisePerDay / kDayS : 1.0);
+
+    Soak s;
+    MemJournalStorage journalStorage;   // survives reboots, as flash does
+    RigParams rig;
+    double endS = days * kDayS;
+    double printS = 0, wrapRunS = -1;
+    uint32_t jams = 0, detected = 0, selfCleared = 0, falsePositives = 0, cycles = 0;
+    uint32_t bursts = 0, lostEntries = 0;
+
+    while (s.bootRunS < endS) {
+        s.boot++;
+        double uptimeS = s.boot == 1 ? uptimeDays * kDayS : 0.0;
+        double lengthS = rebootDays > 0 ? (0.5 + uniform(rng)) * rebootDays * kDayS : endS;
+        // The first boot always runs a day past the wrap.
+        if (s.boot == 1 && uptimeS < kMillisWrapS) {
+            lengthS = std::max(lengthS, kMillisWrapS - uptimeS + kDayS);
+        }
+        lengthS = std::min(lengthS, endS - s.bootRunS);
+
+        opt.seed = seed * 1000 + s.boot;
+        opt.startUs = (uint64_t)(uptimeS * 1e6);
+        auto sim = std::make_unique<Simulation>(cfg, rig, opt);
+        s.sim = sim.get();
+        s.bootUs = opt.startUs;
+        s.state = sim->controller().state();
+        s.stateSinceUs = s.bootUs;
+        s.stateReported = false;
+        s.seenDetected = 0;
+        s.snagJams = s.snagDetected = 0;
+        s.snagPrintS = 0;
+
+        JamJournal journal;
+        journal.begin(&journalStorage, &sim->clock());
+        if (s.boot == 1) journal.setSpool(0, 1);
+        checkJournal(s, journal);
+        sim->journalTo(&journal);
+        sim->watchEvents(onEvent, &s);
+
+        uint64_t endUs = s.bootUs + (uint64_t)(lengthS * 1e6);
+        bool wraps = uptimeS < kMillisWrapS && endUs / 1e6 >= kMillisWrapS;
+        if (wraps) wrapRunS = s.bootRunS + kMillisWrapS - uptimeS;
+
+        Counters was = sample(*sim);
+        uint64_t lastCheckUs = s.bootUs;
+        double burstAtS = noisePerDay > 0 ? runSeconds(s) + burstGap(rng) : endS;
+        double burstEndS = 0;
+        uint32_t bootBursts = 0;
+        while (sim->clock().micros() < endUs) {
+            sim->step();
+            uint64_t nowUs = sim->clock().micros();
+            if (nowUs - lastCheckUs < 1000000) continue;
+
+            Counters now = sample(*sim);
+            check(s, cfg, was, now, (nowUs - lastCheckUs) / 1e6);
+            was = now;
+            lastCheckUs = nowUs;
+
+            // Pot noise bursts: a servo or a heater switching nearby.
+            double runS = runSeconds(s);
+            if (burstEndS > 0 && runS >= burstEndS) {
+                sim->rig().setPotNoise(rig.potNoise);
+                burstEndS = 0;
+            }
+            if (runS >= burstAtS) {
+                sim->rig().setPotNoise(rig.potNoise * kNoiseBurstGain);
+                burstEndS = runS + 60.0 + uniform(rng) * 540.0;
+                burstAtS = runS + burstGap(rng);
+                bootBursts++;
+            }
+        }
+        sim->finish();
+
+        // A reboot loses whatever the journal hadn't flushed.
+        lostEntries += journal.pending();
+
+        const DetectionScorer& score = sim->score();
+        const SimStats& st = sim->stats();
+        double bootPrintS = st.simSeconds - st.gapSeconds;
+        printf("  boot %-3u day %5.1f-%-5.1f uptime %5.1f-%-5.1f d  %4u snags, %4u detected",
+               s.boot, s.bootRunS / kDayS, (s.bootRunS + lengthS) / kDayS, uptimeS / kDayS,
+               (uptimeS + lengthS) / kDayS, score.jams(), score.detected());
+        if (score.detected()) {
+            printf(" (p50 %5.2f s)", percentiles(score.latencyMs()).p50 / 1000.0);
+        }
+        printf(", %u false, %u bursts%s\n", score.falsePositives(), bootBursts,
+               wraps ? ", millis() wrapped" : "");
+
+        jams += score.jams();
+        detected += score.detected();
+        selfCleared += score.undetected();
+        falsePositives += score.falsePositives();
+        cycles += score.unstickCycles();
+        bursts += bootBursts;
+        printS += bootPrintS;
+        s.bootRunS += lengthS;
+        s.sim = nullptr;
+    }
+
+    // Replay once more, as the next boot would.
+    JamJournal journal;
+    SimClock clock;
+    bool log = simLogEnabled;
+    simLogEnabled = false;
+    journal.begin(&journalStorage, &clock);
+    simLogEnabled = log;
+    s.boot++;
+    checkJournal(s, journal);
+
+    double wallS = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    printf("=== Soak: %.1f days, %u boot(s), in %.1f s (%.0fx real time) ===\n",
+           days, s.boot - 1, wallS, wallS > 0 ? endS / wallS : 0.0);
+    printf("  Printing:           %.1f days\n", printS / kDayS);
+    if (wrapRunS >= 0) {
+        printf("  millis() wrapped:   day %.2f\n", wrapRunS / kDayS);
+    } else {
+        printf("  millis() wrapped:   never (first boot too short)\n");
+    }
+    printf("  Snags:              %u, %u detected, %u self-cleared\n", jams, detected,
+           selfCleared);
+    std::vector<double> all, nearWrap;
+    for (const Detection& d : s.detections) {
+        all.push_back(d.latencyS);
+        if (d.nearWrap) nearWrap.push_back(d.latencyS);
+    }
+    if (!all.empty()) {
+        Percentiles p = percentiles(all);
+        printf("  Latency:            p50 %.2f s, p90 %.2f s, p99 %.2f s, max %.2f s\n",
+               p.p50, p.p90, p.p99, p.max);
+    }
+    if (!nearWrap.empty()) {
+        Percentiles p = percentiles(nearWrap);
+        printf("  Within a day of it: %zu detected, p50 %.2f s, max %.2f s\n",
+               nearWrap.size(), p.p50, p.max);
+    }
+    printf("  False detections:   %u (%.3f per print-hour)\n", falsePositives,
+           printS > 0 ? falsePositives / (printS / 3600.0) : 0.0);
+    printf("  Unstick cycles:     %u\n", cycles);
+    printf("  Noise bursts:       %u\n", bursts);
+    printf("  Journal:            %u jam(s) kept over %u boot(s), %u entries lost to reboots\n",
+           journal.storedJams(), journal.boot() - 1, lostEntries);
+    if (s.failures) {
+        printf("  Invariants:         %u broken\n", s.failures);
+        return 1;
+    }
+    printf("  Invariants:         all held\n");
+    return 0;
+}
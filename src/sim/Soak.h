@@ -0,0 +1,24 @@
+#pragma once
+
+// Long-duration soak on the virtual clock.
+//
+// Runs the controller through weeks of simulated uptime in minutes: prints
+// alternate with idle gaps (skipped over once the rig settles), and spool
+// snags, pot noise bursts and reboots (every --reboot-days, give or take
+// half) are injected. The first boot starts --uptime-days in and lasts at
+// least a day past the point where millis() wraps (2^32 ms, 49.7 days);
+// every later boot starts from zero. Invariants are checked once a
+// simulated second and on every event:
+//   - no state but MONITORING lasts longer than kSoakMaxStateS
+//   - event timestamps are the clock's millis() at the tick
+//   - control ticks keep coming, at least one per idle tick
+//   - no snag goes undetected for longer than kSoakMaxLatencyS of printing
+//   - filament used, print count and ladder counts never go back in a boot,
+//     and the ladder never closes more jams than it opened
+//   - the journal restates every boot once, in order, and uptimes within a
+//     boot never go back
+// Exits 1 if any broke.
+//
+//   program soak [--days D] [--seed N] [--uptime-days U] [--reboot-days R]
+//                [--jams-per-hour R] [--noise-per-day N] [--low-power] [-v]
+int soakMain(int argc, char** argv);
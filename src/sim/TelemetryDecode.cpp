@@ -0,0 +1,116 @@
+#include "TelemetryDecode.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include "Telemetry.h"
+
+int decodeMain(int argc, char** argv) {
+    const char* inPath = nullptr;
+    std::string prefix = "telemetry";
+
+    for (int i = 0; i < argc; i++) {
+        if (!strcmp(argv[i], "--out") && i + 1 < argc) {
+            prefix = argv[++i];
+        } else if (!inPath) {
+            inPath = argv[i];
+        } else {
+            fprintf(stderr, "decode: unexpected argument '%s'\n", argv[i]);
+            return 2;
+        }
+    }
+    if (!inPath) {
+        fprintf(stderr, "usage: program decode <capture|-> [--out PREFIX]\n");
+        return 2;
+    }
+
+    FILE* in = strcmp(inPath, "-") == 0 ? stdin : fopen(inPath, "rb");
+    if (!in) {
+        fprintf(stderr, "decode: can't open %s\n", inPath);
+        return 1;
+    }
+    FILE* ticks = fopen((prefix + "_ticks.csv").c_str(), "w");
+    FILE* reed = fopen((prefix + "_reed.csv").c_str(), "w");
+    FILE* events = fopen((prefix + "_events.csv").c_str(), "w");
+    FILE* profile = fopen((prefix + "_profile.csv").c_str(), "w");
+    if (!ticks || !reed || !events || !profile) {
+        fprintf(stderr, "decode: can't write %s_*.csv\n", prefix.c_str());
+        return 1;
+    }
+    fprintf(ticks, "channel,tick,time_ms,state,stalled,feed_deg,tension_arm_deg,tension_cmd_deg,"
+                   "feed_raw,tension_raw,pulses,unsticks\n");
+    fprintf(reed, "channel,pulse,stamp_us,period_us\n");
+    fprintf(events, "channel,time_ms,event,text\n");
+    fprintf(profile, "scope,count,min_ns,p50_ns,p90_ns,p99_ns,max_ns\n");
+
+    TelemetryDecoder dec;
+    uint32_t nTicks = 0, nReed = 0, nEvents = 0, nProfile = 0, tickGaps = 0;
+    // Every channel publishes each tick, so gaps are counted per channel.
+    uint32_t lastTick[kMaxFeedChannels] = {};
+    bool haveTick[kMaxFeedChannels] = {};
+    char text[96];
+
+    int c;
+    while ((c = fgetc(in)) != EOF) {
+        if (!dec.feed((uint8_t)c)) continue;
+
+        switch (dec.type()) {
+        case TelemetryRecord::HELLO:
+            fprintf(stderr, "decode: session v%u, %u ms ticks\n",
+                    dec.hello().version, dec.hello().periodMs);
+            for (bool& h : haveTick) h = false;
+            break;
+        case TelemetryRecord::TICK: {
+            const TelemetryTick& t = dec.tick();
+            // Ticks the firmware couldn't queue never became frames, so they
+            // only show up as jumps in the tick counter.
+            uint8_t ch = t.channel < kMaxFeedChannels ? t.channel : 0;
+            if (haveTick[ch] && t.tick != lastTick[ch] + 1) tickGaps += t.tick - lastTick[ch] - 1;
+            haveTick[ch] = true;
+            lastTick[ch] = t.tick;
+            fprintf(ticks, "%u,%u,%u,%s,%u,%.2f,%.2f,%.2f,%u,%u,%u,%u\n",
+                    t.channel, t.tick, t.timeMs, feedArmStateName(t.state),
+                    (t.flags & kTelemetryStalled) ? 1 : 0,
+                    t.feedArmAngle, t.tensionArmAngle, t.tensionAngle,
+                    t.rawFeedPot, t.rawTensionPot, t.pulseCount, t.unstickCount);
+            nTicks++;
+            break;
+        }
+        case TelemetryRecord::REED: {
+            const TelemetryReed& r = dec.reed();
+            fprintf(reed, "%u,%u,%llu,%u\n", r.channel, r.pulseCount,
+                    (unsigned long long)r.stampUs, r.periodUs);
+            nReed++;
+            break;
+        }
+        case TelemetryRecord::EVENT: {
+            const FeedArmEvent& ev = dec.event();
+            formatFeedArmEvent(ev, text, sizeof(text));
+            // Quote the text column; event text has no double quotes.
+            fprintf(events, "%u,%u,%u,\"%s\"\n", ev.channel, ev.timeMs,
+                    (unsigned)ev.type, text);
+            nEvents++;
+            break;
+        }
+        case TelemetryRecord::PROFILE: {
+            const TelemetryProfile& p = dec.profile();
+            const ProfileStats& st = p.stats;
+            fprintf(profile, "%s,%u,%u,%u,%u,%u,%u\n", profileScopeName(p.scope), st.count,
+                    st.minNs, st.p50Ns, st.p90Ns, st.p99Ns, st.maxNs);
+            nProfile++;
+            break;
+        }
+        }
+    }
+
+    if (in != stdin) fclose(in);
+    fclose(ticks);
+    fclose(reed);
+    fclose(events);
+    fclose(profile);
+
+    fprintf(stderr, "decode: %u ticks, %u reed pulses, %u events, %u profile rows; "
+                    "%u bad frames, %u lost frames, %u ticks missing\n",
+            nTicks, nReed, nEvents, nProfile, dec.badFrames(), dec.lostFrames(), tickGaps);
+    return 0;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+// Host decoder for the binary telemetry stream (Telemetry.h).
+// Reads a capture file or a serial device already set to raw mode
+// (stty -F /dev/ttyACM0 raw) and splits the records into CSV files:
+// <prefix>_ticks.csv, <prefix>_reed.csv, <prefix>_events.csv and
+// <prefix>_profile.csv.
+//
+//   program decode <capture|-> [--out PREFIX]
+int decodeMain(int argc, char** argv);
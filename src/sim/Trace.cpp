@@ -0,0 +1,59 @@
+#include "Trace.h"
+
+#include <cinttypes>
+#include <cstring>
+
+bool TraceWriter::open(const char* path) {
+    close();
+    _file = fopen(path, "w");
+    if (!_file) return false;
+    fprintf(_file, "t_us,feed_adc,tension_adc,reed,jam\n");
+    return true;
+}
+
+void TraceWriter::write(const TraceRow& row) {
+    if (!_file) return;
+    fprintf(_file, "%" PRIu64 ",%u,%u,%d,%d\n", row.us, row.feedAdc, row.tensionAdc,
+            row.reed ? 1 : 0, row.jam ? 1 : 0);
+}
+
+void TraceWriter::close() {
+    if (_file) {
+        fclose(_file);
+        _file = nullptr;
+    }
+}
+
+bool loadTrace(const char* path, std::vector<TraceRow>& rows, std::string& err) {
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        err = std::string("can't open ") + path;
+        return false;
+    }
+
+    char line[128];
+    uint32_t lineNo = 0;
+    uint64_t lastUs = 0;
+    while (fgets(line, sizeof(line), f)) {
+        lineNo++;
+        if (line[0] == '#' || line[0] == '\n' || !strncmp(line, "t_us", 4)) continue;
+
+        uint64_t us;
+        unsigned feed, tension;
+        int reed, jam;
+        if (sscanf(line, "%" SCNu64 ",%u,%u,%d,%d", &us, &feed, &tension, &reed, &jam) != 5) {
+            err = std::string(path) + ":" + std::to_string(lineNo) + ": bad row";
+            fclose(f);
+            return false;
+        }
+        if (us < lastUs) {
+            err = std::string(path) + ":" + std::to_string(lineNo) + ": time goes backwards";
+            fclose(f);
+            return false;
+        }
+        lastUs = us;
+        rows.push_back({ us, (uint16_t)feed, (uint16_t)tension, reed != 0, jam != 0 });
+    }
+    fclose(f);
+    return true;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Sensor traces for replay.
+//
+// CSV, one row per pot sample or reed edge, in time order:
+//   t_us,feed_adc,tension_adc,reed,jam
+// reed = 1 marks a reed edge at t_us (pot columns repeat the last sample).
+// jam = 1 while the filament is known to be snagged (ground truth label).
+
+struct TraceRow {
+    uint64_t us;
+    uint16_t feedAdc;
+    uint16_t tensionAdc;
+    bool reed;
+    bool jam;
+};
+
+class TraceWriter {
+public:
+    ~TraceWriter() { close(); }
+
+    bool open(const char* path);
+    void write(const TraceRow& row);
+    void close();
+    bool isOpen() const { return _file != nullptr; }
+
+private:
+    FILE* _file = nullptr;
+};
+
+// Returns false with a message in err if the file can't be read or parsed.
+bool loadTrace(const char* path, std::vector<TraceRow>& rows, std::string& err);
@@ -0,0 +1,65 @@
+#include "TraceReplay.h"
+
+#include <chrono>
+#include "FeedArmController.h"
+#include "SimHal.h"
+#include "Simulation.h"
+#include "WheelEncoder.h"
+
+double replayTrace(const Config& cfg, const std::vector<TraceRow>& rows,
+                   DetectionScorer& score) {
+    if (rows.empty()) return 0;
+
+    SimClock clock;
+    ReplayPotInput pots;
+    SimServoOutput feedServo;
+    SimServoOutput tensionServo;
+    SimEdgeInput gpio;
+    ReedSwitch reed;
+    FeedArmController arm;
+    FeedArmEventRing events;
+
+    clock.setUs(rows.front().us);
+    pots.set(0, rows.front().feedAdc);
+    pots.set(1, rows.front().tensionAdc);
+
+    reed.begin(kSimPinReed, gpio, clock);
+    FeedArmIo io = { &clock, &pots, &feedServo, &tensionServo };
+    arm.setEventSink(&events);
+    arm.begin(cfg, io, kSimPinFeedServo, kSimPinTensionServo, kSimPinFeedPot,
+              kSimPinTensionPot, &reed);
+
+    const uint64_t periodUs = (uint64_t)cfg.monitorIntervalMs * 1000;
+    uint64_t nextTickUs = clock.micros();
+
+    auto tick = [&]() {
+        auto t0 = std::chrono::steady_clock::now();
+        arm.update();
+        auto t1 = std::chrono::steady_clock::now();
+        score.tickCost((uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+        FeedArmEvent ev;
+        while (events.pop(ev)) score.event(ev, clock.micros());
+    };
+
+    for (const TraceRow& row : rows) {
+        // Run every tick that falls before this row.
+        while (nextTickUs <= row.us) {
+            if (nextTickUs > clock.micros()) clock.setUs(nextTickUs);
+            tick();
+            nextTickUs += periodUs;
+        }
+        if (row.us > clock.micros()) clock.setUs(row.us);
+
+        if (row.jam && !score.jamOpen()) score.jamStarted(row.us);
+        if (!row.jam && score.jamOpen()) score.jamEnded(row.us);
+
+        if (row.reed) {
+            gpio.fire(kSimPinReed, row.us);
+        } else {
+            pots.set(0, row.feedAdc);
+            pots.set(1, row.tensionAdc);
+        }
+    }
+    score.finish(clock.micros());
+    return (rows.back().us - rows.front().us) / 3.6e9;
+}
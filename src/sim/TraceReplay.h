@@ -0,0 +1,14 @@
+#pragma once
+
+#include <vector>
+#include "Config.h"
+#include "DetectionScorer.h"
+#include "Trace.h"
+
+// Open-loop replay: feeds a recorded trace through a real FeedArmController
+// on a virtual clock, ticking it at monitorIntervalMs, and scores its JAM
+// events against the trace's jam labels. Servo commands go nowhere, so the
+// trace doesn't react to unsticks — cycle times are the controller's own.
+// Returns the replayed duration in hours.
+double replayTrace(const Config& cfg, const std::vector<TraceRow>& rows,
+                   DetectionScorer& score);
@@ -0,0 +1,146 @@
+// Host entry point: runs the feed arm controller against the physics model.
+//
+//   pio run -e native
+//   .pio/build/native/program [sim] [--hours H] [--seed N] [--jams-per-hour R] [-v]
+//   .pio/build/native/program record --out trace.csv [sim options]
+//   .pio/build/native/program bench [see Bench.h]
+//   .pio/build/native/program decode capture.bin [--out PREFIX]
+//   .pio/build/native/program journal dump.txt [--csv FILE]
+//   .pio/build/native/program soak [see Soak.h]
+//   .pio/build/native/program printer [see PrinterHost.h]
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "Bench.h"
+#include "Config.h"
+#include "JournalSummary.h"
+#include "PrinterHost.h"
+#include "Simulation.h"
+#include "Soak.h"
+#include "TelemetryDecode.h"
+#include "Trace.h"
+
+static void usage() {
+    printf("usage: program [sim|record] [--hours H] [--seed N] [--jams-per-hour R]\n"
+           "               [--hold-min N] [--hold-max N] [--detector threshold|trajectory]\n"
+           "               [--pot-filter NAME] [--print-gaps PRINT_S GAP_S]\n"
+           "               [--low-power] [--out trace.csv] [--journal dump.txt] [-v]\n"
+           "       program bench [--hours H] [--seed N] [--scenario NAME]\n"
+           "               [--trace FILE]... [--json FILE] [--label TEXT]\n"
+           "               [--detector threshold|trajectory] [--pot-filter NAME]\n"
+           "               [--reed-filter NAME] [--filters]\n"
+           "       program decode <capture|-> [--out PREFIX]\n"
+           "       program journal <dump|-> [--csv FILE]\n"
+           "       program printer [--seconds S] [--seed N] [--report-ms MS] [--tool N]\n"
+           "       program soak [--days D] [--seed N] [--uptime-days U] [--reboot-days R]\n"
+           "               [--jams-per-hour R] [--noise-per-day N] [--low-power] [-v]\n");
+}
+
+int main(int argc, char** argv) {
+    int first = 1;
+    bool record = false;
+    if (argc > 1 && !strcmp(argv[1], "bench")) {
+        return benchMain(argc - 2, argv + 2);
+    } else if (argc > 1 && !strcmp(argv[1], "decode")) {
+        return decodeMain(argc - 2, argv + 2);
+    } else if (argc > 1 && !strcmp(argv[1], "journal")) {
+        return journalMain(argc - 2, argv + 2);
+    } else if (argc > 1 && !strcmp(argv[1], "printer")) {
+        return printerMain(argc - 2, argv + 2);
+    } else if (argc > 1 && !strcmp(argv[1], "soak")) {
+        return soakMain(argc - 2, argv + 2);
+    } else if (argc > 1 && !strcmp(argv[1], "record")) {
+        record = true;
+        first = 2;
+    } else if (argc > 1 && !strcmp(argv[1], "sim")) {
+        first = 2;
+    }
+
+    SimOptions opt;
+    Config cfg;
+    const char* outPath = nullptr;
+    const char* journalPath = nullptr;
+    for (int i = first; i < argc; i++) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (!strcmp(arg, "--hours") && hasValue) {
+            opt.hours = atof(argv[++i]);
+        } else if (!strcmp(arg, "--seed") && hasValue) {
+            opt.seed = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        } else if (!strcmp(arg, "--jams-per-hour") && hasValue) {
+            opt.jamsPerHour = (float)atof(argv[++i]);
+        } else if (!strcmp(arg, "--hold-min") && hasValue) {
+            opt.jamHoldMinN = (float)atof(argv[++i]);
+        } else if (!strcmp(arg, "--hold-max") && hasValue) {
+            opt.jamHoldMaxN = (float)atof(argv[++i]);
+        } else if (!strcmp(arg, "--detector") && hasValue) {
+            if (!parseDetector(argv[++i], cfg.jamDetector)) {
+                usage();
+                return 2;
+            }
+        } else if (!strcmp(arg, "--pot-filter") && hasValue) {
+            if (!parseSignalFilter(argv[++i], cfg.potFilter)) {
+                usage();
+                return 2;
+            }
+        } else if (!strcmp(arg, "--print-gaps") && i + 2 < argc) {
+            opt.printMeanS = (float)atof(argv[++i]);
+            opt.idleGapMeanS = (float)atof(argv[++i]);
+        } else if (!strcmp(arg, "--low-power")) {
+            cfg.lowPower = true;
+        } else if (!strcmp(arg, "--out") && hasValue) {
+            outPath = argv[++i];
+        } else if (!strcmp(arg, "--journal") && hasValue) {
+            journalPath = argv[++i];
+        } else if (!strcmp(arg, "-v") || !strcmp(arg, "--verbose")) {
+            opt.verbose = true;
+        } else {
+            usage();
+            return 2;
+        }
+    }
+
+    if (record && !outPath) {
+        usage();
+        return 2;
+    }
+    simLogEnabled = opt.verbose;
+
+    RigParams rig;
+    Simulation sim(cfg, rig, opt);
+
+    TraceWriter trace;
+    if (outPath) {
+        if (!trace.open(outPath)) {
+            fprintf(stderr, "can't write %s\n", outPath);
+            return 1;
+        }
+        sim.recordTo(&trace);
+    }
+
+    // The board's journal on RAM segments, dumped as 'g dump' would.
+    MemJournalStorage journalStorage;
+    JamJournal journal;
+    if (journalPath) {
+        journal.begin(&journalStorage, &sim.clock());
+        journal.setSpool(0, 1);
+        sim.journalTo(&journal);
+    }
+    sim.run();
+    sim.printSummary();
+
+    if (journalPath) {
+        journal.flush();
+        FILE* out = fopen(journalPath, "w");
+        if (!out) {
+            fprintf(stderr, "can't write %s\n", journalPath);
+            return 1;
+        }
+        writeJournalDump(journal, out);
+        fclose(out);
+        printf("  Journal:            %u jam(s), %u bytes in %u segment(s) -> %s\n",
+               journal.storedJams(), journal.storedBytes(), journal.segmentsUsed(), journalPath);
+    }
+    return 0;
+}